@@ -0,0 +1,163 @@
+#pragma once
+#ifndef BlobSolver_H
+#define BlobSolver_H
+
+// The blob's mass-spring simulation, without graphics or networking.
+//
+// Each vertex is pulled back to its rest position and towards its neighbors
+// on the icosphere. Neighbor lists are kept in one array (compressed sparse
+// rows), so visiting a vertex's neighbors reads one contiguous run instead of
+// following a pointer per vertex. Vertices can be renumbered so that
+// neighbors sit close together in memory (see bandwidthOrder()), and the
+// step runs over chunks of vertices on a ThreadPool. Forces only read the
+// positions from before the step, so the result does not depend on the
+// number of threads.
+
+#include <algorithm>
+#include <vector>
+
+#include "al/graphics/al_Mesh.hpp"
+#include "al/math/al_Vec.hpp"
+
+#include "playground/ThreadPool.hpp"
+
+// The neighbor lists of all vertices, stored back to back
+struct NeighborTable {
+  std::vector<int> offsets{0}; // Start of each vertex's list, plus the end
+  std::vector<int> indices;
+
+  int size() const { return int(offsets.size()) - 1; }
+  int count(int i) const { return offsets[i + 1] - offsets[i]; }
+  const int *begin(int i) const { return indices.data() + offsets[i]; }
+  const int *end(int i) const { return indices.data() + offsets[i + 1]; }
+
+  void clear() {
+    offsets.assign(1, 0);
+    indices.clear();
+  }
+
+  // Adds the list of the next vertex
+  template <class It> void add(It first, It last) {
+    indices.insert(indices.end(), first, last);
+    offsets.push_back(int(indices.size()));
+  }
+};
+
+// A numbering of the vertices in reverse Cuthill-McKee order: breadth first
+// from a vertex of fewest neighbors, visiting neighbors with fewer neighbors
+// first, then reversed. Neighbors end up with nearby numbers. Returns the old
+// number of each vertex in the new order.
+inline std::vector<int> bandwidthOrder(const NeighborTable &nn) {
+  int n = nn.size();
+  std::vector<int> order;
+  order.reserve(n);
+  std::vector<char> visited(n, 0);
+  std::vector<int> next;
+
+  for (int start = 0; start < n; ++start) {
+    // Start each connected piece at its first vertex of fewest neighbors
+    if (visited[start])
+      continue;
+    int root = start;
+    for (int i = start; i < n; ++i)
+      if (!visited[i] && nn.count(i) < nn.count(root))
+        root = i;
+
+    visited[root] = 1;
+    order.push_back(root);
+    for (size_t head = order.size() - 1; head < order.size(); ++head) {
+      int v = order[head];
+      next.clear();
+      for (const int *j = nn.begin(v); j != nn.end(v); ++j) {
+        if (!visited[*j]) {
+          visited[*j] = 1;
+          next.push_back(*j);
+        }
+      }
+      std::stable_sort(next.begin(), next.end(), [&](int a, int b) {
+        return nn.count(a) < nn.count(b);
+      });
+      order.insert(order.end(), next.begin(), next.end());
+    }
+  }
+  std::reverse(order.begin(), order.end());
+  return order;
+}
+
+// Renumbers the vertices of a mesh and its neighbor table, where order[i] is
+// the old number of new vertex i. Triangle indices and neighbor lists are
+// rewritten to match; each vertex keeps its neighbors in the same order.
+inline void reorder(al::Mesh &mesh, NeighborTable &nn,
+                    const std::vector<int> &order) {
+  int n = int(order.size());
+  std::vector<int> newIndex(n);
+  for (int i = 0; i < n; ++i)
+    newIndex[order[i]] = i;
+
+  auto &verts = mesh.vertices();
+  std::vector<al::Vec3f> oldVerts(verts.begin(), verts.end());
+  for (int i = 0; i < n; ++i)
+    verts[i] = oldVerts[order[i]];
+
+  for (auto &index : mesh.indices())
+    index = newIndex[index];
+
+  NeighborTable old;
+  std::swap(old, nn);
+  nn.indices.reserve(old.indices.size());
+  nn.offsets.reserve(n + 1);
+  for (int i = 0; i < n; ++i) {
+    for (const int *j = old.begin(order[i]); j != old.end(order[i]); ++j)
+      nn.indices.push_back(newIndex[*j]);
+    nn.offsets.push_back(int(nn.indices.size()));
+  }
+}
+
+class BlobSolver {
+public:
+  float anchor = 0.06f;   // Spring constant to the rest position
+  float neighbor = 0.1f;  // Spring constant between neighbors
+  float damping = 0.08f;
+
+  NeighborTable nn;
+  std::vector<al::Vec3f> original; // Rest positions
+  std::vector<al::Vec3f> velocity;
+
+  // Takes the rest positions and neighbors; velocities start at zero
+  void init(const std::vector<al::Vec3f> &rest, const NeighborTable &table) {
+    original = rest;
+    nn = table;
+    velocity.assign(rest.size(), al::Vec3f(0));
+  }
+
+  int size() const { return int(original.size()); }
+
+  // Moves vertex i by v and its neighbors by half as much
+  void poke(al::Vec3f *p, int i, const al::Vec3f &v) const {
+    for (const int *j = nn.begin(i); j != nn.end(i); ++j)
+      p[*j] += v * 0.5;
+    p[i] += v;
+  }
+
+  // Advances the positions p, one per vertex, by one step
+  void step(al::Vec3f *p, ThreadPool &pool) {
+    // Velocities from the current positions, then positions from the new
+    // velocities, so no chunk reads positions another chunk is moving
+    pool.parallelFor(0, size(), [&](int begin, int end, int) {
+      for (int i = begin; i < end; ++i) {
+        const al::Vec3f &v = p[i];
+        al::Vec3f force = (v - original[i]) * -anchor;
+        for (const int *j = nn.begin(i); j != nn.end(i); ++j)
+          force += (v - p[*j]) * -neighbor;
+        force -= velocity[i] * damping;
+        velocity[i] += force;
+      }
+    });
+    pool.parallelFor(0, size(), [&](int begin, int end, int) {
+      for (int i = begin; i < end; ++i)
+        p[i] += velocity[i];
+    });
+  }
+};
+
+#endif
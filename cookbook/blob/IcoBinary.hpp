@@ -0,0 +1,209 @@
+#pragma once
+#ifndef IcoBinary_H
+#define IcoBinary_H
+
+// A binary form of the blob's .ico icosphere files.
+//
+// The text files are parsed a number at a time, which takes seconds for the
+// larger spheres on every node at start-up. The binary file holds the same
+// vertices, triangle indices and neighbor table as arrays in the machine's
+// own byte order, so loading maps the file into memory and copies each array
+// into place in one go:
+//
+//   Header           magic, version, flags and the four array lengths
+//   float[3 * V]     vertex positions
+//   uint32[I]        triangle indices
+//   int32[V + 1]     neighbor table offsets
+//   int32[K]         neighbor table indices
+//
+// Files are written by "./main -convert in.ico out.icob". The flag
+// kBandwidthOrdered says the vertices are already renumbered by
+// bandwidthOrder(), so nodes need not renumber after loading.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <fstream>
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "al/graphics/al_Mesh.hpp"
+
+#include "BlobSolver.hpp"
+
+struct IcoBinaryHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t flags;
+  uint32_t numVertices, numIndices, numOffsets, numNeighbors;
+};
+
+const char kIcoBinaryMagic[4] = {'I', 'C', 'O', 'B'};
+const uint32_t kIcoBinaryVersion = 1;
+const uint32_t kBandwidthOrdered = 1;
+
+// Writes a mesh and its neighbor table; returns false if the file could not
+// be written
+inline bool saveIcoBinary(const std::string &fileName, const al::Mesh &mesh,
+                          const NeighborTable &nn, uint32_t flags) {
+  IcoBinaryHeader header;
+  std::memcpy(header.magic, kIcoBinaryMagic, 4);
+  header.version = kIcoBinaryVersion;
+  header.flags = flags;
+  header.numVertices = mesh.vertices().size();
+  header.numIndices = mesh.indices().size();
+  header.numOffsets = nn.offsets.size();
+  header.numNeighbors = nn.indices.size();
+
+  std::vector<float> positions;
+  positions.reserve(3 * header.numVertices);
+  for (auto &v : mesh.vertices()) {
+    positions.push_back(v.x);
+    positions.push_back(v.y);
+    positions.push_back(v.z);
+  }
+  std::vector<uint32_t> indices(mesh.indices().begin(), mesh.indices().end());
+
+  FILE *file = fopen(fileName.c_str(), "wb");
+  if (!file)
+    return false;
+  bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+  auto write = [&](const void *data, size_t size, size_t count) {
+    ok = ok && (count == 0 || fwrite(data, size, count, file) == count);
+  };
+  write(positions.data(), sizeof(float), positions.size());
+  write(indices.data(), sizeof(uint32_t), indices.size());
+  write(nn.offsets.data(), sizeof(int32_t), nn.offsets.size());
+  write(nn.indices.data(), sizeof(int32_t), nn.indices.size());
+  return fclose(file) == 0 && ok;
+}
+
+// A read-only view of a whole file, memory mapped where possible
+class MappedFile {
+public:
+  explicit MappedFile(const std::string &fileName) {
+#ifdef _WIN32
+    std::ifstream file(fileName, std::ios::binary);
+    if (file) {
+      mCopy.assign(std::istreambuf_iterator<char>(file),
+                   std::istreambuf_iterator<char>());
+      mData = mCopy.data();
+      mSize = mCopy.size();
+    }
+#else
+    int fd = open(fileName.c_str(), O_RDONLY);
+    if (fd < 0)
+      return;
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+      void *p = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (p != MAP_FAILED) {
+        mData = static_cast<const char *>(p);
+        mSize = info.st_size;
+        madvise(p, mSize, MADV_SEQUENTIAL);
+      }
+    }
+    close(fd);
+#endif
+  }
+
+  ~MappedFile() {
+#ifndef _WIN32
+    if (mData)
+      munmap(const_cast<char *>(mData), mSize);
+#endif
+  }
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  const char *data() const { return mData; }
+  size_t size() const { return mSize; }
+
+private:
+  const char *mData = nullptr;
+  size_t mSize = 0;
+#ifdef _WIN32
+  std::vector<char> mCopy;
+#endif
+};
+
+// Loads a file written by saveIcoBinary() into a mesh and neighbor table.
+// Returns false, leaving mesh and nn unchanged, if the file is missing, of
+// another version or inconsistent. flags is set to the file's flags.
+inline bool loadIcoBinary(const std::string &fileName, al::Mesh &mesh,
+                          NeighborTable &nn, uint32_t *flags = nullptr) {
+  MappedFile file(fileName);
+  if (file.size() < sizeof(IcoBinaryHeader))
+    return false;
+  IcoBinaryHeader header;
+  std::memcpy(&header, file.data(), sizeof(header));
+  if (std::memcmp(header.magic, kIcoBinaryMagic, 4) != 0 ||
+      header.version != kIcoBinaryVersion ||
+      header.numOffsets != header.numVertices + 1)
+    return false;
+
+  size_t vertexBytes = size_t(header.numVertices) * 3 * sizeof(float);
+  size_t indexBytes = size_t(header.numIndices) * sizeof(uint32_t);
+  size_t offsetBytes = size_t(header.numOffsets) * sizeof(int32_t);
+  size_t neighborBytes = size_t(header.numNeighbors) * sizeof(int32_t);
+  if (file.size() !=
+      sizeof(header) + vertexBytes + indexBytes + offsetBytes + neighborBytes)
+    return false;
+
+  // Check the table and indices in the file before copying anything, so a
+  // damaged file leaves the mesh and table as they were
+  const char *vertexData = file.data() + sizeof(header);
+  const char *indexData = vertexData + vertexBytes;
+  const char *offsetData = indexData + indexBytes;
+  const char *neighborData = offsetData + offsetBytes;
+  auto at = [](const char *data, size_t i) {
+    uint32_t value;
+    std::memcpy(&value, data + i * sizeof(value), sizeof(value));
+    return value;
+  };
+  uint32_t numVertices = header.numVertices;
+  bool ok = at(offsetData, 0) == 0 &&
+            at(offsetData, numVertices) == header.numNeighbors;
+  for (uint32_t i = 0; ok && i < numVertices; ++i)
+    ok = int32_t(at(offsetData, i)) <= int32_t(at(offsetData, i + 1));
+  for (uint32_t k = 0; ok && k < header.numNeighbors; ++k)
+    ok = at(neighborData, k) < numVertices;
+  for (uint32_t k = 0; ok && k < header.numIndices; ++k)
+    ok = at(indexData, k) < numVertices;
+  if (!ok)
+    return false;
+
+  static_assert(sizeof(al::Vec3f) == 3 * sizeof(float),
+                "vertices are copied as packed floats");
+  auto &verts = mesh.vertices();
+  verts.resize(header.numVertices);
+  if (vertexBytes)
+    std::memcpy(&verts[0][0], vertexData, vertexBytes);
+
+  auto &indices = mesh.indices();
+  indices.resize(header.numIndices);
+  if (indexBytes)
+    std::memcpy(indices.data(), indexData, indexBytes);
+
+  nn.offsets.resize(header.numOffsets);
+  std::memcpy(nn.offsets.data(), offsetData, offsetBytes);
+  nn.indices.resize(header.numNeighbors);
+  if (neighborBytes)
+    std::memcpy(nn.indices.data(), neighborData, neighborBytes);
+
+  if (flags)
+    *flags = header.flags;
+  return true;
+}
+
+#endif
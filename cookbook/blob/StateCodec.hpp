@@ -0,0 +1,287 @@
+#pragma once
+#ifndef StateCodec_H
+#define StateCodec_H
+
+// Quantized, change-only encoding of the blob's vertex positions, to share
+// them in a fixed-size packet instead of the whole array every frame.
+//
+// Each position is sent as its offset from the vertex's rest position, 16
+// bits per coordinate over [-range, range]. A packet holds:
+//
+//   - the vertices that moved further than a tolerance from what was last
+//     sent, each as the gap from the previous one's index and three int16s.
+//     If they don't all fit, the ones that moved furthest are sent and the
+//     rest wait for a later packet.
+//   - a refresh slice: the next refreshCount vertices in turn, whether they
+//     changed or not. Over numVertices / refreshCount packets every vertex is
+//     sent, which works as a rolling keyframe: a renderer that joins late or
+//     misses packets is fully up to date after one cycle.
+//
+// Values are sent whole rather than as differences from the last packet, so
+// a lost packet only leaves the vertices it carried stale until they are
+// sent again.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "al/math/al_Vec.hpp"
+
+struct StatePacketHeader {
+  uint32_t sequence;     // Counts packets, from 1
+  uint32_t numVertices;
+  float range;           // Largest offset from rest that can be sent
+  uint32_t refreshBegin; // First vertex of the refresh slice
+  uint32_t refreshCount;
+  uint32_t numChanged;
+};
+
+class StateEncoder {
+public:
+  float range = 2;          // Offsets are clamped to [-range, range]
+  float tolerance = 1e-3f;  // Vertices closer than this to what was last
+                            // sent are left out
+  int refreshCount = 1024;  // Vertices sent in every packet in turn
+
+  void init(const std::vector<al::Vec3f> &rest) {
+    mRest = rest;
+    mSent.assign(rest.size() * 3, 0);
+    mQuantized.assign(rest.size() * 3, 0);
+    mSequence = 0;
+    mRefresh = 0;
+    mPending = 0;
+    mCandidates.reserve(rest.size());
+    mChosen.reserve(rest.size());
+  }
+
+  // Encodes positions p, one per vertex, into at most capacity bytes of out.
+  // Returns the number of bytes written.
+  size_t encode(const al::Vec3f *p, unsigned char *out, size_t capacity) {
+    StatePacketHeader header;
+    if (capacity < sizeof(header))
+      return 0;
+    int n = int(mRest.size());
+    float scale = 32767.f / range;
+    for (int i = 0; i < n; ++i) {
+      for (int k = 0; k < 3; ++k) {
+        float d = std::max(-range, std::min(range, p[i][k] - mRest[i][k]));
+        mQuantized[i * 3 + k] = int16_t(std::lround(d * scale));
+      }
+    }
+
+    header.sequence = ++mSequence;
+    header.numVertices = n;
+    header.range = range;
+    header.refreshBegin = mRefresh;
+    header.refreshCount = std::min(
+        std::min(refreshCount, n),
+        int((capacity - sizeof(header)) / kVertexBytes));
+    header.numChanged = 0;
+
+    // The refresh slice
+    unsigned char *w = out + sizeof(header);
+    for (uint32_t j = 0; j < header.refreshCount; ++j) {
+      int i = (mRefresh + j) % n;
+      w = writeVertex(w, i);
+    }
+    mRefresh = n ? (mRefresh + header.refreshCount) % n : 0;
+
+    // Vertices further than the tolerance from what was last sent, the
+    // furthest that fit if they don't all, written in index order
+    int limit = std::max(0, int(std::lround(tolerance * scale)));
+    mCandidates.clear();
+    for (int i = 0; i < n; ++i) {
+      int error = 0;
+      for (int k = 0; k < 3; ++k)
+        error = std::max(error, std::abs(mQuantized[i * 3 + k] -
+                                         mSent[i * 3 + k]));
+      if (error > limit)
+        mCandidates.push_back({error, i});
+    }
+    auto furthest = [](const Candidate &a, const Candidate &b) {
+      return a.error > b.error;
+    };
+    size_t space = out + capacity - w;
+    // Gaps take a byte at least, so no more than this many fit
+    size_t count = std::min(mCandidates.size(), space / (kVertexBytes + 1));
+    if (count < mCandidates.size())
+      std::nth_element(mCandidates.begin(), mCandidates.begin() + count,
+                       mCandidates.end(), furthest);
+    if (changedBytes(count) > space) {
+      // Longer gaps take up to five bytes. Leaving a vertex out never makes
+      // the others take more, so keep as many of the furthest as fit.
+      std::sort(mCandidates.begin(), mCandidates.begin() + count, furthest);
+      size_t fits = 0, fitsNot = count;
+      while (fitsNot - fits > 1) {
+        size_t k = (fits + fitsNot) / 2;
+        if (changedBytes(k) <= space)
+          fits = k;
+        else
+          fitsNot = k;
+      }
+      count = fits;
+    }
+    mCandidates.resize(count);
+    sortByIndex(mCandidates);
+
+    int position = 0;
+    for (auto &c : mCandidates) {
+      w = writeVarint(w, c.index - position);
+      w = writeVertex(w, c.index);
+      position = c.index;
+    }
+    header.numChanged = count;
+    mPending = 0;
+    for (int i = 0; i < n; ++i)
+      mPending += changed(i, limit);
+
+    std::memcpy(out, &header, sizeof(header));
+    return w - out;
+  }
+
+  // Vertices still further than the tolerance from what was sent, after the
+  // last packet
+  int pending() const { return mPending; }
+
+private:
+  static const int kVertexBytes = 3 * sizeof(int16_t);
+
+  struct Candidate {
+    int error, index;
+  };
+
+  bool changed(int i, int limit) const {
+    for (int k = 0; k < 3; ++k)
+      if (std::abs(mQuantized[i * 3 + k] - mSent[i * 3 + k]) > limit)
+        return true;
+    return false;
+  }
+
+  static void sortByIndex(std::vector<Candidate> &c) {
+    std::sort(c.begin(), c.end(), [](const Candidate &a, const Candidate &b) {
+      return a.index < b.index;
+    });
+  }
+
+  // Bytes the first k candidates take, written in index order
+  size_t changedBytes(size_t k) {
+    mChosen.assign(mCandidates.begin(), mCandidates.begin() + k);
+    sortByIndex(mChosen);
+    size_t bytes = 0;
+    int position = 0;
+    for (auto &c : mChosen) {
+      bytes += varintBytes(c.index - position) + kVertexBytes;
+      position = c.index;
+    }
+    return bytes;
+  }
+
+  unsigned char *writeVertex(unsigned char *w, int i) {
+    std::memcpy(w, &mQuantized[i * 3], kVertexBytes);
+    std::memcpy(&mSent[i * 3], &mQuantized[i * 3], kVertexBytes);
+    return w + kVertexBytes;
+  }
+
+  static size_t varintBytes(uint32_t v) {
+    size_t bytes = 1;
+    for (; v >= 0x80; v >>= 7)
+      ++bytes;
+    return bytes;
+  }
+
+  static unsigned char *writeVarint(unsigned char *w, uint32_t v) {
+    while (v >= 0x80) {
+      *w++ = (v & 0x7f) | 0x80;
+      v >>= 7;
+    }
+    *w++ = v;
+    return w;
+  }
+
+  std::vector<al::Vec3f> mRest;
+  std::vector<int16_t> mSent, mQuantized; // Three per vertex
+  std::vector<Candidate> mCandidates, mChosen;
+  uint32_t mSequence = 0;
+  int mRefresh = 0, mPending = 0;
+};
+
+class StateDecoder {
+public:
+  void init(const std::vector<al::Vec3f> &rest) {
+    mRest = rest;
+    mLastSequence = 0;
+    mMissed = 0;
+  }
+
+  // Applies a packet to positions p, one per vertex. Returns false if the
+  // packet is malformed, for another mesh, or was already applied.
+  bool decode(const unsigned char *in, size_t size, al::Vec3f *p) {
+    StatePacketHeader header;
+    if (size < sizeof(header))
+      return false;
+    std::memcpy(&header, in, sizeof(header));
+    int n = int(mRest.size());
+    if (header.numVertices != uint32_t(n) || n == 0 ||
+        header.refreshBegin >= uint32_t(n) ||
+        header.sequence == mLastSequence)
+      return false;
+    if (mLastSequence && header.sequence > mLastSequence + 1)
+      mMissed += header.sequence - mLastSequence - 1;
+    mLastSequence = header.sequence;
+
+    float scale = header.range / 32767.f;
+    const unsigned char *r = in + sizeof(header), *end = in + size;
+    for (uint32_t j = 0; j < header.refreshCount; ++j) {
+      if (end - r < kVertexBytes)
+        return false;
+      r = readVertex(r, (header.refreshBegin + j) % n, scale, p);
+    }
+    uint32_t position = 0;
+    for (uint32_t j = 0; j < header.numChanged; ++j) {
+      uint32_t gap;
+      if (!(r = readVarint(r, end, gap)) || end - r < kVertexBytes)
+        return false;
+      position += gap;
+      if (position >= uint32_t(n))
+        return false;
+      r = readVertex(r, position, scale, p);
+    }
+    return true;
+  }
+
+  // Packets skipped between ones received, as counted by their sequence
+  long long missed() const { return mMissed; }
+
+private:
+  static const int kVertexBytes = 3 * sizeof(int16_t);
+
+  const unsigned char *readVertex(const unsigned char *r, int i, float scale,
+                                  al::Vec3f *p) const {
+    int16_t q[3];
+    std::memcpy(q, r, kVertexBytes);
+    for (int k = 0; k < 3; ++k)
+      p[i][k] = mRest[i][k] + q[k] * scale;
+    return r + kVertexBytes;
+  }
+
+  static const unsigned char *readVarint(const unsigned char *r,
+                                         const unsigned char *end,
+                                         uint32_t &v) {
+    v = 0;
+    for (int shift = 0; r < end && shift < 35; shift += 7) {
+      unsigned char b = *r++;
+      v |= uint32_t(b & 0x7f) << shift;
+      if (!(b & 0x80))
+        return r;
+    }
+    return nullptr;
+  }
+
+  std::vector<al::Vec3f> mRest;
+  uint32_t mLastSequence = 0;
+  long long mMissed = 0;
+};
+
+#endif
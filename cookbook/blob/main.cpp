@@ -1,6 +1,7 @@
 
 #include "al/app/al_DistributedApp.hpp"
 #include "al/math/al_Random.hpp"
+#include "al/system/al_Time.hpp"
 
 #include "al/app/al_GUIDomain.hpp"
 
@@ -10,12 +11,55 @@
 
 using namespace al;
 
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
 #include <iostream> // cout
+#include <unordered_map>
 #include <vector> // vector
 
+#include "playground/CounterRandom.hpp"
+#include "playground/StateHistory.hpp"
+
+#include "BlobSolver.hpp"
+#include "IcoBinary.hpp"
+#include "StateCodec.hpp"
+
 // This example demonstrates how to write a distributed application that
 // shares mesh vertices through cuttlebone.
 // Original by Karl Yerkes, adapted by Andres Cabrera
+//
+// The simulation is in BlobSolver.hpp. Every node renumbers the vertices it
+// loads in the same way, so neighbors are close in memory, and the simulator
+// steps them on all cores. Run with -bench to time a step of larger
+// icospheres, made by subdividing the 162 vertex one, against the original
+// serial loop:
+//
+//     ./main -bench [subdivisions] [threads]
+//
+// Subdividing already numbers neighbors close together, so renumbering makes
+// no measurable difference to these spheres on one thread; the gain is from
+// the threads, on machines with cores to spare.
+//
+// Each node looks for the icosphere as N.icob, the binary format of
+// IcoBinary.hpp, before falling back to parsing N.ico. To make the binary
+// file from the text one (and time loading each):
+//
+//     ./main -convert 163842.ico 163842.icob
+//
+// With DELTA_STATE defined below, positions are shared as quantized changes
+// in a fixed-size packet (see StateCodec.hpp) instead of the whole array.
+// To measure the packet size and the error renderers would see, run
+//
+//     ./main -loopback [subdivisions] [frames] [packetBytes] [lossPercent]
+//
+// Renderers keep the last few states they receive in a StateHistory and draw
+// a blend of them a little behind the simulator, so late or lost states and a
+// simulator running slower than the renderers don't show as judder. To
+// compare with drawing each state as it arrives:
+//
+//     ./main -history [publishHz] [renderHz] [lossPercent] [jitterMs]
 
 // State --------------------------
 #define N 162
@@ -26,7 +70,12 @@ using namespace al;
 //#define N 163842
 //#define N 655362
 
+// Share positions as quantized changes rather than the whole array
+//#define DELTA_STATE
+const size_t kPacketBytes = 64 * 1024;
+
 struct State {
+  double time = 0; // Seconds simulated, to order and blend states
   Pose pose; // for navigation
 
   // this is how you might control renderering settings.
@@ -46,16 +95,24 @@ struct State {
   // on the server/simulator, so it does not need to be calculated on the
   // renderer, only interpreted.
   //
+  // at N = 655362 the array is 7.8 MB, so for the larger spheres define
+  // DELTA_STATE to send a packet of changed vertices instead.
 
+#ifdef DELTA_STATE
+  uint32_t packetSize;
+  unsigned char packet[kPacketBytes];
+#else
   Vec3f p[N];
+#endif
 };
 
 // Load file into mesh
-bool load(std::string fileName, Mesh &mesh, std::vector<std::vector<int>> &nn) {
+bool load(std::string fileName, Mesh &mesh, NeighborTable &nn) {
   std::ifstream file(fileName);
   if (!file.is_open())
     return false;
 
+  nn.clear();
   std::string line;
   int state = 0;
   while (getline(file, line)) {
@@ -98,7 +155,7 @@ bool load(std::string fileName, Mesh &mesh, std::vector<std::vector<int>> &nn) {
       }
       if ((v.size() != 5) && (v.size() != 6))
         return false;
-      nn.push_back(v);
+      nn.add(v.begin(), v.end());
       // cout << nn[nn.size() - 1].size() << endl;
     } break;
     }
@@ -114,6 +171,24 @@ bool load(std::string fileName, Mesh &mesh, std::vector<std::vector<int>> &nn) {
 #undef far
 #endif
 
+// What renderers keep of each state to blend between them
+struct BlobFrame {
+  Pose pose;
+  std::vector<Vec3f> positions;
+};
+
+// Blends the poses and positions of two frames, a + (b - a) t
+void blendFrames(const BlobFrame &a, const BlobFrame &b, float t,
+                 BlobFrame &out, ThreadPool &pool) {
+  out.pose = a.pose;
+  out.pose.lerp(b.pose, t);
+  out.positions.resize(a.positions.size());
+  pool.parallelFor(0, int(a.positions.size()), [&](int begin, int end, int) {
+    for (int i = begin; i < end; ++i)
+      out.positions[i] = a.positions[i] + (b.positions[i] - a.positions[i]) * t;
+  });
+}
+
 // Create a new DistributedAppWithState, templated on the state data structure
 // that will be shared on the network
 
@@ -133,9 +208,18 @@ struct Blob : DistributedAppWithState<State> {
   // Internal computation data
   // This data will not be shared to remote nodes, so you should only use it on
   // the simulator machine
-  vector<vector<int>> nn;
-  vector<Vec3f> velocity;
-  vector<Vec3f> original;
+  BlobSolver solver;
+  ThreadPool pool;
+
+#ifdef DELTA_STATE
+  // Positions are local, and encoded to or decoded from the state's packet
+  std::vector<Vec3f> localPositions;
+  StateEncoder encoder;
+  StateDecoder decoder;
+  Vec3f *positions() { return localPositions.data(); }
+#else
+  Vec3f *positions() { return state().p; }
+#endif
 
   // a boolean value that is read and reset (false) by the simulation step and
   // written (true) by audio, keyboard and mouse callbacks.
@@ -146,6 +230,10 @@ struct Blob : DistributedAppWithState<State> {
   // a mesh we use to do graphics rendering in this app
   Mesh mesh;
 
+  // Renderers draw from the states received so far
+  StateHistory<BlobFrame> history;
+  BlobFrame received, drawn;
+
   gam::NoisePink<> pinkNoise;
 
   void onInit() override {
@@ -159,21 +247,34 @@ struct Blob : DistributedAppWithState<State> {
 
     std::string icoSphereFile = std::to_string(N) + ".ico";
 
-    if (!load(searchPaths.find(icoSphereFile).filepath(), mesh, nn)) {
-      std::cout << "cannot find " << icoSphereFile << std::endl;
-      quit();
+    // Renderers renumber the same way, so the shared positions line up
+    NeighborTable nn;
+    uint32_t flags = 0;
+    if (!loadIcoBinary(searchPaths.find(icoSphereFile + "b").filepath(), mesh,
+                       nn, &flags)) {
+      if (!load(searchPaths.find(icoSphereFile).filepath(), mesh, nn)) {
+        std::cout << "cannot find " << icoSphereFile << std::endl;
+        quit();
+      }
     }
+    if (!(flags & kBandwidthOrdered))
+      reorder(mesh, nn, bandwidthOrder(nn));
+
+#ifdef DELTA_STATE
+    localPositions = mesh.vertices();
+    encoder.refreshCount = kPacketBytes / 4 / 6; // A quarter of the packet
+    encoder.init(mesh.vertices());
+    decoder.init(mesh.vertices());
+#endif
+
     if (isPrimary()) {
       shouldPoke = true; // start with a poke
 
       // Initialize simulation data
-      velocity.resize(mesh.vertices().size(), Vec3f(0, 0, 0));
-      original.resize(mesh.vertices().size());
-      for (int i = 0; i < mesh.vertices().size(); i++)
-        original[i] = mesh.vertices()[i];
+      solver.init(mesh.vertices(), nn);
 
       for (int i = 0; i < N; i++)
-        state().p[i] = original[i];
+        positions()[i] = solver.original[i];
       state().eyeSeparation = 0.03;
       state().backgroundColor = Color(0.1f, 0.1f);
       state().wireFrame = true;
@@ -204,44 +305,55 @@ struct Blob : DistributedAppWithState<State> {
         shouldPoke = false;
         int n = al::rnd::uniform(N);
         pokedVertex = n;
-        pokedVertexRest = original[n];
+        pokedVertexRest = solver.original[n];
         Vec3f v = Vec3f(rnd::uniformS(), rnd::uniformS(), rnd::uniformS());
-        for (unsigned k = 0; k < nn[n].size(); k++)
-          state().p[nn[n][k]] += v * 0.5;
-        state().p[n] += v;
+        solver.poke(positions(), n, v);
       }
 
       // Compute new postions
-      for (int i = 0; i < N; i++) {
-        Vec3f &v = state().p[i];
-        Vec3f force = (v - original[i]) * -SK;
-
-        for (int k = 0; k < nn[i].size(); k++) {
-          Vec3f &n = state().p[nn[i][k]];
-          force += (v - n) * -NK;
-        }
-
-        force -= velocity[i] * D;
-        velocity[i] += force;
-      }
-
-      for (int i = 0; i < N; i++) {
-        state().p[i] += velocity[i];
-      }
+      solver.anchor = SK.get();
+      solver.neighbor = NK.get();
+      solver.damping = D.get();
+      solver.step(positions(), pool);
+#ifdef DELTA_STATE
+      state().packetSize =
+          encoder.encode(positions(), state().packet, kPacketBytes);
+#endif
 
       // Update variables in state to send to nodes
+      state().time += dt;
       state().pose = nav();
       state().backgroundColor = bgColor;
       state().wireFrame = wireFrame;
 
+      // Copy vertex positions from state to mesh
+      memcpy(&mesh.vertices()[0], positions(), sizeof(Vec3f) * N);
+
     } else {
-      // For remote nodes, update pose and color from state
-      pose() = state().pose;
+      // For remote nodes, update color from state
       bgColor = state().backgroundColor;
       wireFrame = state().wireFrame;
+#ifdef DELTA_STATE
+      decoder.decode(state().packet, state().packetSize, positions());
+#endif
+
+      // Keep each new state, then draw pose and positions blended from them
+      double now = al_steady_time();
+      if (history.size() == 0 || state().time > history.newestTime()) {
+        received.pose = state().pose;
+        received.positions.assign(positions(), positions() + N);
+        history.push(received, state().time, now);
+      }
+      if (history.sample(now, drawn,
+                         [this](const BlobFrame &a, const BlobFrame &b,
+                                float t, BlobFrame &out) {
+                           blendFrames(a, b, t, out, pool);
+                         })) {
+        pose() = drawn.pose;
+        memcpy(&mesh.vertices()[0], drawn.positions.data(),
+               sizeof(Vec3f) * N);
+      }
     }
-    // Copy vertex positions from state to mesh
-    memcpy(&mesh.vertices()[0], &state().p[0], sizeof(Vec3f) * N);
   }
 
   void onDraw(Graphics &g) override {
@@ -274,7 +386,7 @@ struct Blob : DistributedAppWithState<State> {
           }
         }
 
-        float f = (state().p[pokedVertex] - pokedVertexRest).mag() - 0.45;
+        float f = (positions()[pokedVertex] - pokedVertexRest).mag() - 0.45;
 
         if (f > 0.99) {
           f = 0.99;
@@ -302,7 +414,442 @@ struct Blob : DistributedAppWithState<State> {
   }
 };
 
-int main() {
+// Splits every triangle of a unit icosphere into four, with the new vertices
+// on the sphere, and rebuilds the neighbor table from the triangles
+void subdivide(Mesh &mesh, NeighborTable &nn) {
+  auto &verts = mesh.vertices();
+  std::vector<unsigned> tris(mesh.indices().begin(), mesh.indices().end());
+  std::unordered_map<unsigned long long, unsigned> midpoints;
+  auto midpoint = [&](unsigned a, unsigned b) {
+    unsigned long long key =
+        (unsigned long long)std::min(a, b) << 32 | std::max(a, b);
+    auto found = midpoints.find(key);
+    if (found != midpoints.end())
+      return found->second;
+    unsigned i = verts.size();
+    mesh.vertex((verts[a] + verts[b]).normalized());
+    midpoints[key] = i;
+    return i;
+  };
+
+  mesh.indices().clear();
+  for (size_t t = 0; t < tris.size(); t += 3) {
+    unsigned a = tris[t], b = tris[t + 1], c = tris[t + 2];
+    unsigned ab = midpoint(a, b), bc = midpoint(b, c), ca = midpoint(c, a);
+    mesh.index(a, ab, ca);
+    mesh.index(ab, b, bc);
+    mesh.index(ca, bc, c);
+    mesh.index(ab, bc, ca);
+  }
+
+  std::vector<std::vector<int>> lists(verts.size());
+  auto &indices = mesh.indices();
+  for (size_t t = 0; t < indices.size(); t += 3) {
+    for (int k = 0; k < 3; ++k) {
+      int a = indices[t + k], b = indices[t + (k + 1) % 3];
+      lists[a].push_back(b);
+      lists[b].push_back(a);
+    }
+  }
+  nn.clear();
+  for (auto &list : lists) {
+    std::sort(list.begin(), list.end());
+    list.erase(std::unique(list.begin(), list.end()), list.end());
+    nn.add(list.begin(), list.end());
+  }
+}
+
+// The original step, with a separately allocated neighbor list per vertex
+void referenceStep(std::vector<Vec3f> &p, std::vector<Vec3f> &velocity,
+                   const std::vector<Vec3f> &original,
+                   const std::vector<std::vector<int>> &nn, float SK,
+                   float NK, float D) {
+  for (size_t i = 0; i < p.size(); i++) {
+    Vec3f &v = p[i];
+    Vec3f force = (v - original[i]) * -SK;
+
+    for (size_t k = 0; k < nn[i].size(); k++) {
+      Vec3f &n = p[nn[i][k]];
+      force += (v - n) * -NK;
+    }
+
+    force -= velocity[i] * D;
+    velocity[i] += force;
+  }
+
+  for (size_t i = 0; i < p.size(); i++) {
+    p[i] += velocity[i];
+  }
+}
+
+// Times a step of the original loop, of BlobSolver on one thread in file
+// order, and of BlobSolver renumbered on a pool of threads, then checks that
+// all three give the same positions
+void benchmark(int subdivisions, int numThreads) {
+  typedef std::chrono::steady_clock Clock;
+  SearchPaths searchPaths;
+  searchPaths.addSearchPath(".", false);
+  searchPaths.addSearchPath("/alloshare/blob", false);
+  searchPaths.addAppPaths();
+
+  Mesh mesh;
+  NeighborTable nn;
+  if (!load(searchPaths.find("162.ico").filepath(), mesh, nn)) {
+    std::cout << "cannot find 162.ico" << std::endl;
+    return;
+  }
+  for (int i = 0; i < subdivisions; ++i)
+    subdivide(mesh, nn);
+  int n = mesh.vertices().size();
+
+  std::vector<std::vector<int>> lists(n);
+  for (int i = 0; i < n; ++i)
+    lists[i].assign(nn.begin(i), nn.end(i));
+
+  // Runs steps until a second has passed, after the same poke, and returns
+  // milliseconds per step
+  const Vec3f kick(0.3f, -0.2f, 0.1f);
+  auto time = [&](std::function<void()> step) {
+    int steps = 0;
+    auto t0 = Clock::now();
+    double elapsed;
+    do {
+      step();
+      ++steps;
+      elapsed = std::chrono::duration<double>(Clock::now() - t0).count();
+    } while (elapsed < 1 || steps < 3);
+    return elapsed / steps * 1e3;
+  };
+  const int checkSteps = 50;
+
+  // Original loop
+  std::vector<Vec3f> original(mesh.vertices().begin(), mesh.vertices().end());
+  std::vector<Vec3f> p = original, velocity(n, Vec3f(0));
+  for (int k = 0; k < nn.count(0); ++k)
+    p[nn.begin(0)[k]] += kick * 0.5;
+  p[0] += kick;
+  std::vector<Vec3f> start = p, reference;
+  for (int s = 0; s < checkSteps; ++s)
+    referenceStep(p, velocity, original, lists, 0.06f, 0.1f, 0.08f);
+  reference = p;
+  double referenceMs = time([&]() {
+    referenceStep(p, velocity, original, lists, 0.06f, 0.1f, 0.08f);
+  });
+
+  // BlobSolver in file order on one thread
+  ThreadPool one(1);
+  BlobSolver serial;
+  serial.init(original, nn);
+  p = start;
+  for (int s = 0; s < checkSteps; ++s)
+    serial.step(p.data(), one);
+  float serialError = 0;
+  for (int i = 0; i < n; ++i)
+    serialError = std::max(serialError, (p[i] - reference[i]).mag());
+  double serialMs = time([&]() { serial.step(p.data(), one); });
+
+  // BlobSolver renumbered, on one thread and then on all, to tell the gain
+  // of renumbering from that of the threads
+  ThreadPool pool(numThreads);
+  std::vector<int> order = bandwidthOrder(nn);
+  Mesh reordered = mesh;
+  NeighborTable reorderedNN = nn;
+  reorder(reordered, reorderedNN, order);
+  BlobSolver parallel;
+  parallel.init(reordered.vertices(), reorderedNN);
+  std::vector<Vec3f> q(n);
+  for (int i = 0; i < n; ++i)
+    q[i] = start[order[i]];
+  for (int s = 0; s < checkSteps; ++s)
+    parallel.step(q.data(), pool);
+  float parallelError = 0;
+  for (int i = 0; i < n; ++i)
+    parallelError =
+        std::max(parallelError, (q[i] - reference[order[i]]).mag());
+  double reorderedMs = time([&]() { parallel.step(q.data(), one); });
+  double parallelMs = time([&]() { parallel.step(q.data(), pool); });
+
+  printf("%d vertices, %d neighbors\n", n, int(nn.indices.size()));
+  printf("original loop          %8.3f ms/step\n", referenceMs);
+  printf("CSR, 1 thread          %8.3f ms/step, max difference %g\n",
+         serialMs, serialError);
+  printf("CSR reordered, 1 thr   %8.3f ms/step\n", reorderedMs);
+  printf("CSR reordered, %2d thr  %8.3f ms/step, max difference %g\n",
+         pool.size(), parallelMs, parallelError);
+}
+
+// Converts a text .ico file to the binary format, renumbered, and checks that
+// loading it back gives the same mesh
+int convert(const std::string &in, const std::string &out) {
+  typedef std::chrono::steady_clock Clock;
+  auto ms = [](Clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0)
+        .count();
+  };
+
+  Mesh mesh;
+  NeighborTable nn;
+  auto t0 = Clock::now();
+  if (!load(in, mesh, nn)) {
+    std::cout << "cannot read " << in << std::endl;
+    return 1;
+  }
+  double textMs = ms(t0);
+  reorder(mesh, nn, bandwidthOrder(nn));
+  if (!saveIcoBinary(out, mesh, nn, kBandwidthOrdered)) {
+    std::cout << "cannot write " << out << std::endl;
+    return 1;
+  }
+
+  Mesh loaded;
+  NeighborTable loadedNN;
+  t0 = Clock::now();
+  bool ok = loadIcoBinary(out, loaded, loadedNN);
+  double binaryMs = ms(t0);
+  ok = ok && loaded.indices() == mesh.indices() &&
+       loadedNN.offsets == nn.offsets && loadedNN.indices == nn.indices &&
+       loaded.vertices().size() == mesh.vertices().size();
+  for (size_t i = 0; ok && i < mesh.vertices().size(); ++i)
+    for (int k = 0; k < 3; ++k)
+      ok = loaded.vertices()[i][k] == mesh.vertices()[i][k];
+
+  printf("%d vertices: parsed %s in %.2f ms, loaded %s in %.2f ms\n",
+         int(mesh.vertices().size()), in.c_str(), textMs, out.c_str(),
+         binaryMs);
+  printf("%s\n", ok ? "binary file matches" : "binary file DIFFERS");
+  return ok ? 0 : 1;
+}
+
+// Simulates the blob on a subdivided icosphere and sends its positions
+// through StateEncoder and StateDecoder as the renderers would, dropping a
+// share of the packets. Reports the bytes per frame and the renderer's error,
+// and how long a renderer joining halfway takes to catch up.
+void loopback(int subdivisions, int frames, size_t packetBytes,
+              int lossPercent) {
+  SearchPaths searchPaths;
+  searchPaths.addSearchPath(".", false);
+  searchPaths.addSearchPath("/alloshare/blob", false);
+  searchPaths.addAppPaths();
+
+  Mesh mesh;
+  NeighborTable nn;
+  if (!load(searchPaths.find("162.ico").filepath(), mesh, nn)) {
+    std::cout << "cannot find 162.ico" << std::endl;
+    return;
+  }
+  for (int i = 0; i < subdivisions; ++i)
+    subdivide(mesh, nn);
+  reorder(mesh, nn, bandwidthOrder(nn));
+  int n = mesh.vertices().size();
+
+  ThreadPool pool;
+  BlobSolver solver;
+  solver.init(mesh.vertices(), nn);
+  StateEncoder encoder;
+  encoder.refreshCount = std::max(1, int(packetBytes / 4 / 6)); // As the app
+  encoder.init(mesh.vertices());
+  StateDecoder decoder, lateDecoder;
+  decoder.init(mesh.vertices());
+  lateDecoder.init(mesh.vertices());
+
+  std::vector<Vec3f> p = mesh.vertices(), received = p, late = p;
+  std::vector<unsigned char> packet(packetBytes);
+  // Largest error of a vertex that is up to date: off by the tolerance plus
+  // rounding, in each coordinate
+  float quantum = encoder.range / 32767.f;
+  float bound = (encoder.tolerance + quantum) * std::sqrt(3.f);
+
+  auto maxError = [&](const std::vector<Vec3f> &q) {
+    float e = 0;
+    for (int i = 0; i < n; ++i)
+      e = std::max(e, (q[i] - p[i]).mag());
+    return e;
+  };
+
+  double bytes = 0, sumError = 0, worstError = 0;
+  size_t maxBytes = 0;
+  int lateStart = frames / 2, lateCaughtUp = -1, backlogFrames = 0;
+  for (int frame = 0; frame < frames; ++frame) {
+    if (frame % 60 == 0) {
+      int v = counter_rnd::bits(counter_rnd::key(1, frame, 0), 0) % n;
+      solver.poke(p.data(), v,
+                  counter_rnd::ball<Vec3f>(counter_rnd::key(1, frame, 1)));
+    }
+    solver.step(p.data(), pool);
+
+    size_t size = encoder.encode(p.data(), packet.data(), packet.size());
+    bytes += size;
+    maxBytes = std::max(maxBytes, size);
+    backlogFrames += encoder.pending() > 0;
+
+    bool lost = counter_rnd::uniform(counter_rnd::key(2, frame, 0), 0) * 100 <
+                lossPercent;
+    if (!lost) {
+      decoder.decode(packet.data(), size, received.data());
+      if (frame >= lateStart)
+        lateDecoder.decode(packet.data(), size, late.data());
+    }
+    float error = maxError(received);
+    sumError += error;
+    worstError = std::max(worstError, double(error));
+    if (frame >= lateStart && lateCaughtUp < 0 && maxError(late) <= bound)
+      lateCaughtUp = frame - lateStart + 1;
+  }
+
+  printf("%d vertices, %d frames, %zu byte packets, %d%% lost\n", n, frames,
+         packetBytes, lossPercent);
+  printf("full array      %10zu bytes/frame\n", n * sizeof(Vec3f));
+  printf("packets         %10.0f bytes/frame average, %zu largest\n",
+         bytes / frames, maxBytes);
+  printf("frames with vertices left for the next packet: %d\n",
+         backlogFrames);
+  printf("renderer error  %.2e average, %.2e largest (up to date %.2e)\n",
+         sumError / frames, worstError, bound);
+  if (lateCaughtUp >= 0)
+    printf("a renderer joining at frame %d caught up after %d frames\n",
+           lateStart, lateCaughtUp);
+  else
+    printf("a renderer joining at frame %d did not catch up\n", lateStart);
+}
+
+// Simulates the blob publishing its state at publishHz to a renderer drawing
+// at renderHz, with each state delayed by 5 ms plus up to jitterMs and a
+// share of them lost. Compares drawing the latest state received with
+// drawing from a StateHistory: judder is the RMS change in vertex velocity
+// between frames, against that of the simulation drawn smoothly.
+void replay(double publishHz, double renderHz, int lossPercent,
+             double jitterMs) {
+  SearchPaths searchPaths;
+  searchPaths.addSearchPath(".", false);
+  searchPaths.addSearchPath("/alloshare/blob", false);
+  searchPaths.addAppPaths();
+
+  Mesh mesh;
+  NeighborTable nn;
+  if (!load(searchPaths.find("162.ico").filepath(), mesh, nn)) {
+    std::cout << "cannot find 162.ico" << std::endl;
+    return;
+  }
+  int n = mesh.vertices().size();
+  const double seconds = 20;
+
+  // Every state the simulator publishes, and when each arrives
+  ThreadPool pool;
+  BlobSolver solver;
+  solver.init(mesh.vertices(), nn);
+  int numStates = int(seconds * publishHz);
+  std::vector<BlobFrame> states(numStates);
+  std::vector<std::pair<double, int>> arrivals;
+  std::vector<Vec3f> p = mesh.vertices();
+  for (int k = 0; k < numStates; ++k) {
+    if (k % int(publishHz) == 0) {
+      int v = counter_rnd::bits(counter_rnd::key(1, k, 0), 0) % n;
+      solver.poke(p.data(), v,
+                  counter_rnd::ball<Vec3f>(counter_rnd::key(1, k, 1)));
+    }
+    solver.step(p.data(), pool);
+    states[k].positions = p;
+    bool lost =
+        counter_rnd::uniform(counter_rnd::key(2, k, 0), 0) * 100 < lossPercent;
+    double latency = 0.005 + jitterMs * 1e-3 * counter_rnd::uniform(
+                                                   counter_rnd::key(2, k, 1), 0);
+    if (!lost)
+      arrivals.push_back({k / publishHz + latency, k});
+  }
+  std::sort(arrivals.begin(), arrivals.end());
+
+  // The simulation at time t, drawn smoothly from every state
+  auto truth = [&](double t, BlobFrame &out) {
+    double x = std::max(0., std::min(t * publishHz, numStates - 1.));
+    int k = std::min(int(x), numStates - 2);
+    blendFrames(states[k], states[k + 1], float(x - k), out, pool);
+  };
+
+  // Sums the squared second difference of the positions drawn
+  struct Judder {
+    std::vector<Vec3f> a, b;
+    double sum = 0;
+    long long count = 0;
+    void add(const std::vector<Vec3f> &c) {
+      if (!a.empty()) {
+        for (size_t i = 0; i < c.size(); ++i)
+          sum += (c[i] - b[i] * 2 + a[i]).magSqr();
+        ++count;
+      }
+      a.swap(b);
+      b = c;
+    }
+    double rms() const { return std::sqrt(sum / std::max(1LL, count)); }
+  };
+
+  StateHistory<BlobFrame> history;
+  history.delay = 1.5 / publishHz;
+  BlobFrame latest = states[0], drawn, ideal;
+  Judder latestJudder, historyJudder, idealJudder;
+  double sumError = 0, worstError = 0;
+  size_t next = 0;
+  int numFrames = int(seconds * renderHz), measured = 0;
+  for (int frame = 0; frame < numFrames; ++frame) {
+    double now = frame / renderHz;
+    for (; next < arrivals.size() && arrivals[next].first <= now; ++next) {
+      const BlobFrame &state = states[arrivals[next].second];
+      latest = state; // As copying state() does, even if it is older
+      history.push(state, arrivals[next].second / publishHz, now);
+    }
+    auto blend = [&](const BlobFrame &a, const BlobFrame &b, float t,
+                     BlobFrame &out) { blendFrames(a, b, t, out, pool); };
+    if (!history.sample(now, drawn, blend))
+      continue;
+    truth(history.drawTime(now), ideal);
+    latestJudder.add(latest.positions);
+    historyJudder.add(drawn.positions);
+    idealJudder.add(ideal.positions);
+
+    float error = 0;
+    for (int i = 0; i < n; ++i)
+      error = std::max(error, (drawn.positions[i] - ideal.positions[i]).mag());
+    sumError += error;
+    worstError = std::max(worstError, double(error));
+    ++measured;
+  }
+
+  auto &stats = history.stats();
+  printf("%d vertices, states at %g Hz, frames at %g Hz, %d%% lost, "
+         "%g ms jitter\n",
+         n, publishHz, renderHz, lossPercent, jitterMs);
+  printf("judder      latest state %.3e   history %.3e   smooth %.3e\n",
+         latestJudder.rms(), historyJudder.rms(), idealJudder.rms());
+  printf("history error against smooth  %.2e average, %.2e largest\n",
+         sumError / std::max(1, measured), worstError);
+  printf("states %lld received, %lld stale, %lld restarts; frames %lld "
+         "interpolated, %lld extrapolated, %lld held\n",
+         stats.received, stats.stale, stats.restarts, stats.interpolated,
+         stats.extrapolated, stats.held);
+}
+
+int main(int argc, char *argv[]) {
+  if (argc > 1 && std::string(argv[1]) == "-bench") {
+    benchmark(argc > 2 ? std::stoi(argv[2]) : 5,
+              argc > 3 ? std::stoi(argv[3]) : 0);
+    return 0;
+  }
+  if (argc > 1 && std::string(argv[1]) == "-loopback") {
+    loopback(argc > 2 ? std::stoi(argv[2]) : 5,
+             argc > 3 ? std::stoi(argv[3]) : 600,
+             argc > 4 ? std::stoi(argv[4]) : kPacketBytes,
+             argc > 5 ? std::stoi(argv[5]) : 0);
+    return 0;
+  }
+  if (argc > 1 && std::string(argv[1]) == "-history") {
+    replay(argc > 2 ? std::stod(argv[2]) : 30,
+            argc > 3 ? std::stod(argv[3]) : 60,
+            argc > 4 ? std::stoi(argv[4]) : 5,
+            argc > 5 ? std::stod(argv[5]) : 10);
+    return 0;
+  }
+  if (argc > 3 && std::string(argv[1]) == "-convert")
+    return convert(argv[2], argv[3]);
+
   Blob blob;
   blob.start();
   return 0;
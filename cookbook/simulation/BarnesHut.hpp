@@ -0,0 +1,260 @@
+#pragma once
+#ifndef BarnesHut_H
+#define BarnesHut_H
+
+// Barnes-Hut approximation of the mutual gravity of N equal mass bodies.
+//
+// Bodies are sorted into an octree whose nodes store their total mass and
+// center of mass. A node that looks small from where the force is evaluated
+// (node size / distance < theta) acts as a single body, so each evaluation
+// costs O(log N) instead of O(N). theta = 0 gives the exact direct sum.
+//
+// The distance is to the node's center of mass, which a point inside the
+// node can be up to sqrt(3) sizes from. Past theta = 1/sqrt(3) a node holding
+// the point could pass the test and act as one body, the point's own mass
+// included, so nodes whose cube contains the point are always opened. theta
+// is also limited to maxTheta; above about 1 the error grows quickly.
+//
+// Gravity is Plummer softened, a = G m r / (|r|^2 + eps^2)^(3/2), which keeps
+// close encounters finite and makes a body exert no force on itself.
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "al/math/al_Vec.hpp"
+
+#include "playground/ThreadPool.hpp"
+
+class BarnesHut {
+public:
+  static constexpr float maxTheta = 1.0f;
+
+  float theta = 0.5f;      // Opening angle, in [0, maxTheta]
+  float softening = 0.05f; // Plummer softening length
+  float mass = 1e-4f;      // Gravitational constant times mass of one body
+  int leafSize = 8;        // Maximum number of bodies in a leaf
+  int maxDepth = 24;       // Coincident bodies stop splitting here
+
+  struct Node {
+    al::Vec3f center{0};    // Center of the node's cube
+    float halfSize = 0;     // Half the side length of the cube
+    al::Vec3f com{0};       // Center of mass
+    float mass = 0;         // Total mass
+    int begin = 0, end = 0; // Range of bodies in sorted order
+    int firstChild = -1;    // Index of the first child; children are contiguous
+    int numChildren = 0;    // Number of non-empty children; 0 for leaves
+  };
+
+  // Builds the tree over n bodies, where pos(i) returns the i-th position
+  template <class GetPos> void build(int n, GetPos pos) {
+    mIndex.resize(n);
+    mTemp.resize(n);
+    mSorted.resize(n);
+    mNodes.clear();
+    if (n == 0)
+      return;
+
+    al::Vec3f lo = pos(0), hi = pos(0);
+    for (int i = 0; i < n; ++i) {
+      mIndex[i] = i;
+      mSorted[i] = pos(i);
+      for (int k = 0; k < 3; ++k) {
+        lo[k] = std::min(lo[k], mSorted[i][k]);
+        hi[k] = std::max(hi[k], mSorted[i][k]);
+      }
+    }
+
+    Node root;
+    root.center = (lo + hi) * 0.5f;
+    root.halfSize =
+        std::max(std::max(hi.x - lo.x, hi.y - lo.y), hi.z - lo.z) * 0.5f +
+        1e-6f;
+    root.begin = 0;
+    root.end = n;
+    mNodes.push_back(root);
+    buildNode(0, 0);
+
+    // Store positions in tree order so leaves are read contiguously
+    for (int k = 0; k < n; ++k)
+      mSorted[k] = pos(mIndex[k]);
+  }
+
+  // Acceleration at p due to all bodies, using the tree
+  al::Vec3f acceleration(const al::Vec3f &p) const {
+    al::Vec3f acc(0);
+    if (mNodes.empty())
+      return acc;
+
+    float theta2 = openingAngle2();
+    float eps2 = softening * softening;
+    int stack[512];
+    int top = 0;
+    stack[top++] = 0;
+
+    while (top > 0) {
+      const Node &node = mNodes[stack[--top]];
+      al::Vec3f d = node.com - p;
+      float r2 = d.magSqr();
+
+      if (isFar(node, p, r2, theta2)) {
+        // Far enough away to act as one body
+        acc += pull(d, r2 + eps2, node.mass);
+      } else if (node.numChildren == 0) {
+        for (int k = node.begin; k < node.end; ++k) {
+          al::Vec3f dk = mSorted[k] - p;
+          acc += pull(dk, dk.magSqr() + eps2, mass);
+        }
+      } else {
+        for (int c = 0; c < node.numChildren; ++c)
+          stack[top++] = node.firstChild + c;
+      }
+    }
+    return acc;
+  }
+
+  // Potential at p due to all bodies, using the tree. A body evaluated at its
+  // own position includes its self term -mass / softening.
+  float potential(const al::Vec3f &p) const {
+    float phi = 0;
+    if (mNodes.empty())
+      return phi;
+
+    float theta2 = openingAngle2();
+    float eps2 = softening * softening;
+    int stack[512];
+    int top = 0;
+    stack[top++] = 0;
+
+    while (top > 0) {
+      const Node &node = mNodes[stack[--top]];
+      float r2 = (node.com - p).magSqr();
+
+      if (isFar(node, p, r2, theta2)) {
+        phi -= node.mass / std::sqrt(r2 + eps2);
+      } else if (node.numChildren == 0) {
+        for (int k = node.begin; k < node.end; ++k)
+          phi -= mass / std::sqrt((mSorted[k] - p).magSqr() + eps2);
+      } else {
+        for (int c = 0; c < node.numChildren; ++c)
+          stack[top++] = node.firstChild + c;
+      }
+    }
+    return phi;
+  }
+
+  // Acceleration at p by summing over every body; the reference for
+  // validating acceleration()
+  al::Vec3f accelerationDirect(const al::Vec3f &p) const {
+    al::Vec3f acc(0);
+    float eps2 = softening * softening;
+    for (auto &q : mSorted) {
+      al::Vec3f d = q - p;
+      acc += pull(d, d.magSqr() + eps2, mass);
+    }
+    return acc;
+  }
+
+  // Writes the acceleration of every body into acc, split across the pool.
+  // Bodies are visited in tree order so neighboring evaluations walk the
+  // same parts of the tree.
+  void accelerations(ThreadPool &pool, std::vector<al::Vec3f> &acc) const {
+    acc.resize(mSorted.size());
+    pool.parallelFor(0, mSorted.size(), [&](int begin, int end, int) {
+      for (int k = begin; k < end; ++k)
+        acc[mIndex[k]] = acceleration(mSorted[k]);
+    });
+  }
+
+  const std::vector<Node> &nodes() const { return mNodes; }
+  int size() const { return mSorted.size(); }
+
+private:
+  // Square of theta, limited to [0, maxTheta]
+  float openingAngle2() const {
+    float t = theta < 0 ? 0 : theta > maxTheta ? maxTheta : theta;
+    return t * t;
+  }
+
+  // Whether node can act as one body at p, r2 from its center of mass
+  static bool isFar(const Node &node, const al::Vec3f &p, float r2,
+                    float theta2) {
+    float size = 2 * node.halfSize;
+    if (size * size >= theta2 * r2)
+      return false;
+    // Opened if p is inside the node's cube
+    for (int k = 0; k < 3; ++k)
+      if (std::abs(p[k] - node.center[k]) > node.halfSize)
+        return true;
+    return false;
+  }
+
+  static al::Vec3f pull(const al::Vec3f &d, float r2soft, float m) {
+    return d * (m / (r2soft * std::sqrt(r2soft)));
+  }
+
+  void buildNode(int nodeIndex, int depth) {
+    // Copy, as mNodes may reallocate while adding children
+    Node node = mNodes[nodeIndex];
+
+    node.com = al::Vec3f(0);
+    for (int k = node.begin; k < node.end; ++k)
+      node.com += mSorted[mIndex[k]];
+    node.com /= float(node.end - node.begin);
+    node.mass = mass * (node.end - node.begin);
+    node.firstChild = -1;
+    node.numChildren = 0;
+
+    if (node.end - node.begin <= leafSize || depth >= maxDepth) {
+      mNodes[nodeIndex] = node;
+      return;
+    }
+
+    // Counting sort of the node's bodies into octants
+    int count[9] = {0};
+    for (int k = node.begin; k < node.end; ++k)
+      ++count[octant(node, mSorted[mIndex[k]]) + 1];
+    for (int o = 0; o < 8; ++o)
+      count[o + 1] += count[o];
+    int fill[8];
+    for (int o = 0; o < 8; ++o)
+      fill[o] = node.begin + count[o];
+    for (int k = node.begin; k < node.end; ++k) {
+      int i = mIndex[k];
+      mTemp[fill[octant(node, mSorted[i])]++] = i;
+    }
+    std::copy(mTemp.begin() + node.begin, mTemp.begin() + node.end,
+              mIndex.begin() + node.begin);
+
+    node.firstChild = mNodes.size();
+    float h = node.halfSize * 0.5f;
+    for (int o = 0; o < 8; ++o) {
+      if (count[o + 1] == count[o])
+        continue;
+      Node child;
+      child.center = node.center + al::Vec3f(o & 1 ? h : -h, o & 2 ? h : -h,
+                                             o & 4 ? h : -h);
+      child.halfSize = h;
+      child.begin = node.begin + count[o];
+      child.end = node.begin + count[o + 1];
+      mNodes.push_back(child);
+      ++node.numChildren;
+    }
+    mNodes[nodeIndex] = node;
+
+    for (int c = 0; c < node.numChildren; ++c)
+      buildNode(node.firstChild + c, depth + 1);
+  }
+
+  static int octant(const Node &node, const al::Vec3f &p) {
+    return (p.x > node.center.x) | ((p.y > node.center.y) << 1) |
+           ((p.z > node.center.z) << 2);
+  }
+
+  std::vector<Node> mNodes;
+  std::vector<int> mIndex;         // Body indices in tree order
+  std::vector<int> mTemp;          // Scratch space for sorting
+  std::vector<al::Vec3f> mSorted;  // Body positions (in tree order after build)
+};
+
+#endif
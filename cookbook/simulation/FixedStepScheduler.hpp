@@ -0,0 +1,221 @@
+#pragma once
+#ifndef FixedStepScheduler_H
+#define FixedStepScheduler_H
+
+// Runs a simulation at a fixed time step on its own thread.
+//
+// A worker thread wakes every `interval` seconds of wall-clock time, works out
+// how many steps of `step` simulated seconds have come due and runs them, then
+// publishes a snapshot of the state. The render thread reads the two newest
+// snapshots and blends between them, so motion stays smooth when the step
+// rate and frame rate differ, and a slow frame no longer changes the
+// simulation: it keeps stepping on schedule.
+//
+// If a wake-up finds more than maxCatchUp steps due, because steps are slower
+// than real time or the thread was starved, it runs maxCatchUp of them and
+// drops the rest, so the simulation falls behind the clock instead of
+// spiraling. These overruns are counted in stats().
+//
+//   FixedStepScheduler<Snapshot> scheduler;
+//   scheduler.start([&](double dt) { sim.step(dt); },        // worker thread
+//                   [&](Snapshot &s) { s.copyFrom(sim); });   // worker thread
+//
+//   // in onAnimate or onDraw
+//   scheduler.read([&](const Snapshot &a, const Snapshot &b, float t) {
+//     // draw the state blended from a to b by t in [0, 1]
+//   });
+//
+// Anything else that touches the simulation, like a key press, should be
+// passed to post() to run on the worker between steps. Five snapshots are
+// kept, so the worker never waits for the render thread.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+template <class Snapshot> class FixedStepScheduler {
+public:
+  typedef std::chrono::steady_clock Clock;
+
+  double step = 1. / 120;     // Simulated seconds per step
+  double interval = 1. / 240; // Wall-clock seconds between wake-ups
+  double timeScale = 1;       // Simulated seconds per wall-clock second
+  int maxCatchUp = 8;         // Most steps run in one wake-up
+
+  struct Stats {
+    long long steps = 0;        // Steps run
+    long long wakeUps = 0;      // Wake-ups that ran at least one step
+    long long overruns = 0;     // Wake-ups that had more than maxCatchUp due
+    long long droppedSteps = 0; // Steps skipped by overruns
+    double simTime = 0;         // Simulated seconds so far
+    double stepTime = 0;        // Wall-clock seconds spent stepping
+    double maxWakeTime = 0;     // Longest wake-up, in wall-clock seconds
+  };
+
+  ~FixedStepScheduler() { stop(); }
+
+  // Starts the worker. advance(dt) steps the simulation and capture(s) copies
+  // its state into a snapshot; both are only called on the worker.
+  void start(std::function<void(double)> advance,
+             std::function<void(Snapshot &)> capture) {
+    stop();
+    mAdvance = advance;
+    mCapture = capture;
+    mQuit = false;
+    publish(); // so there is something to draw right away
+    mThread = std::thread([this]() { workerLoop(); });
+  }
+
+  void stop() {
+    if (!mThread.joinable())
+      return;
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mQuit = true;
+    }
+    mThread.join();
+  }
+
+  bool running() const { return mThread.joinable(); }
+
+  // Runs fn on the worker before its next steps
+  void post(std::function<void()> fn) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mPosted.push_back(fn);
+  }
+
+  // Calls fn(older, newer, t) with the two newest snapshots and how far
+  // between them the current moment is. This trails the newest snapshot by
+  // about one wake-up. Returns false if nothing has been published yet.
+  template <class Fn> bool read(Fn fn) {
+    int a, b;
+    Clock::time_point ta, tb;
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      if (mNewer < 0)
+        return false;
+      a = mReadOlder = mOlder;
+      b = mReadNewer = mNewer;
+      ta = mPublished[a];
+      tb = mPublished[b];
+    }
+
+    float t = 1;
+    double span = std::chrono::duration<double>(tb - ta).count();
+    if (span > 0) {
+      double since = std::chrono::duration<double>(Clock::now() - tb).count();
+      t = float(std::min(1., std::max(0., since / span)));
+    }
+    fn(mSlots[a], mSlots[b], t);
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    mReadOlder = mReadNewer = -1;
+    return true;
+  }
+
+  Stats stats() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mStats;
+  }
+
+  // Advances the schedule by `elapsed` wall-clock seconds: runs the due steps
+  // up to maxCatchUp and publishes a snapshot if any ran. The worker calls
+  // this on every wake-up; call it directly to drive the scheduler without a
+  // thread, e.g. to test it or to render offline.
+  void tick(double elapsed) {
+    runPosted();
+    mOwed += elapsed * timeScale;
+    long long due = (long long)std::floor(mOwed / step);
+    if (due <= 0)
+      return;
+    int run = int(std::min<long long>(due, maxCatchUp));
+    mOwed -= due * step; // dropped steps are forgotten, not owed
+
+    auto t0 = Clock::now();
+    for (int i = 0; i < run; ++i)
+      mAdvance(step);
+    publish();
+    double busy = std::chrono::duration<double>(Clock::now() - t0).count();
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStats.steps += run;
+    mStats.wakeUps += 1;
+    if (due > run) {
+      mStats.overruns += 1;
+      mStats.droppedSteps += due - run;
+    }
+    mStats.simTime += run * step;
+    mStats.stepTime += busy;
+    mStats.maxWakeTime = std::max(mStats.maxWakeTime, busy);
+  }
+
+private:
+  static const int kSlots = 5; // older, newer, two being read, one writing
+
+  void workerLoop() {
+    auto last = Clock::now();
+    auto wake = last;
+    while (true) {
+      {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mQuit)
+          return;
+      }
+      wake += std::chrono::duration_cast<Clock::duration>(
+          std::chrono::duration<double>(interval));
+      auto now = Clock::now();
+      if (wake < now)
+        wake = now; // don't try to make up for missed wake-ups
+      std::this_thread::sleep_until(wake);
+
+      now = Clock::now();
+      tick(std::chrono::duration<double>(now - last).count());
+      last = now;
+    }
+  }
+
+  void runPosted() {
+    std::vector<std::function<void()>> posted;
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      posted.swap(mPosted);
+    }
+    for (auto &fn : posted)
+      fn();
+  }
+
+  // Captures into a slot nobody is using and makes it the newest
+  void publish() {
+    int w = 0;
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      while (w == mOlder || w == mNewer || w == mReadOlder || w == mReadNewer)
+        ++w;
+    }
+    mCapture(mSlots[w]);
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    mOlder = mNewer < 0 ? w : mNewer;
+    mNewer = w;
+    mPublished[w] = Clock::now();
+  }
+
+  std::function<void(double)> mAdvance;
+  std::function<void(Snapshot &)> mCapture;
+  std::vector<std::function<void()>> mPosted;
+  Snapshot mSlots[kSlots];
+  Clock::time_point mPublished[kSlots];
+  int mOlder = -1, mNewer = -1;         // Published snapshots
+  int mReadOlder = -1, mReadNewer = -1; // Snapshots being read
+  double mOwed = 0;                     // Simulated seconds due
+  Stats mStats;
+  std::thread mThread;
+  std::mutex mMutex;
+  bool mQuit = false;
+};
+
+#endif
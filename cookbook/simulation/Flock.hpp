@@ -0,0 +1,503 @@
+#pragma once
+#ifndef Flock_H
+#define Flock_H
+
+// The flock of flocking.cpp, without graphics. See flocking.cpp for a
+// description of the algorithm and its neighbor grid and vectorized kernel.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "al/math/al_Functions.hpp"
+#include "al/math/al_Vec.hpp"
+
+#include "playground/CounterRandom.hpp"
+#include "playground/ThreadPool.hpp"
+
+// A "boid" (play on bird) is one member of a flock.
+class Boid {
+ public:
+  // Each boid has a position and velocity.
+  al::Vec2d pos, vel;
+
+  // Update position based on velocity and delta time
+  void update(double dt) { pos += vel * dt; }
+};
+
+// A uniform grid of square cells covering the [-1,1]^2 box.
+// Boids are binned with a counting sort, so rebuilding is O(N) and does not
+// allocate once the arrays have grown to the flock size. Boids that stray
+// outside the box are clamped into the border cells.
+// Cells are a fraction of the cutoff wide, so the flockmates of a boid lie
+// within kReach cells of its own. Scanning the (2 kReach + 1)^2 block of
+// cells around a boid covers (2.5 cutoff)^2 rather than the (3 cutoff)^2 of
+// cells one cutoff wide.
+class NeighborGrid {
+ public:
+  static const int kReach = 2;  // Cells spanned by the cutoff distance
+  int res = 1;                  // Number of cells along each side
+  double cellSize = 2;          // Side length of a cell
+  std::vector<int> cellStart;   // Offset of each cell into sorted (res^2 + 1)
+  std::vector<int> sorted;      // Boid indices ordered by cell
+  std::vector<int> cellOfBoid;  // Cell index of each boid
+
+  // Cells will be at least minCellSize wide
+  void build(const std::vector<Boid>& boids, double minCellSize) {
+    res = std::max(1, std::min(1024, int(2. / minCellSize)));
+    cellSize = 2. / res;
+
+    int Nc = res * res;
+    int Nb = boids.size();
+    cellStart.assign(Nc + 1, 0);
+    sorted.resize(Nb);
+    cellOfBoid.resize(Nb);
+
+    // Count boids per cell
+    for (int i = 0; i < Nb; ++i) {
+      int c = cellAt(boids[i].pos);
+      cellOfBoid[i] = c;
+      ++cellStart[c + 1];
+    }
+
+    // Prefix sum gives the start of each cell
+    for (int c = 0; c < Nc; ++c) cellStart[c + 1] += cellStart[c];
+
+    // Scatter boid indices into their cells, keeping them in index order
+    mFill.assign(cellStart.begin(), cellStart.end() - 1);
+    for (int i = 0; i < Nb; ++i) sorted[mFill[cellOfBoid[i]]++] = i;
+  }
+
+  int cellCoord(double x) const {
+    int c = int((x + 1.) / cellSize);
+    return c < 0 ? 0 : (c >= res ? res - 1 : c);
+  }
+
+  int cellAt(const al::Vec2d& p) const {
+    return cellCoord(p.y) * res + cellCoord(p.x);
+  }
+
+  int begin(int cell) const { return cellStart[cell]; }
+  int end(int cell) const { return cellStart[cell + 1]; }
+
+ private:
+  std::vector<int> mFill;
+};
+
+// Fast exp(x) for x in [-87, 0], accurate to about 3e-6 relative error.
+// Written without branches or library calls so loops over it vectorize.
+inline float fastExp(float x) {
+  float t = x * 1.442695041f;  // log2(e)
+  // Round to nearest integer by adding and removing 1.5 * 2^23
+  float n = (t + 12582912.f) - 12582912.f;
+  float f = t - n;  // in [-0.5, 0.5]
+  // 2^f by its Taylor series
+  float p = 1.f + f * (0.6931472f + f * (0.2402265f + f * (0.05550411f +
+                  f * (0.009618129f + f * 0.001333355f))));
+  // 2^n by writing the exponent bits directly
+  int32_t bits = (int32_t(n) + 127) << 23;
+  float scale;
+  std::memcpy(&scale, &bits, sizeof(scale));
+  return p * scale;
+}
+
+// Fast 1/sqrt(x) for x > 0 using two Newton steps, about 5e-6 relative error
+inline float fastInvSqrt(float x) {
+  int32_t bits;
+  std::memcpy(&bits, &x, sizeof(bits));
+  bits = 0x5f3759df - (bits >> 1);
+  float y;
+  std::memcpy(&y, &bits, sizeof(y));
+  y = y * (1.5f - 0.5f * x * y * y);
+  y = y * (1.5f - 0.5f * x * y * y);
+  return y;
+}
+
+// Structure-of-arrays copy of the flock in single precision.
+// Boids are stored in grid cell order, so that the flockmates in a row of
+// neighboring cells are contiguous.
+struct FlockSoA {
+  std::vector<float> x, y, vx, vy;
+
+  void resize(int n) {
+    x.resize(n);
+    y.resize(n);
+    vx.resize(n);
+    vy.resize(n);
+  }
+};
+
+// Constants of the batched interaction kernel
+struct KernelParams {
+  float cutoffSqr;     // Squared cutoff distance
+  float expMaxSqr;     // Squared distance past which both kernels are ~0
+  float invPushSqr;    // 1 / pushRadius^2
+  float pushStrength;  // Strength of collision avoidance
+  float invMatchSqr;   // 1 / matchRadius^2
+};
+
+// Interaction sums of one boid with its flockmates
+struct PairSums {
+  float px = 0, py = 0;  // Collision avoidance displacement
+  float w = 0;           // Total velocity matching weight
+  float mx = 0, my = 0;  // Weighted sum of flockmate velocities
+};
+
+// Bit pattern of a float. For x >= 0, ordering the bit patterns as integers
+// orders the floats, and integer compares (unlike float compares, which may
+// trap) are turned into branch-free selects by the vectorizer.
+inline int32_t floatBits(float x) {
+  int32_t bits;
+  std::memcpy(&bits, &x, sizeof(bits));
+  return bits;
+}
+
+// Accumulates the interactions of the boid at (xi, yi) with flockmates
+// [begin, end) of the store. Only the boid itself is written, so flockmates
+// are read in batches of kLanes with a fixed number of independent partial
+// sums per lane. This maps onto one AVX2 or two NEON registers per quantity.
+inline void accumulatePairs(const FlockSoA& s, int begin, int end, float xi,
+                            float yi, const KernelParams& k, PairSums& sums) {
+  static const int kLanes = 8;
+  float px[kLanes] = {0}, py[kLanes] = {0}, w[kLanes] = {0};
+  float mx[kLanes] = {0}, my[kLanes] = {0};
+
+  int32_t cutoffBits = floatBits(k.cutoffSqr);
+  int32_t expMaxBits = floatBits(k.expMaxSqr);
+
+  auto lane = [&](int l, int j) {
+    float dx = xi - s.x[j];
+    float dy = yi - s.y[j];
+    float d2 = dx * dx + dy * dy;
+    int32_t d2Bits = floatBits(d2);
+    // Skip the boid itself (and exact overlaps) and anything past the cutoff
+    float inside = float((d2Bits > 0) & (d2Bits < cutoffBits));
+    // Keep the exp arguments in range
+    int32_t d2ClampBits = d2Bits < expMaxBits ? d2Bits : expMaxBits;
+    float d2c;
+    std::memcpy(&d2c, &d2ClampBits, sizeof(d2c));
+    float push = fastExp(-d2c * k.invPushSqr) * k.pushStrength * inside *
+                 fastInvSqrt(d2 + 1e-30f);
+    float near = 0.5f * fastExp(-d2c * k.invMatchSqr) * inside;
+    px[l] += push * dx;
+    py[l] += push * dy;
+    w[l] += near;
+    mx[l] += near * s.vx[j];
+    my[l] += near * s.vy[j];
+  };
+
+  int j = begin;
+  for (; j + kLanes <= end; j += kLanes) {
+    for (int l = 0; l < kLanes; ++l) lane(l, j + l);
+  }
+  for (int l = 0; j < end; ++j, ++l) lane(l, j);
+
+  for (int l = 0; l < kLanes; ++l) {
+    sums.px += px[l];
+    sums.py += py[l];
+    sums.w += w[l];
+    sums.mx += mx[l];
+    sums.my += my[l];
+  }
+}
+
+// The flock simulation, independent of any window or graphics
+struct Flock {
+  std::vector<Boid> boids;
+
+  double pushRadius = 0.05;    // Radius of collision avoidance
+  double pushStrength = 1;     // Strength of collision avoidance
+  double matchRadius = 0.125;  // Radius of velocity matching
+  double cutoff = 2.5;         // Interaction cutoff, in units of matchRadius
+  float huntUrge = 0.2f;       // Strength of random "hunting" motion
+  bool bruteForce = false;     // Compare all pairs instead of using the grid
+  bool vectorized = false;     // Use the batched single precision kernel
+
+  // Random numbers are a function of the seed, step count and boid index,
+  // so runs with the same seed are identical
+  uint64_t seed = 1;
+  uint64_t steps = 0;
+
+  NeighborGrid grid;
+  FlockSoA soa;
+  std::vector<PairSums> sums;
+  std::vector<Boid> next;  // Next state of the double buffered step
+  std::unique_ptr<ThreadPool> pool;
+
+  int size() const { return boids.size(); }
+
+  // Randomize boid positions/velocities uniformly inside unit disc
+  void reset(int numBoids, uint64_t newSeed) {
+    seed = newSeed;
+    steps = 0;
+    boids.resize(numBoids);
+    for (int i = 0; i < numBoids; ++i) {
+      boids[i].pos = counter_rnd::ball<al::Vec2f>(counter_rnd::key(seed, 0, i, 0));
+      boids[i].vel = counter_rnd::ball<al::Vec2f>(counter_rnd::key(seed, 0, i, 2));
+    }
+  }
+
+  // Distance past which two boids do not interact. At the default of 2.5
+  // radii both Gaussians are below e^-6.
+  double cutoffDistance() const {
+    return cutoff * std::max(pushRadius, matchRadius);
+  }
+
+  // Bins the boids into cells of a kReach-th of the cutoff distance
+  void buildGrid() {
+    grid.build(boids, cutoffDistance() / NeighborGrid::kReach);
+  }
+
+  // Interaction between boids i and j
+  void interact(Boid& bi, Boid& bj) {
+    auto ds = bi.pos - bj.pos;
+    auto dist = ds.mag();
+
+    // Collision avoidance
+    double push = std::exp(-al::pow2(dist / pushRadius)) * pushStrength;
+
+    auto pushVector = ds.normalized() * push;
+    bi.pos += pushVector;
+    bj.pos -= pushVector;
+
+    // Velocity matching
+    double nearness = std::exp(-al::pow2(dist / matchRadius));
+    al::Vec2d veli = bi.vel;
+    al::Vec2d velj = bj.vel;
+
+    // Take a weighted average of velocities according to nearness
+    bi.vel = veli * (1 - 0.5 * nearness) + velj * (0.5 * nearness);
+    bj.vel = velj * (1 - 0.5 * nearness) + veli * (0.5 * nearness);
+
+    // TODO: Flock centering
+  }
+
+  // Interact if the boids are closer than the cutoff distance
+  void interactNear(Boid& bi, Boid& bj, double cutoffSqr) {
+    if ((bi.pos - bj.pos).magSqr() < cutoffSqr) interact(bi, bj);
+  }
+
+  // Compute boid-boid interactions between every pair
+  void interactAllPairs() {
+    int Nb = size();
+    for (int i = 0; i < Nb - 1; ++i) {
+      for (int j = i + 1; j < Nb; ++j) {
+        interact(boids[i], boids[j]);
+      }
+    }
+  }
+
+  // Compute boid-boid interactions between boids in neighboring cells.
+  // Each pair of cells is visited once by only looking "forward": the cell
+  // itself, the kReach cells to its right and the 2 kReach + 1 cells of each
+  // of the kReach rows above.
+  void interactNeighbors() {
+    double cutoffSqr = al::pow2(cutoffDistance());
+    buildGrid();
+
+    const int R = NeighborGrid::kReach;
+    int res = grid.res;
+
+    for (int cy = 0; cy < res; ++cy) {
+      for (int cx = 0; cx < res; ++cx) {
+        int c = cy * res + cx;
+
+        // Pairs within the cell
+        for (int a = grid.begin(c); a < grid.end(c); ++a) {
+          Boid& bi = boids[grid.sorted[a]];
+          for (int b = a + 1; b < grid.end(c); ++b) {
+            interactNear(bi, boids[grid.sorted[b]], cutoffSqr);
+          }
+        }
+
+        // Pairs with neighboring cells
+        for (int ny = cy; ny <= std::min(cy + R, res - 1); ++ny) {
+          int nxBegin = ny == cy ? cx + 1 : std::max(cx - R, 0);
+          for (int nx = nxBegin; nx <= std::min(cx + R, res - 1); ++nx) {
+            int n = ny * res + nx;
+            for (int a = grid.begin(c); a < grid.end(c); ++a) {
+              Boid& bi = boids[grid.sorted[a]];
+              for (int b = grid.begin(n); b < grid.end(n); ++b) {
+                interactNear(bi, boids[grid.sorted[b]], cutoffSqr);
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+
+  KernelParams kernelParams() const {
+    KernelParams k;
+    k.cutoffSqr = al::pow2(cutoffDistance());
+    k.invPushSqr = 1. / al::pow2(pushRadius);
+    k.pushStrength = pushStrength;
+    k.invMatchSqr = 1. / al::pow2(matchRadius);
+    k.expMaxSqr = 87. * al::pow2(std::min(pushRadius, matchRadius));
+    return k;
+  }
+
+  // Range of the store holding the row of 2 kReach + 1 cells centered on
+  // (cx, cy)
+  void rowRange(int cx, int cy, int& begin, int& end) const {
+    const int R = NeighborGrid::kReach;
+    int res = grid.res;
+    begin = grid.begin(cy * res + std::max(cx - R, 0));
+    end = grid.end(cy * res + std::min(cx + R, res - 1));
+  }
+
+  // Calls fn(k, begin, end) for each row of cells around the boid at k in
+  // cell order, whose flockmates are [begin, end) of the store
+  template <class Fn>
+  void forEachRow(int begin, int end, Fn fn) const {
+    const int R = NeighborGrid::kReach;
+    int res = grid.res;
+    for (int k = begin; k < end; ++k) {
+      int c = grid.cellOfBoid[grid.sorted[k]];
+      int cx = c % res;
+      int cy = c / res;
+      for (int ny = std::max(cy - R, 0); ny <= std::min(cy + R, res - 1);
+           ++ny) {
+        int rowBegin, rowEnd;
+        rowRange(cx, ny, rowBegin, rowEnd);
+        fn(k, rowBegin, rowEnd);
+      }
+    }
+  }
+
+  // Mean number of flockmates the vectorized kernel looks at per boid, from
+  // the grid of the last step
+  double pairsPerBoid() const {
+    double pairs = 0;
+    forEachRow(0, size(),
+               [&](int, int begin, int end) { pairs += end - begin; });
+    return size() > 0 ? pairs / size() : 0;
+  }
+
+  // Computes the interaction sums of every boid from the positions and
+  // velocities at the start of the step. Sums are indexed in cell order.
+  // Each thread handles a contiguous run of cells and only writes the sums
+  // of its own boids.
+  void accumulateNeighbors() {
+    int Nb = size();
+    buildGrid();
+
+    soa.resize(Nb);
+    sums.resize(Nb);
+    KernelParams params = kernelParams();
+
+    threadPool().parallelFor(0, Nb, [&](int begin, int end, int) {
+      for (int k = begin; k < end; ++k) {
+        const Boid& b = boids[grid.sorted[k]];
+        soa.x[k] = b.pos.x;
+        soa.y[k] = b.pos.y;
+        soa.vx[k] = b.vel.x;
+        soa.vy[k] = b.vel.y;
+      }
+    });
+
+    threadPool().parallelFor(0, Nb, [&](int begin, int end, int) {
+      for (int k = begin; k < end; ++k) sums[k] = PairSums();
+      forEachRow(begin, end, [&](int k, int rowBegin, int rowEnd) {
+        accumulatePairs(soa, rowBegin, rowEnd, soa.x[k], soa.y[k], params,
+                        sums[k]);
+      });
+    });
+  }
+
+  // Vectorized counterpart of interactNeighbors. The flock is double
+  // buffered: interactions are read from the previous state and each boid's
+  // next state is written to its own slot in next, so boids can be updated
+  // in parallel and in any order. Since all boids see the flock as it was at
+  // the start of the step, velocity matching takes a weighted average of the
+  // boid's own velocity (weight 1) and those of its flockmates, which stays
+  // stable however crowded the flock gets.
+  void stepDoubleBuffered(double dt) {
+    accumulateNeighbors();
+    next.resize(size());
+
+    threadPool().parallelFor(0, size(), [&](int begin, int end, int) {
+      for (int k = begin; k < end; ++k) {
+        int i = grid.sorted[k];
+        const Boid& b = boids[i];
+        const PairSums& s = sums[k];
+        Boid& n = next[i];
+        n.pos = b.pos + al::Vec2d(s.px, s.py);
+        n.vel = (b.vel + al::Vec2d(s.mx, s.my)) / (1. + s.w);
+        behave(n, i, dt);
+      }
+    });
+
+    boids.swap(next);
+  }
+
+  // Update boid independent behaviors
+  void behave(Boid& b, int i, double dt) const {
+    // Random "hunting" motion
+    auto hunt = counter_rnd::ball<al::Vec2f>(counter_rnd::key(seed, steps, i, 1));
+    // Use cubed distribution to make small jumps more frequent
+    hunt *= hunt.magSqr();
+    b.vel += hunt * huntUrge;
+
+    // Bound boid into a box
+    if (b.pos.x > 1 || b.pos.x < -1) {
+      b.pos.x = b.pos.x > 0 ? 1 : -1;
+      b.vel.x = -b.vel.x;
+    }
+    if (b.pos.y > 1 || b.pos.y < -1) {
+      b.pos.y = b.pos.y > 0 ? 1 : -1;
+      b.vel.y = -b.vel.y;
+    }
+
+    b.update(dt);
+  }
+
+  void step(double dt) {
+    if (vectorized && !bruteForce) {
+      stepDoubleBuffered(dt);
+    } else {
+      if (bruteForce) {
+        interactAllPairs();
+      } else {
+        interactNeighbors();
+      }
+      for (int i = 0; i < size(); ++i) behave(boids[i], i, dt);
+    }
+    ++steps;
+  }
+
+  // Order dependent hash of the flock's state, for comparing runs
+  uint64_t checksum() const {
+    uint64_t h = 0;
+    for (auto& b : boids) {
+      for (double v : {b.pos.x, b.pos.y, b.vel.x, b.vel.y}) {
+        uint64_t bits;
+        std::memcpy(&bits, &v, sizeof(bits));
+        h = counter_rnd::mix(h ^ bits);
+      }
+    }
+    return h;
+  }
+
+  // Sets the number of threads of the double buffered step; zero or less
+  // uses all hardware threads
+  void threads(int numThreads) {
+    if (numThreads <= 0) {
+      numThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (!pool || pool->size() != numThreads) {
+      pool.reset(new ThreadPool(numThreads));
+    }
+  }
+
+  ThreadPool& threadPool() {
+    if (!pool) threads(1);
+    return *pool;
+  }
+};
+
+#endif
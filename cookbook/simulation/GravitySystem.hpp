@@ -0,0 +1,208 @@
+#pragma once
+#ifndef GravitySystem_H
+#define GravitySystem_H
+
+// The particles and wells of gravityWell.cpp, without graphics
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "al/math/al_Random.hpp"
+#include "al/math/al_Vec.hpp"
+#include "al/types/al_Conversion.hpp" // clone
+
+#include "playground/ThreadPool.hpp"
+
+#include "BarnesHut.hpp"
+#include "Integrators.hpp"
+
+// A particle; its acceleration comes from GravitySystem::accelerations()
+class GravityParticle {
+public:
+  al::Vec3f pos;
+  al::Vec3f vel;
+};
+
+// The particles and the forces acting on them, independent of graphics
+struct GravitySystem {
+  std::vector<GravityParticle> particles;
+  std::vector<al::Vec3f> wells{al::Vec3f(0, 0, 0)};
+
+  bool nbody = false;      // Whether particles also attract each other
+  float totalMass = 0.1f;  // G times total mass of the particles
+  BarnesHut tree;
+  std::vector<al::Vec3f> mutualAcc; // Accelerations due to the other particles
+
+  ThreadPool pool;
+  ParticleIntegrator integrator;
+
+  explicit GravitySystem(int numThreads = 0) : pool(numThreads) {
+    integrator.pool = &pool;
+    integrator.length = 0.1f; // the wells' minimum distance
+  }
+
+  int size() const { return particles.size(); }
+
+  void resize(int n) {
+    particles.resize(n);
+    integrator.reset();
+  }
+
+  al::Vec3f &position(int i) { return particles[i].pos; }
+  al::Vec3f &velocity(int i) { return particles[i].vel; }
+
+  // Pull of the wells on a particle at p
+  al::Vec3f wellAcceleration(const al::Vec3f &p) const {
+    al::Vec3f acc(0);
+    for (auto &w : wells) {
+      // Newton's law of gravity
+      auto r21 = w - p;              // distance vector between well and particle
+      auto dist = r21.mag();         // distance between well and particle
+      dist = std::max(dist, 0.1f);   // prevent high velocities
+      auto F = r21 / (dist * dist * dist); // force vector acting on particle
+
+      // Newton's second law of motion, F = ma -> a = F/m
+      acc += F * (1. / 10); // mass of particle is 10
+    }
+    return acc;
+  }
+
+  // Potential energy per unit mass of a particle at p due to the wells. Inside
+  // the minimum distance the pull grows linearly, so the potential is a
+  // parabola there that meets -1/(10 d) at d = 0.1.
+  float wellPotential(const al::Vec3f &p) const {
+    float phi = 0;
+    for (auto &w : wells) {
+      float dist = (w - p).mag();
+      phi += dist >= 0.1f ? -0.1f / dist : 50 * dist * dist - 1.5f;
+    }
+    return phi;
+  }
+
+  // Builds the octree over the current particle positions
+  void buildTree() {
+    tree.mass = totalMass / std::max(size(), 1);
+    tree.build(size(), [this](int i) { return particles[i].pos; });
+  }
+
+  // Acceleration of every particle at the current positions
+  void accelerations(std::vector<al::Vec3f> &acc) {
+    acc.resize(size());
+    if (nbody) {
+      buildTree();
+      tree.accelerations(pool, mutualAcc);
+    }
+
+    pool.parallelFor(0, size(), [&](int begin, int end, int) {
+      for (int i = begin; i < end; ++i) {
+        acc[i] = wellAcceleration(particles[i].pos);
+        if (nbody)
+          acc[i] += mutualAcc[i];
+      }
+    });
+  }
+
+  void step(double dt) { integrator.step(*this, dt); }
+
+  // Sums f(i) over all particles. Partial sums are per thread and added in
+  // order, so the result does not depend on timing.
+  template <class Fn> double sum(Fn f) {
+    std::vector<double> partial(pool.size(), 0.);
+    pool.parallelFor(0, size(), [&](int begin, int end, int t) {
+      for (int i = begin; i < end; ++i)
+        partial[t] += f(i);
+    });
+    double total = 0;
+    for (double p : partial)
+      total += p;
+    return total;
+  }
+
+  // Energies per unit particle mass
+  double kineticEnergy() {
+    return sum([this](int i) { return 0.5 * particles[i].vel.magSqr(); });
+  }
+
+  double potentialEnergy() {
+    double U = sum([this](int i) { return wellPotential(particles[i].pos); });
+    if (nbody) {
+      // Each pair counts once; the tree's self term is taken out
+      buildTree();
+      float self = tree.mass / tree.softening;
+      U += 0.5 * sum([this, self](int i) {
+             return tree.potential(particles[i].pos) + self;
+           });
+    }
+    return U;
+  }
+};
+
+// Sets N particles to one of the initial conditions selected by the number
+// keys. Other keys leave the particles as they are.
+inline void initialize(GravitySystem &sim, int N, int preset) {
+  if (preset < '1' || preset > '6')
+    return;
+  sim.resize(N);
+  auto &particles = sim.particles;
+  int M = std::max(2, int(std::sqrt(float(N)))); // side of grid formations
+
+  switch (preset) {
+  case '1': // dust cloud
+    for (auto &p : particles) {
+      p.pos = al::rnd::ball<al::Vec3f>() * 0.2 + al::Vec3f(-0.7, 0, 0);
+      p.vel = al::Vec3f(0, -0.3, 0);
+    }
+    break;
+  case '2': // hourglass
+    for (auto &p : particles) {
+      p.pos = al::rnd::ball<al::Vec3f>().mag(1);
+      p.vel = al::clone(p.pos).rotate(M_PI / 2) * al::Vec3f(1, 1, -1) * 0.2;
+    }
+    break;
+  case '3': // line orbit 1
+    for (int i = 0; i < N; ++i) {
+      particles[i].pos = al::Vec3f(float(i) / N * 0.5 - 1, 0, 0);
+      particles[i].vel = al::Vec3f(0, -0.3, 0);
+    }
+    break;
+  case '4': // line orbit 2
+    for (int i = 0; i < N; ++i) {
+      float frac = float(i) / N;
+      particles[i].pos = al::Vec3f(-0.8, frac, 0);
+      particles[i].vel = al::Vec3f(-0.1, -0.2, 0.2);
+    }
+    break;
+  case '5': // grid formation (side)
+    for (int i = 0; i < N; ++i) {
+      particles[i].pos = al::Vec3f(-1, float(i % M) / (M - 1) * 2 - 1,
+                               float(i / M) / (M - 1) * 2 - 1);
+      particles[i].vel = al::Vec3f(0, 0, 0);
+    }
+    break;
+  case '6': // grid formation (front)
+    for (int i = 0; i < N; ++i) {
+      particles[i].pos = al::Vec3f(float(i % M) / (M - 1) - 0.5,
+                               float(i / M) / (M - 1) - 0.5, 1);
+      particles[i].vel = al::Vec3f(0.1, 0, 0);
+    }
+    break;
+  }
+}
+
+// Packs the position and scale of every particle into the instance buffer
+// layout read by instanceVert. Returns the number of bytes packed.
+inline size_t packInstances(const GravitySystem &sim, float scale,
+                            std::vector<al::Vec4f> &instances,
+                            ThreadPool &pool) {
+  instances.resize(sim.size());
+  pool.parallelFor(0, sim.size(), [&](int begin, int end, int) {
+    for (int i = begin; i < end; ++i) {
+      const al::Vec3f &p = sim.particles[i].pos;
+      instances[i] = al::Vec4f(p.x, p.y, p.z, scale);
+    }
+  });
+  return instances.size() * sizeof(al::Vec4f);
+}
+
+#endif
@@ -0,0 +1,146 @@
+#pragma once
+#ifndef HeightFieldMesh_H
+#define HeightFieldMesh_H
+
+// Heights and normals of a grid surface mesh (as made by addSurface), written
+// straight from a height field.
+//
+// Mesh::generateNormals() walks every triangle and allocates on every call.
+// For a grid, the normal at a vertex is known from the height field alone:
+// with central differences of the heights (one-sided at the edges),
+//
+//   n = normalize(-dh/dx, -dh/dy, 1)
+//
+// so each vertex's height and normal are written together in one parallel
+// pass over tiles of the grid.
+//
+// The field is given as two height arrays and a blend factor, to draw between
+// two simulation steps. A tile whose new heights (and those around its edge)
+// equal the mesh's current ones is skipped, so a mostly still surface costs
+// little more than comparing heights.
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "al/graphics/al_Mesh.hpp"
+
+#include "playground/ThreadPool.hpp"
+
+class HeightFieldMesh {
+public:
+  int tileSize = 32;         // Side of a tile in vertices
+  float threshold = 1e-6f;   // Largest change in height that leaves a tile
+
+  // Sets up a mesh of nx by ny vertices in rows, like addSurface() makes
+  void init(al::Mesh &mesh, int nx, int ny) {
+    mNx = nx;
+    mNy = ny;
+    auto &verts = mesh.vertices();
+    mStepX = nx > 1 ? verts[1].x - verts[0].x : 1;
+    mStepY = ny > 1 ? verts[nx].y - verts[0].y : 1;
+    auto &normals = mesh.normals();
+    normals.resize(verts.size());
+    for (auto &n : normals)
+      n = al::Vec3f(0, 0, 1);
+
+    mTilesX = (nx + tileSize - 1) / tileSize;
+    mTilesY = (ny + tileSize - 1) / tileSize;
+    mChanged.assign(mTilesX * mTilesY, 0);
+    mDirty.assign(mTilesX * mTilesY, 0);
+  }
+
+  // Writes the heights a + (b - a) t into the mesh's z coordinates along with
+  // the normals, skipping tiles that have not changed. Returns the number of
+  // tiles written.
+  int update(al::Mesh &mesh, const float *a, const float *b, float t,
+             ThreadPool &pool) {
+    al::Vec3f *verts = mesh.vertices().data();
+    al::Vec3f *normals = mesh.normals().data();
+    int numTiles = mTilesX * mTilesY;
+
+    // Find the tiles whose heights changed
+    pool.parallelFor(0, numTiles, [&](int begin, int end, int) {
+      for (int k = begin; k < end; ++k) {
+        int x0, x1, y0, y1;
+        tileRange(k, x0, x1, y0, y1);
+        float maxDelta = 0;
+        for (int y = y0; y < y1; ++y) {
+          for (int x = x0; x < x1; ++x) {
+            int i = y * mNx + x;
+            float h = a[i] + (b[i] - a[i]) * t;
+            maxDelta = std::max(maxDelta, std::abs(h - verts[i].z));
+          }
+        }
+        mChanged[k] = maxDelta > threshold;
+      }
+    });
+
+    // A tile's edge normals also depend on the rows and columns next to it
+    int numDirty = 0;
+    for (int ty = 0; ty < mTilesY; ++ty) {
+      for (int tx = 0; tx < mTilesX; ++tx) {
+        bool dirty = false;
+        for (int dy = -1; dy <= 1; ++dy) {
+          for (int dx = -1; dx <= 1; ++dx) {
+            int nx = tx + dx, ny = ty + dy;
+            if (nx >= 0 && nx < mTilesX && ny >= 0 && ny < mTilesY)
+              dirty |= mChanged[ny * mTilesX + nx] != 0;
+          }
+        }
+        mDirty[ty * mTilesX + tx] = dirty;
+        numDirty += dirty;
+      }
+    }
+
+    // Heights and normals of the dirty tiles, both from the height field so
+    // tiles don't read each other's output
+    pool.parallelFor(0, numTiles, [&](int begin, int end, int) {
+      for (int k = begin; k < end; ++k) {
+        if (!mDirty[k])
+          continue;
+        int x0, x1, y0, y1;
+        tileRange(k, x0, x1, y0, y1);
+        for (int y = y0; y < y1; ++y) {
+          int yd = std::max(y - 1, 0), yu = std::min(y + 1, mNy - 1);
+          for (int x = x0; x < x1; ++x) {
+            int xl = std::max(x - 1, 0), xr = std::min(x + 1, mNx - 1);
+            auto h = [&](int xi, int yi) {
+              int i = yi * mNx + xi;
+              return a[i] + (b[i] - a[i]) * t;
+            };
+            int i = y * mNx + x;
+            verts[i].z = h(x, y);
+            float dhdx = (h(xr, y) - h(xl, y)) / ((xr - xl) * mStepX);
+            float dhdy = (h(x, yu) - h(x, yd)) / ((yu - yd) * mStepY);
+            float invLen = 1.f / std::sqrt(dhdx * dhdx + dhdy * dhdy + 1.f);
+            normals[i] = al::Vec3f(-dhdx * invLen, -dhdy * invLen, invLen);
+          }
+        }
+      }
+    });
+
+    mLastDirty = numDirty;
+    return numDirty;
+  }
+
+  int tiles() const { return mTilesX * mTilesY; }
+  int lastDirtyTiles() const { return mLastDirty; }
+
+private:
+  void tileRange(int k, int &x0, int &x1, int &y0, int &y1) const {
+    int tx = k % mTilesX, ty = k / mTilesX;
+    x0 = tx * tileSize;
+    x1 = std::min(x0 + tileSize, mNx);
+    y0 = ty * tileSize;
+    y1 = std::min(y0 + tileSize, mNy);
+  }
+
+  int mNx = 0, mNy = 0;
+  int mTilesX = 0, mTilesY = 0;
+  float mStepX = 1, mStepY = 1; // Signed spacing of columns and rows
+  std::vector<char> mChanged, mDirty;
+  int mLastDirty = 0;
+};
+
+#endif
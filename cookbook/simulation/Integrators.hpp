@@ -0,0 +1,274 @@
+#pragma once
+#ifndef Integrators_H
+#define Integrators_H
+
+// Time integrators for particle systems.
+//
+// A system integrated by ParticleIntegrator provides
+//
+//   int size() const;
+//   al::Vec3f &position(int i);
+//   al::Vec3f &velocity(int i);
+//   void accelerations(std::vector<al::Vec3f> &acc); // at current state
+//
+// Methods, with the number of acceleration evaluations per step:
+//
+//   EULER               explicit Euler; 1st order, gains energy in orbits (1)
+//   SEMI_IMPLICIT_EULER symplectic Euler; 1st order (1)
+//   VELOCITY_VERLET     kick-drift-kick; 2nd order, symplectic (1, reusing
+//                       the acceleration from the end of the last step)
+//   LEAPFROG            drift-kick-drift; 2nd order, symplectic (1)
+//   RK4                 classic Runge-Kutta; 4th order, not symplectic (4)
+//
+// Each call to step(system, dt) takes a fixed number of substeps, or with
+// adaptive on, as many as needed to keep every substep below
+// eta * sqrt(length / max|a|), the time to cross `length` from rest under the
+// largest acceleration.
+//
+// EnergyMonitor tracks a system's total energy across frames so the drift of
+// a method and time step can be watched while tuning them.
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <vector>
+
+#include "al/math/al_Vec.hpp"
+
+#include "playground/ThreadPool.hpp"
+
+enum class IntegratorMethod {
+  EULER,
+  SEMI_IMPLICIT_EULER,
+  VELOCITY_VERLET,
+  LEAPFROG,
+  RK4
+};
+
+inline const char *integratorName(IntegratorMethod m) {
+  switch (m) {
+  case IntegratorMethod::EULER:
+    return "Euler";
+  case IntegratorMethod::SEMI_IMPLICIT_EULER:
+    return "semi-implicit Euler";
+  case IntegratorMethod::VELOCITY_VERLET:
+    return "velocity Verlet";
+  case IntegratorMethod::LEAPFROG:
+    return "leapfrog";
+  case IntegratorMethod::RK4:
+    return "RK4";
+  }
+  return "";
+}
+
+// The method after m, wrapping around; for cycling through them from a key
+inline IntegratorMethod nextIntegrator(IntegratorMethod m) {
+  return IntegratorMethod((int(m) + 1) % (int(IntegratorMethod::RK4) + 1));
+}
+
+class ParticleIntegrator {
+public:
+  IntegratorMethod method = IntegratorMethod::SEMI_IMPLICIT_EULER;
+  int substeps = 1;      // Substeps per step when not adaptive
+  bool adaptive = false; // Choose the number of substeps from accelerations
+  float eta = 0.2f;      // Adaptive accuracy; smaller takes more substeps
+  float length = 0.05f;  // Adaptive length scale, e.g. a softening length
+  int maxSubsteps = 64;  // Adaptive upper limit on substeps
+  ThreadPool *pool = nullptr; // Splits the per particle loops, if set
+
+  // Number of substeps taken by the last call to step()
+  int lastSubsteps() const { return mLastSubsteps; }
+
+  // Forgets the cached acceleration; call when the system is changed other
+  // than by step(), e.g. when particles are reset
+  void reset() { mHaveAcc = false; }
+
+  template <class System> void step(System &sys, double dt) {
+    int n = sys.size();
+    if (int(mAcc.size()) != n)
+      mHaveAcc = false;
+
+    int numSteps = substeps;
+    if (adaptive) {
+      ensureAcc(sys);
+      float maxAcc = 0;
+      for (auto &a : mAcc)
+        maxAcc = std::max(maxAcc, a.magSqr());
+      maxAcc = std::sqrt(maxAcc);
+      double h = maxAcc > 0 ? eta * std::sqrt(length / maxAcc) : dt;
+      numSteps = std::min(maxSubsteps, std::max(1, int(std::ceil(dt / h))));
+    }
+    numSteps = std::max(numSteps, 1);
+    mLastSubsteps = numSteps;
+
+    double h = dt / numSteps;
+    for (int s = 0; s < numSteps; ++s)
+      substep(sys, h);
+  }
+
+private:
+  template <class Fn> void forEach(int n, Fn fn) {
+    if (pool) {
+      pool->parallelFor(0, n, [&](int begin, int end, int) {
+        for (int i = begin; i < end; ++i)
+          fn(i);
+      });
+    } else {
+      for (int i = 0; i < n; ++i)
+        fn(i);
+    }
+  }
+
+  template <class System> void ensureAcc(System &sys) {
+    if (!mHaveAcc) {
+      sys.accelerations(mAcc);
+      mHaveAcc = true;
+    }
+  }
+
+  template <class System> void substep(System &sys, double h) {
+    int n = sys.size();
+    float hf = h;
+
+    switch (method) {
+    case IntegratorMethod::EULER:
+      sys.accelerations(mAcc);
+      forEach(n, [&](int i) {
+        sys.position(i) += sys.velocity(i) * hf;
+        sys.velocity(i) += mAcc[i] * hf;
+      });
+      mHaveAcc = false;
+      break;
+
+    case IntegratorMethod::SEMI_IMPLICIT_EULER:
+      sys.accelerations(mAcc);
+      forEach(n, [&](int i) {
+        sys.velocity(i) += mAcc[i] * hf;
+        sys.position(i) += sys.velocity(i) * hf;
+      });
+      mHaveAcc = false;
+      break;
+
+    case IntegratorMethod::VELOCITY_VERLET:
+      ensureAcc(sys);
+      forEach(n, [&](int i) {
+        sys.velocity(i) += mAcc[i] * (0.5f * hf);
+        sys.position(i) += sys.velocity(i) * hf;
+      });
+      sys.accelerations(mAcc);
+      forEach(n, [&](int i) { sys.velocity(i) += mAcc[i] * (0.5f * hf); });
+      mHaveAcc = true;
+      break;
+
+    case IntegratorMethod::LEAPFROG:
+      forEach(n, [&](int i) { sys.position(i) += sys.velocity(i) * (0.5f * hf); });
+      sys.accelerations(mAcc);
+      forEach(n, [&](int i) {
+        sys.velocity(i) += mAcc[i] * hf;
+        sys.position(i) += sys.velocity(i) * (0.5f * hf);
+      });
+      mHaveAcc = false;
+      break;
+
+    case IntegratorMethod::RK4:
+      rk4(sys, hf);
+      mHaveAcc = false;
+      break;
+    }
+  }
+
+  template <class System> void rk4(System &sys, float h) {
+    int n = sys.size();
+    mX0.resize(n);
+    mV0.resize(n);
+    mSumX.resize(n);
+    mSumV.resize(n);
+
+    forEach(n, [&](int i) {
+      mX0[i] = sys.position(i);
+      mV0[i] = sys.velocity(i);
+      mSumX[i] = al::Vec3f(0);
+      mSumV[i] = al::Vec3f(0);
+    });
+
+    // Stage k: evaluate at the current state, add the derivative with its
+    // weight and move to the next stage's state x0 + c * h * derivative
+    static const float weight[4] = {1.f / 6, 1.f / 3, 1.f / 3, 1.f / 6};
+    static const float next[4] = {0.5f, 0.5f, 1.f, 0.f};
+    for (int k = 0; k < 4; ++k) {
+      sys.accelerations(mAcc);
+      forEach(n, [&](int i) {
+        al::Vec3f dx = sys.velocity(i);
+        al::Vec3f dv = mAcc[i];
+        mSumX[i] += dx * weight[k];
+        mSumV[i] += dv * weight[k];
+        if (k < 3) {
+          sys.position(i) = mX0[i] + dx * (next[k] * h);
+          sys.velocity(i) = mV0[i] + dv * (next[k] * h);
+        }
+      });
+    }
+
+    forEach(n, [&](int i) {
+      sys.position(i) = mX0[i] + mSumX[i] * h;
+      sys.velocity(i) = mV0[i] + mSumV[i] * h;
+    });
+  }
+
+  std::vector<al::Vec3f> mAcc;
+  std::vector<al::Vec3f> mX0, mV0, mSumX, mSumV;
+  bool mHaveAcc = false;
+  int mLastSubsteps = 1;
+};
+
+// Tracks the total energy of a system from frame to frame
+class EnergyMonitor {
+public:
+  double kinetic = 0;   // Kinetic energy of the last frame
+  double potential = 0; // Potential energy of the last frame
+  double initial = 0;   // Total energy when the monitor was (re)started
+  double previous = 0;  // Total energy of the frame before the last
+  long frames = 0;      // Frames recorded since (re)starting
+
+  // Called after every recorded frame, e.g. to print or plot the energy
+  std::function<void(const EnergyMonitor &)> hook;
+
+  double total() const { return kinetic + potential; }
+
+  // Change since (re)starting, relative to the starting energy
+  double drift() const {
+    return initial != 0 ? (total() - initial) / std::abs(initial)
+                        : total() - initial;
+  }
+
+  // Change over the last frame, relative to the starting energy
+  double frameDrift() const {
+    return initial != 0 ? (total() - previous) / std::abs(initial)
+                        : total() - previous;
+  }
+
+  // Start measuring drift from the next recorded frame
+  void restart() { frames = 0; }
+
+  // The system's energy was changed other than by integrating, e.g. particles
+  // were added or removed. Drift is measured on from the new energy.
+  void rebase(double kineticEnergy, double potentialEnergy) {
+    if (frames > 0)
+      initial += kineticEnergy + potentialEnergy - total();
+    kinetic = kineticEnergy;
+    potential = potentialEnergy;
+  }
+
+  void record(double kineticEnergy, double potentialEnergy) {
+    previous = frames > 0 ? total() : kineticEnergy + potentialEnergy;
+    kinetic = kineticEnergy;
+    potential = potentialEnergy;
+    if (frames == 0)
+      initial = total();
+    ++frames;
+    if (hook)
+      hook(*this);
+  }
+};
+
+#endif
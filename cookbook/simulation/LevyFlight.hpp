@@ -0,0 +1,320 @@
+#pragma once
+#ifndef LevyFlight_H
+#define LevyFlight_H
+
+// The walks of levyFlight.cpp, without graphics: a single walker, and many
+// independent walkers stepped in batches across threads.
+//
+// The trail is kept in a TrailRing: a fixed number of vertex slots that new
+// points overwrite oldest first. A point's color is worked out once, when it
+// is added, along with the time it was added, so the trail can fade with age
+// in a shader. Only the slots written since the last upload need to be sent
+// to the GPU, so the cost of a frame depends on the number of new points and
+// not on the length of the trail.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "al/math/al_Functions.hpp"
+#include "al/math/al_Random.hpp"
+#include "al/math/al_Vec.hpp"
+#include "al/types/al_Color.hpp"
+
+#include "playground/CounterRandom.hpp"
+#include "playground/ThreadPool.hpp"
+
+class TrailRing {
+public:
+  // A range of slots [begin, end)
+  struct Range {
+    int begin, end;
+  };
+
+  explicit TrailRing(int capacity = 8000, int width = 1) {
+    resize(capacity, width);
+  }
+
+  // Sets the number of slots kept and the number of points in each slot, and
+  // clears the trail. A slot holds one point of each of width trails, stored
+  // together so the points written in a frame are contiguous.
+  void resize(int capacity, int width = 1) {
+    mCapacity = std::max(capacity, 2);
+    mWidth = std::max(width, 1);
+    // One slot more than the capacity mirrors slot 0, so the strip through
+    // the last slot continues into the first one
+    int points = (mCapacity + 1) * mWidth;
+    mPositions.assign(points, al::Vec3f(0));
+    mColors.assign(points, al::Color(0));
+    mTimes.assign(points, 0.f);
+    mHead = -1;
+    mFill = 0;
+    mDirtyBegin = 0;
+    mDirtyCount = 0;
+  }
+
+  int capacity() const { return mCapacity; }
+  int width() const { return mWidth; }
+  int size() const { return mFill; }
+
+  // The slot written i additions ago; 0 is the newest
+  int slot(int i = 0) const { return (mHead - i + mCapacity) % mCapacity; }
+
+  // Point k of the slot written i additions ago
+  const al::Vec3f &back(int i = 0, int k = 0) const {
+    return mPositions[slot(i) * mWidth + k];
+  }
+
+  // Moves on to the next slot, the oldest once the trail is full, and returns
+  // it for its points to be written with set()
+  int advance() {
+    mHead = (mHead + 1) % mCapacity;
+    mFill = std::min(mFill + 1, mCapacity);
+
+    if (mDirtyCount == 0)
+      mDirtyBegin = mHead;
+    mDirtyCount = std::min(mDirtyCount + 1, mCapacity);
+    return mHead;
+  }
+
+  // Writes point k of a slot. Different points can be written at once from
+  // different threads.
+  void set(int slot, int k, const al::Vec3f &p, const al::Color &c,
+           float time) {
+    write(slot * mWidth + k, p, c, time);
+    if (slot == 0)
+      write(mCapacity * mWidth + k, p, c, time);
+  }
+
+  // Adds a point to a trail of width 1
+  void append(const al::Vec3f &p, const al::Color &c, float time) {
+    set(advance(), 0, p, c, time);
+  }
+
+  // Slots written since the last call, in at most three ranges (the run up to
+  // the end, the run from the start and the mirror slot). Returns the number
+  // of ranges. Points [begin * width(), end * width()) need uploading.
+  int takeDirty(Range ranges[3]) {
+    int n = 0;
+    if (mDirtyCount > 0) {
+      int end = mDirtyBegin + mDirtyCount;
+      if (mDirtyCount == mCapacity) {
+        ranges[n++] = {0, mCapacity + 1};
+      } else if (end <= mCapacity) {
+        ranges[n++] = {mDirtyBegin, end};
+      } else {
+        ranges[n++] = {mDirtyBegin, mCapacity};
+        ranges[n++] = {0, end - mCapacity};
+      }
+      bool wroteZero = mDirtyBegin == 0 || end > mCapacity;
+      if (wroteZero && mDirtyCount != mCapacity)
+        ranges[n++] = {mCapacity, mCapacity + 1};
+    }
+    mDirtyCount = 0;
+    return n;
+  }
+
+  // Slots of a trail of width 1 to draw as line strips, oldest to newest.
+  // Returns the number of ranges, at most two.
+  int drawRanges(Range ranges[2]) const {
+    if (mFill < mCapacity) {
+      ranges[0] = {0, mFill};
+      return mFill > 0;
+    }
+    int oldest = (mHead + 1) % mCapacity;
+    if (oldest == 0) {
+      ranges[0] = {0, mCapacity};
+      return 1;
+    }
+    ranges[0] = {oldest, mCapacity + 1};
+    ranges[1] = {0, mHead + 1};
+    return 2;
+  }
+
+  // Segments to draw as lines for trails of any width, where segment s joins
+  // each point of slot s to the same point of slot s + 1 (the mirror slot
+  // after the last). The segment from the newest slot to the oldest is left
+  // out. Returns the number of ranges, at most two.
+  int segmentRanges(Range ranges[2]) const {
+    if (mFill < mCapacity) {
+      ranges[0] = {0, std::max(mFill - 1, 0)};
+      return mFill > 1;
+    }
+    int n = 0;
+    if (mHead > 0)
+      ranges[n++] = {0, mHead};
+    if (mHead + 1 < mCapacity)
+      ranges[n++] = {mHead + 1, mCapacity};
+    return n;
+  }
+
+  // Vertex attributes of all (capacity() + 1) * width() points, slot by slot
+  const al::Vec3f *positions() const { return mPositions.data(); }
+  const al::Color *colors() const { return mColors.data(); }
+  const float *times() const { return mTimes.data(); }
+
+private:
+  void write(int i, const al::Vec3f &p, const al::Color &c, float time) {
+    mPositions[i] = p;
+    mColors[i] = c;
+    mTimes[i] = time;
+  }
+
+  int mCapacity = 0, mWidth = 1;
+  std::vector<al::Vec3f> mPositions;
+  std::vector<al::Color> mColors;
+  std::vector<float> mTimes;
+  int mHead = -1; // Slot of the newest point
+  int mFill = 0;
+  int mDirtyBegin = 0, mDirtyCount = 0;
+};
+
+struct LevyFlight {
+  TrailRing trail{8000};
+  int stepsPerFrame = 4;
+  float spread = 0.04f; // spread of steps; lower is more flighty
+  float time = 0;       // Seconds walked
+
+  LevyFlight() { trail.append(al::Vec3f(0), al::Color(0), 0); }
+
+  void step(float dt) {
+    time += dt;
+    for (int i = 0; i < stepsPerFrame; ++i) {
+      auto p = al::rnd::ball<al::Vec3f>();
+
+      float mm = p.magSqr();
+      float l = spread;
+      float v = l / (mm + l * l) * 0.1f;  // map uniform to Cauchy distribution
+
+      p = p.normalized() * v;
+      p += trail.back();
+
+      // Long steps are more saturated
+      al::Vec3f dr = p - trail.back(1);
+      al::Color c = al::HSV(0.2, al::clip(dr.mag() * 4 + 0.2), 1);
+      trail.append(p, c, time);
+    }
+  }
+
+  // Seconds for the oldest point of a full trail to be drawn at 60 fps
+  float historySeconds() const {
+    return float(trail.capacity()) / (stepsPerFrame * 60);
+  }
+};
+
+// Cauchy distributed steps of walkers first to first + n - 1 at one step
+// count, written to dx, dy and dz.
+//
+// The steps have the distribution of LevyFlight::step: a direction uniform on
+// the sphere and a length spread / (r^2 + spread^2) * 0.1, where r is the
+// distance from the center of a point uniform in the unit ball. Rejection
+// sampling the point would branch per walker, so instead the direction comes
+// from a uniform height and angle, and r from the largest of three uniform
+// numbers (which has the density 3r^2 of the radius in a ball). The loop has
+// no branches or library calls, so it vectorizes where the target allows.
+inline void cauchySteps(uint64_t seed, uint64_t step, int first, int n,
+                        float spread, float *__restrict dx,
+                        float *__restrict dy, float *__restrict dz) {
+  const float pi = 3.14159265f;
+  float l = spread;
+  for (int i = 0; i < n; ++i) {
+    uint64_t key = counter_rnd::key(seed, step, first + i);
+    float z = counter_rnd::uniformS(key, 0);
+    float r = std::max(std::max(counter_rnd::uniform(key, 1),
+                                counter_rnd::uniform(key, 2)),
+                       counter_rnd::uniform(key, 3));
+
+    // Half the angle, in [-pi/2, pi/2), by Taylor series, then doubled
+    float a = counter_rnd::uniformS(key, 4) * (pi / 2);
+    float a2 = a * a;
+    float s = a * (1.f - a2 / 6 * (1.f - a2 / 20 * (1.f - a2 / 42 *
+                                                       (1.f - a2 / 72))));
+    float c = 1.f - a2 / 2 * (1.f - a2 / 12 * (1.f - a2 / 30 *
+                                                  (1.f - a2 / 56)));
+    float sinA = 2 * s * c, cosA = c * c - s * s;
+
+    float v = l / (r * r + l * l) * 0.1f;
+    float rho = std::sqrt(std::max(1.f - z * z, 0.f)) * v;
+    dx[i] = rho * cosA;
+    dy[i] = rho * sinA;
+    dz[i] = z * v;
+  }
+}
+
+// Many independent Lévy flights. All walkers step together, so their trails
+// share one TrailRing of width size(), and each walker's steps depend only on
+// the seed, the step count and its index: runs with the same seed give the
+// same walks on any number of threads.
+struct LevyWalkers {
+  TrailRing trails;
+  std::vector<al::Vec3f> pos;
+  int stepsPerFrame = 4;
+  float spread = 0.04f;  // spread of steps; lower is more flighty
+  float startRadius = 2; // Walkers start uniformly inside a ball this size
+  float time = 0;        // Seconds walked
+
+  uint64_t seed = 1;
+  uint64_t steps = 0;
+
+  // Walkers are stepped in batches of this many
+  static const int kBatch = 256;
+
+  int size() const { return pos.size(); }
+
+  void reset(int numWalkers, int trailLength, uint64_t newSeed = 1) {
+    seed = newSeed;
+    steps = 0;
+    time = 0;
+    pos.resize(numWalkers);
+    trails.resize(trailLength, numWalkers);
+    int slot = trails.advance();
+    for (int i = 0; i < numWalkers; ++i) {
+      pos[i] = counter_rnd::ball<al::Vec3f>(counter_rnd::key(seed, 0, i, 1)) *
+               startRadius;
+      trails.set(slot, i, pos[i], al::Color(0), time);
+    }
+  }
+
+  // Each walker's own hue
+  float hue(int i) const {
+    float h = i * 0.618034f;
+    return h - std::floor(h);
+  }
+
+  void step(float dt, ThreadPool &pool) {
+    time += dt;
+    mSlots.resize(stepsPerFrame);
+    for (auto &s : mSlots)
+      s = trails.advance();
+
+    pool.parallelFor(0, size(), [&](int begin, int end, int) {
+      float dx[kBatch], dy[kBatch], dz[kBatch];
+      for (int b = begin; b < end; b += kBatch) {
+        int n = std::min(int(kBatch), end - b);
+        for (int k = 0; k < stepsPerFrame; ++k) {
+          cauchySteps(seed, steps + 1 + k, b, n, spread, dx, dy, dz);
+          for (int i = 0; i < n; ++i) {
+            al::Vec3f d(dx[i], dy[i], dz[i]);
+            auto &p = pos[b + i];
+            p += d;
+            // Long steps are more saturated
+            al::Color c = al::HSV(hue(b + i), al::clip(d.mag() * 4 + 0.2f), 1);
+            trails.set(mSlots[k], b + i, p, c, time);
+          }
+        }
+      }
+    });
+    steps += stepsPerFrame;
+  }
+
+  // Seconds for the oldest point of a full trail to be drawn at 60 fps
+  float historySeconds() const {
+    return float(trails.capacity()) / (stepsPerFrame * 60);
+  }
+
+private:
+  std::vector<int> mSlots;
+};
+
+#endif
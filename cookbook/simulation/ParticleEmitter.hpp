@@ -0,0 +1,187 @@
+#pragma once
+#ifndef ParticleEmitter_H
+#define ParticleEmitter_H
+
+// The fountain of particleSystem.cpp, without graphics, and the snapshot and
+// mesh writing its app uses
+
+#include <algorithm>
+#include <vector>
+
+#include "al/graphics/al_Mesh.hpp"
+#include "al/math/al_Random.hpp"
+#include "al/math/al_Vec.hpp"
+#include "al/types/al_Color.hpp"
+
+#include "playground/ThreadPool.hpp"
+
+#include "Integrators.hpp"
+
+struct Particle {
+  al::Vec3f pos, vel, acc;
+  float age = 0;        // Seconds since emitted
+  float saturation = 0; // Of the particle's color
+  unsigned id = 0;      // Identifies the particle across steps
+};
+
+class Emitter {
+public:
+  float rate = 2400;        // Particles emitted per second
+  float lifetime = 10. / 3; // Seconds a particle lives
+  ParticleIntegrator integrator;
+
+  explicit Emitter(int capacity = 8000) : mParticles(capacity) {}
+
+  // Most particles alive at once. Growing it reallocates; shrinking it drops
+  // the newest particles.
+  int capacity() const { return mParticles.size(); }
+  void capacity(int n) {
+    mParticles.resize(n);
+    mSize = std::min(mSize, n);
+    integrator.reset();
+  }
+
+  // Live particles are 0 to size() - 1
+  int size() const { return mSize; }
+  const Particle &operator[](int i) const { return mParticles[i]; }
+
+  // Moves the particles dt seconds, removes those past their lifetime and
+  // emits new ones
+  void update(double dt, EnergyMonitor *energy = nullptr) {
+    integrator.step(*this, dt);
+
+    for (int i = 0; i < mSize;) {
+      Particle &p = mParticles[i];
+      p.age += dt;
+      if (p.age >= lifetime) {
+        p = mParticles[--mSize]; // the last one is aged on its new spot
+      } else {
+        ++i;
+      }
+    }
+    if (energy)
+      energy->record(kineticEnergy(), potentialEnergy());
+
+    mDue += rate * dt;
+    int count = int(mDue);
+    mDue -= count;
+    count = std::min(count, capacity() - mSize);
+    for (int i = 0; i < count; ++i)
+      emit(mParticles[mSize++]);
+
+    // New particles may have a new acceleration and the removals moved others
+    integrator.reset();
+    if (energy)
+      energy->rebase(kineticEnergy(), potentialEnergy());
+  }
+
+  al::Vec3f &position(int i) { return mParticles[i].pos; }
+  al::Vec3f &velocity(int i) { return mParticles[i].vel; }
+
+  void accelerations(std::vector<al::Vec3f> &acc) {
+    acc.resize(mSize);
+    for (int i = 0; i < mSize; ++i)
+      acc[i] = mParticles[i].acc;
+  }
+
+  // Energies per unit particle mass; each particle's field is uniform, so
+  // its potential is -acc . pos
+  double kineticEnergy() const {
+    double K = 0;
+    for (int i = 0; i < mSize; ++i)
+      K += 0.5 * mParticles[i].vel.magSqr();
+    return K;
+  }
+
+  double potentialEnergy() const {
+    double U = 0;
+    for (int i = 0; i < mSize; ++i)
+      U -= mParticles[i].acc.dot(mParticles[i].pos);
+    return U;
+  }
+
+private:
+  void emit(Particle &p) {
+    // fountain
+    if (al::rnd::prob(0.95)) {
+      p.vel.set(al::rnd::uniform(-6., -3.), al::rnd::uniform(7.2, 8.4),
+                al::rnd::uniform(0.6));
+      p.acc.set(0, -7.2, 0);
+
+      // spray
+    } else {
+      p.vel.set(al::rnd::uniformS(0.6), al::rnd::uniformS(0.6), al::rnd::uniformS(0.6));
+      p.acc.set(0, 0, 0);
+    }
+    p.pos.set(4, -2, 0);
+
+    p.age = 0;
+    p.saturation = al::rnd::uniform();
+    p.id = mNextId++;
+  }
+
+  std::vector<Particle> mParticles;
+  int mSize = 0;
+  double mDue = 0; // Fraction of a particle due to be emitted
+  unsigned mNextId = 0;
+};
+
+// What the render thread needs of the emitter. The arrays only grow, so once
+// they reach the emitter's capacity copying allocates nothing.
+struct EmitterSnapshot {
+  std::vector<al::Vec3f> pos;
+  std::vector<unsigned> id;
+  std::vector<float> age, saturation;
+  int size = 0;
+  float lifetime = 1;
+
+  void copyFrom(const Emitter &em) {
+    size = em.size();
+    lifetime = em.lifetime;
+    if (int(pos.size()) < size) {
+      pos.resize(em.capacity());
+      id.resize(em.capacity());
+      age.resize(em.capacity());
+      saturation.resize(em.capacity());
+    }
+    for (int i = 0; i < size; ++i) {
+      pos[i] = em[i].pos;
+      id[i] = em[i].id;
+      age[i] = em[i].age;
+      saturation[i] = em[i].saturation;
+    }
+  }
+};
+
+// Writes the particles blended from snapshot a to b by t into the mesh's
+// vertices and colors. The mesh keeps the arrays' capacity, so they are only
+// reallocated when the emitter grows.
+inline void fillMesh(al::Mesh &mesh, const EmitterSnapshot &a,
+                     const EmitterSnapshot &b, float t, ThreadPool &pool) {
+  auto &verts = mesh.vertices();
+  auto &colors = mesh.colors();
+  verts.resize(b.size);
+  colors.resize(b.size);
+
+  // The color is al::HSV(0.6, saturation, value), which for a fixed hue is
+  // value * (1 - saturation * (1 - full)), full the color at saturation 1
+  static const al::Color full = al::HSV(0.6, 1, 1);
+  pool.parallelFor(0, b.size, [&](int begin, int end, int) {
+    for (int i = begin; i < end; ++i) {
+      // A particle that moved to this slot or was emitted in between is drawn
+      // where it is now rather than streaked from another particle's spot
+      al::Vec3f pos = b.pos[i];
+      if (i < a.size && a.id[i] == b.id[i])
+        pos = a.pos[i] + (b.pos[i] - a.pos[i]) * t;
+      float value = (1 - b.age[i] / b.lifetime) * 0.4f;
+      float s = b.saturation[i];
+
+      verts[i] = pos;
+      colors[i] = al::Color(value * (1 - s * (1 - full.r)),
+                        value * (1 - s * (1 - full.g)),
+                        value * (1 - s * (1 - full.b)));
+    }
+  });
+}
+
+#endif
@@ -0,0 +1,52 @@
+#pragma once
+#ifndef WaveSim_H
+#define WaveSim_H
+
+// The raindrops on a pool of waveEquation.cpp, without graphics
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "al/math/al_Random.hpp"
+
+#include "playground/ThreadPool.hpp"
+
+#include "WaveStencil.hpp"
+
+struct WaveSim {
+  WaveGrid grid;
+  std::unique_ptr<ThreadPool> pool;
+  int view = 256; // Side of the drawn surface
+
+  WaveSim(int size = 256, int numThreads = 0)
+      : grid(size, size), pool(new ThreadPool(numThreads)) {
+    view = std::min(size, 256);
+  }
+
+  void update() {
+    // Add some random droplets, as wide relative to the grid at any size
+    float radius = 4.f * grid.nx() / 256;
+    for (int k = 0; k < 3; ++k) {
+      if (al::rnd::prob(0.01)) {
+        int ix = al::rnd::uniform(grid.nx());
+        int iy = al::rnd::uniform(grid.ny());
+        grid.addDrop(ix, iy, radius, 0.5f);
+      }
+    }
+
+    grid.step(*pool);
+  }
+
+  // Samples the grid down to view x view heights
+  void capture(std::vector<float>& h) {
+    h.resize(view * view);
+    for (int j = 0; j < view; ++j) {
+      const float* row = grid.row(j * grid.ny() / view);
+      for (int i = 0; i < view; ++i)
+        h[j * view + i] = row[i * grid.nx() / view];
+    }
+  }
+};
+
+#endif
@@ -0,0 +1,133 @@
+#pragma once
+#ifndef WaveStencil_H
+#define WaveStencil_H
+
+// A toroidal 2D wave equation stencil laid out for SIMD and threads.
+//
+// The current and previous time steps are separate planes of rows padded
+// with one ghost cell on each side and one ghost row above and below. Before
+// a row is updated its ghost cells are filled with the values from the
+// opposite edge, so the inner loop reads its neighbors without any wrap
+// branches and compiles to straight vector code. Rows are split into one
+// contiguous block per thread. A row only reads its own ghost cells, and the
+// two ghost rows are filled before the threads start, so the threads never
+// wait on each other.
+//
+// Each step computes
+//
+//   u' = decay * (2u - u_prev + v^2 (u_left + u_right + u_up + u_down - 4u))
+//
+// and stores u' over u_prev, which is then swapped to become current.
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "playground/ThreadPool.hpp"
+
+class WaveGrid {
+public:
+  float decay = 0.96f;   // Decay factor of waves, in (0, 1]
+  float velocity = 0.5f; // Velocity of wave propagation, in (0, 0.5]
+
+  WaveGrid(int nx = 256, int ny = 256) { resize(nx, ny); }
+
+  // Resizes the grid and clears it
+  void resize(int nx, int ny) {
+    mNx = nx;
+    mNy = ny;
+    // Round rows up to 16 floats so every row starts on a 64-byte boundary
+    // relative to the plane
+    mStride = (nx + 2 + 15) & ~15;
+    mCurr.assign(mStride * (ny + 2), 0.f);
+    mPrev.assign(mStride * (ny + 2), 0.f);
+  }
+
+  int nx() const { return mNx; }
+  int ny() const { return mNy; }
+  long long cells() const { return (long long)mNx * mNy; }
+
+  // Value at cell (x, y) of the current step, 0 <= x < nx, 0 <= y < ny
+  float at(int x, int y) const { return mCurr[index(x, y)]; }
+
+  // Row y of the current step; x from 0 to nx - 1
+  const float *row(int y) const { return &mCurr[index(0, y)]; }
+
+  // Adds a Gaussian bump of the given radius (in cells) centered at (cx, cy)
+  // to both planes, so it starts at rest. Wraps around the edges.
+  void addDrop(int cx, int cy, float radius, float amplitude) {
+    int r = int(std::ceil(radius));
+    for (int j = -r; j <= r; ++j) {
+      for (int i = -r; i <= r; ++i) {
+        float x = i / radius;
+        float y = j / radius;
+        float v = amplitude * std::exp(-(x * x + y * y) / (0.5f * 0.5f));
+        int k = index(wrap(cx + i, mNx), wrap(cy + j, mNy));
+        mCurr[k] += v;
+        mPrev[k] += v;
+      }
+    }
+  }
+
+  // Advances one time step, splitting the rows across the pool
+  void step(ThreadPool &pool) {
+    // Ghost rows: above the first row is the last and below the last the first
+    std::copy_n(&mCurr[index(0, mNy - 1)], mNx, &mCurr[index(0, -1)]);
+    std::copy_n(&mCurr[index(0, 0)], mNx, &mCurr[index(0, mNy)]);
+
+    pool.parallelFor(0, mNy, [this](int begin, int end, int) {
+      for (int y = begin; y < end; ++y)
+        stepRow(y);
+    });
+    mCurr.swap(mPrev);
+  }
+
+  // Advances one time step on the calling thread
+  void step() {
+    ThreadPool serial(1);
+    step(serial);
+  }
+
+private:
+  int index(int x, int y) const { return (y + 1) * mStride + x + 1; }
+
+  static int wrap(int i, int n) { return ((i % n) + n) % n; }
+
+  void stepRow(int y) {
+    float *c = &mCurr[index(0, y)];
+    c[-1] = c[mNx - 1];
+    c[mNx] = c[0];
+    stencil(&mPrev[index(0, y)], c, c - mStride, c + mStride, mNx, velocity,
+            decay);
+  }
+
+  // Inner loop over one row. restrict tells the compiler the rows don't
+  // overlap, and the fixed-size blocks map onto vector registers even when
+  // it will only vectorize straight-line code (-O2).
+  static void stencil(float *__restrict prev, const float *__restrict c,
+                      const float *__restrict up, const float *__restrict down,
+                      int n, float v, float d) {
+    const int kLanes = 8;
+    int x = 0;
+    for (; x + kLanes <= n; x += kLanes) {
+      float out[kLanes];
+      for (int k = 0; k < kLanes; ++k)
+        out[k] = update(c + x + k, up[x + k], down[x + k], prev[x + k], v, d);
+      for (int k = 0; k < kLanes; ++k)
+        prev[x + k] = out[k];
+    }
+    for (; x < n; ++x)
+      prev[x] = update(c + x, up[x], down[x], prev[x], v, d);
+  }
+
+  static float update(const float *c, float up, float down, float prev,
+                      float v, float d) {
+    float lap = (c[-1] + c[1]) + (up + down) - 4 * c[0];
+    return (2 * c[0] - prev + v * lap) * d;
+  }
+
+  int mNx = 0, mNy = 0, mStride = 0;
+  std::vector<float> mCurr, mPrev;
+};
+
+#endif
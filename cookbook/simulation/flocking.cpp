@@ -15,6 +15,47 @@ calculating the "nearness" of flockmates. This is done primarily to avoid
 infinities, but also to give smoother motions. Lastly, we give each boid a
 random walk motion which helps both dissolve and redirect the flocks.
 
+Since both Gaussians are practically zero a few radii away, boids only need to
+look at flockmates that are close by. The flock is binned into a uniform grid
+over the [-1,1]^2 box every frame and only boids in nearby cells are compared.
+The cutoff (in units of the velocity matching radius) is the distance past
+which interactions are ignored; cells are half of it wide, so each boid scans
+the 5x5 block of cells around its own. The original all-pairs loop is kept as
+a reference and can be toggled with 'b'.
+
+Pressing 'v' switches to a vectorized kernel. It keeps a single precision,
+structure-of-arrays copy of the flock in cell order and evaluates each boid
+against a batch of flockmates at a time, using a fast approximation of exp.
+This path is double buffered (boids read the previous state and write their
+own slot of the next one) and is split across threads by runs of cells. The
+random hunting motion is a hash of the seed, step and boid index, so a given
+seed always produces the same flock, whatever the number of threads.
+
+The vectorized kernel looks at every pair from both sides and evaluates the
+Gaussians past the cutoff too, so it does about four times the work of the
+scalar grid. It only comes out ahead when the loop is compiled for wide
+vectors (e.g. -O3 -march=native on AVX2) or spread over several threads,
+which is why the scalar grid is the default.
+
+Press '[' and ']' to halve or double the number of boids.
+
+The flock itself is in Flock.hpp, so it can be stepped without a window.
+
+Run with -bench to step the flock headlessly and compare the grid against the
+all-pairs loop:
+
+    ./flocking -bench [maxBoids] [threads]
+
+The all-pairs loop is only timed up to 10k boids. The radii are fixed while
+the box is too, so the flockmates each boid looks at grow with the number of
+boids; the pairs/boid column reports how many the grid leaves.
+
+-kernel reports the time per boid-boid interaction of the scalar and vectorized
+kernels, and -check fails if the vectorized kernel deviates from a double
+precision reference by more than 1e-4 relative to the largest sum. -repro
+[threads] fails if the threaded flock does not match a single threaded run
+bit for bit.
+
 [1] Reynolds, C. W. (1987). Flocks, herds, and schools: A distributed behavioral
     model. Computer Graphics, 21(4):25–34.
 
@@ -22,28 +63,31 @@ Author:
 Lance Putnam, Oct. 2014
 */
 
+#include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
 
 #include "al/app/al_App.hpp"
 #include "al/graphics/al_Shapes.hpp"
 #include "al/math/al_Functions.hpp"
 #include "al/math/al_Random.hpp"
 
-using namespace al;
+#include "playground/CounterRandom.hpp"
+#include "playground/ThreadPool.hpp"
 
-// A "boid" (play on bird) is one member of a flock.
-class Boid {
- public:
-  // Each boid has a position and velocity.
-  Vec2d pos, vel;
+#include "Flock.hpp"
 
-  // Update position based on velocity and delta time
-  void update(double dt) { pos += vel * dt; }
-};
+using namespace al;
 
 struct MyApp : public App {
-  static const int Nb = 32;  // Number of boids
-  Boid boids[Nb];
+  int Nb = 32;  // Number of boids
+  Flock flock;
   Mesh heads, tails;
   Mesh box;
 
@@ -55,70 +99,16 @@ struct MyApp : public App {
     box.vertex(-1, 1);
     nav().pullBack(4);
 
+    flock.threads(0);
     resetBoids();
   }
 
-  // Randomize boid positions/velocities uniformly inside unit disc
-  void resetBoids() {
-    for (auto& b : boids) {
-      b.pos = rnd::ball<Vec2f>();
-      b.vel = rnd::ball<Vec2f>();
-    }
-  }
+  void resetBoids() { flock.reset(Nb, flock.seed + 1); }
 
   void onAnimate(double dt_ms) {
     double dt = dt_ms;
 
-    // Compute boid-boid interactions
-    for (int i = 0; i < Nb - 1; ++i) {
-      for (int j = i + 1; j < Nb; ++j) {
-        // printf("checking boids %d and %d\n", i,j);
-
-        auto ds = boids[i].pos - boids[j].pos;
-        auto dist = ds.mag();
-
-        // Collision avoidance
-        double pushRadius = 0.05;
-        double pushStrength = 1;
-        double push = exp(-al::pow2(dist / pushRadius)) * pushStrength;
-
-        auto pushVector = ds.normalized() * push;
-        boids[i].pos += pushVector;
-        boids[j].pos -= pushVector;
-
-        // Velocity matching
-        double matchRadius = 0.125;
-        double nearness = exp(-al::pow2(dist / matchRadius));
-        Vec2d veli = boids[i].vel;
-        Vec2d velj = boids[j].vel;
-
-        // Take a weighted average of velocities according to nearness
-        boids[i].vel = veli * (1 - 0.5 * nearness) + velj * (0.5 * nearness);
-        boids[j].vel = velj * (1 - 0.5 * nearness) + veli * (0.5 * nearness);
-
-        // TODO: Flock centering
-      }
-    }
-
-    // Update boid independent behaviors
-    for (auto& b : boids) {
-      // Random "hunting" motion
-      float huntUrge = 0.2f;
-      auto hunt = rnd::ball<Vec2f>();
-      // Use cubed distribution to make small jumps more frequent
-      hunt *= hunt.magSqr();
-      b.vel += hunt * huntUrge;
-
-      // Bound boid into a box
-      if (b.pos.x > 1 || b.pos.x < -1) {
-        b.pos.x = b.pos.x > 0 ? 1 : -1;
-        b.vel.x = -b.vel.x;
-      }
-      if (b.pos.y > 1 || b.pos.y < -1) {
-        b.pos.y = b.pos.y > 0 ? 1 : -1;
-        b.vel.y = -b.vel.y;
-      }
-    }
+    flock.step(dt);
 
     // Generate meshes
     heads.reset();
@@ -127,14 +117,14 @@ struct MyApp : public App {
     tails.reset();
     tails.primitive(Mesh::LINES);
 
-    for (size_t i = 0; i < Nb; ++i) {
-      boids[i].update(dt);
+    for (int i = 0; i < flock.size(); ++i) {
+      const Boid& b = flock.boids[i];
 
-      heads.vertex(boids[i].pos);
+      heads.vertex(b.pos);
       heads.color(HSV(float(i) / Nb * 0.3f + 0.3f, 0.7f));
 
-      tails.vertex(boids[i].pos);
-      tails.vertex(boids[i].pos - boids[i].vel.normalized(0.07));
+      tails.vertex(b.pos);
+      tails.vertex(b.pos - b.vel.normalized(0.07));
 
       tails.color(heads.colors()[i]);
       tails.color(RGB(0.5));
@@ -161,12 +151,218 @@ struct MyApp : public App {
       case 'r':
         resetBoids();
         break;
+      case 'b':
+        flock.bruteForce = !flock.bruteForce;
+        printf("%s\n", flock.bruteForce ? "all pairs" : "neighbor grid");
+        break;
+      case 'v':
+        flock.vectorized = !flock.vectorized;
+        printf("%s kernel\n", flock.vectorized ? "vectorized" : "scalar");
+        break;
+      case '[':
+        if (Nb > 2) Nb /= 2;
+        resetBoids();
+        break;
+      case ']':
+        Nb *= 2;
+        resetBoids();
+        break;
     }
     return true;
   }
 };
 
-int main() {
+// Steps per second of the flock, measured for at least minSeconds
+double stepsPerSecond(Flock& flock, double minSeconds) {
+  typedef std::chrono::steady_clock Clock;
+  auto start = Clock::now();
+  int steps = 0;
+  double elapsed = 0;
+  do {
+    flock.step(1. / 60);
+    ++steps;
+    elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+  } while (elapsed < minSeconds);
+  return steps / elapsed;
+}
+
+void benchmark(int maxBoids, int numThreads) {
+  // Largest flock timed with the all-pairs loop, which takes minutes a step
+  // past it
+  static const int maxPairsBoids = 10000;
+  printf("%10s %14s %14s %14s %14s %12s\n", "boids", "pairs steps/s",
+         "grid steps/s", "simd steps/s", "threads", "pairs/boid");
+  static const int sizes[] = {32, 100, 1000, 10000, 100000, 200000};
+  for (int Nb : sizes) {
+    if (Nb > maxBoids) break;
+    Flock flock;
+    double pairs = 0;
+    if (Nb <= maxPairsBoids) {
+      flock.reset(Nb, 1);
+      flock.bruteForce = true;
+      pairs = stepsPerSecond(flock, 0.5);
+    }
+
+    flock.reset(Nb, 1);
+    flock.bruteForce = false;
+    double grid = stepsPerSecond(flock, 0.5);
+
+    flock.reset(Nb, 1);
+    flock.vectorized = true;
+    double simd = stepsPerSecond(flock, 0.5);
+
+    flock.reset(Nb, 1);
+    flock.threads(numThreads);
+    double threaded = stepsPerSecond(flock, 0.5);
+
+    if (Nb <= maxPairsBoids) {
+      printf("%10d %14.1f", Nb, pairs);
+    } else {
+      printf("%10d %14s", Nb, "-");
+    }
+    printf(" %14.1f %14.1f %14.1f %12.1f\n", grid, simd, threaded,
+           flock.pairsPerBoid());
+    fflush(stdout);
+  }
+}
+
+// Double precision version of accumulatePairs using the standard library
+void accumulatePairsReference(const Flock& f, int begin, int end, int i,
+                              double out[5]) {
+  const FlockSoA& s = f.soa;
+  double cutoffSqr = al::pow2(f.cutoffDistance());
+  for (int j = begin; j < end; ++j) {
+    double dx = double(s.x[i]) - s.x[j];
+    double dy = double(s.y[i]) - s.y[j];
+    double d2 = dx * dx + dy * dy;
+    if (d2 <= 0 || d2 >= cutoffSqr) continue;
+    double push = exp(-d2 / al::pow2(f.pushRadius)) * f.pushStrength;
+    double near = 0.5 * exp(-d2 / al::pow2(f.matchRadius));
+    out[0] += push * dx / sqrt(d2);
+    out[1] += push * dy / sqrt(d2);
+    out[2] += near;
+    out[3] += near * s.vx[j];
+    out[4] += near * s.vy[j];
+  }
+}
+
+// Runs fn over the rows of flockmates of every boid, returning the number of
+// pairs looked at
+template <class Fn>
+double forEachRow(const Flock& flock, Fn fn) {
+  double pairs = 0;
+  flock.forEachRow(0, flock.size(), [&](int k, int begin, int end) {
+    fn(k, begin, end);
+    pairs += end - begin;
+  });
+  return pairs;
+}
+
+// Compares the vectorized kernel against the double precision reference for
+// a single step. Returns false if the largest deviation, relative to the
+// largest magnitude of each sum, is above tolerance.
+bool checkKernel(int Nb, double tolerance) {
+  Flock flock;
+  flock.reset(Nb, 1);
+  flock.accumulateNeighbors();
+
+  std::vector<double> ref(Nb * 5, 0.);
+  forEachRow(flock, [&](int k, int begin, int end) {
+    accumulatePairsReference(flock, begin, end, k, &ref[k * 5]);
+  });
+
+  static const char* names[5] = {"push x", "push y", "weight", "match x",
+                                 "match y"};
+  bool ok = true;
+  for (int q = 0; q < 5; ++q) {
+    double maxErr = 0, maxMag = 0;
+    for (int k = 0; k < Nb; ++k) {
+      const PairSums& s = flock.sums[k];
+      float vals[5] = {s.px, s.py, s.w, s.mx, s.my};
+      maxErr = std::max(maxErr, std::abs(vals[q] - ref[k * 5 + q]));
+      maxMag = std::max(maxMag, std::abs(ref[k * 5 + q]));
+    }
+    double relErr = maxMag > 0 ? maxErr / maxMag : maxErr;
+    printf("%8s: max deviation %.3g (%.3g relative)\n", names[q], maxErr,
+           relErr);
+    if (relErr > tolerance) ok = false;
+  }
+  printf("%s\n", ok ? "PASS" : "FAIL");
+  return ok;
+}
+
+// Time per boid-boid interaction of the scalar and vectorized kernels
+void benchmarkKernel(int Nb) {
+  typedef std::chrono::steady_clock Clock;
+  Flock flock;
+  flock.reset(Nb, 1);
+  flock.accumulateNeighbors();
+  KernelParams params = flock.kernelParams();
+
+  auto start = Clock::now();
+  double sink = 0;
+  double pairs = forEachRow(flock, [&](int k, int begin, int end) {
+    double out[5] = {0};
+    accumulatePairsReference(flock, begin, end, k, out);
+    sink += out[2];
+  });
+  double scalar = std::chrono::duration<double>(Clock::now() - start).count();
+
+  start = Clock::now();
+  forEachRow(flock, [&](int k, int begin, int end) {
+    PairSums sums;
+    accumulatePairs(flock.soa, begin, end, flock.soa.x[k], flock.soa.y[k],
+                    params, sums);
+    sink -= sums.w;
+  });
+  double simd = std::chrono::duration<double>(Clock::now() - start).count();
+
+  printf("%d boids, %.0f interactions (check %g)\n", Nb, pairs, sink);
+  printf("scalar: %6.2f ns/interaction\n", scalar / pairs * 1e9);
+  printf("simd:   %6.2f ns/interaction\n", simd / pairs * 1e9);
+}
+
+// Checksum of the double buffered flock after a number of steps
+uint64_t runChecksum(int Nb, int numSteps, int numThreads) {
+  Flock flock;
+  flock.vectorized = true;
+  flock.threads(numThreads);
+  flock.reset(Nb, 1234);
+  for (int i = 0; i < numSteps; ++i) flock.step(1. / 60);
+  return flock.checksum();
+}
+
+// Runs the double buffered flock twice with numThreads threads and once with
+// a single thread. Returns false if the final states are not bit identical.
+bool checkReproducible(int numThreads, int Nb, int numSteps) {
+  uint64_t a = runChecksum(Nb, numSteps, numThreads);
+  uint64_t b = runChecksum(Nb, numSteps, numThreads);
+  uint64_t c = runChecksum(Nb, numSteps, 1);
+  printf("%d boids, %d steps\n", Nb, numSteps);
+  printf("%2d threads: %016llx\n", numThreads, (unsigned long long)a);
+  printf("%2d threads: %016llx\n", numThreads, (unsigned long long)b);
+  printf("%2d thread:  %016llx\n", 1, (unsigned long long)c);
+  bool ok = a == b && a == c;
+  printf("%s\n", ok ? "PASS" : "FAIL");
+  return ok;
+}
+
+int main(int argc, char* argv[]) {
+  std::string mode = argc > 1 ? argv[1] : "";
+  if (mode == "-bench") {
+    benchmark(argc > 2 ? std::stoi(argv[2]) : 100000,
+              argc > 3 ? std::stoi(argv[3]) : 0);
+    return 0;
+  } else if (mode == "-kernel") {
+    benchmarkKernel(argc > 2 ? std::stoi(argv[2]) : 10000);
+    return 0;
+  } else if (mode == "-check") {
+    return checkKernel(argc > 2 ? std::stoi(argv[2]) : 2000, 1e-4) ? 0 : 1;
+  } else if (mode == "-repro") {
+    int numThreads = argc > 2 ? std::stoi(argv[2]) : 4;
+    return checkReproducible(numThreads, 5000, 100) ? 0 : 1;
+  }
+
   MyApp().start();
   return 0;
 }
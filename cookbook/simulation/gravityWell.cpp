@@ -3,10 +3,44 @@ Allocore Example: Gravity Well
 
 Description:
 The demonstrates how to make many lightweight bodies interact with the
-gravitational pull of a single heavy body.
+gravitational pull of heavy bodies ("wells").
 
 Press the number keys to reset the particles with different initial conditions.
 
+Press 'n' to have the particles also attract each other. Summing the pull of
+every particle on every other is O(N^2), so the mutual gravity is computed
+with a Barnes-Hut octree (see BarnesHut.hpp). Use ',' and '.' to lower or
+raise its opening angle theta, trading accuracy for speed, up to 1.
+
+Other keys:
+  '[' / ']'   halve / double the number of particles
+  '=' / '-'   add / remove a well
+  Tab         select the next well
+  j/l i/k u/o move the selected well along x, y and z
+
+Drawing each particle with its own push/translate/draw/pop is one draw call
+per particle. By default the particles are instead drawn with instancing:
+their positions are packed into one buffer that is streamed to the GPU every
+frame and the icosahedron is drawn for all of them in a single call. Press 'g'
+to switch between the two.
+
+The simulation itself is in GravitySystem.hpp, so it can be stepped without a
+window. The particles are moved by one of the integrators in Integrators.hpp. Press
+'m' to cycle through them, ';' / '\'' to lower / raise the number of substeps
+per frame and 'p' to let the substeps adapt to the largest acceleration.
+Press 'h' to print the total energy and how far it has drifted, which shows
+how well a method and step size conserve it.
+
+Run with -bench to time the force evaluation headlessly for increasing N,
+against the direct sum, and with -pack to time packing the instance buffer:
+
+    ./gravityWell -bench [maxParticles] [threads]
+    ./gravityWell -pack [particles] [threads]
+
+and with -energy to compare the energy drift of the integrators:
+
+    ./gravityWell -energy [particles] [seconds] [substeps]
+
 Author:
 Lance Putnam, Nov. 2015
 */
@@ -18,108 +52,113 @@ Lance Putnam, Nov. 2015
 #include "al/math/al_Random.hpp"
 #include "al/system/al_Time.hpp"
 #include <algorithm> // max
+#include <chrono>
 #include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "playground/ThreadPool.hpp"
+
+#include "GravitySystem.hpp"
+#include "Integrators.hpp"
 
 using namespace al;
 using namespace std;
 
-// A particle with acceleration
-class Particle {
-public:
-  Vec3f pos;
-  Vec3f vel;
-  Vec3f acc;
-
-  void update(double dt) {
-    // Semi-implicit Euler method:
-    vel += acc * dt;
-    pos += vel * dt;
-  }
-};
+// Instanced drawing: the mesh attributes are shared by all instances and
+// each instance adds its own offset (xyz) and scale (w) from location 5
+const std::string instanceVert = R"(
+#version 330
+uniform mat4 al_ModelViewMatrix;
+uniform mat4 al_ProjectionMatrix;
+
+layout (location = 0) in vec3 position;
+layout (location = 3) in vec3 normal;
+layout (location = 5) in vec4 offsetScale;
+
+out vec3 N;
+
+void main() {
+  vec4 p = vec4(position * offsetScale.w + offsetScale.xyz, 1.0);
+  gl_Position = al_ProjectionMatrix * al_ModelViewMatrix * p;
+  N = normal;
+}
+)";
+
+const std::string instanceFrag = R"(
+#version 330
+uniform vec4 color;
+uniform vec3 lightDir;
+
+in vec3 N;
+layout (location = 0) out vec4 fragColor;
+
+void main() {
+  float diffuse = max(dot(normalize(N), lightDir), 0.0);
+  fragColor = vec4(color.rgb * (0.3 + 0.7 * diffuse), color.a);
+}
+)";
 
 class MyApp : public App {
 public:
-  static const int M = 20;
-  static const int N = M * M;
-  Particle particles[N];
-  Particle well;
-  Mesh body1, body2;
+  int N = 400;
+  GravitySystem sim;
+  int selectedWell = 0;
+  bool showEnergy = false;
+  EnergyMonitor energy;
+  VAOMesh body1;
+  Mesh body2;
   Light light1, light2;
 
+  bool instanced = true;
+  ShaderProgram instanceShader;
+  BufferObject instanceBuffer;
+  vector<Vec4f> instances;
+
   void onCreate() override {
     reset();
+    energy.hook = [this](const EnergyMonitor &e) {
+      printf("\rE = %.6f  drift %+.3e  last frame %+.3e  substeps %d   ",
+             e.total(), e.drift(), e.frameDrift(), sim.integrator.lastSubsteps());
+      fflush(stdout);
+    };
     addIcosahedron(body1, 0.03);
     body1.generateNormals();
+    body1.update();
     addTorus(body2, 0.03, 0.1);
     body2.generateNormals();
 
+    instanceShader.compile(instanceVert, instanceFrag);
+
+    // Attach the instance buffer to the icosahedron's vertex array, advancing
+    // once per instance rather than once per vertex
+    instanceBuffer.bufferType(GL_ARRAY_BUFFER);
+    instanceBuffer.usage(GL_STREAM_DRAW);
+    instanceBuffer.create();
+    auto &vao = body1.vao();
+    vao.bind();
+    vao.enableAttrib(5);
+    vao.attribPointer(5, instanceBuffer, 4);
+    glVertexAttribDivisor(5, 1);
+
     nav().pullBack(3.5);
     nav().faceToward(Vec3f(0, 0.7, -1));
   }
 
   void reset(int preset = '1') {
-    switch (preset) {
-    case '1': // dust cloud
-      for (auto &p : particles) {
-        p.pos = rnd::ball<Vec3f>() * 0.2 + Vec3f(-0.7, 0, 0);
-        p.vel = Vec3f(0, -0.3, 0);
-      }
-      break;
-    case '2': // hourglass
-      for (auto &p : particles) {
-        p.pos = rnd::ball<Vec3f>().mag(1);
-        p.vel = clone(p.pos).rotate(M_PI / 2) * Vec3f(1, 1, -1) * 0.2;
-      }
-      break;
-    case '3': // line orbit 1
-      for (int i = 0; i < N; ++i) {
-        particles[i].pos = Vec3f(float(i) / N * 0.5 - 1, 0, 0);
-        particles[i].vel = Vec3f(0, -0.3, 0);
-      }
-      break;
-    case '4': // line orbit 2
-      for (int i = 0; i < N; ++i) {
-        float frac = float(i) / N;
-        particles[i].pos = Vec3f(-0.8, frac, 0);
-        particles[i].vel = Vec3f(-0.1, -0.2, 0.2);
-      }
-      break;
-    case '5': // grid formation (side)
-      for (int i = 0; i < N; ++i) {
-        particles[i].pos = Vec3f(-1, float(i % M) / (M - 1) * 2 - 1,
-                                 float(i / M) / (M - 1) * 2 - 1);
-        particles[i].vel = Vec3f(0, 0, 0);
-      }
-      break;
-    case '6': // grid formation (front)
-      for (int i = 0; i < N; ++i) {
-        particles[i].pos = Vec3f(float(i % M) / (M - 1) - 0.5,
-                                 float(i / M) / (M - 1) - 0.5, 1);
-        particles[i].vel = Vec3f(0.1, 0, 0);
-      }
-      break;
-    }
+    initialize(sim, N, preset);
+    energy.restart();
   }
 
   void onAnimate(double dt_ms) override {
     // convert millisecond to second
     float dt = dt_ms;
 
-    // Compute forces
-    for (auto &p : particles) {
-      // Newton's law of gravity
-      auto r21 = well.pos - p.pos; // distance vector between well and particle
-      auto dist = r21.mag();       // distance between well and particle
-      dist = std::max(dist, 0.1f); // prevent high velocities
-      auto F = r21 / (dist * dist * dist); // force vector acting on particle
+    sim.step(dt);
 
-      // Newton's second law of motion, F = ma -> a = F/m
-      p.acc = F * (1. / 10); // mass of particle is 10
-    }
-
-    // Update particles
-    for (auto &p : particles)
-      p.update(dt);
+    if (showEnergy)
+      energy.record(sim.kineticEnergy(), sim.potentialEnergy());
   }
 
   void onDraw(Graphics &g) override {
@@ -143,34 +182,281 @@ public:
     l3.diffuse({1, 0, 0});
     g.light(l3, 2);
 
-    // Draw the well
-    g.color(HSV(0.2));
-    g.draw(body2);
-
-    // Draw the particles
-    g.color(HSV(0.67, 0.2, 0.5));
-    for (auto &p : particles) {
+    // Draw the wells
+    for (int i = 0; i < int(sim.wells.size()); ++i) {
+      g.color(HSV(0.2, i == selectedWell ? 0.5 : 1));
       g.pushMatrix();
-      g.translate(p.pos);
-      g.draw(body1);
+      g.translate(sim.wells[i]);
+      g.draw(body2);
       g.popMatrix();
     }
 
+    // Draw the particles
+    if (instanced) {
+      drawInstanced(g);
+    } else {
+      g.color(HSV(0.67, 0.2, 0.5));
+      for (auto &p : sim.particles) {
+        g.pushMatrix();
+        g.translate(p.pos);
+        g.draw(body1);
+        g.popMatrix();
+      }
+    }
+
     // cout << "\rfps: " << fps() << rnd::uniform() << flush;
     //		cout << "\rfps: " << fps() << "   " << rnd::uniform() << flush;
   }
 
+  void drawInstanced(Graphics &g) {
+    // Stream this frame's instances, orphaning the previous buffer storage so
+    // the upload does not wait for the GPU to finish with the last frame
+    size_t bytes = packInstances(sim, 1, instances, sim.pool);
+    instanceBuffer.bind();
+    instanceBuffer.data(bytes, instances.data());
+
+    g.shader(instanceShader);
+    g.shader().uniform("color", Color(HSV(0.67, 0.2, 0.5)));
+    g.shader().uniform("lightDir", Vec3f(1, 1, 1).normalize());
+    g.update();
+
+    body1.vao().bind();
+    if (body1.indices().size()) {
+      body1.indexBuffer().bind();
+      glDrawElementsInstanced(GL_TRIANGLES, body1.indices().size(),
+                              GL_UNSIGNED_INT, 0, sim.size());
+    } else {
+      glDrawArraysInstanced(GL_TRIANGLES, 0, body1.vertices().size(),
+                            sim.size());
+    }
+  }
+
   bool onKeyDown(const Keyboard &k) override {
-    reset(k.key());
+    if (k.key() >= '1' && k.key() <= '6')
+      reset(k.key());
 
-    if (k.key() == ' ') {
+    auto &wells = sim.wells;
+    float step = 0.05;
+    switch (k.key()) {
+    case ' ':
       graphics().toggleLight(1);
+      break;
+    case 'g':
+      instanced = !instanced;
+      printf("%s drawing\n", instanced ? "instanced" : "per particle");
+      break;
+    case 'n':
+      sim.nbody = !sim.nbody;
+      sim.integrator.reset();
+      energy.restart();
+      printf("mutual gravity %s\n", sim.nbody ? "on" : "off");
+      break;
+    case ',':
+      sim.tree.theta = std::max(0.f, sim.tree.theta - 0.1f);
+      printf("theta = %g\n", sim.tree.theta);
+      break;
+    case '.':
+      sim.tree.theta += 0.1f;
+      if (sim.tree.theta > BarnesHut::maxTheta)
+        sim.tree.theta = BarnesHut::maxTheta;
+      printf("theta = %g\n", sim.tree.theta);
+      break;
+    case 'm':
+      sim.integrator.method = nextIntegrator(sim.integrator.method);
+      sim.integrator.reset();
+      energy.restart();
+      printf("\n%s\n", integratorName(sim.integrator.method));
+      break;
+    case 'p':
+      sim.integrator.adaptive = !sim.integrator.adaptive;
+      energy.restart();
+      printf("\nadaptive substeps %s\n", sim.integrator.adaptive ? "on" : "off");
+      break;
+    case ';':
+      sim.integrator.substeps = std::max(1, sim.integrator.substeps - 1);
+      energy.restart();
+      printf("\n%d substeps\n", sim.integrator.substeps);
+      break;
+    case '\'':
+      sim.integrator.substeps += 1;
+      energy.restart();
+      printf("\n%d substeps\n", sim.integrator.substeps);
+      break;
+    case 'h':
+      showEnergy = !showEnergy;
+      energy.restart();
+      printf("\n");
+      break;
+    case '[':
+      N = std::max(N / 2, 4);
+      reset();
+      break;
+    case ']':
+      N *= 2;
+      reset();
+      break;
+    case '=':
+      wells.push_back(rnd::ball<Vec3f>() * 0.5);
+      selectedWell = wells.size() - 1;
+      break;
+    case '-':
+      if (!wells.empty())
+        wells.pop_back();
+      selectedWell = std::max(0, std::min(selectedWell, int(wells.size()) - 1));
+      break;
+    case Keyboard::TAB:
+      if (!wells.empty())
+        selectedWell = (selectedWell + 1) % wells.size();
+      break;
+    }
+
+    if (selectedWell < int(wells.size())) {
+      Vec3f &w = wells[selectedWell];
+      switch (k.key()) {
+      case 'j': w.x -= step; break;
+      case 'l': w.x += step; break;
+      case 'k': w.y -= step; break;
+      case 'i': w.y += step; break;
+      case 'u': w.z -= step; break;
+      case 'o': w.z += step; break;
+      }
     }
     return true;
   }
 };
 
-int main() {
+// Times the mutual gravity of N particles in a uniform ball. The direct sum is
+// evaluated for a sample of particles, which also gives the error of the tree.
+void benchmark(int maxN, int numThreads) {
+  typedef std::chrono::steady_clock Clock;
+  auto ms = [](Clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0)
+        .count();
+  };
+
+  printf("%d threads\n", GravitySystem(numThreads).pool.size());
+  printf("%9s %7s %10s %10s %12s %10s\n", "particles", "nodes", "build ms",
+         "tree ms", "direct ms", "rms error");
+
+  for (int N = 1000; N <= maxN; N *= 10) {
+    GravitySystem sim(numThreads);
+    auto &pool = sim.pool;
+    sim.resize(N);
+    for (auto &p : sim.particles)
+      p.pos = rnd::ball<Vec3f>();
+
+    auto t0 = Clock::now();
+    sim.buildTree();
+    double buildTime = ms(t0);
+
+    std::vector<Vec3f> acc;
+    t0 = Clock::now();
+    sim.tree.accelerations(pool, acc);
+    double treeTime = ms(t0);
+
+    // Direct sum on a sample, scaled up to all particles
+    int numSamples = std::min(N, 1000);
+    std::vector<Vec3f> direct(numSamples);
+    t0 = Clock::now();
+    pool.parallelFor(0, numSamples, [&](int begin, int end, int) {
+      for (int s = begin; s < end; ++s)
+        direct[s] = sim.tree.accelerationDirect(sim.particles[s].pos);
+    });
+    double directTime = ms(t0) * N / numSamples;
+
+    double errSqr = 0, magSqr = 0;
+    for (int s = 0; s < numSamples; ++s) {
+      errSqr += (acc[s] - direct[s]).magSqr();
+      magSqr += direct[s].magSqr();
+    }
+
+    printf("%9d %7d %10.2f %10.2f %11.2f%s %10.2e\n", N,
+           int(sim.tree.nodes().size()), buildTime, treeTime, directTime,
+           numSamples < N ? "*" : " ", std::sqrt(errSqr / magSqr));
+    fflush(stdout);
+  }
+  printf("* extrapolated from 1000 particles\n");
+}
+
+// Bytes and time per frame of packing the instance buffer
+void benchmarkPacking(int N, int numThreads) {
+  GravitySystem sim(numThreads);
+  auto &pool = sim.pool;
+  sim.resize(N);
+  for (auto &p : sim.particles)
+    p.pos = rnd::ball<Vec3f>();
+  vector<Vec4f> instances;
+  packInstances(sim, 1, instances, pool); // allocate
+
+  typedef std::chrono::steady_clock Clock;
+  int frames = 0;
+  size_t bytes = 0;
+  auto t0 = Clock::now();
+  double elapsed = 0;
+  do {
+    bytes = packInstances(sim, 1, instances, pool);
+    ++frames;
+    elapsed = std::chrono::duration<double>(Clock::now() - t0).count();
+  } while (elapsed < 0.5);
+
+  double msPerFrame = elapsed / frames * 1000;
+  printf("%d particles, %d threads\n", N, pool.size());
+  printf("%zu bytes/frame, %.3f ms/frame, %.2f GB/s\n", bytes, msPerFrame,
+         bytes / (msPerFrame * 1e-3) * 1e-9);
+}
+
+// Energy drift of each integrator over a few orbits of the line orbit preset
+// with mutual gravity, stepped at 60 frames per second
+void benchmarkEnergy(int N, double seconds, int substeps) {
+  typedef std::chrono::steady_clock Clock;
+  printf("%d particles, %g s at 60 fps, %d substeps\n", N, seconds, substeps);
+  printf("%20s %12s %12s %10s\n", "method", "drift", "max |drift|",
+         "ms/frame");
+
+  IntegratorMethod m = IntegratorMethod::EULER;
+  do {
+    GravitySystem sim;
+    sim.nbody = true;
+    sim.integrator.method = m;
+    sim.integrator.substeps = substeps;
+    initialize(sim, N, '3');
+
+    EnergyMonitor energy;
+    energy.record(sim.kineticEnergy(), sim.potentialEnergy());
+    double maxDrift = 0;
+    int frames = int(seconds * 60);
+    double stepTime = 0;
+    for (int f = 0; f < frames; ++f) {
+      auto t0 = Clock::now();
+      sim.step(1. / 60);
+      stepTime += std::chrono::duration<double>(Clock::now() - t0).count();
+      energy.record(sim.kineticEnergy(), sim.potentialEnergy());
+      maxDrift = std::max(maxDrift, std::abs(energy.drift()));
+    }
+    printf("%20s %+12.3e %12.3e %10.3f\n", integratorName(m), energy.drift(),
+           maxDrift, stepTime / frames * 1000);
+    fflush(stdout);
+    m = nextIntegrator(m);
+  } while (m != IntegratorMethod::EULER);
+}
+
+int main(int argc, char *argv[]) {
+  std::string mode = argc > 1 ? argv[1] : "";
+  if (mode == "-bench") {
+    benchmark(argc > 2 ? std::stoi(argv[2]) : 1000000,
+              argc > 3 ? std::stoi(argv[3]) : 0);
+    return 0;
+  } else if (mode == "-energy") {
+    benchmarkEnergy(argc > 2 ? std::stoi(argv[2]) : 400,
+                    argc > 3 ? std::stod(argv[3]) : 20,
+                    argc > 4 ? std::stoi(argv[4]) : 1);
+    return 0;
+  } else if (mode == "-pack") {
+    benchmarkPacking(argc > 2 ? std::stoi(argv[2]) : 100000,
+                     argc > 3 ? std::stoi(argv[3]) : 0);
+    return 0;
+  }
+
   MyApp().start();
   return 0;
 }
@@ -5,56 +5,382 @@ Description:
 A Lévy flight is a random walk where the step size is determined by a function
 that is heavy-tailed. This example uses a Cauchy distribution.
 
+The walk itself is in LevyFlight.hpp, so it can be stepped without a window.
+Its trail lives in vertex buffers used as a ring: each frame only the few new
+points are written over the oldest ones, and the strip is drawn in up to two
+pieces starting from the oldest point. Colors are set when a point is added
+and the shader fades them by how long ago that was, so a frame costs the same
+for a trail of a thousand points or of millions.
+
+    ./levyFlight [trailLength]
+
+With -walkers, thousands of walkers flight at once, each with its own trail.
+Their steps are drawn in batches from counter-based random numbers (see
+LevyFlight.hpp) and split across threads:
+
+    ./levyFlight -walkers [count] [trailLength] [threads]
+
+Run with -bench to time a frame for increasing trail lengths, against
+rebuilding the whole mesh every frame:
+
+    ./levyFlight -bench [maxTrailLength]
+
+and -walkers-bench to time batched against one-at-a-time random steps and
+frames of many walkers, and to check the walks do not depend on the number of
+threads:
+
+    ./levyFlight -walkers-bench [count] [threads]
+
 Author:
 Lance Putnam, 9/2011
 */
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
 #include "al/app/al_App.hpp"
-#include "al/math/al_Functions.hpp"
-#include "al/math/al_Random.hpp"
-#include "al/types/al_Buffer.hpp"
+
+#include "LevyFlight.hpp"
 
 using namespace al;
 
+const std::string trailVert = R"(
+#version 330
+uniform mat4 al_ModelViewMatrix;
+uniform mat4 al_ProjectionMatrix;
+uniform float now;
+uniform float history;
+
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec4 color;
+layout (location = 2) in float time;
+
+out vec4 vColor;
+
+void main() {
+  gl_Position = al_ProjectionMatrix * al_ModelViewMatrix * vec4(position, 1.0);
+  float fade = clamp(1.0 - (now - time) / history, 0.0, 1.0);
+  vColor = vec4(color.rgb * fade, color.a);
+}
+)";
+const std::string trailFrag = R"(
+#version 330
+in vec4 vColor;
+layout (location = 0) out vec4 fragColor;
+
+void main() { fragColor = vColor; }
+)";
+
+// GPU copy of a TrailRing: one buffer per vertex attribute, holding every slot
+// of the ring. Only the slots written since the last upload are sent.
+struct TrailBuffers {
+  VAO vao;
+  BufferObject positions, colors, times, indices;
+
+  // With segments, also makes the index buffer that joins each point of a
+  // slot to the same point of the next slot, for drawSegments()
+  void create(const TrailRing &trail, bool segments) {
+    int points = (trail.capacity() + 1) * trail.width();
+    vao.create();
+    vao.bind();
+    createBuffer(positions, 0, 3, points * sizeof(Vec3f));
+    createBuffer(colors, 1, 4, points * sizeof(Color));
+    createBuffer(times, 2, 1, points * sizeof(float));
+
+    if (segments) {
+      int w = trail.width();
+      std::vector<unsigned> lines;
+      lines.reserve(size_t(trail.capacity()) * w * 2);
+      for (int s = 0; s < trail.capacity(); ++s) {
+        for (int k = 0; k < w; ++k) {
+          lines.push_back(s * w + k);
+          lines.push_back((s + 1) * w + k);
+        }
+      }
+      indices.bufferType(GL_ELEMENT_ARRAY_BUFFER);
+      indices.create();
+      indices.bind();
+      indices.data(lines.size() * sizeof(unsigned), lines.data());
+    }
+  }
+
+  void createBuffer(BufferObject &buffer, int location, int components,
+                    size_t bytes) {
+    buffer.bufferType(GL_ARRAY_BUFFER);
+    buffer.usage(GL_DYNAMIC_DRAW);
+    buffer.create();
+    buffer.bind();
+    buffer.data(bytes, nullptr);
+    vao.enableAttrib(location);
+    vao.attribPointer(location, buffer, components);
+  }
+
+  // Uploads the slots written since the last call
+  void upload(TrailRing &trail) {
+    TrailRing::Range dirty[3];
+    int n = trail.takeDirty(dirty);
+    int w = trail.width();
+    for (int i = 0; i < n; ++i) {
+      int begin = dirty[i].begin * w;
+      int count = (dirty[i].end - dirty[i].begin) * w;
+      positions.bind();
+      positions.subdata(begin * sizeof(Vec3f), count * sizeof(Vec3f),
+                        trail.positions() + begin);
+      colors.bind();
+      colors.subdata(begin * sizeof(Color), count * sizeof(Color),
+                     trail.colors() + begin);
+      times.bind();
+      times.subdata(begin * sizeof(float), count * sizeof(float),
+                    trail.times() + begin);
+    }
+  }
+
+  // Draws a trail of width 1 as a line strip, oldest to newest
+  void drawStrips(const TrailRing &trail) {
+    vao.bind();
+    TrailRing::Range ranges[2];
+    int n = trail.drawRanges(ranges);
+    for (int i = 0; i < n; ++i)
+      glDrawArrays(GL_LINE_STRIP, ranges[i].begin,
+                   ranges[i].end - ranges[i].begin);
+  }
+
+  // Draws every trail of the ring as lines between its slots
+  void drawSegments(const TrailRing &trail) {
+    vao.bind();
+    indices.bind();
+    TrailRing::Range ranges[2];
+    int n = trail.segmentRanges(ranges);
+    size_t perSegment = size_t(trail.width()) * 2;
+    for (int i = 0; i < n; ++i)
+      glDrawElements(
+          GL_LINES, int((ranges[i].end - ranges[i].begin) * perSegment),
+          GL_UNSIGNED_INT,
+          (void *)(ranges[i].begin * perSegment * sizeof(unsigned)));
+  }
+};
+
 struct MyApp : public App {
-  RingBuffer<Vec3f> A{8000};
-  Mesh vert;
+  LevyFlight walk;
+  ShaderProgram trailShader;
+  TrailBuffers buffers;
+
+  MyApp(int trailLength) { walk.trail.resize(trailLength); }
 
-  void onCreate() { nav().pullBack(4); }
+  void onCreate() {
+    nav().pullBack(4);
+    trailShader.compile(trailVert, trailFrag);
+    buffers.create(walk.trail, false);
+  }
 
   void onAnimate(double dt) {
-    for (int i = 0; i < 4; ++i) {
-      auto p = rnd::ball<Vec3f>();
+    walk.step(dt);
+    buffers.upload(walk.trail);
+  }
 
-      float mm = p.magSqr();
-      float l = 0.04f;  // spread of steps; lower is more flighty
-      float v = l / (mm + l * l) * 0.1f;  // map uniform to Cauchy distribution
+  void onDraw(Graphics &g) {
+    g.clear(0);
+    g.shader(trailShader);
+    g.shader().uniform("now", walk.time);
+    g.shader().uniform("history", walk.historySeconds());
+    g.update();
+    buffers.drawStrips(walk.trail);
+  }
+};
 
-      p = p.normalized() * v;
-      p += A.newest();
-      A.write(p);
-    }
+// Many walkers, each with its own trail
+struct WalkersApp : public App {
+  LevyWalkers walkers;
+  ThreadPool pool;
+  ShaderProgram trailShader;
+  TrailBuffers buffers;
 
-    vert.primitive(Mesh::LINE_STRIP);
-    vert.reset();
-    for (int i = 0; i < A.fill(); ++i) {
-      float f = float(i) / A.size();
-      vert.vertex(A.read(i));
+  WalkersApp(int count, int trailLength, int numThreads) : pool(numThreads) {
+    walkers.reset(count, trailLength);
+  }
 
-      Vec3f dr = A.read(i + 1) - A.read(i - 1);
+  void onCreate() {
+    nav().pullBack(8);
+    trailShader.compile(trailVert, trailFrag);
+    buffers.create(walkers.trails, true);
+  }
 
-      vert.color(HSV((1 - f) * 0.2, al::clip(dr.mag() * 4 + 0.2), 1 - f));
-    }
+  void onAnimate(double dt) {
+    walkers.step(dt, pool);
+    buffers.upload(walkers.trails);
   }
 
-  void onDraw(Graphics& g) {
+  void onDraw(Graphics &g) {
     g.clear(0);
-    g.meshColor();
-    g.draw(vert);
+    g.blendAdd();
+    g.shader(trailShader);
+    g.shader().uniform("now", walkers.time);
+    g.shader().uniform("history", walkers.historySeconds());
+    g.update();
+    buffers.drawSegments(walkers.trails);
   }
 };
 
-int main() {
-  MyApp().start();
+// The previous way of drawing the trail: a mesh rebuilt from every point each
+// frame, converting each point's color from HSV
+void rebuildMesh(const TrailRing &trail, Mesh &vert) {
+  vert.primitive(Mesh::LINE_STRIP);
+  vert.reset();
+  for (int i = 0; i < trail.size(); ++i) {
+    float f = float(i) / trail.capacity();
+    vert.vertex(trail.back(i));
+
+    Vec3f dr = trail.back(i + 1) - trail.back(i - 1);
+
+    vert.color(HSV((1 - f) * 0.2, al::clip(dr.mag() * 4 + 0.2), 1 - f));
+  }
+}
+
+// Time per frame of stepping the walk and copying out the new slots, against
+// rebuilding the mesh, for full trails of increasing length
+void benchmark(int maxLength) {
+  typedef std::chrono::steady_clock Clock;
+  auto timeFrames = [](std::function<void()> frame) {
+    int frames = 0;
+    auto t0 = Clock::now();
+    double elapsed = 0;
+    do {
+      frame();
+      ++frames;
+      elapsed = std::chrono::duration<double>(Clock::now() - t0).count();
+    } while (elapsed < 0.5 || frames < 3);
+    return elapsed / frames * 1e6;
+  };
+
+  printf("%10s %14s %16s\n", "points", "ring us/frame", "rebuild us/frame");
+  for (int length = 1000; length <= maxLength; length *= 10) {
+    LevyFlight walk;
+    walk.trail.resize(length);
+    while (walk.trail.size() < length)
+      walk.step(1. / 60);
+
+    // Stands in for the buffer uploads
+    std::vector<Vec3f> positions(length + 1);
+    std::vector<Color> colors(length + 1);
+    std::vector<float> times(length + 1);
+    auto &trail = walk.trail;
+    double ring = timeFrames([&]() {
+      walk.step(1. / 60);
+      TrailRing::Range dirty[3];
+      int n = trail.takeDirty(dirty);
+      for (int i = 0; i < n; ++i) {
+        for (int k = dirty[i].begin; k < dirty[i].end; ++k) {
+          positions[k] = trail.positions()[k];
+          colors[k] = trail.colors()[k];
+          times[k] = trail.times()[k];
+        }
+      }
+    });
+
+    Mesh mesh;
+    double rebuild = timeFrames([&]() {
+      walk.step(1. / 60);
+      rebuildMesh(trail, mesh);
+    });
+
+    printf("%10d %14.2f %16.2f\n", length, ring, rebuild);
+    fflush(stdout);
+  }
+}
+
+// Time per step of drawing Cauchy steps one at a time with rnd::ball, against
+// cauchySteps() in batches, with the median step length of each as a check
+// that they match. Then times frames of many walkers and checks that the
+// walks are the same on one thread and on several.
+void walkersBenchmark(int count, int numThreads) {
+  typedef std::chrono::steady_clock Clock;
+  auto seconds = [](Clock::time_point t0) {
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+  };
+  auto median = [](std::vector<float> &v) {
+    std::nth_element(v.begin(), v.begin() + v.size() / 2, v.end());
+    return v[v.size() / 2];
+  };
+
+  const int samples = 1 << 20;
+  const float spread = 0.04f;
+  std::vector<float> lengths(samples);
+
+  auto t0 = Clock::now();
+  for (int i = 0; i < samples; ++i) {
+    auto p = rnd::ball<Vec3f>();
+    float v = spread / (p.magSqr() + spread * spread) * 0.1f;
+    lengths[i] = (p.normalized() * v).mag();
+  }
+  double scalar = seconds(t0) / samples * 1e9;
+  float scalarMedian = median(lengths);
+
+  const int batch = LevyWalkers::kBatch;
+  float dx[batch], dy[batch], dz[batch];
+  t0 = Clock::now();
+  for (int i = 0; i < samples; i += batch) {
+    cauchySteps(1, 1, i, batch, spread, dx, dy, dz);
+    for (int k = 0; k < batch; ++k)
+      lengths[i + k] = std::sqrt(dx[k] * dx[k] + dy[k] * dy[k] + dz[k] * dz[k]);
+  }
+  double batched = seconds(t0) / samples * 1e9;
+  float batchedMedian = median(lengths);
+
+  printf("rnd::ball     %6.1f ns/step, median length %.5f\n", scalar,
+         scalarMedian);
+  printf("cauchySteps   %6.1f ns/step, median length %.5f\n", batched,
+         batchedMedian);
+
+  auto walk = [&](int threads, int frames, double &ms) {
+    ThreadPool pool(threads);
+    LevyWalkers walkers;
+    walkers.reset(count, 64);
+    auto t0 = Clock::now();
+    for (int i = 0; i < frames; ++i)
+      walkers.step(1. / 60, pool);
+    ms = seconds(t0) / frames * 1e3;
+    return walkers.pos;
+  };
+  double ms1, msN;
+  auto one = walk(1, 60, ms1);
+  auto many = walk(numThreads, 60, msN);
+  bool same = true;
+  for (size_t i = 0; i < one.size(); ++i)
+    for (int k = 0; k < 3; ++k)
+      same &= one[i][k] == many[i][k];
+
+  ThreadPool pool(numThreads);
+  printf("%d walkers: %.3f ms/frame on 1 thread, %.3f ms/frame on %d\n", count,
+         ms1, msN, pool.size());
+  printf("walks on 1 and %d threads are %s\n", pool.size(),
+         same ? "identical" : "DIFFERENT");
+}
+
+int main(int argc, char *argv[]) {
+  std::string mode = argc > 1 ? argv[1] : "";
+  if (mode == "-bench") {
+    benchmark(argc > 2 ? std::stoi(argv[2]) : 1000000);
+    return 0;
+  }
+  if (mode == "-walkers-bench") {
+    walkersBenchmark(argc > 2 ? std::stoi(argv[2]) : 10000,
+                     argc > 3 ? std::stoi(argv[3]) : 0);
+    return 0;
+  }
+  if (mode == "-walkers") {
+    WalkersApp(argc > 2 ? std::stoi(argv[2]) : 10000,
+               argc > 3 ? std::stoi(argv[3]) : 256,
+               argc > 4 ? std::stoi(argv[4]) : 0)
+        .start();
+    return 0;
+  }
+
+  MyApp(argc > 1 ? std::stoi(argv[1]) : 8000).start();
   // window().displayMode(window().displayMode() | Window::MULTISAMPLE);
+  return 0;
 }
@@ -5,85 +5,100 @@ Description:
 This demonstrates how to build a particle system with a simple fountain-like
 behavior.
 
+The emitter, in ParticleEmitter.hpp, holds its live particles packed at the
+front of a fixed capacity array. New particles are appended at a rate in
+particles per second and a particle that dies is replaced by the last live
+one, so updating only ever touches live particles and nothing is allocated
+after start-up. Each frame, positions and colors are written straight into
+the mesh's preallocated vertex and color arrays.
+
+    ./particleSystem [capacity] [threads]
+
+The emission rate is set to keep the emitter about full. Press '[' / ']' to
+halve / double it; doubling grows the capacity as needed.
+
+Velocities are in units per second and accelerations in units per second
+squared, and the particles are moved by one of the integrators in
+Integrators.hpp. Press 'm' to cycle through them and 'h' to print the total
+energy and its drift. The fountain falls in a uniform field, which the
+second order methods follow exactly, so only the Euler methods drift. New
+particles change the energy too, so the drift is only measured over the
+integration.
+
+The emitter steps 120 times per simulated second on its own thread (see
+FixedStepScheduler.hpp), so it runs at the same speed at any frame rate. That
+thread and the render thread each split their loops over a pool of threads.
+Press 'i' to print the scheduler's step and overrun counts.
+
+Run with -bench to time a full emitter of a given size headlessly and check
+that no arrays are reallocated:
+
+    ./particleSystem -bench [capacity] [threads]
+
 Author(s):
 Lance Putnam, 4/25/2011
 */
 
 #include "al/app/al_App.hpp"
 #include "al/math/al_Random.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
 
-using namespace al;
-
-struct Particle {
-  Vec3f pos, vel, acc;
-  int age = 0;
-
-  void update(int ageInc) {
-    vel += acc;
-    pos += vel;
-    age += ageInc;
-  }
-};
-
-template <int N> struct Emitter {
-  Particle particles[N];
-  int tap = 0;
-
-  Emitter() {
-    for (auto &p : particles)
-      p.age = N;
-  }
+#include "playground/ThreadPool.hpp"
 
-  template <int M> void update() {
-    for (auto &p : particles)
-      p.update(M);
-
-    for (int i = 0; i < M; ++i) {
-      auto &p = particles[tap];
-
-      // fountain
-      if (rnd::prob(0.95)) {
-        p.vel.set(rnd::uniform(-0.1, -0.05), rnd::uniform(0.12, 0.14),
-                  rnd::uniform(0.01));
-        p.acc.set(0, -0.002, 0);
-
-        // spray
-      } else {
-        p.vel.set(rnd::uniformS(0.01), rnd::uniformS(0.01),
-                  rnd::uniformS(0.01));
-        p.acc.set(0, 0, 0);
-      }
-      p.pos.set(4, -2, 0);
-
-      p.age = 0;
-      ++tap;
-      if (tap >= N)
-        tap = 0;
-    }
-  }
+#include "FixedStepScheduler.hpp"
+#include "Integrators.hpp"
+#include "ParticleEmitter.hpp"
 
-  int size() { return N; }
-};
+using namespace al;
 
 struct MyApp : public App {
-  Emitter<8000> em1;
+  // Only touched by the scheduler's thread once started
+  Emitter em1;
+  bool showEnergy = false;
+  EnergyMonitor energy;
+
+  FixedStepScheduler<EmitterSnapshot> scheduler;
+  // parallelFor can't be called from two threads at once, so the scheduler's
+  // thread integrates on one pool and the render thread fills the mesh on
+  // another
+  ThreadPool simPool, renderPool;
   Mesh mesh;
 
-  void onCreate() { nav().pullBack(16); }
+  MyApp(int capacity, int numThreads)
+      : em1(capacity), simPool(numThreads), renderPool(numThreads) {
+    em1.rate = capacity / em1.lifetime;
+    em1.integrator.pool = &simPool;
+  }
 
-  void onAnimate(double dt) {
-    em1.update<40>();
+  void onCreate() {
+    nav().pullBack(16);
+    energy.hook = [](const EnergyMonitor &e) {
+      printf("\rE = %.4f  drift %+.3e   ", e.total(), e.drift());
+      fflush(stdout);
+    };
 
-    mesh.reset();
     mesh.primitive(Mesh::POINTS);
+    mesh.vertices().reserve(em1.capacity());
+    mesh.colors().reserve(em1.capacity());
+
+    scheduler.step = 1. / 120;
+    scheduler.start(
+        [this](double dt) {
+          em1.update(dt, showEnergy ? &energy : nullptr);
+        },
+        [this](EmitterSnapshot &s) { s.copyFrom(em1); });
+  }
 
-    for (int i = 0; i < em1.size(); ++i) {
-      Particle &p = em1.particles[i];
-      float age = float(p.age) / em1.size();
-
-      mesh.vertex(p.pos);
-      mesh.color(HSV(0.6, rnd::uniform(), (1 - age) * 0.4));
-    }
+  void onAnimate(double dt) {
+    scheduler.read(
+        [&](const EmitterSnapshot &a, const EmitterSnapshot &b, float t) {
+          fillMesh(mesh, a, b, t, renderPool);
+        });
   }
 
   void onDraw(Graphics &g) {
@@ -93,6 +108,120 @@ struct MyApp : public App {
     g.meshColor();
     g.draw(mesh);
   }
+
+  bool onKeyDown(const Keyboard &k) {
+    switch (k.key()) {
+    case 'm':
+      scheduler.post([this]() {
+        em1.integrator.method = nextIntegrator(em1.integrator.method);
+        em1.integrator.reset();
+        energy.restart();
+        printf("\n%s\n", integratorName(em1.integrator.method));
+      });
+      break;
+    case 'h':
+      scheduler.post([this]() {
+        showEnergy = !showEnergy;
+        energy.restart();
+        printf("\n");
+      });
+      break;
+    case '[':
+    case ']': {
+      float scale = k.key() == ']' ? 2 : 0.5;
+      scheduler.post([this, scale]() {
+        em1.rate *= scale;
+        int needed = int(std::ceil(em1.rate * em1.lifetime));
+        if (needed > em1.capacity())
+          em1.capacity(needed);
+        printf("\n%g particles/s, capacity %d\n", em1.rate, em1.capacity());
+      });
+    } break;
+    case 'i': {
+      auto s = scheduler.stats();
+      printf("\n%.2f s simulated in %lld steps, %lld overruns (%lld steps "
+             "dropped), %.3f ms/step\n",
+             s.simTime, s.steps, s.overruns, s.droppedSteps,
+             s.steps ? s.stepTime / s.steps * 1e3 : 0.);
+    } break;
+    }
+    return true;
+  }
+
+  void onExit() { scheduler.stop(); }
 };
 
-int main() { MyApp().start(); }
+// Fills an emitter of the given capacity, then times its steps, snapshots and
+// mesh writes and counts reallocations of the arrays
+void benchmark(int capacity, int numThreads) {
+  typedef std::chrono::steady_clock Clock;
+  auto ms = [](Clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0)
+        .count();
+  };
+
+  ThreadPool pool(numThreads);
+  Emitter em(capacity);
+  em.rate = capacity / em.lifetime;
+  em.integrator.pool = &pool;
+  const double dt = 1. / 120;
+  while (em.size() < capacity * 0.99)
+    em.update(dt);
+
+  EmitterSnapshot a, b;
+  a.copyFrom(em);
+  b.copyFrom(em);
+  Mesh mesh;
+  mesh.vertices().reserve(capacity);
+  mesh.colors().reserve(capacity);
+  fillMesh(mesh, a, b, 0.5f, pool);
+  const Vec3f *vertData = mesh.vertices().data();
+  const Color *colorData = mesh.colors().data();
+  const Vec3f *snapData[2] = {a.pos.data(), b.pos.data()};
+
+  int frames = 0, reallocations = 0;
+  double stepTime = 0, copyTime = 0, fillTime = 0;
+  auto start = Clock::now();
+  do {
+    // Two steps per frame at 60 fps
+    auto t0 = Clock::now();
+    em.update(dt);
+    em.update(dt);
+    stepTime += ms(t0);
+
+    t0 = Clock::now();
+    std::swap(a, b);
+    b.copyFrom(em);
+    copyTime += ms(t0);
+
+    t0 = Clock::now();
+    fillMesh(mesh, a, b, 0.5f, pool);
+    fillTime += ms(t0);
+
+    if (mesh.vertices().data() != vertData ||
+        mesh.colors().data() != colorData ||
+        std::min(a.pos.data(), b.pos.data()) !=
+            std::min(snapData[0], snapData[1]))
+      ++reallocations;
+    ++frames;
+  } while (ms(start) < 2000 || frames < 3);
+
+  printf("%d particles alive of %d, %d threads, %d frames\n", em.size(),
+         capacity, pool.size(), frames);
+  printf("step x2 %.3f ms, snapshot %.3f ms, mesh %.3f ms per frame\n",
+         stepTime / frames, copyTime / frames, fillTime / frames);
+  printf("%d frames reallocated an array\n", reallocations);
+}
+
+int main(int argc, char *argv[]) {
+  std::string mode = argc > 1 ? argv[1] : "";
+  if (mode == "-bench") {
+    benchmark(argc > 2 ? std::stoi(argv[2]) : 1000000,
+              argc > 3 ? std::stoi(argv[3]) : 0);
+    return 0;
+  }
+
+  MyApp(argc > 1 ? std::stoi(argv[1]) : 8000, argc > 2 ? std::stoi(argv[2]) : 0)
+      .start();
+  return 0;
+}
@@ -0,0 +1,268 @@
+/*
+Allocore Example: Simulation Benchmark
+
+Description:
+Steps each of the simulations in this folder without a window and reports
+their cost as JSON, so runs can be compared across commits and machines.
+
+A step is what the simulation's app does on the CPU for one frame, short of
+drawing: for example gravityWell steps the particles and packs the instance
+buffer, and waveEquation steps the grid and writes the surface mesh. flocking
+steps the app's default scalar grid, which runs on one thread. Each
+simulation is set up and warmed up first, so arrays have grown to size before
+timing starts. For each, the output gives
+
+    ns_per_step           wall-clock time per step
+    allocations_per_step  calls to operator new per step
+    peak_rss_kb           the process's peak resident memory so far
+
+Peak memory only grows over a run, so run a single simulation to see its own.
+
+    ./simulationBenchmark [steps] [threads] [name]
+
+where name is one of flocking, gravityWell, particleSystem, waveEquation,
+levyFlight or levyWalkers. By default every simulation takes 100 steps on one
+thread.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#include <malloc.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "al/graphics/al_Mesh.hpp"
+#include "al/graphics/al_Shapes.hpp"
+
+#include "playground/ThreadPool.hpp"
+
+#include "Flock.hpp"
+#include "GravitySystem.hpp"
+#include "HeightFieldMesh.hpp"
+#include "LevyFlight.hpp"
+#include "ParticleEmitter.hpp"
+#include "WaveSim.hpp"
+
+using namespace al;
+
+// Every allocation in the process goes through these
+static std::atomic<long long> allocations(0);
+
+void *operator new(std::size_t size) {
+  ++allocations;
+  if (void *p = std::malloc(size ? size : 1))
+    return p;
+  throw std::bad_alloc();
+}
+
+// GCC inlines these into callers and then takes free() of a pointer from
+// operator new as a mismatch
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+// Over-aligned types are allocated through these, when the compiler supports
+// them
+#if defined(__cpp_aligned_new)
+void *operator new(std::size_t size, std::align_val_t align) {
+  ++allocations;
+  void *p = nullptr;
+#if defined(_WIN32)
+  p = _aligned_malloc(size ? size : 1, std::size_t(align));
+#else
+  std::size_t alignment = std::max(std::size_t(align), sizeof(void *));
+  if (posix_memalign(&p, alignment, size ? size : 1) != 0)
+    p = nullptr;
+#endif
+  if (p)
+    return p;
+  throw std::bad_alloc();
+}
+
+void operator delete(void *p, std::align_val_t) noexcept {
+#if defined(_WIN32)
+  _aligned_free(p);
+#else
+  std::free(p);
+#endif
+}
+void operator delete(void *p, std::size_t, std::align_val_t align) noexcept {
+  operator delete(p, align);
+}
+#endif
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
+
+// Peak resident set size of the process in kilobytes, or 0 if unknown
+long peakRSS() {
+#if defined(_WIN32)
+  return 0;
+#else
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+  return usage.ru_maxrss / 1024; // bytes on macOS
+#else
+  return usage.ru_maxrss;
+#endif
+#endif
+}
+
+struct Simulation {
+  std::string name;
+  int size; // Boids, particles, grid side, trail length or walkers
+  // Sets up and warms up the simulation; returns its step
+  std::function<std::function<void()>(int numThreads)> setup;
+};
+
+std::vector<Simulation> simulations() {
+  std::vector<Simulation> sims;
+
+  sims.push_back({"flocking", 1024, [](int) {
+                    auto flock = std::make_shared<Flock>();
+                    flock->reset(1024, 1);
+                    return [flock]() { flock->step(1. / 60); };
+                  }});
+
+  sims.push_back({"gravityWell", 4096, [](int numThreads) {
+                    auto sim = std::make_shared<GravitySystem>(numThreads);
+                    sim->nbody = true;
+                    initialize(*sim, 4096, '1');
+                    auto instances = std::make_shared<std::vector<Vec4f>>();
+                    return [sim, instances]() {
+                      sim->step(1. / 60);
+                      packInstances(*sim, 1, *instances, sim->pool);
+                    };
+                  }});
+
+  sims.push_back({"particleSystem", 100000, [](int numThreads) {
+                    struct State {
+                      ThreadPool pool;
+                      Emitter em{100000};
+                      EmitterSnapshot a, b;
+                      Mesh mesh;
+                      State(int n) : pool(n) {}
+                    };
+                    auto s = std::make_shared<State>(numThreads);
+                    s->em.rate = s->em.capacity() / s->em.lifetime;
+                    s->em.integrator.pool = &s->pool;
+                    while (s->em.size() < s->em.capacity() * 0.99)
+                      s->em.update(1. / 120);
+                    s->mesh.vertices().reserve(s->em.capacity());
+                    s->mesh.colors().reserve(s->em.capacity());
+                    s->a.copyFrom(s->em);
+                    return [s]() {
+                      // Two scheduler steps per frame at 60 fps
+                      s->em.update(1. / 120);
+                      s->em.update(1. / 120);
+                      std::swap(s->a, s->b);
+                      s->b.copyFrom(s->em);
+                      fillMesh(s->mesh, s->a, s->b, 0.5f, s->pool);
+                    };
+                  }});
+
+  sims.push_back({"waveEquation", 1024, [](int numThreads) {
+                    struct State {
+                      WaveSim sim;
+                      std::vector<float> a, b;
+                      Mesh mesh;
+                      HeightFieldMesh surface;
+                      State(int n) : sim(1024, n) {}
+                    };
+                    auto s = std::make_shared<State>(numThreads);
+                    addSurface(s->mesh, s->sim.view, s->sim.view);
+                    s->surface.init(s->mesh, s->sim.view, s->sim.view);
+                    s->sim.capture(s->a);
+                    return [s]() {
+                      s->sim.update();
+                      s->sim.capture(s->b);
+                      s->surface.update(s->mesh, s->a.data(), s->b.data(),
+                                        0.5f, *s->sim.pool);
+                      std::swap(s->a, s->b);
+                    };
+                  }});
+
+  sims.push_back({"levyFlight", 8000, [](int) {
+                    auto walk = std::make_shared<LevyFlight>();
+                    while (walk->trail.size() < walk->trail.capacity())
+                      walk->step(1. / 60);
+                    return [walk]() {
+                      walk->step(1. / 60);
+                      TrailRing::Range dirty[3];
+                      walk->trail.takeDirty(dirty);
+                    };
+                  }});
+
+  sims.push_back({"levyWalkers", 10000, [](int numThreads) {
+                    struct State {
+                      ThreadPool pool;
+                      LevyWalkers walkers;
+                      State(int n) : pool(n) {}
+                    };
+                    auto s = std::make_shared<State>(numThreads);
+                    s->walkers.reset(10000, 256);
+                    while (s->walkers.trails.size() <
+                           s->walkers.trails.capacity())
+                      s->walkers.step(1. / 60, s->pool);
+                    return [s]() {
+                      s->walkers.step(1. / 60, s->pool);
+                      TrailRing::Range dirty[3];
+                      s->walkers.trails.takeDirty(dirty);
+                    };
+                  }});
+
+  return sims;
+}
+
+int main(int argc, char *argv[]) {
+  typedef std::chrono::steady_clock Clock;
+  int steps = argc > 1 ? std::stoi(argv[1]) : 100;
+  int numThreads = argc > 2 ? std::stoi(argv[2]) : 1;
+  std::string only = argc > 3 ? argv[3] : "";
+  const int warmUp = 10;
+
+  printf("{\n  \"steps\": %d,\n  \"threads\": %d,\n  \"simulations\": [",
+         steps, numThreads);
+  bool first = true;
+  for (auto &sim : simulations()) {
+    if (!only.empty() && only != sim.name)
+      continue;
+
+    auto step = sim.setup(numThreads);
+    for (int i = 0; i < warmUp; ++i)
+      step();
+
+    long long allocs0 = allocations;
+    auto t0 = Clock::now();
+    for (int i = 0; i < steps; ++i)
+      step();
+    double ns = std::chrono::duration<double, std::nano>(Clock::now() - t0)
+                    .count();
+    long long allocs = allocations - allocs0;
+
+    printf("%s\n    {\"name\": \"%s\", \"size\": %d, \"ns_per_step\": %.0f, "
+           "\"allocations_per_step\": %.2f, \"peak_rss_kb\": %ld}",
+           first ? "" : ",", sim.name.c_str(), sim.size, ns / steps,
+           double(allocs) / steps, peakRSS());
+    fflush(stdout);
+    first = false;
+  }
+  printf("\n  ]\n}\n");
+  return 0;
+}
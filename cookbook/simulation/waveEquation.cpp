@@ -17,6 +17,32 @@ The simulation adds random Gaussian-shaped drops to simulate water droplets
 falling into a pool. A minor artifact is increased rippling along the wavefronts
 in the x and y directions.
 
+The simulation is in WaveSim.hpp, so it can be stepped without a window, and
+its grid is updated by the stencil engine in WaveStencil.hpp, which keeps
+each time step in its own padded plane with ghost cells so the inner loop
+vectorizes, and splits the rows across threads. Grids up to 4096 x 4096 step
+at interactive rates; the surface drawn is sampled down to at most 256 x 256.
+The surface's heights and normals are written together from the height field
+(see HeightFieldMesh.hpp), skipping tiles where the water is still.
+
+    ./waveEquation [size] [threads]
+
+The simulation steps 60 times per simulated second on its own thread (see
+FixedStepScheduler.hpp), independent of the frame rate, and the drawn surface
+is blended between the two newest steps. Press 'i' to print the scheduler's
+step and overrun counts and how many tiles of the surface were updated.
+
+Run with -bench to time the stencil in cell updates per second for
+increasing grid sizes, against the original one cell at a time loop, with
+-check to compare the two, with -surface to time writing the surface against
+Mesh::generateNormals(), and with -schedule to check headlessly that a
+stuttering renderer does not change the simulation rate:
+
+    ./waveEquation -bench [maxSize] [threads]
+    ./waveEquation -check
+    ./waveEquation -surface
+    ./waveEquation -schedule [seconds]
+
 See also: http://locklessinc.com/articles/wave_eqn/
 
 Author:
@@ -26,59 +52,57 @@ Lance Putnam, Oct. 2014
 #include "al/app/al_App.hpp"
 #include "al/graphics/al_Shapes.hpp"
 #include "al/math/al_Random.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "playground/ThreadPool.hpp"
+
+#include "FixedStepScheduler.hpp"
+#include "HeightFieldMesh.hpp"
+#include "WaveSim.hpp"
+#include "WaveStencil.hpp"
+
 using namespace al;
 
-struct MyApp : public App {
-  static const int Nx = 256, Ny = Nx;
-  float wave[Nx * Ny * 2];  // Values of wave for current and previous time step
+// The original update with interleaved planes and wrap branches; the
+// reference for -check and the baseline for -bench
+struct ReferenceWave {
+  int Nx, Ny;
+  std::vector<float> wave;  // Values of wave for current and previous time step
   int zcurr = 0;            // The current "plane" coordinate representing time
   float decay = 0.96f;      // Decay factor of waves, in (0, 1]
   float velocity = 0.5f;    // Velocity of wave propagation, in (0, 0.5]
 
-  Mesh mesh;
-  Light light;
-  Material mtrl;
-
-  void onCreate() {
-    for (auto& v : wave) v = 0;
-
-    // Add a tessellated plane
-    addSurface(mesh, Nx, Ny);
-
-    nav().pullBack(4);
-
-    light.dir(1, 1, 1);
-    mtrl.specular(RGB(1));
-    mtrl.shininess(30);
-  }
+  ReferenceWave(int n) : Nx(n), Ny(n), wave(n * n * 2, 0.f) {}
 
   int indexAt(int x, int y, int z) {
     // return (z*Nx + y)*Ny + x;
     return (y * Nx + x) * 2 + z;  // may give slightly faster accessing
   }
 
-  void onAnimate(double /*dt*/) {
+  void addDrop(int ix, int iy) {
     int zprev = 1 - zcurr;
-
-    // Add some random droplets
-    for (int k = 0; k < 3; ++k) {
-      if (rnd::prob(0.01)) {
-        // Add a Gaussian-shaped droplet
-        int ix = rnd::uniform(Nx - 8) + 4;
-        int iy = rnd::uniform(Ny - 8) + 4;
-        for (int j = -4; j <= 4; ++j) {
-          for (int i = -4; i <= 4; ++i) {
-            float x = float(i) / 4;
-            float y = float(j) / 4;
-            float v = 0.5 * exp(-(x * x + y * y) / (0.5 * 0.5));
-            wave[indexAt(ix + i, iy + j, zcurr)] += v;
-            wave[indexAt(ix + i, iy + j, zprev)] += v;
-          }
-        }
+    for (int j = -4; j <= 4; ++j) {
+      for (int i = -4; i <= 4; ++i) {
+        float x = float(i) / 4;
+        float y = float(j) / 4;
+        float v = 0.5 * exp(-(x * x + y * y) / (0.5 * 0.5));
+        int wx = (ix + i + Nx) % Nx, wy = (iy + j + Ny) % Ny;
+        wave[indexAt(wx, wy, zcurr)] += v;
+        wave[indexAt(wx, wy, zprev)] += v;
       }
     }
+  }
 
-    // Update wave equation
+  void step() {
+    int zprev = 1 - zcurr;
     for (int j = 0; j < Ny; ++j) {
       for (int i = 0; i < Nx; ++i) {
         // Neighbor indices; wrap toroidally
@@ -101,15 +125,62 @@ struct MyApp : public App {
 
         // Store in previous value since we don't need it again
         wave[indexAt(i, j, zprev)] = val * decay;
-
-        int idx = j * Nx + i;
-        mesh.vertices()[idx].z = val;
       }
     }
+    zcurr = zprev;
+  }
+};
 
-    mesh.generateNormals();
+typedef FixedStepScheduler<std::vector<float>> WaveScheduler;
 
-    zcurr = zprev;
+void startScheduler(WaveScheduler& scheduler, WaveSim& sim) {
+  scheduler.step = 1. / 60;
+  scheduler.start([&sim](double) { sim.update(); },
+                  [&sim](std::vector<float>& s) { sim.capture(s); });
+}
+
+void printStats(WaveScheduler& scheduler) {
+  auto s = scheduler.stats();
+  printf("%.2f s simulated in %lld steps, %lld wake-ups, %lld overruns "
+         "(%lld steps dropped), %.3f ms/step, longest wake-up %.2f ms\n",
+         s.simTime, s.steps, s.wakeUps, s.overruns, s.droppedSteps,
+         s.steps ? s.stepTime / s.steps * 1e3 : 0., s.maxWakeTime * 1e3);
+}
+
+struct MyApp : public App {
+  WaveSim sim;
+  WaveScheduler scheduler;
+
+  Mesh mesh;
+  HeightFieldMesh surface;
+  ThreadPool renderPool;
+  Light light;
+  Material mtrl;
+
+  MyApp(int size, int numThreads)
+      : sim(size, numThreads), renderPool(numThreads) {}
+
+  void onCreate() {
+    // Add a tessellated plane
+    addSurface(mesh, sim.view, sim.view);
+    surface.init(mesh, sim.view, sim.view);
+
+    nav().pullBack(4);
+
+    light.dir(1, 1, 1);
+    mtrl.specular(RGB(1));
+    mtrl.shininess(30);
+
+    printf("%d x %d grid, %d threads\n", sim.grid.nx(), sim.grid.ny(),
+           sim.pool->size());
+    startScheduler(scheduler, sim);
+  }
+
+  void onAnimate(double /*dt*/) {
+    scheduler.read([&](const std::vector<float>& a, const std::vector<float>& b,
+                       float t) {
+      surface.update(mesh, a.data(), b.data(), t, renderPool);
+    });
   }
 
   void onDraw(Graphics& g) {
@@ -120,6 +191,207 @@ struct MyApp : public App {
     g.material(mtrl);
     g.draw(mesh);
   }
+
+  bool onKeyDown(const Keyboard& k) {
+    if (k.key() == 'i') {
+      printStats(scheduler);
+      printf("%d of %d surface tiles updated last frame\n",
+             surface.lastDirtyTiles(), surface.tiles());
+    }
+    return true;
+  }
+
+  void onExit() { scheduler.stop(); }
 };
 
-int main() { MyApp().start(); }
+// Time to write the heights and normals of a 256 x 256 surface, when every
+// tile changes and when none do, against Mesh::generateNormals(), and the
+// angles between the two sets of normals. They differ most on the steepest
+// slopes, where generateNormals() follows the triangulation's diagonals.
+void benchmarkSurface() {
+  typedef std::chrono::steady_clock Clock;
+  const int n = 256;
+  WaveSim sim(n, 1);
+  for (int k = 0; k < 8; ++k)
+    sim.grid.addDrop(rnd::uniform(n), rnd::uniform(n), 4, 0.5f);
+  std::vector<float> a, b;
+  for (int s = 0; s < 30; ++s) sim.grid.step(*sim.pool);
+  sim.capture(a);
+  sim.grid.step(*sim.pool);
+  sim.capture(b);
+
+  Mesh mesh;
+  addSurface(mesh, n, n);
+  HeightFieldMesh surface;
+  surface.init(mesh, n, n);
+  ThreadPool pool;
+
+  auto timeIt = [](std::function<void()> fn) {
+    int reps = 0;
+    auto t0 = Clock::now();
+    double elapsed = 0;
+    do {
+      fn();
+      ++reps;
+      elapsed = std::chrono::duration<double>(Clock::now() - t0).count();
+    } while (elapsed < 0.5);
+    return elapsed / reps * 1e3;
+  };
+
+  // Alternating between the two steps changes every tile each time
+  int frame = 0;
+  double moving = timeIt([&]() {
+    const float* h = ++frame & 1 ? a.data() : b.data();
+    surface.update(mesh, h, h, 0, pool);
+  });
+  int dirty = surface.lastDirtyTiles();
+  double still =
+      timeIt([&]() { surface.update(mesh, b.data(), b.data(), 0, pool); });
+
+  Mesh reference = mesh;
+  double generate = timeIt([&]() { reference.generateNormals(); });
+
+  double maxAngle = 0, sumAngle = 0;
+  for (int y = 1; y < n - 1; ++y) {
+    for (int x = 1; x < n - 1; ++x) {
+      int i = y * n + x;
+      float c = mesh.normals()[i].dot(reference.normals()[i]);
+      double angle = std::acos(std::min(1.f, c)) * 180 / M_PI;
+      maxAngle = std::max(maxAngle, angle);
+      sumAngle += angle;
+    }
+  }
+
+  printf("%d x %d surface, %d threads\n", n, n, pool.size());
+  printf("moving:               %.3f ms (%d tiles updated)\n", moving, dirty);
+  printf("still:                %.3f ms (%d tiles updated)\n", still,
+         surface.lastDirtyTiles());
+  printf("generateNormals():    %.3f ms\n", generate);
+  printf("angle to generateNormals() inside the edge: mean %.3f, max %.2f "
+         "degrees\n",
+         sumAngle / ((n - 2) * (n - 2)), maxAngle);
+}
+
+// Reads snapshots at 60 frames per second, with every 20th frame stalling for
+// 250 ms, and reports how many steps were run against the wall clock
+void checkSchedule(double seconds) {
+  typedef std::chrono::steady_clock Clock;
+  WaveSim sim;
+  WaveScheduler scheduler;
+  std::vector<float> frame;
+
+  auto t0 = Clock::now();
+  startScheduler(scheduler, sim);
+  int frames = 0;
+  while (std::chrono::duration<double>(Clock::now() - t0).count() < seconds) {
+    scheduler.read([&](const std::vector<float>& a,
+                       const std::vector<float>& b, float t) {
+      frame.resize(b.size());
+      for (int i = 0; i < int(b.size()); ++i)
+        frame[i] = a[i] + (b[i] - a[i]) * t;
+    });
+    ++frames;
+    std::this_thread::sleep_for(std::chrono::milliseconds(
+        frames % 20 == 0 ? 250 : 16));
+  }
+  scheduler.stop();
+  double elapsed = std::chrono::duration<double>(Clock::now() - t0).count();
+
+  auto s = scheduler.stats();
+  printf("%d frames in %.2f s, expected %.0f steps\n", frames, elapsed,
+         elapsed / scheduler.step);
+  printStats(scheduler);
+  printf("%s\n", std::abs(s.simTime - elapsed) < 2 * scheduler.step + 0.05
+                     ? "simulation kept time"
+                     : "simulation fell behind");
+}
+
+// Cell updates per second of the stencil engine and the original loop
+void benchmark(int maxSize, int numThreads) {
+  typedef std::chrono::steady_clock Clock;
+  ThreadPool pool(numThreads);
+  printf("%d threads\n", pool.size());
+  printf("%6s %12s %14s %12s %14s\n", "size", "ms/step", "cells/s",
+         "ref ms/step", "ref cells/s");
+
+  // Runs step() for at least half a second; returns seconds per step
+  auto timeSteps = [](std::function<void()> step) {
+    int steps = 0;
+    auto t0 = Clock::now();
+    double elapsed = 0;
+    do {
+      step();
+      ++steps;
+      elapsed = std::chrono::duration<double>(Clock::now() - t0).count();
+    } while (elapsed < 0.5 || steps < 3);
+    return elapsed / steps;
+  };
+
+  for (int n = 256; n <= maxSize; n *= 2) {
+    WaveGrid grid(n, n);
+    grid.addDrop(n / 3, n / 2, 4.f * n / 256, 0.5f);
+    double t = timeSteps([&]() { grid.step(pool); });
+
+    ReferenceWave ref(n);
+    ref.addDrop(n / 3, n / 2);
+    double tRef = timeSteps([&]() { ref.step(); });
+
+    double cells = double(n) * n;
+    printf("%6d %12.3f %14.3e %12.3f %14.3e\n", n, t * 1e3, cells / t,
+           tRef * 1e3, cells / tRef);
+    fflush(stdout);
+  }
+}
+
+// Steps the engine and the original loop from the same drops, including ones
+// across the edges, and compares them
+bool check() {
+  const int n = 256, steps = 60;
+  WaveGrid grid(n, n);
+  ReferenceWave ref(n);
+  int drops[][2] = {{40, 60}, {200, 30}, {0, 128}, {255, 255}, {128, 2}};
+  for (auto& d : drops) {
+    grid.addDrop(d[0], d[1], 4, 0.5f);
+    ref.addDrop(d[0], d[1]);
+  }
+
+  ThreadPool pool(4);
+  for (int s = 0; s < steps; ++s) {
+    grid.step(pool);
+    ref.step();
+  }
+
+  float maxErr = 0, maxVal = 0;
+  for (int y = 0; y < n; ++y) {
+    for (int x = 0; x < n; ++x) {
+      float v = ref.wave[ref.indexAt(x, y, ref.zcurr)];
+      maxErr = std::max(maxErr, std::abs(grid.at(x, y) - v));
+      maxVal = std::max(maxVal, std::abs(v));
+    }
+  }
+  bool ok = maxErr <= 1e-5f * maxVal;
+  printf("%d steps, max |u| %g, max error %g: %s\n", steps, maxVal, maxErr,
+         ok ? "ok" : "FAILED");
+  return ok;
+}
+
+int main(int argc, char* argv[]) {
+  std::string mode = argc > 1 ? argv[1] : "";
+  if (mode == "-bench") {
+    benchmark(argc > 2 ? std::stoi(argv[2]) : 4096,
+              argc > 3 ? std::stoi(argv[3]) : 0);
+    return 0;
+  } else if (mode == "-check") {
+    return check() ? 0 : 1;
+  } else if (mode == "-surface") {
+    benchmarkSurface();
+    return 0;
+  } else if (mode == "-schedule") {
+    checkSchedule(argc > 2 ? std::stod(argv[2]) : 5);
+    return 0;
+  }
+
+  MyApp(argc > 1 ? std::stoi(argv[1]) : 256, argc > 2 ? std::stoi(argv[2]) : 0)
+      .start();
+  return 0;
+}
@@ -0,0 +1,56 @@
+#pragma once
+#ifndef CounterRandom_H
+#define CounterRandom_H
+
+// Counter-based random numbers.
+//
+// Instead of advancing a shared generator, every number is a hash of a key
+// made of a seed, a step count, an item index and a stream number. The same
+// key always gives the same number, so items can be updated in any order and
+// on any thread and a simulation stays reproducible for a fixed seed.
+
+#include <cstdint>
+
+namespace counter_rnd {
+
+// SplitMix64 finalizer; a bijective mix of all 64 bits
+inline uint64_t mix(uint64_t x) {
+  x += 0x9e3779b97f4a7c15ull;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+  return x ^ (x >> 31);
+}
+
+// Key for the random numbers of one item at one step
+inline uint64_t key(uint64_t seed, uint64_t step, uint64_t index,
+                    uint64_t stream = 0) {
+  return mix(mix(mix(seed) ^ step) ^ (index * 4 + stream));
+}
+
+// The n-th 64-bit random number of a key
+inline uint64_t bits(uint64_t key, uint64_t n) { return mix(key + n); }
+
+// Uniform in [0, 1)
+inline float uniform(uint64_t key, uint64_t n) {
+  return float(bits(key, n) >> 40) * (1.f / 16777216.f);
+}
+
+// Uniform in [-1, 1)
+inline float uniformS(uint64_t key, uint64_t n) {
+  return uniform(key, n) * 2.f - 1.f;
+}
+
+// Uniform inside the unit ball of dimension V::size() by rejection sampling.
+// Draws numbers n, n+1, ... of the key.
+template <class V> V ball(uint64_t key, uint64_t n = 0) {
+  V v;
+  do {
+    for (int i = 0; i < V::size(); ++i)
+      v[i] = uniformS(key, n++);
+  } while (v.magSqr() > 1 || v.magSqr() == 0);
+  return v;
+}
+
+} // namespace counter_rnd
+
+#endif
@@ -0,0 +1,153 @@
+#pragma once
+#ifndef StateHistory_H
+#define StateHistory_H
+
+// Smooth drawing of a DistributedAppWithState's state on renderers.
+//
+// A renderer that copies state() as it finds it each frame shows every late
+// or lost packet as a jump, and draws at the simulator's rate when that is
+// lower than its own. Instead, a renderer can keep the last few states it
+// received, each stamped with the simulator's time, and draw the state at a
+// time slightly in the past: between two received states it interpolates,
+// and if the next state is late it extrapolates from the last two for a
+// bounded time before holding the newest.
+//
+// The simulator adds its time to the state, for example
+//
+//   struct State { double time; Pose pose; ... };
+//
+//   // simulator, onAnimate
+//   state().time += dt;
+//
+//   // renderer, onAnimate
+//   history.push(state(), state().time, localTime);
+//   history.sample(localTime, drawn, [](const State &a, const State &b,
+//                                       float t, State &out) { ... });
+//
+// push() ignores a state whose time is not newer than the newest, so it can
+// be called every frame whether or not a new state arrived. A time further
+// back than the states held (or than delay) means the simulator restarted,
+// and the history starts over from that state. Local and simulator clocks
+// are matched by the smallest difference seen between them, which is the
+// fastest delivery, so jitter in delivery doesn't move the drawn time.
+
+#include <algorithm>
+#include <vector>
+
+template <class T> class StateHistory {
+public:
+  double delay = 1. / 30;          // Seconds drawn behind the newest state
+  double maxExtrapolation = 0.05;  // Seconds to extrapolate before holding
+  double clockDrift = 1e-3;        // Allowed drift of the clocks, in s/s
+
+  struct Stats {
+    long long received = 0, stale = 0; // stale: older than the newest
+    long long restarts = 0;            // Times the simulator's clock reset
+    long long interpolated = 0, extrapolated = 0, held = 0;
+  };
+
+  explicit StateHistory(int capacity = 8) : mStates(std::max(capacity, 2)) {}
+
+  // Adds a state stamped with the simulator's time, received at localTime.
+  // Returns false, and keeps nothing, if it is not newer than the newest
+  // unless it is so much older that the simulator must have restarted.
+  bool push(const T &state, double stateTime, double localTime) {
+    if (mSize > 0) {
+      double span = std::max(newest().time - at(mSize - 1).time, delay);
+      if (newest().time - stateTime > span) {
+        mSize = 0;
+        ++mStats.restarts;
+      }
+    }
+    if (mSize > 0 && stateTime <= newest().time) {
+      mStats.stale += stateTime < newest().time; // Not the same one again
+      return false;
+    }
+    double offset = localTime - stateTime;
+    if (mSize == 0) {
+      mOffset = offset;
+    } else {
+      // Follow the fastest delivery, letting the estimate rise slowly in
+      // case the clocks drift apart
+      mOffset = std::min(offset, mOffset + clockDrift *
+                                               (localTime - mLastLocal));
+    }
+    mLastLocal = localTime;
+
+    mHead = (mHead + 1) % int(mStates.size());
+    mStates[mHead].state = state;
+    mStates[mHead].time = stateTime;
+    mSize = std::min(mSize + 1, int(mStates.size()));
+    ++mStats.received;
+    return true;
+  }
+
+  // Simulator time drawn at localTime
+  double drawTime(double localTime) const {
+    return localTime - mOffset - delay;
+  }
+
+  // Writes the state at localTime to out with blend(a, b, t, out), which
+  // should give a for t = 0 and b for t = 1; t is greater than 1 when
+  // extrapolating. Returns false if no state has been received.
+  template <class Blend>
+  bool sample(double localTime, T &out, Blend blend) {
+    if (mSize == 0)
+      return false;
+    double t = drawTime(localTime);
+
+    const Entry &last = newest();
+    if (mSize == 1 || t >= last.time) {
+      if (mSize > 1 && t - last.time <= maxExtrapolation) {
+        const Entry &prev = at(1);
+        blend(prev.state, last.state,
+              float((t - prev.time) / (last.time - prev.time)), out);
+        ++mStats.extrapolated;
+      } else {
+        out = last.state;
+        ++mStats.held;
+      }
+      return true;
+    }
+
+    // The newest pair of states around t, or the oldest two if t is before
+    // them all
+    int i = 1;
+    while (i + 1 < mSize && at(i).time > t)
+      ++i;
+    const Entry &a = at(i), &b = at(i - 1);
+    float u = float((t - a.time) / (b.time - a.time));
+    blend(a.state, b.state, std::max(u, 0.f), out);
+    ++mStats.interpolated;
+    return true;
+  }
+
+  int size() const { return mSize; }
+  double newestTime() const { return mSize ? newest().time : 0; }
+  const Stats &stats() const { return mStats; }
+
+  void clear() {
+    mSize = 0;
+    mStats = Stats();
+  }
+
+private:
+  struct Entry {
+    T state;
+    double time = 0;
+  };
+
+  // The state received i pushes ago
+  const Entry &at(int i) const {
+    int n = int(mStates.size());
+    return mStates[(mHead - i + n) % n];
+  }
+  const Entry &newest() const { return at(0); }
+
+  std::vector<Entry> mStates;
+  int mHead = -1, mSize = 0;
+  double mOffset = 0, mLastLocal = 0;
+  Stats mStats;
+};
+
+#endif
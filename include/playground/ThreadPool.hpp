@@ -0,0 +1,126 @@
+#pragma once
+#ifndef ThreadPool_H
+#define ThreadPool_H
+
+// A small pool of worker threads for splitting simulation loops.
+//
+// parallelFor() splits an index range into one contiguous chunk per thread.
+// The split only depends on the range and the number of threads, so as long
+// as each index writes its own results, a loop gives the same results every
+// time it is run with the same number of threads. The calling thread works
+// on the first chunk and returns once all chunks are done.
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool {
+public:
+  // Creates a pool running numThreads chunks in parallel, including the
+  // calling thread. Zero or less uses the number of hardware threads.
+  explicit ThreadPool(int numThreads = 0) {
+    if (numThreads <= 0) {
+      numThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    mNumThreads = numThreads;
+    for (int i = 1; i < mNumThreads; ++i) {
+      mWorkers.emplace_back([this, i]() { workerLoop(i); });
+    }
+  }
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mQuit = true;
+    }
+    mStart.notify_all();
+    for (auto &w : mWorkers)
+      w.join();
+  }
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  int size() const { return mNumThreads; }
+
+  // First index of chunk t when splitting [begin, end) into size() chunks
+  int chunkBegin(int begin, int end, int t) const {
+    return begin + int((long long)(end - begin) * t / mNumThreads);
+  }
+
+  // Calls fn(chunkBegin, chunkEnd, thread) for each thread's chunk of
+  // [begin, end) and waits for all of them to finish.
+  template <class Fn> void parallelFor(int begin, int end, Fn &&fn) {
+    if (mNumThreads == 1 || end - begin < 2) {
+      fn(begin, end, 0);
+      return;
+    }
+
+    auto chunk = [&](int t) {
+      fn(chunkBegin(begin, end, t), chunkBegin(begin, end, t + 1), t);
+    };
+
+    // Workers call the chunk through a pointer; it stays alive until they
+    // are all done, so starting a loop allocates nothing
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mJob = &chunk;
+      mRunJob = &runJob<decltype(chunk)>;
+      mPending = mNumThreads - 1;
+      ++mGeneration;
+    }
+    mStart.notify_all();
+
+    chunk(0);
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    mDone.wait(lock, [this]() { return mPending == 0; });
+    mJob = nullptr;
+    mRunJob = nullptr;
+  }
+
+private:
+  template <class Chunk> static void runJob(const void *job, int t) {
+    (*static_cast<const Chunk *>(job))(t);
+  }
+
+  void workerLoop(int t) {
+    unsigned long long generation = 0;
+    while (true) {
+      const void *job;
+      void (*run)(const void *, int);
+      {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mStart.wait(lock,
+                    [&]() { return mQuit || mGeneration != generation; });
+        if (mQuit)
+          return;
+        generation = mGeneration;
+        job = mJob;
+        run = mRunJob;
+      }
+
+      run(job, t);
+
+      {
+        std::lock_guard<std::mutex> lock(mMutex);
+        --mPending;
+      }
+      mDone.notify_one();
+    }
+  }
+
+  int mNumThreads = 1;
+  std::vector<std::thread> mWorkers;
+  std::mutex mMutex;
+  std::condition_variable mStart, mDone;
+  const void *mJob = nullptr;
+  void (*mRunJob)(const void *, int) = nullptr;
+  unsigned long long mGeneration = 0;
+  int mPending = 0;
+  bool mQuit = false;
+};
+
+#endif
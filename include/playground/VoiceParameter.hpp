@@ -0,0 +1,49 @@
+#pragma once
+#ifndef VoiceParameter_H
+#define VoiceParameter_H
+
+// A handle to one of a SynthVoice's internal parameters.
+//
+// getInternalParameterValue("amplitude") searches the voice's parameters,
+// comparing names, each time it is called. Inside the sample loop that is
+// once per sample for every voice playing. A VoiceParameter keeps the
+// parameter createInternalTriggerParameter() returns, so reading it is a
+// single call:
+//
+//   VoiceParameter mAmplitudeParam;
+//
+//   void init() override {
+//     mAmplitudeParam =
+//         createInternalTriggerParameter("amplitude", 0.3, 0.0, 1.0);
+//   }
+//
+//   void onProcess(AudioIOData &io) override {
+//     while (io()) {
+//       float s = mOsc() * mAmpEnv() * mAmplitudeParam.get();
+//       ...
+//
+// The voice owns the parameter, so the handle is valid for the voice's
+// lifetime. Parameter::get() reads a float without locking, so the audio
+// thread can read while the GUI or a sequencer sets it. Like
+// getInternalParameterValue() for a name the voice doesn't have, a handle
+// that was never assigned reads 0.
+
+#include <memory>
+
+#include "al/ui/al_Parameter.hpp"
+
+class VoiceParameter {
+public:
+  VoiceParameter() {}
+  VoiceParameter(const std::shared_ptr<al::Parameter> &parameter)
+      : mParameter(parameter.get()) {}
+  VoiceParameter(al::Parameter &parameter) : mParameter(&parameter) {}
+  VoiceParameter(al::Parameter *parameter) : mParameter(parameter) {}
+
+  float get() const { return mParameter ? mParameter->get() : 0.f; }
+
+private:
+  al::Parameter *mParameter = nullptr;
+};
+
+#endif
@@ -0,0 +1,268 @@
+#pragma once
+#ifndef WavetableBank_H
+#define WavetableBank_H
+
+// The tutorials' oscillator tables, built once per process and shared by
+// every voice.
+//
+// Voices used to fill global tables with gam::addSines() in init(), so each
+// voice allocated redid the same synthesis, and since addSines() adds to
+// what is in the table, each one also made the tables louder. Voices
+// initialized on different threads raced on the tables. The bank builds a
+// table the first time any thread asks for it; later calls return the same
+// one:
+//
+//   mOsc.source(WavetableBank::shared().table(WavetableBank::SAW));
+//
+// The waves are numbered as the voices' "table" parameter numbers them, so
+// table(int(mTableParam.get())) also works.
+//
+// Each wave also has band-limited levels, one an octave. Level k keeps the
+// partials up to harmonic 1024 >> k, so a table read at a frequency with
+// level(frequency, sampleRate) <= k has no partial above Nyquist. All levels
+// are 2048 samples, so any of them can be the source of a gam::Osc. Levels
+// which drop no partials are the same table as the level below.
+//
+// save() writes every table to a file which load() reads back, so an app can
+// skip the synthesis when it starts again:
+//
+//   if (!WavetableBank::shared().load("wavetables.bin"))
+//     WavetableBank::shared().save("wavetables.bin");
+//
+// The file is a cache for one machine, in its byte order. load() rejects
+// files written for other table sizes or partials.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Gamma/Containers.h"
+#include "Gamma/tbl.h"
+
+class WavetableBank {
+public:
+  enum Wave {
+    SAW,
+    SQUARE,
+    IMPULSE,
+    SINE,
+    PULSE,
+    PARTIALS_1,
+    PARTIALS_2,
+    PARTIALS_3,
+    PARTIALS_4,
+    NUM_WAVES
+  };
+
+  static constexpr int SIZE = 2048; // Samples in each table
+  static constexpr int LEVELS = 11; // Octaves, down to the fundamental alone
+
+  struct Partial {
+    float harmonic, amplitude;
+  };
+
+  // The bank the whole process shares
+  static WavetableBank &shared() {
+    static WavetableBank bank;
+    return bank;
+  }
+
+  // The partials making up wave, which is clamped to the waves above
+  static std::vector<Partial> partials(int wave) {
+    std::vector<Partial> p;
+    switch (clampWave(wave)) {
+    case SAW: // Harmonics 1-9 at 1/h
+      for (int h = 1; h <= 9; ++h)
+        p.push_back({float(h), 1.f / h});
+      break;
+    case SQUARE: // Odd harmonics 1-17 at 1/h
+      for (int h = 1; h <= 17; h += 2)
+        p.push_back({float(h), 1.f / h});
+      break;
+    case IMPULSE: // Harmonics 1-9 at 1
+      for (int h = 1; h <= 9; ++h)
+        p.push_back({float(h), 1.f});
+      break;
+    case SINE:
+      p.push_back({1, 1});
+      break;
+    case PULSE:
+      p = {{1, 1}, {2, 1}, {3, 1}, {4, 1}, {5, 0.7}, {6, 0.5}, {7, 0.3},
+           {8, 0.1}};
+      break;
+    case PARTIALS_1:
+      p = {{1, 1}, {4, 0.4}, {7, 0.65}, {11, 0.3}, {15, 0.18}, {18, 0.08}};
+      break;
+    case PARTIALS_2:
+      p = {{3, 0.5},  {4, 0.8},  {7, 0.7},  {8, 1},
+           {11, 0.3}, {12, 0.4}, {15, 0.2}, {16, 0.12}};
+      break;
+    case PARTIALS_3:
+      p = {{10, 1},   {27, 0.7},  {54, 0.45},
+           {81, 0.3}, {108, 0.15}, {135, 0.08}};
+      break;
+    default: // Harmonics 20-27
+      p = {{20, 0.2}, {21, 0.4}, {22, 0.6}, {23, 1},
+           {24, 0.7}, {25, 0.5}, {26, 0.3}, {27, 0.1}};
+    }
+    return p;
+  }
+
+  // Highest harmonic kept at level
+  static int highestHarmonic(int level) { return (SIZE / 2) >> level; }
+
+  // The lowest level with no partial above Nyquist at frequency
+  static int level(float frequency, float sampleRate) {
+    float ratio = std::fabs(frequency) * SIZE / sampleRate;
+    int k = 0;
+    while (k < LEVELS - 1 && float(1 << k) < ratio)
+      ++k;
+    return k;
+  }
+
+  // Table of wave at level, built on first use. Voices may pass it to
+  // gam::Osc::source(), which needs a non-const array, but must not write
+  // to it.
+  gam::ArrayPow2<float> &table(int wave, int level = 0) {
+    Tables &t = mWaves[clampWave(wave)];
+    std::call_once(t.built, [&] { build(clampWave(wave)); });
+    level = level < 0 ? 0 : level >= LEVELS ? LEVELS - 1 : level;
+    return *t.tables[t.levels[level]];
+  }
+
+  // Writes every table to path, building those not yet used. Returns false
+  // if the file can't be written.
+  bool save(const std::string &path) {
+    std::string temporary = path + ".tmp";
+    std::ofstream out(temporary, std::ios::binary);
+    Header header = currentHeader();
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    for (int w = 0; w < NUM_WAVES; ++w) {
+      table(w);
+      const Tables &t = mWaves[w];
+      uint32_t count = uint32_t(t.tables.size());
+      out.write(reinterpret_cast<const char *>(&count), sizeof(count));
+      out.write(reinterpret_cast<const char *>(t.levels), sizeof(t.levels));
+      for (auto &table : t.tables)
+        out.write(reinterpret_cast<const char *>(table->elems()),
+                  SIZE * sizeof(float));
+    }
+    out.close();
+    // Replaced whole, so a reader never sees half a file. A failed write
+    // leaves nothing behind.
+    if (!out || std::rename(temporary.c_str(), path.c_str()) != 0) {
+      std::remove(temporary.c_str());
+      return false;
+    }
+    return true;
+  }
+
+  // Takes the tables not yet built from a file save() wrote. Returns false,
+  // taking none, if the file is missing or doesn't match this bank.
+  bool load(const std::string &path) {
+    std::ifstream in(path, std::ios::binary);
+    Header header, current = currentHeader();
+    if (!in.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+        std::memcmp(&header, &current, sizeof(header)) != 0)
+      return false;
+
+    struct Loaded {
+      uint32_t levels[LEVELS];
+      std::vector<float> data;
+    };
+    std::vector<Loaded> loaded(NUM_WAVES);
+    for (Loaded &l : loaded) {
+      uint32_t count = 0;
+      in.read(reinterpret_cast<char *>(&count), sizeof(count));
+      in.read(reinterpret_cast<char *>(l.levels), sizeof(l.levels));
+      if (!in || count < 1 || count > LEVELS)
+        return false;
+      for (uint32_t index : l.levels)
+        if (index >= count)
+          return false;
+      l.data.resize(size_t(count) * SIZE);
+      if (!in.read(reinterpret_cast<char *>(l.data.data()),
+                   l.data.size() * sizeof(float)))
+        return false;
+    }
+
+    for (int w = 0; w < NUM_WAVES; ++w)
+      std::call_once(mWaves[w].built, [&] {
+        Tables &t = mWaves[w];
+        const Loaded &l = loaded[w];
+        for (size_t i = 0; i < l.data.size() / SIZE; ++i) {
+          t.tables.emplace_back(new gam::ArrayPow2<float>(SIZE));
+          std::copy(&l.data[i * SIZE], &l.data[i * SIZE] + SIZE,
+                    t.tables.back()->elems());
+        }
+        std::copy(l.levels, l.levels + LEVELS, t.levels);
+      });
+    return true;
+  }
+
+private:
+  struct Tables {
+    std::once_flag built;
+    std::vector<std::unique_ptr<gam::ArrayPow2<float>>> tables;
+    uint32_t levels[LEVELS]; // Index in tables of each level's table
+  };
+
+  // Describes the tables a file holds
+  struct Header {
+    char magic[4];
+    uint32_t size, levels, waves;
+    uint32_t partials; // Hash of every wave's partials
+  };
+
+  static int clampWave(int wave) {
+    return wave < 0 ? 0 : wave >= NUM_WAVES ? NUM_WAVES - 1 : wave;
+  }
+
+  static Header currentHeader() {
+    Header header = {{'W', 'T', 'B', '1'}, SIZE, LEVELS, NUM_WAVES,
+                     2166136261u};
+    for (int w = 0; w < NUM_WAVES; ++w)
+      for (Partial p : partials(w)) {
+        unsigned char bytes[sizeof(p)];
+        std::memcpy(bytes, &p, sizeof(p));
+        for (unsigned char b : bytes)
+          header.partials = (header.partials ^ b) * 16777619u; // FNV-1a
+      }
+    return header;
+  }
+
+  void build(int wave) {
+    Tables &t = mWaves[wave];
+    std::vector<Partial> all = partials(wave);
+    size_t kept = size_t(-1);
+    for (int k = 0; k < LEVELS; ++k) {
+      std::vector<Partial> p;
+      for (Partial partial : all)
+        if (partial.harmonic <= highestHarmonic(k))
+          p.push_back(partial);
+      if (p.size() != kept) {
+        t.tables.emplace_back(new gam::ArrayPow2<float>(SIZE));
+        gam::ArrayPow2<float> &table = *t.tables.back();
+        for (int i = 0; i < SIZE; ++i)
+          table[i] = 0;
+        for (Partial partial : p)
+          gam::addSine(table, partial.harmonic, partial.amplitude);
+        kept = p.size();
+      }
+      t.levels[k] = uint32_t(t.tables.size() - 1);
+    }
+  }
+
+  WavetableBank() {}
+
+  Tables mWaves[NUM_WAVES];
+};
+
+#endif
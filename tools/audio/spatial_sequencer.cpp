@@ -14,6 +14,7 @@
 #include "al/sphere/al_AlloSphereSpeakerLayout.hpp"
 #include "al/sphere/al_Meter.hpp"
 #include "al/sphere/al_SphereUtils.hpp"
+#include "al/system/al_Time.hpp"
 #include "al/ui/al_FileSelector.hpp"
 #include "al/ui/al_ParameterGUI.hpp"
 
@@ -23,9 +24,12 @@
 #include "Gamma/Analysis.h"
 #include "Gamma/scl.h"
 
+#include "playground/StateHistory.hpp"
+
 using namespace al;
 
 struct SharedState {
+  double time = 0; // Seconds since start on the primary
   float meterValues[64] = {0};
 };
 
@@ -210,8 +214,14 @@ public:
       auto &values = mMeter.getMeterValues();
       assert(values.size() < 65);
       memcpy(state().meterValues, values.data(), values.size() * sizeof(float));
+      state().time += dt;
     } else {
-      mMeter.setMeterValues(state().meterValues, 64);
+      // Meters are drawn from the states received, blended so they move
+      // smoothly when states arrive late or less often than frames
+      double now = al_steady_time();
+      mStateHistory.push(state(), state().time, now);
+      mStateHistory.sample(now, mDrawnState, blendMeters);
+      mMeter.setMeterValues(mDrawnState.meterValues, 64);
     }
   }
 
@@ -263,6 +273,17 @@ private:
   SpeakerDistanceGainAdjustmentProcessor gainAdjustment;
   Meter mMeter;
   std::shared_ptr<Spatializer> mSpatializer;
+
+  StateHistory<SharedState> mStateHistory;
+  SharedState mDrawnState;
+
+  static void blendMeters(const SharedState &a, const SharedState &b, float t,
+                          SharedState &out) {
+    for (int i = 0; i < 64; ++i) {
+      float v = a.meterValues[i] + (b.meterValues[i] - a.meterValues[i]) * t;
+      out.meterValues[i] = std::max(0.f, v); // Extrapolation may undershoot
+    }
+  }
 };
 
 int main(int argc, char *argv[]) {
@@ -32,17 +32,27 @@ You should use parameters when you need near instantaneous updates (usually
 good for audio), or if your state is getting large and you don't require
 updating values on every frame.
 
+Renderers may receive the state late, miss some, or run faster than the
+primary sends them. Instead of drawing state() as it is, this example keeps
+the states received in a StateHistory, with the time the primary sent them,
+and draws a blend of the last two a little behind the primary (see
+include/playground/StateHistory.hpp).
+
 */
 
 #include "Gamma/Oscillator.h"
 #include "al/app/al_DistributedApp.hpp"
 #include "al/graphics/al_Mesh.hpp"
+#include "al/system/al_Time.hpp"
 #include "al/ui/al_ControlGUI.hpp"
 #include "al/ui/al_Parameter.hpp"
 
+#include "playground/StateHistory.hpp"
+
 using namespace al;
 
 struct CommonState {
+  double time = 0; // seconds since start on the primary
   float xPosition = 0.0;
   float mod = 0.5; // modulation value
   Nav nav;
@@ -61,6 +71,10 @@ public:
   Parameter mod{"mod", "", 0.5};
   ControlGUI gui;
 
+  // The states received, and the one drawn
+  StateHistory<CommonState> history;
+  CommonState drawn;
+
   void onInit() override {}
   void onCreate() override {
     addIcosphere(m);
@@ -88,19 +102,34 @@ public:
 
       state().xPosition = factor * 10;
       state().nav = nav();
+      state().time += dt;
+      drawn = state();
     } else {
-      nav() = state().nav;
+      double now = al_steady_time();
+      history.push(state(), state().time, now);
+      // Draw between the last two states received, a + (b - a) * t
+      history.sample(now, drawn,
+                     [](const CommonState &a, const CommonState &b, float t,
+                        CommonState &out) {
+                       out.time = a.time + (b.time - a.time) * t;
+                       out.xPosition =
+                           a.xPosition + (b.xPosition - a.xPosition) * t;
+                       out.mod = a.mod + (b.mod - a.mod) * t;
+                       out.nav = a.nav;
+                       out.nav.lerp(b.nav, t);
+                     });
+      nav() = drawn.nav;
     }
   }
 
   void onDraw(Graphics &g) override {
     g.clear(0);
     g.pushMatrix();
-    // Notice that I query variables through state(). In the case of the primary
-    // node, this is local data, in the case of renderers, this is data
-    // received through state synchronization.
-    g.translate(state().xPosition, 0, -4);
-    g.scale(state().mod);
+    // Notice that I query variables through the state. In the case of the
+    // primary node, this is local data, in the case of renderers, this is data
+    // received through state synchronization and blended by the history.
+    g.translate(drawn.xPosition, 0, -4);
+    g.scale(drawn.mod);
     g.polygonLine();
     g.draw(m);
     if (hasCapability(Capability::CAP_2DGUI)) {
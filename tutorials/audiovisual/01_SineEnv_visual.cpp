@@ -31,6 +31,8 @@
 #include "al/io/al_MIDI.hpp"
 #include "al/math/al_Random.hpp"
 
+#include "playground/VoiceParameter.hpp"
+
 // using namespace gam;
 using namespace al;
 using namespace std;
@@ -59,6 +61,10 @@ public:
   Vec3f note_position;
   Vec3f note_direction;
 
+  // Handles to the parameters read below, set in init()
+  VoiceParameter mAmplitudeParam, mFrequencyParam, mAttackTimeParam,
+      mReleaseTimeParam, mPanParam;
+
   // Additional members
   // Initialize voice. This function will only be called once per voice when
   // it is created. Voices will be reused if they are idle.
@@ -80,11 +86,14 @@ public:
     // change them while you are prototyping, but their changes will only be
     // stored and aplied when a note is triggered.)
 
-    createInternalTriggerParameter("amplitude", 0.3, 0.0, 1.0);
-    createInternalTriggerParameter("frequency", 60, 20, 5000);
-    createInternalTriggerParameter("attackTime", 1.0, 0.01, 3.0);
-    createInternalTriggerParameter("releaseTime", 3.0, 0.1, 10.0);
-    createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+    mAmplitudeParam =
+        createInternalTriggerParameter("amplitude", 0.3, 0.0, 1.0);
+    mFrequencyParam = createInternalTriggerParameter("frequency", 60, 20, 5000);
+    mAttackTimeParam =
+        createInternalTriggerParameter("attackTime", 1.0, 0.01, 3.0);
+    mReleaseTimeParam =
+        createInternalTriggerParameter("releaseTime", 3.0, 0.1, 10.0);
+    mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
 
     // Initalize MIDI device input
   }
@@ -98,13 +107,13 @@ public:
     // voice, rather than having to trigger a new voice to hear the changes.
     // Parameters will update values once per audio callback because they
     // are outside the sample processing loop.
-    mOsc.freq(getInternalParameterValue("frequency"));
-    mAmpEnv.lengths()[0] = getInternalParameterValue("attackTime");
-    mAmpEnv.lengths()[2] = getInternalParameterValue("releaseTime");
-    mPan.pos(getInternalParameterValue("pan"));
+    mOsc.freq(mFrequencyParam.get());
+    mAmpEnv.lengths()[0] = mAttackTimeParam.get();
+    mAmpEnv.lengths()[2] = mReleaseTimeParam.get();
+    mPan.pos(mPanParam.get());
     while (io())
     {
-      float s1 = mOsc() * mAmpEnv() * getInternalParameterValue("amplitude");
+      float s1 = mOsc() * mAmpEnv() * mAmplitudeParam.get();
       float s2;
       mEnvFollow(s1);
       mPan(s1, s1, s2);
@@ -126,8 +135,8 @@ public:
     timepose += 0.02;
     // Get the paramter values on every video frame, to apply changes to the
     // current instance
-    float frequency = getInternalParameterValue("frequency");
-    float amplitude = getInternalParameterValue("amplitude");
+    float frequency = mFrequencyParam.get();
+    float amplitude = mAmplitudeParam.get();
     // Now draw
     g.pushMatrix();
     g.depthTesting(true);
@@ -146,7 +155,7 @@ public:
   // the voice from the processing chain.
   void onTriggerOn() override
   {
-    float angle = getInternalParameterValue("frequency") / 200;
+    float angle = mFrequencyParam.get() / 200;
     mAmpEnv.reset();
     a = al::rnd::uniform();
     b = al::rnd::uniform();
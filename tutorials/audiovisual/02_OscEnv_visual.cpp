@@ -21,6 +21,8 @@
 #include "al/ui/al_Parameter.hpp"
 #include "al/io/al_MIDI.hpp"
 #include "al/math/al_Random.hpp"
+
+#include "playground/VoiceParameter.hpp"
 #include <cstdio>  
 
 // using namespace gam;
@@ -52,6 +54,10 @@ class OscEnv : public SynthVoice {
   double b_rotate = 0;
   double timepose = 0;
 
+  // Handles to the parameters read below, set in init()
+  VoiceParameter mAmplitudeParam, mFrequencyParam, mAttackTimeParam,
+      mReleaseTimeParam, mSustainParam, mCurveParam, mPanParam, mTableParam;
+
   // Initialize voice. This function will nly be called once per voice
   void init() override {
     // Intialize envelope
@@ -60,14 +66,17 @@ class OscEnv : public SynthVoice {
                    0);  // These tables are not normalized, so scale to 0.3
     mAmpEnv.sustainPoint(2);  // Make point 2 sustain until a release is issued
 
-    createInternalTriggerParameter("amplitude", 0.1, 0.0, 1.0);
-    createInternalTriggerParameter("frequency", 60, 20, 5000);
-    createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
-    createInternalTriggerParameter("releaseTime", 1.0, 0.1, 10.0);
-    createInternalTriggerParameter("sustain", 0.7, 0.0, 1.0);
-    createInternalTriggerParameter("curve", 4.0, -10.0, 10.0);
-    createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
-    createInternalTriggerParameter("table", 0, 0, 8);
+    mAmplitudeParam =
+        createInternalTriggerParameter("amplitude", 0.1, 0.0, 1.0);
+    mFrequencyParam = createInternalTriggerParameter("frequency", 60, 20, 5000);
+    mAttackTimeParam =
+        createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
+    mReleaseTimeParam =
+        createInternalTriggerParameter("releaseTime", 1.0, 0.1, 10.0);
+    mSustainParam = createInternalTriggerParameter("sustain", 0.7, 0.0, 1.0);
+    mCurveParam = createInternalTriggerParameter("curve", 4.0, -10.0, 10.0);
+    mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+    mTableParam = createInternalTriggerParameter("table", 0, 0, 8);
 
     // Table & Visual meshes
     // Now We have the mesh according to the waveform
@@ -161,8 +170,7 @@ class OscEnv : public SynthVoice {
   virtual void onProcess(AudioIOData& io) override {
     updateFromParameters();
     while (io()) {
-      float s1 =
-          0.1 * mOsc() * mAmpEnv() * getInternalParameterValue("amplitude");
+      float s1 = 0.1 * mOsc() * mAmpEnv() * mAmplitudeParam.get();
       float s2;
       mEnvFollow(s1);
       mPan(s1, s1, s2);
@@ -179,9 +187,9 @@ class OscEnv : public SynthVoice {
     a_rotate += 0.81;
     b_rotate += 0.78;
     timepose -= 0.06;
-    float frequency = getInternalParameterValue("frequency");
-    float amplitude = getInternalParameterValue("amplitude");
-    int shape = getInternalParameterValue("table");
+    float frequency = mFrequencyParam.get();
+    float amplitude = mAmplitudeParam.get();
+    int shape = mTableParam.get();
 
     // static Light light;
     g.polygonMode(wireframe ? GL_LINE : GL_FILL);
@@ -191,7 +199,7 @@ class OscEnv : public SynthVoice {
     // g.light(light);
     g.pushMatrix();
     g.depthTesting(true);
-    g.translate( timepose, getInternalParameterValue("frequency") / 200 - 3 , -4);
+    g.translate( timepose, mFrequencyParam.get() / 200 - 3 , -4);
     g.rotate(a_rotate, Vec3f(0, 1, 1));
     g.rotate(b_rotate, Vec3f(1));    
     g.scale(0.5 + mAmpEnv() * 2, 0.5 + mAmpEnv() * 2, 0.03 + 0.1*mAmpEnv() );
@@ -210,17 +218,17 @@ class OscEnv : public SynthVoice {
   virtual void onTriggerOff() override { mAmpEnv.triggerRelease(); }
 
   void updateFromParameters() {
-    mOsc.freq(getInternalParameterValue("frequency"));
-    mAmpEnv.attack(getInternalParameterValue("attackTime"));
-    mAmpEnv.decay(getInternalParameterValue("attackTime"));
-    mAmpEnv.release(getInternalParameterValue("releaseTime"));
-    mAmpEnv.sustain(getInternalParameterValue("sustain"));
-    mAmpEnv.curve(getInternalParameterValue("curve"));
-    mPan.pos(getInternalParameterValue("pan"));
+    mOsc.freq(mFrequencyParam.get());
+    mAmpEnv.attack(mAttackTimeParam.get());
+    mAmpEnv.decay(mAttackTimeParam.get());
+    mAmpEnv.release(mReleaseTimeParam.get());
+    mAmpEnv.sustain(mSustainParam.get());
+    mAmpEnv.curve(mCurveParam.get());
+    mPan.pos(mPanParam.get());
   }
   void updateWaveform(){
         // Map table number to table in memory
-    switch (int(getInternalParameterValue("table"))) {
+    switch (int(mTableParam.get())) {
       case 0:
         mOsc.source(tbSaw);
         break;
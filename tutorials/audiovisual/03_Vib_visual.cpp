@@ -21,6 +21,8 @@
 #include "al/ui/al_Parameter.hpp"
 #include "al/io/al_MIDI.hpp"
 #include "al/math/al_Random.hpp"
+
+#include "playground/VoiceParameter.hpp"
 #include <cstdio>  
 
 // using namespace gam;
@@ -55,6 +57,11 @@ class Vib : public SynthVoice {
   float vibValue;
   float outFreq;
   
+  // Handles to the parameters read below, set in init()
+  VoiceParameter mAmplitudeParam, mFrequencyParam, mAttackTimeParam,
+      mReleaseTimeParam, mSustainParam, mCurveParam, mPanParam, mTableParam,
+      mVibRate1Param, mVibRate2Param, mVibRiseParam, mVibDepthParam;
+
   // Initialize voice. This function will nly be called once per voice
   void init() override {
     // Intialize envelope
@@ -64,18 +71,22 @@ class Vib : public SynthVoice {
     mAmpEnv.sustainPoint(2);  // Make point 2 sustain until a release is issued
     mVibEnv.curve(0);
 
-    createInternalTriggerParameter("amplitude", 0.1, 0.0, 1.0);
-    createInternalTriggerParameter("frequency", 60, 20, 5000);
-    createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
-    createInternalTriggerParameter("releaseTime", 1.0, 0.1, 10.0);
-    createInternalTriggerParameter("sustain", 0.7, 0.0, 1.0);
-    createInternalTriggerParameter("curve", 4.0, -10.0, 10.0);
-    createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
-    createInternalTriggerParameter("table", 0, 0, 8);
-    createInternalTriggerParameter("vibRate1", 3.5, 0.2, 20);
-    createInternalTriggerParameter("vibRate2", 5.8, 0.2, 20);
-    createInternalTriggerParameter("vibRise", 0.5, 0.1, 2);
-    createInternalTriggerParameter("vibDepth", 0.005, 0.0, 0.3);
+    mAmplitudeParam =
+        createInternalTriggerParameter("amplitude", 0.1, 0.0, 1.0);
+    mFrequencyParam = createInternalTriggerParameter("frequency", 60, 20, 5000);
+    mAttackTimeParam =
+        createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
+    mReleaseTimeParam =
+        createInternalTriggerParameter("releaseTime", 1.0, 0.1, 10.0);
+    mSustainParam = createInternalTriggerParameter("sustain", 0.7, 0.0, 1.0);
+    mCurveParam = createInternalTriggerParameter("curve", 4.0, -10.0, 10.0);
+    mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+    mTableParam = createInternalTriggerParameter("table", 0, 0, 8);
+    mVibRate1Param = createInternalTriggerParameter("vibRate1", 3.5, 0.2, 20);
+    mVibRate2Param = createInternalTriggerParameter("vibRate2", 5.8, 0.2, 20);
+    mVibRiseParam = createInternalTriggerParameter("vibRise", 0.5, 0.1, 2);
+    mVibDepthParam =
+        createInternalTriggerParameter("vibDepth", 0.005, 0.0, 0.3);
 
     // Table & Visual meshes
     // Now We have the mesh according to the waveform
@@ -157,15 +168,14 @@ class Vib : public SynthVoice {
   //
   virtual void onProcess(AudioIOData& io) override {
     updateFromParameters();
-    float oscFreq = getInternalParameterValue("frequency");
-    float vibDepth = getInternalParameterValue("vibDepth");
+    float oscFreq = mFrequencyParam.get();
+    float vibDepth = mVibDepthParam.get();
     outFreq = oscFreq + vibValue * vibDepth * oscFreq;
     while (io()) {
       mVib.freq(mVibEnv());
       vibValue = mVib();
        mOsc.freq(outFreq);
-      float s1 =
-          0.1 * mOsc() * mAmpEnv() * getInternalParameterValue("amplitude");
+      float s1 = 0.1 * mOsc() * mAmpEnv() * mAmplitudeParam.get();
       float s2;
       mEnvFollow(s1);
       mPan(s1, s1, s2);
@@ -182,7 +192,7 @@ class Vib : public SynthVoice {
     a_rotate += 0.81;
     b_rotate += 0.78;
     timepose -= 0.06;
-    int shape = getInternalParameterValue("table");
+    int shape = mTableParam.get();
     // static Light light;
     g.polygonMode(wireframe ? GL_LINE : GL_FILL);
     // light.pos(0, 0, 0);
@@ -214,24 +224,22 @@ class Vib : public SynthVoice {
   }
 
   void updateFromParameters() {
-    mOsc.freq(getInternalParameterValue("frequency"));
-    mAmpEnv.attack(getInternalParameterValue("attackTime"));
-    mAmpEnv.decay(getInternalParameterValue("attackTime"));
-    mAmpEnv.release(getInternalParameterValue("releaseTime"));
-    mAmpEnv.sustain(getInternalParameterValue("sustain"));
-    mAmpEnv.curve(getInternalParameterValue("curve"));
-    mPan.pos(getInternalParameterValue("pan"));
-    mVibEnv.levels(getInternalParameterValue("vibRate1"),
-                   getInternalParameterValue("vibRate2"),
-                   getInternalParameterValue("vibRate2"),
-                   getInternalParameterValue("vibRate1"));
-    mVibEnv.lengths()[0] = getInternalParameterValue("vibRise");
-    mVibEnv.lengths()[1] = getInternalParameterValue("vibRise");
-    mVibEnv.lengths()[3] = getInternalParameterValue("vibRise");
+    mOsc.freq(mFrequencyParam.get());
+    mAmpEnv.attack(mAttackTimeParam.get());
+    mAmpEnv.decay(mAttackTimeParam.get());
+    mAmpEnv.release(mReleaseTimeParam.get());
+    mAmpEnv.sustain(mSustainParam.get());
+    mAmpEnv.curve(mCurveParam.get());
+    mPan.pos(mPanParam.get());
+    mVibEnv.levels(mVibRate1Param.get(), mVibRate2Param.get(),
+                   mVibRate2Param.get(), mVibRate1Param.get());
+    mVibEnv.lengths()[0] = mVibRiseParam.get();
+    mVibEnv.lengths()[1] = mVibRiseParam.get();
+    mVibEnv.lengths()[3] = mVibRiseParam.get();
   }
   void updateWaveform(){
         // Map table number to table in memory
-    switch (int(getInternalParameterValue("table"))) {
+    switch (int(mTableParam.get())) {
       case 0:
         mOsc.source(tbSaw);
         break;
@@ -22,6 +22,8 @@
 #include "al/ui/al_ControlGUI.hpp"
 #include "al/ui/al_Parameter.hpp"
 
+#include "playground/VoiceParameter.hpp"
+
 // using namespace gam;
 using namespace al;
 using namespace std;
@@ -48,6 +50,12 @@ public:
   float mVibDepth;
   float mVibRise;
 
+  // Handles to the parameters read below, set in init()
+  VoiceParameter mFreqParam, mAmplitudeParam, mAttackTimeParam,
+      mReleaseTimeParam, mSustainParam, mIdx1Param, mIdx2Param, mIdx3Param,
+      mCarMulParam, mModMulParam, mVibRate1Param, mVibRate2Param, mVibRiseParam,
+      mVibDepthParam, mPanParam;
+
   void init() override
   {
     mAmpEnv.curve(0); // linear segments
@@ -62,37 +70,39 @@ public:
     ball.generateNormals();
 
     // We have the mesh be a sphere
-    createInternalTriggerParameter("freq", 440, 10, 4000.0);
-    createInternalTriggerParameter("amplitude", 0.05, 0.0, 1.0);
-    createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
-    createInternalTriggerParameter("releaseTime", 0.5, 0.1, 10.0);
-    createInternalTriggerParameter("sustain", 0.65, 0.1, 1.0);
+    mFreqParam = createInternalTriggerParameter("freq", 440, 10, 4000.0);
+    mAmplitudeParam =
+        createInternalTriggerParameter("amplitude", 0.05, 0.0, 1.0);
+    mAttackTimeParam =
+        createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
+    mReleaseTimeParam =
+        createInternalTriggerParameter("releaseTime", 0.5, 0.1, 10.0);
+    mSustainParam = createInternalTriggerParameter("sustain", 0.65, 0.1, 1.0);
 
     // FM index
-    createInternalTriggerParameter("idx1", 0.01, 0.0, 10.0);
-    createInternalTriggerParameter("idx2", 7, 0.0, 10.0);
-    createInternalTriggerParameter("idx3", 5, 0.0, 10.0);
+    mIdx1Param = createInternalTriggerParameter("idx1", 0.01, 0.0, 10.0);
+    mIdx2Param = createInternalTriggerParameter("idx2", 7, 0.0, 10.0);
+    mIdx3Param = createInternalTriggerParameter("idx3", 5, 0.0, 10.0);
 
-    createInternalTriggerParameter("carMul", 1, 0.0, 20.0);
-    createInternalTriggerParameter("modMul", 1.0007, 0.0, 20.0);
+    mCarMulParam = createInternalTriggerParameter("carMul", 1, 0.0, 20.0);
+    mModMulParam = createInternalTriggerParameter("modMul", 1.0007, 0.0, 20.0);
 
-    createInternalTriggerParameter("vibRate1", 0.01, 0.0, 10.0);
-    createInternalTriggerParameter("vibRate2", 0.5, 0.0, 10.0);
-    createInternalTriggerParameter("vibRise", 0, 0.0, 10.0);
-    createInternalTriggerParameter("vibDepth", 0, 0.0, 10.0);
+    mVibRate1Param =
+        createInternalTriggerParameter("vibRate1", 0.01, 0.0, 10.0);
+    mVibRate2Param = createInternalTriggerParameter("vibRate2", 0.5, 0.0, 10.0);
+    mVibRiseParam = createInternalTriggerParameter("vibRise", 0, 0.0, 10.0);
+    mVibDepthParam = createInternalTriggerParameter("vibDepth", 0, 0.0, 10.0);
 
-    createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+    mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
   }
 
   //
   void onProcess(AudioIOData &io) override
   {
     mVib.freq(mVibEnv());
-    float carBaseFreq =
-        getInternalParameterValue("freq") * getInternalParameterValue("carMul");
-    float modScale =
-        getInternalParameterValue("freq") * getInternalParameterValue("modMul");
-    float amp = getInternalParameterValue("amplitude");
+    float carBaseFreq = mFreqParam.get() * mCarMulParam.get();
+    float modScale = mFreqParam.get() * mModMulParam.get();
+    float amp = mAmplitudeParam.get();
     while (io())
     {
       mVib.freq(mVibEnv());
@@ -117,12 +127,12 @@ public:
     g.pushMatrix();
     g.depthTesting(true);
     g.lighting(true);
-    g.translate(timepose, getInternalParameterValue("freq") / 200 - 3, -4);
+    g.translate(timepose, mFreqParam.get() / 200 - 3, -4);
     g.rotate(mVib() + a, Vec3f(0, 1, 0));
     g.rotate(mVibDepth + b, Vec3f(1));
-    float scaling = getInternalParameterValue("amplitude") / 10;
-    g.scale(scaling + getInternalParameterValue("modMul") / 10, scaling + getInternalParameterValue("carMul") / 30, scaling + mEnvFollow.value() * 5);
-    g.color(HSV(getInternalParameterValue("modMul") / 20, getInternalParameterValue("carMul") / 20, 0.5 + getInternalParameterValue("attackTime")));
+    float scaling = mAmplitudeParam.get() / 10;
+    g.scale(scaling + mModMulParam.get() / 10, scaling + mCarMulParam.get() / 30, scaling + mEnvFollow.value() * 5);
+    g.color(HSV(mModMulParam.get() / 20, mCarMulParam.get() / 20, 0.5 + mAttackTimeParam.get()));
     g.draw(ball);
     g.popMatrix();
   }
@@ -137,8 +147,7 @@ public:
     mod.phase(0);
     updateFromParameters();
 
-    float modFreq =
-        getInternalParameterValue("freq") * getInternalParameterValue("modMul");
+    float modFreq = mFreqParam.get() * mModMulParam.get();
     mod.freq(modFreq);
   }
   void onTriggerOff() override
@@ -150,28 +159,26 @@ public:
 
   void updateFromParameters()
   {
-    mModEnv.levels()[0] = getInternalParameterValue("idx1");
-    mModEnv.levels()[1] = getInternalParameterValue("idx2");
-    mModEnv.levels()[2] = getInternalParameterValue("idx2");
-    mModEnv.levels()[3] = getInternalParameterValue("idx3");
-
-    mAmpEnv.attack(getInternalParameterValue("attackTime"));
-    mAmpEnv.release(getInternalParameterValue("releaseTime"));
-    mAmpEnv.sustain(getInternalParameterValue("sustain"));
-
-    mModEnv.lengths()[0] = getInternalParameterValue("attackTime");
-    mModEnv.lengths()[3] = getInternalParameterValue("releaseTime");
-
-    mVibEnv.levels(getInternalParameterValue("vibRate1"),
-                   getInternalParameterValue("vibRate2"),
-                   getInternalParameterValue("vibRate2"),
-                   getInternalParameterValue("vibRate1"));
-    mVibEnv.lengths()[0] = getInternalParameterValue("vibRise");
-    mVibEnv.lengths()[1] = getInternalParameterValue("vibRise");
-    mVibEnv.lengths()[3] = getInternalParameterValue("vibRise");
-    mVibDepth = getInternalParameterValue("vibDepth");
+    mModEnv.levels()[0] = mIdx1Param.get();
+    mModEnv.levels()[1] = mIdx2Param.get();
+    mModEnv.levels()[2] = mIdx2Param.get();
+    mModEnv.levels()[3] = mIdx3Param.get();
+
+    mAmpEnv.attack(mAttackTimeParam.get());
+    mAmpEnv.release(mReleaseTimeParam.get());
+    mAmpEnv.sustain(mSustainParam.get());
+
+    mModEnv.lengths()[0] = mAttackTimeParam.get();
+    mModEnv.lengths()[3] = mReleaseTimeParam.get();
+
+    mVibEnv.levels(mVibRate1Param.get(), mVibRate2Param.get(),
+                   mVibRate2Param.get(), mVibRate1Param.get());
+    mVibEnv.lengths()[0] = mVibRiseParam.get();
+    mVibEnv.lengths()[1] = mVibRiseParam.get();
+    mVibEnv.lengths()[3] = mVibRiseParam.get();
+    mVibDepth = mVibDepthParam.get();
     
-    mPan.pos(getInternalParameterValue("pan"));
+    mPan.pos(mPanParam.get());
   }
 };
 
@@ -22,14 +22,14 @@
 #include "al/ui/al_ControlGUI.hpp"
 #include "al/ui/al_Parameter.hpp"
 
+#include "playground/VoiceParameter.hpp"
+#include "playground/WavetableBank.hpp"
+
 // using namespace gam;
 using namespace al;
 using namespace std;
 #define FFT_SIZE 4048
 
-// tables for oscillator
-gam::ArrayPow2<float> tbSaw(2048), tbSqr(2048), tbImp(2048), tbSin(2048),
-    tbPls(2048), tb__1(2048), tb__2(2048), tb__3(2048), tb__4(2048);
 
 class FMWT : public SynthVoice
 {
@@ -56,6 +56,12 @@ public:
   bool wireframe = false;
   bool vertexLight = false;
 
+  // Handles to the parameters read below, set in init()
+  VoiceParameter mFreqParam, mAmplitudeParam, mAttackTimeParam,
+      mReleaseTimeParam, mSustainParam, mIdx1Param, mIdx2Param, mIdx3Param,
+      mCarMulParam, mModMulParam, mVibRate1Param, mVibRate2Param, mVibRiseParam,
+      mVibDepthParam, mPanParam, mTableParam;
+
   void init() override
   {
     //      mAmpEnv.curve(0); // linear segments
@@ -65,59 +71,51 @@ public:
     mAmpEnv.sustainPoint(2);
 
     // We have the mesh be a sphere
-    createInternalTriggerParameter("freq", 440, 10, 4000.0);
-    createInternalTriggerParameter("amplitude", 0.1, 0.0, 1.0);
-    createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
-    createInternalTriggerParameter("releaseTime", 0.3, 0.1, 10.0);
-    createInternalTriggerParameter("sustain", 0.65, 0.1, 1.0);
+    mFreqParam = createInternalTriggerParameter("freq", 440, 10, 4000.0);
+    mAmplitudeParam =
+        createInternalTriggerParameter("amplitude", 0.1, 0.0, 1.0);
+    mAttackTimeParam =
+        createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
+    mReleaseTimeParam =
+        createInternalTriggerParameter("releaseTime", 0.3, 0.1, 10.0);
+    mSustainParam = createInternalTriggerParameter("sustain", 0.65, 0.1, 1.0);
 
     // FM index
-    createInternalTriggerParameter("idx1", 0.01, 0.0, 10.0);
-    createInternalTriggerParameter("idx2", 7, 0.0, 10.0);
-    createInternalTriggerParameter("idx3", 5, 0.0, 10.0);
+    mIdx1Param = createInternalTriggerParameter("idx1", 0.01, 0.0, 10.0);
+    mIdx2Param = createInternalTriggerParameter("idx2", 7, 0.0, 10.0);
+    mIdx3Param = createInternalTriggerParameter("idx3", 5, 0.0, 10.0);
 
-    createInternalTriggerParameter("carMul", 1, 0.0, 20.0);
-    createInternalTriggerParameter("modMul", 1.0007, 0.0, 20.0);
+    mCarMulParam = createInternalTriggerParameter("carMul", 1, 0.0, 20.0);
+    mModMulParam = createInternalTriggerParameter("modMul", 1.0007, 0.0, 20.0);
 
-    createInternalTriggerParameter("vibRate1", 0.01, 0.0, 10.0);
-    createInternalTriggerParameter("vibRate2", 0.5, 0.0, 10.0);
-    createInternalTriggerParameter("vibRise", 0, 0.0, 10.0);
-    createInternalTriggerParameter("vibDepth", 0, 0.0, 10.0);
+    mVibRate1Param =
+        createInternalTriggerParameter("vibRate1", 0.01, 0.0, 10.0);
+    mVibRate2Param = createInternalTriggerParameter("vibRate2", 0.5, 0.0, 10.0);
+    mVibRiseParam = createInternalTriggerParameter("vibRise", 0, 0.0, 10.0);
+    mVibDepthParam = createInternalTriggerParameter("vibDepth", 0, 0.0, 10.0);
 
-    createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
-    createInternalTriggerParameter("table", 0, 0, 8);
+    mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+    mTableParam = createInternalTriggerParameter("table", 0, 0, 8);
 
-    // Table & Visual meshes
+    // Visual meshes
     // Now We have the mesh according to the waveform
-    gam::addSinesPow<1>(tbSaw, 9, 1);
     addCone(mMesh[0],1, Vec3f(0,0,5), 40, 1); //tbSaw
 
-    gam::addSinesPow<1>(tbSqr, 9, 2);
     addCube(mMesh[1]);  // tbSquare
 
-    gam::addSinesPow<0>(tbImp, 9, 1);
     addPrism(mMesh[2],1,1,1,100); // tbImp
 
-    gam::addSine(tbSin);
     addSphere(mMesh[3], 0.3, 16, 100); // tbSin
 
-// About: addSines (dst, amps, cycs, numh)
-// \param[out] dst		destination array
-// \param[in] amps		harmonic amplitudes of series, size must be numh - A[]
-// \param[in] cycs		harmonic numbers of series, size must be numh - C[]
-// \param[in] numh		total number of harmonics
     float scaler = 0.15;
     float hscaler = 1;
 
     { //tbPls
-      float A[] = {1, 1, 1, 1, 0.7, 0.5, 0.3, 0.1};
-      gam::addSines(tbPls, A, 8); 
       addWireBox(mMesh[4],2);    // tbPls
     }
     { // tb__1 
       float A[] = {1, 0.4, 0.65, 0.3, 0.18, 0.08, 0, 0};
       float C[] = {1, 4, 7, 11, 15, 18, 0, 0 };
-      gam::addSines(tb__1, A, C, 6);
       for (int i = 0; i < 7; i++){
         addWireBox(mMesh[5], scaler * A[i]*C[i], scaler * A[i+1]*C[i+1], 1 + 0.3*i);
 
@@ -127,7 +125,6 @@ public:
     { // inharmonic partials
       float A[] = {0.5, 0.8, 0.7, 1, 0.3, 0.4, 0.2, 0.12};
       float C[] = {3, 4, 7, 8, 11, 12, 15, 16}; 
-      gam::addSines(tb__2, A, C, 8); // tb__2
       for (int i = 0; i < 7; i++){
         addWireBox(mMesh[6], scaler * A[i]*C[i], scaler * A[i+1]*C[i+1], 1 + 0.3*i);
       }
@@ -135,14 +132,12 @@ public:
     { // inharmonic partials
       float A[] = {1, 0.7, 0.45, 0.3, 0.15, 0.08, 0 , 0};
       float C[] = {10, 27, 54, 81, 108, 135, 0, 0};
-      gam::addSines(tb__3, A, C, 6); // tb__3
       for (int i = 0; i < 7; i++){
         addWireBox(mMesh[7], scaler * A[i]*C[i], scaler * A[i+1]*C[i+1], 1 + 0.3*i);
       }
     }
   { // harmonics 20-27
       float A[] = {0.2, 0.4, 0.6, 1, 0.7, 0.5, 0.3, 0.1};
-      gam::addSines(tb__4, A, 8, 20); // tb__4
       for (int i = 0; i < 7; i++){
         addWireBox(mMesh[8], hscaler * A[i], hscaler * A[i+1], 1 + 0.3*i);
       }
@@ -170,10 +165,9 @@ public:
   void onProcess(AudioIOData &io) override
   {
     mVib.freq(mVibEnv());
-    float carBaseFreq =
-        getInternalParameterValue("freq") * getInternalParameterValue("carMul");
-    float modScale = getInternalParameterValue("freq") * getInternalParameterValue("modMul");
-    float amp = getInternalParameterValue("amplitude") * 0.01;
+    float carBaseFreq = mFreqParam.get() * mCarMulParam.get();
+    float modScale = mFreqParam.get() * mModMulParam.get();
+    float amp = mAmplitudeParam.get() * 0.01;
     while (io())
     {
       mVib.freq(mVibEnv());
@@ -195,19 +189,19 @@ public:
     a += 0.29;
     b += 0.23;
     timepose -= 0.06;
-    int shape = getInternalParameterValue("table");
+    int shape = mTableParam.get();
     g.polygonMode(wireframe ? GL_LINE : GL_FILL);
     // light.pos(0, 0, 0);
     gl::depthTesting(true);
     g.pushMatrix();
     g.depthTesting(true);
     g.lighting(true);
-    g.translate(timepose, getInternalParameterValue("freq") / 200 - 3, -4);
+    g.translate(timepose, mFreqParam.get() / 200 - 3, -4);
     g.rotate(mVib() + a, Vec3f(0, 1, 0));
     g.rotate(mVib() * mVibDepth + b, Vec3f(1));
-    float scaling = getInternalParameterValue("amplitude") * 10;
-    g.scale(scaling + getInternalParameterValue("modMul") / 2, scaling + getInternalParameterValue("carMul") / 20, scaling + mEnvFollow.value() * 5);
-    g.color(HSV(getInternalParameterValue("modMul") / 20, getInternalParameterValue("carMul") / 20, 0.5 + getInternalParameterValue("attackTime")));
+    float scaling = mAmplitudeParam.get() * 10;
+    g.scale(scaling + mModMulParam.get() / 2, scaling + mCarMulParam.get() / 20, scaling + mEnvFollow.value() * 5);
+    g.color(HSV(mModMulParam.get() / 20, mCarMulParam.get() / 20, 0.5 + mAttackTimeParam.get()));
     g.draw(mMesh[shape]);
     g.popMatrix();
   }
@@ -223,8 +217,7 @@ public:
     updateFromParameters();
     updateWaveform();
 
-    float modFreq =
-        getInternalParameterValue("freq") * getInternalParameterValue("modMul");
+    float modFreq = mFreqParam.get() * mModMulParam.get();
     mod.freq(modFreq);
   }
   void onTriggerOff() override
@@ -236,60 +229,30 @@ public:
 
   void updateFromParameters()
   {
-    mModEnv.levels()[0] = getInternalParameterValue("idx1");
-    mModEnv.levels()[1] = getInternalParameterValue("idx2");
-    mModEnv.levels()[2] = getInternalParameterValue("idx2");
-    mModEnv.levels()[3] = getInternalParameterValue("idx3");
-
-    mAmpEnv.attack(getInternalParameterValue("attackTime"));
-    mAmpEnv.release(getInternalParameterValue("releaseTime"));
-    mAmpEnv.sustain(getInternalParameterValue("sustain"));
-
-    mModEnv.lengths()[0] = getInternalParameterValue("attackTime");
-    mModEnv.lengths()[3] = getInternalParameterValue("releaseTime");
-
-    mVibEnv.levels(getInternalParameterValue("vibRate1"),
-                   getInternalParameterValue("vibRate2"),
-                   getInternalParameterValue("vibRate2"),
-                   getInternalParameterValue("vibRate1"));
-    mVibEnv.lengths()[0] = getInternalParameterValue("vibRise");
-    mVibEnv.lengths()[1] = getInternalParameterValue("vibRise");
-    mVibEnv.lengths()[3] = getInternalParameterValue("vibRise");
-    mVibDepth = getInternalParameterValue("vibDepth");
+    mModEnv.levels()[0] = mIdx1Param.get();
+    mModEnv.levels()[1] = mIdx2Param.get();
+    mModEnv.levels()[2] = mIdx2Param.get();
+    mModEnv.levels()[3] = mIdx3Param.get();
+
+    mAmpEnv.attack(mAttackTimeParam.get());
+    mAmpEnv.release(mReleaseTimeParam.get());
+    mAmpEnv.sustain(mSustainParam.get());
+
+    mModEnv.lengths()[0] = mAttackTimeParam.get();
+    mModEnv.lengths()[3] = mReleaseTimeParam.get();
+
+    mVibEnv.levels(mVibRate1Param.get(), mVibRate2Param.get(),
+                   mVibRate2Param.get(), mVibRate1Param.get());
+    mVibEnv.lengths()[0] = mVibRiseParam.get();
+    mVibEnv.lengths()[1] = mVibRiseParam.get();
+    mVibEnv.lengths()[3] = mVibRiseParam.get();
+    mVibDepth = mVibDepthParam.get();
     
-    mPan.pos(getInternalParameterValue("pan"));
+    mPan.pos(mPanParam.get());
   }
   void updateWaveform(){
         // Map table number to table in memory
-    switch (int(getInternalParameterValue("table"))) {
-      case 0:
-        car.source(tbSaw);
-        break;
-      case 1:
-        car.source(tbSqr);
-        break;
-      case 2:
-        car.source(tbImp);
-        break;
-      case 3:
-        car.source(tbSin);
-        break;
-      case 4:
-        car.source(tbPls);
-        break;
-      case 5:
-        car.source(tb__1);
-        break;
-      case 6:
-        car.source(tb__2);
-        break;
-      case 7:
-        car.source(tb__3);
-        break;
-      case 8:
-        car.source(tb__4);
-        break;
-    }
+    car.source(WavetableBank::shared().table(int(mTableParam.get())));
   }
 
 
@@ -322,6 +285,9 @@ public:
                                 // will be using keyboard for note triggering
     // Set sampling rate for Gamma objects from app's audio
     gam::sampleRate(audioIO().framesPerSecond());
+    // Tables come from the cache the first run writes, else are built
+    if (!WavetableBank::shared().load("wavetables.bin"))
+      WavetableBank::shared().save("wavetables.bin");
     // Check for connected MIDI devices
     if (midiIn.getPortCount() > 0)
     {
@@ -24,6 +24,8 @@
 #include "al/io/al_MIDI.hpp"
 #include "al/math/al_Random.hpp"
 
+#include "playground/VoiceParameter.hpp"
+
 // using namespace gam;
 using namespace al;
 using namespace std;
@@ -58,6 +60,11 @@ public:
     double a_rotate = 0;
     double b_rotate = 0;
     double timepose = 0;
+    // Handles to the parameters read below, set in init()
+    VoiceParameter mAmplitudeParam, mFrequencyParam, mAttackTimeParam,
+        mReleaseTimeParam, mSustainParam, mCurveParam, mPanParam, mTableParam,
+        mTrm1Param, mTrm2Param, mTrmRiseParam, mTrmDepthParam;
+
     // Initialize voice. This function will nly be called once per voice
     virtual void init()
     {
@@ -66,18 +73,24 @@ public:
         mAmpEnv.levels(0, 0.3, 0.3, 0); // These tables are not normalized, so scale to 0.3
         mTrmEnv.curve(0);
         mTrmEnv.levels(0, 1, 1, 0);
-        createInternalTriggerParameter("amplitude", 0.03, 0.0, 1.0);
-        createInternalTriggerParameter("frequency", 60, 20, 5000);
-        createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
-        createInternalTriggerParameter("releaseTime", 2.0, 0.1, 10.0);
-        createInternalTriggerParameter("sustain", 0.6, 0.0, 1.0);
-        createInternalTriggerParameter("curve", 4.0, -10.0, 10.0);
-        createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
-        createInternalTriggerParameter("table", 0, 0, 8);
-        createInternalTriggerParameter("trm1", 3.5, 0.2, 20);
-        createInternalTriggerParameter("trm2", 5.8, 0.2, 20);
-        createInternalTriggerParameter("trmRise", 0.5, 0.1, 2);
-        createInternalTriggerParameter("trmDepth", 0.1, 0.0, 1.0);
+        mAmplitudeParam =
+            createInternalTriggerParameter("amplitude", 0.03, 0.0, 1.0);
+        mFrequencyParam =
+            createInternalTriggerParameter("frequency", 60, 20, 5000);
+        mAttackTimeParam =
+            createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
+        mReleaseTimeParam =
+            createInternalTriggerParameter("releaseTime", 2.0, 0.1, 10.0);
+        mSustainParam =
+            createInternalTriggerParameter("sustain", 0.6, 0.0, 1.0);
+        mCurveParam = createInternalTriggerParameter("curve", 4.0, -10.0, 10.0);
+        mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+        mTableParam = createInternalTriggerParameter("table", 0, 0, 8);
+        mTrm1Param = createInternalTriggerParameter("trm1", 3.5, 0.2, 20);
+        mTrm2Param = createInternalTriggerParameter("trm2", 5.8, 0.2, 20);
+        mTrmRiseParam = createInternalTriggerParameter("trmRise", 0.5, 0.1, 2);
+        mTrmDepthParam =
+            createInternalTriggerParameter("trmDepth", 0.1, 0.0, 1.0);
 
         // Table & Visual meshes
         // Now We have the mesh according to the waveform
@@ -167,9 +180,9 @@ public:
     virtual void onProcess(AudioIOData &io) override
     {
         // updateFromParameters();
-        float oscFreq = getInternalParameterValue("frequency");
-        float amp = getInternalParameterValue("amplitude");
-        float trmDepth = getInternalParameterValue("trmDepth");
+        float oscFreq = mFrequencyParam.get();
+        float amp = mAmplitudeParam.get();
+        float trmDepth = mTrmDepthParam.get();
         while (io())
         {
 
@@ -195,8 +208,8 @@ public:
         a_rotate += 0.81;
         b_rotate += 0.78;
         timepose -= 0.06;
-        float frequency = getInternalParameterValue("frequency");
-        int shape = getInternalParameterValue("table");
+        float frequency = mFrequencyParam.get();
+        int shape = mTableParam.get();
 
         // static Light light;
         g.polygonMode(wireframe ? GL_LINE : GL_FILL);
@@ -206,7 +219,7 @@ public:
         // g.light(light);
         g.pushMatrix();
         g.depthTesting(true);
-        g.translate(timepose, getInternalParameterValue("frequency") / 200 - 3, -4);
+        g.translate(timepose, mFrequencyParam.get() / 200 - 3, -4);
         g.rotate(a_rotate, Vec3f(0, 1, 1));
         g.rotate(b_rotate, Vec3f(1));
         g.scale(0.2 + mAmpEnv() * 0.2 + 0.01 * mTrm(), 0.3 + mAmpEnv() * 0.5 + 0.01 * mTrm(), 0.1 + 0.01 * mTrm());
@@ -235,27 +248,25 @@ public:
 
     void updateFromParameters()
     {
-        mOsc.freq(getInternalParameterValue("frequency"));
-        mAmpEnv.attack(getInternalParameterValue("attackTime"));
-        mAmpEnv.decay(getInternalParameterValue("attackTime"));
-        mAmpEnv.release(getInternalParameterValue("releaseTime"));
-        mAmpEnv.sustain(getInternalParameterValue("sustain"));
-        mAmpEnv.curve(getInternalParameterValue("curve"));
-        mPan.pos(getInternalParameterValue("pan"));
-
-        mTrmEnv.levels(getInternalParameterValue("trm1"),
-                       getInternalParameterValue("trm2"),
-                       getInternalParameterValue("trm2"),
-                       getInternalParameterValue("trm1"));
-
-        mTrmEnv.attack(getInternalParameterValue("trmRise"));
-        mTrmEnv.decay(getInternalParameterValue("trmRise"));
-        mTrmEnv.release(getInternalParameterValue("trmRise"));
+        mOsc.freq(mFrequencyParam.get());
+        mAmpEnv.attack(mAttackTimeParam.get());
+        mAmpEnv.decay(mAttackTimeParam.get());
+        mAmpEnv.release(mReleaseTimeParam.get());
+        mAmpEnv.sustain(mSustainParam.get());
+        mAmpEnv.curve(mCurveParam.get());
+        mPan.pos(mPanParam.get());
+
+        mTrmEnv.levels(mTrm1Param.get(), mTrm2Param.get(), mTrm2Param.get(),
+                       mTrm1Param.get());
+
+        mTrmEnv.attack(mTrmRiseParam.get());
+        mTrmEnv.decay(mTrmRiseParam.get());
+        mTrmEnv.release(mTrmRiseParam.get());
     }
     void updateWaveform()
     {
         // Map table number to table in memory
-        switch (int(getInternalParameterValue("table")))
+        switch (int(mTableParam.get()))
         {
         case 0:
             mOsc.source(tbSaw);
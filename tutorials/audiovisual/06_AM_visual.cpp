@@ -27,6 +27,8 @@
 #include "al/math/al_Random.hpp"
 #include "al/sound/al_Reverb.hpp"
 
+#include "playground/VoiceParameter.hpp"
+
 #include <algorithm> 
 #include <cstdint>   
 #include <vector>
@@ -64,6 +66,11 @@ public:
   double b_rotate = 0;
   double timepose = 0;
   Vec3f spinner;
+  // Handles to the parameters read below, set in init()
+  VoiceParameter mAmplitudeParam, mFrequencyParam, mAttackTimeParam,
+      mReleaseTimeParam, mSustainParam, mPanParam, mAmFuncParam, mAm1Param,
+      mAm2Param, mAmRiseParam, mAmRatioParam, mReverberationParam;
+
   // Initialize voice. This function will nly be called once per voice
   virtual void init()
   {
@@ -79,25 +86,30 @@ public:
 
     // We have the mesh be a sphere
 
-    createInternalTriggerParameter("amplitude", 0.1, 0.0, 1.0);
-    createInternalTriggerParameter("frequency", 440, 10, 4000.0);
-    createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
-    createInternalTriggerParameter("releaseTime", 4, 0.1, 10.0);
-    createInternalTriggerParameter("sustain", 0.3, 0.1, 1.0);
-    createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
-    createInternalTriggerParameter("amFunc", 0.0, 0.0, 3.0);
-    createInternalTriggerParameter("am1", 0.75, 0.0, 1.0);
-    createInternalTriggerParameter("am2", 0.75, 0.0, 1.0);
-    createInternalTriggerParameter("amRise", 0.75, 0.1, 1.0);
-    createInternalTriggerParameter("amRatio", 0.75, 0.0, 2.0);
-    createInternalTriggerParameter("reverberation", 0.1, 0.0, 1.0);  }
+    mAmplitudeParam =
+        createInternalTriggerParameter("amplitude", 0.1, 0.0, 1.0);
+    mFrequencyParam =
+        createInternalTriggerParameter("frequency", 440, 10, 4000.0);
+    mAttackTimeParam =
+        createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
+    mReleaseTimeParam =
+        createInternalTriggerParameter("releaseTime", 4, 0.1, 10.0);
+    mSustainParam = createInternalTriggerParameter("sustain", 0.3, 0.1, 1.0);
+    mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+    mAmFuncParam = createInternalTriggerParameter("amFunc", 0.0, 0.0, 3.0);
+    mAm1Param = createInternalTriggerParameter("am1", 0.75, 0.0, 1.0);
+    mAm2Param = createInternalTriggerParameter("am2", 0.75, 0.0, 1.0);
+    mAmRiseParam = createInternalTriggerParameter("amRise", 0.75, 0.1, 1.0);
+    mAmRatioParam = createInternalTriggerParameter("amRatio", 0.75, 0.0, 2.0);
+    mReverberationParam =
+        createInternalTriggerParameter("reverberation", 0.1, 0.0, 1.0);  }
 
   virtual void onProcess(AudioIOData &io) override
   {
-    mOsc.freq(getInternalParameterValue("frequency"));
+    mOsc.freq(mFrequencyParam.get());
 
-    float amp = getInternalParameterValue("amplitude");
-    float amRatio = getInternalParameterValue("amRatio");
+    float amp = mAmplitudeParam.get();
+    float amRatio = mAmRatioParam.get();
     while (io())
     {
 
@@ -127,9 +139,9 @@ public:
 
   virtual void onProcess(Graphics &g)
   {
-    float frequency = getInternalParameterValue("frequency");
-    float amplitude = getInternalParameterValue("amplitude");
-    float pan = getInternalParameterValue("pan");
+    float frequency = mFrequencyParam.get();
+    float amplitude = mAmplitudeParam.get();
+    float pan = mPanParam.get();
     int shape = getInternalParameterValue("table");
     float radius = frequency / 300;
     b_rotate += 1.1;
@@ -147,7 +159,7 @@ public:
     g.rotate(b_rotate, spinner);
     g.scale(0.05 * mAM() + 0.3);
     // center the model
-    g.color(HSV(mOsc.freq() * getInternalParameterValue("amRatio") / 1000 + mAM() * 0.01, 0.5 + mAmpEnv() * 0.5, 0.05 + 5 * mAmpEnv()));
+    g.color(HSV(mOsc.freq() * mAmRatioParam.get() / 1000 + mAM() * 0.01, 0.5 + mAmpEnv() * 0.5, 0.05 + 5 * mAmpEnv()));
     g.draw(mMesh);
     g.popMatrix();
   }
@@ -155,24 +167,21 @@ public:
   virtual void onTriggerOn() override
   {
     reverb.zero();
-    mAmpEnv.attack(getInternalParameterValue("attackTime"));
-    mAmpEnv.release(getInternalParameterValue("releaseTime"));
+    mAmpEnv.attack(mAttackTimeParam.get());
+    mAmpEnv.release(mReleaseTimeParam.get());
 
-    mAmpEnv.levels()[1] = getInternalParameterValue("sustain");
-    mAmpEnv.levels()[2] = getInternalParameterValue("sustain");
+    mAmpEnv.levels()[1] = mSustainParam.get();
+    mAmpEnv.levels()[2] = mSustainParam.get();
 
-    mAMEnv.levels(getInternalParameterValue("am1"),
-                  getInternalParameterValue("am2"),
-                  getInternalParameterValue("am2"),
-                  getInternalParameterValue("am1"));
+    mAMEnv.levels(mAm1Param.get(), mAm2Param.get(), mAm2Param.get(),
+                  mAm1Param.get());
 
-    mAMEnv.lengths(getInternalParameterValue("amRise"),
-                   1 - getInternalParameterValue("amRise"));
+    mAMEnv.lengths(mAmRiseParam.get(), 1 - mAmRiseParam.get());
 
-    mPan.pos(getInternalParameterValue("pan"));
+    mPan.pos(mPanParam.get());
 
 
-    reverb.damping(1-getInternalParameterValue("reverberation"));     // Tail decay factor, in [0,1]
+    reverb.damping(1-mReverberationParam.get());     // Tail decay factor, in [0,1]
 
     mAmpEnv.reset();
     mAMEnv.reset();
@@ -180,7 +189,7 @@ public:
     b_rotate = al::rnd::uniform(0, 360);
     spinner = randomVec3f(1);
     // Map table number to table in memory
-    switch (int(getInternalParameterValue("amFunc")))
+    switch (int(mAmFuncParam.get()))
     {
     case 0:
       mAM.source(tbSin);
@@ -25,6 +25,8 @@
 #include "al/io/al_MIDI.hpp"
 #include "al/math/al_Random.hpp"
 
+#include "playground/VoiceParameter.hpp"
+
 using namespace gam;
 using namespace al;
 using namespace std;
@@ -56,6 +58,14 @@ public:
   double timepose = 0;
   Vec3f note_position;
   Vec3f note_direction;
+  // Handles to the parameters read below, set in init()
+  VoiceParameter mAmpParam, mFrequencyParam, mAmpStriParam, mAttackStriParam,
+      mReleaseStriParam, mSustainStriParam, mAmpLowParam, mAttackLowParam,
+      mReleaseLowParam, mSustainLowParam, mAmpUpParam, mAttackUpParam,
+      mReleaseUpParam, mSustainUpParam, mFreqStri1Param, mFreqStri2Param,
+      mFreqStri3Param, mFreqLow1Param, mFreqLow2Param, mFreqUp1Param,
+      mFreqUp2Param, mFreqUp3Param, mFreqUp4Param, mPanParam;
+
   virtual void init()
   {
 
@@ -78,51 +88,61 @@ public:
     ball.decompress();
     ball.generateNormals();
 
-    createInternalTriggerParameter("amp", 0.01, 0.0, 0.3);
-    createInternalTriggerParameter("frequency", 60, 20, 5000);
-    createInternalTriggerParameter("ampStri", 0.5, 0.0, 1.0);
-    createInternalTriggerParameter("attackStri", 0.1, 0.01, 3.0);
-    createInternalTriggerParameter("releaseStri", 0.1, 0.1, 10.0);
-    createInternalTriggerParameter("sustainStri", 0.8, 0.0, 1.0);
-    createInternalTriggerParameter("ampLow", 0.5, 0.0, 1.0);
-    createInternalTriggerParameter("attackLow", 0.001, 0.01, 3.0);
-    createInternalTriggerParameter("releaseLow", 0.1, 0.1, 10.0);
-    createInternalTriggerParameter("sustainLow", 0.8, 0.0, 1.0);
-    createInternalTriggerParameter("ampUp", 0.6, 0.0, 1.0);
-    createInternalTriggerParameter("attackUp", 0.01, 0.01, 3.0);
-    createInternalTriggerParameter("releaseUp", 0.075, 0.1, 10.0);
-    createInternalTriggerParameter("sustainUp", 0.9, 0.0, 1.0);
-    createInternalTriggerParameter("freqStri1", 1.0, 0.1, 10);
-    createInternalTriggerParameter("freqStri2", 2.001, 0.1, 10);
-    createInternalTriggerParameter("freqStri3", 3.0, 0.1, 10);
-    createInternalTriggerParameter("freqLow1", 4.009, 0.1, 10);
-    createInternalTriggerParameter("freqLow2", 5.002, 0.1, 10);
-    createInternalTriggerParameter("freqUp1", 6.0, 0.1, 10);
-    createInternalTriggerParameter("freqUp2", 7.0, 0.1, 10);
-    createInternalTriggerParameter("freqUp3", 8.0, 0.1, 10);
-    createInternalTriggerParameter("freqUp4", 9.0, 0.1, 10);
-    createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+    mAmpParam = createInternalTriggerParameter("amp", 0.01, 0.0, 0.3);
+    mFrequencyParam = createInternalTriggerParameter("frequency", 60, 20, 5000);
+    mAmpStriParam = createInternalTriggerParameter("ampStri", 0.5, 0.0, 1.0);
+    mAttackStriParam =
+        createInternalTriggerParameter("attackStri", 0.1, 0.01, 3.0);
+    mReleaseStriParam =
+        createInternalTriggerParameter("releaseStri", 0.1, 0.1, 10.0);
+    mSustainStriParam =
+        createInternalTriggerParameter("sustainStri", 0.8, 0.0, 1.0);
+    mAmpLowParam = createInternalTriggerParameter("ampLow", 0.5, 0.0, 1.0);
+    mAttackLowParam =
+        createInternalTriggerParameter("attackLow", 0.001, 0.01, 3.0);
+    mReleaseLowParam =
+        createInternalTriggerParameter("releaseLow", 0.1, 0.1, 10.0);
+    mSustainLowParam =
+        createInternalTriggerParameter("sustainLow", 0.8, 0.0, 1.0);
+    mAmpUpParam = createInternalTriggerParameter("ampUp", 0.6, 0.0, 1.0);
+    mAttackUpParam =
+        createInternalTriggerParameter("attackUp", 0.01, 0.01, 3.0);
+    mReleaseUpParam =
+        createInternalTriggerParameter("releaseUp", 0.075, 0.1, 10.0);
+    mSustainUpParam =
+        createInternalTriggerParameter("sustainUp", 0.9, 0.0, 1.0);
+    mFreqStri1Param = createInternalTriggerParameter("freqStri1", 1.0, 0.1, 10);
+    mFreqStri2Param =
+        createInternalTriggerParameter("freqStri2", 2.001, 0.1, 10);
+    mFreqStri3Param = createInternalTriggerParameter("freqStri3", 3.0, 0.1, 10);
+    mFreqLow1Param = createInternalTriggerParameter("freqLow1", 4.009, 0.1, 10);
+    mFreqLow2Param = createInternalTriggerParameter("freqLow2", 5.002, 0.1, 10);
+    mFreqUp1Param = createInternalTriggerParameter("freqUp1", 6.0, 0.1, 10);
+    mFreqUp2Param = createInternalTriggerParameter("freqUp2", 7.0, 0.1, 10);
+    mFreqUp3Param = createInternalTriggerParameter("freqUp3", 8.0, 0.1, 10);
+    mFreqUp4Param = createInternalTriggerParameter("freqUp4", 9.0, 0.1, 10);
+    mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
   }
 
   virtual void onProcess(AudioIOData &io) override
   {
     // Parameters will update values once per audio callback
-    float freq = getInternalParameterValue("frequency");
+    float freq = mFrequencyParam.get();
     mOsc.freq(freq);
-    mOsc1.freq(getInternalParameterValue("freqStri1") * freq);
-    mOsc2.freq(getInternalParameterValue("freqStri2") * freq);
-    mOsc3.freq(getInternalParameterValue("freqStri3") * freq);
-    mOsc4.freq(getInternalParameterValue("freqLow1") * freq);
-    mOsc5.freq(getInternalParameterValue("freqLow2") * freq);
-    mOsc6.freq(getInternalParameterValue("freqUp1") * freq);
-    mOsc7.freq(getInternalParameterValue("freqUp2") * freq);
-    mOsc8.freq(getInternalParameterValue("freqUp3") * freq);
-    mOsc9.freq(getInternalParameterValue("freqUp4") * freq);
-    mPan.pos(getInternalParameterValue("pan"));
-    float ampStri = getInternalParameterValue("ampStri");
-    float ampUp = getInternalParameterValue("ampUp");
-    float ampLow = getInternalParameterValue("ampLow");
-    float amp = getInternalParameterValue("amp");
+    mOsc1.freq(mFreqStri1Param.get() * freq);
+    mOsc2.freq(mFreqStri2Param.get() * freq);
+    mOsc3.freq(mFreqStri3Param.get() * freq);
+    mOsc4.freq(mFreqLow1Param.get() * freq);
+    mOsc5.freq(mFreqLow2Param.get() * freq);
+    mOsc6.freq(mFreqUp1Param.get() * freq);
+    mOsc7.freq(mFreqUp2Param.get() * freq);
+    mOsc8.freq(mFreqUp3Param.get() * freq);
+    mOsc9.freq(mFreqUp4Param.get() * freq);
+    mPan.pos(mPanParam.get());
+    float ampStri = mAmpStriParam.get();
+    float ampUp = mAmpUpParam.get();
+    float ampLow = mAmpLowParam.get();
+    float amp = mAmpParam.get();
     while (io())
     {
       float s1 = (mOsc1() + mOsc2() + mOsc3()) * mEnvStri() * ampStri;
@@ -147,7 +167,7 @@ public:
     timepose += 0.02;
     // Get the paramter values on every video frame, to apply changes to the
     // current instance
-    float frequency = getInternalParameterValue("frequency");
+    float frequency = mFrequencyParam.get();
     float amplitude = getInternalParameterValue("amplitude");
     // Now draw
     g.pushMatrix();
@@ -166,27 +186,27 @@ public:
   virtual void onTriggerOn() override
   {
 
-    mEnvStri.attack(getInternalParameterValue("attackStri"));
-    mEnvStri.decay(getInternalParameterValue("attackStri"));
-    mEnvStri.sustain(getInternalParameterValue("sustainStri"));
-    mEnvStri.release(getInternalParameterValue("releaseStri"));
+    mEnvStri.attack(mAttackStriParam.get());
+    mEnvStri.decay(mAttackStriParam.get());
+    mEnvStri.sustain(mSustainStriParam.get());
+    mEnvStri.release(mReleaseStriParam.get());
 
-    mEnvLow.attack(getInternalParameterValue("attackLow"));
-    mEnvLow.decay(getInternalParameterValue("attackLow"));
-    mEnvLow.sustain(getInternalParameterValue("sustainLow"));
-    mEnvLow.release(getInternalParameterValue("releaseLow"));
+    mEnvLow.attack(mAttackLowParam.get());
+    mEnvLow.decay(mAttackLowParam.get());
+    mEnvLow.sustain(mSustainLowParam.get());
+    mEnvLow.release(mReleaseLowParam.get());
 
-    mEnvUp.attack(getInternalParameterValue("attackUp"));
-    mEnvUp.decay(getInternalParameterValue("attackUp"));
-    mEnvUp.sustain(getInternalParameterValue("sustainUp"));
-    mEnvUp.release(getInternalParameterValue("releaseUp"));
+    mEnvUp.attack(mAttackUpParam.get());
+    mEnvUp.decay(mAttackUpParam.get());
+    mEnvUp.sustain(mSustainUpParam.get());
+    mEnvUp.release(mReleaseUpParam.get());
 
-    mPan.pos(getInternalParameterValue("pan"));
+    mPan.pos(mPanParam.get());
 
     mEnvStri.reset();
     mEnvLow.reset();
     mEnvUp.reset();
-    float angle = getInternalParameterValue("frequency") / 200;
+    float angle = mFrequencyParam.get() / 200;
 
     a = al::rnd::uniform();
     b = al::rnd::uniform();
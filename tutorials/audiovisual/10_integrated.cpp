@@ -57,6 +57,9 @@ public:
 
   virtual void onInit() override
   {
+    // Tables come from the cache the first run writes, else are built
+    if (!WavetableBank::shared().load("wavetables.bin"))
+      WavetableBank::shared().save("wavetables.bin");
     // Check for connected MIDI devices
     if (midiIn.getPortCount() > 0)
     {
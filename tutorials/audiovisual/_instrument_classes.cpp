@@ -19,13 +19,13 @@
 #include "al/io/al_MIDI.hpp"
 #include "al/math/al_Random.hpp"
 
+#include "playground/VoiceParameter.hpp"
+#include "playground/WavetableBank.hpp"
+
 using namespace gam;
 using namespace al;
 using namespace std;
 #define FFT_SIZE 4048
-// tables for oscillator
-gam::ArrayPow2<float> tbSaw(2048), tbSqr(2048), tbImp(2048), tbSin(2048), tbDin(2048),
-    tbPls(2048), tb__1(2048), tb__2(2048), tb__3(2048), tb__4(2048);
 Vec3f randomVec3f(float scale)
 {
   return Vec3f(al::rnd::uniformS(), al::rnd::uniformS(), al::rnd::uniformS()) * scale;
@@ -48,6 +48,10 @@ public:
   Vec3f note_position;
   Vec3f note_direction;
 
+  // Handles to the parameters read below, set in init()
+  VoiceParameter mAmplitudeParam, mFrequencyParam, mAttackTimeParam,
+      mReleaseTimeParam, mPanParam;
+
   // Additional members
   // Initialize voice. This function will only be called once per voice when
   // it is created. Voices will be reused if they are idle.
@@ -69,11 +73,14 @@ public:
     // change them while you are prototyping, but their changes will only be
     // stored and aplied when a note is triggered.)
 
-    createInternalTriggerParameter("amplitude", 0.3, 0.0, 1.0);
-    createInternalTriggerParameter("frequency", 60, 20, 5000);
-    createInternalTriggerParameter("attackTime", 1.0, 0.01, 3.0);
-    createInternalTriggerParameter("releaseTime", 3.0, 0.1, 10.0);
-    createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+    mAmplitudeParam =
+        createInternalTriggerParameter("amplitude", 0.3, 0.0, 1.0);
+    mFrequencyParam = createInternalTriggerParameter("frequency", 60, 20, 5000);
+    mAttackTimeParam =
+        createInternalTriggerParameter("attackTime", 1.0, 0.01, 3.0);
+    mReleaseTimeParam =
+        createInternalTriggerParameter("releaseTime", 3.0, 0.1, 10.0);
+    mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
 
     // Initalize MIDI device input
   }
@@ -87,13 +94,13 @@ public:
     // voice, rather than having to trigger a new voice to hear the changes.
     // Parameters will update values once per audio callback because they
     // are outside the sample processing loop.
-    mOsc.freq(getInternalParameterValue("frequency"));
-    mAmpEnv.lengths()[0] = getInternalParameterValue("attackTime");
-    mAmpEnv.lengths()[2] = getInternalParameterValue("releaseTime");
-    mPan.pos(getInternalParameterValue("pan"));
+    mOsc.freq(mFrequencyParam.get());
+    mAmpEnv.lengths()[0] = mAttackTimeParam.get();
+    mAmpEnv.lengths()[2] = mReleaseTimeParam.get();
+    mPan.pos(mPanParam.get());
     while (io())
     {
-      float s1 = mOsc() * mAmpEnv() * getInternalParameterValue("amplitude");
+      float s1 = mOsc() * mAmpEnv() * mAmplitudeParam.get();
       float s2;
       mEnvFollow(s1);
       mPan(s1, s1, s2);
@@ -115,8 +122,8 @@ public:
     timepose += 0.02;
     // Get the paramter values on every video frame, to apply changes to the
     // current instance
-    float frequency = getInternalParameterValue("frequency");
-    float amplitude = getInternalParameterValue("amplitude");
+    float frequency = mFrequencyParam.get();
+    float amplitude = mAmplitudeParam.get();
     // Now draw
     g.pushMatrix();
     g.depthTesting(true);
@@ -135,7 +142,7 @@ public:
   // the voice from the processing chain.
   void onTriggerOn() override
   {
-    float angle = getInternalParameterValue("frequency") / 200;
+    float angle = mFrequencyParam.get() / 200;
     mAmpEnv.reset();
     a = al::rnd::uniform();
     b = al::rnd::uniform();
@@ -166,6 +173,10 @@ class OscEnv : public SynthVoice {
   double b_rotate = 0;
   double timepose = 0;
 
+  // Handles to the parameters read below, set in init()
+  VoiceParameter mAmplitudeParam, mFrequencyParam, mAttackTimeParam,
+      mReleaseTimeParam, mSustainParam, mCurveParam, mPanParam, mTableParam;
+
   // Initialize voice. This function will nly be called once per voice
   void init() override {
     // Intialize envelope
@@ -174,46 +185,37 @@ class OscEnv : public SynthVoice {
                    0);  // These tables are not normalized, so scale to 0.3
     mAmpEnv.sustainPoint(2);  // Make point 2 sustain until a release is issued
 
-    createInternalTriggerParameter("amplitude", 0.1, 0.0, 1.0);
-    createInternalTriggerParameter("frequency", 60, 20, 5000);
-    createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
-    createInternalTriggerParameter("releaseTime", 1.0, 0.1, 10.0);
-    createInternalTriggerParameter("sustain", 0.7, 0.0, 1.0);
-    createInternalTriggerParameter("curve", 4.0, -10.0, 10.0);
-    createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
-    createInternalTriggerParameter("table", 0, 0, 8);
-
-    // Table & Visual meshes
+    mAmplitudeParam =
+        createInternalTriggerParameter("amplitude", 0.1, 0.0, 1.0);
+    mFrequencyParam = createInternalTriggerParameter("frequency", 60, 20, 5000);
+    mAttackTimeParam =
+        createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
+    mReleaseTimeParam =
+        createInternalTriggerParameter("releaseTime", 1.0, 0.1, 10.0);
+    mSustainParam = createInternalTriggerParameter("sustain", 0.7, 0.0, 1.0);
+    mCurveParam = createInternalTriggerParameter("curve", 4.0, -10.0, 10.0);
+    mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+    mTableParam = createInternalTriggerParameter("table", 0, 0, 8);
+
+    // Visual meshes
     // Now We have the mesh according to the waveform
-    gam::addSinesPow<1>(tbSaw, 9, 1);
     addCone(mMesh[0],1, Vec3f(0,0,5), 40, 1); //tbSaw
 
-    gam::addSinesPow<1>(tbSqr, 9, 2);
     addCube(mMesh[1]);  // tbSquare
 
-    gam::addSinesPow<0>(tbImp, 9, 1);
     addPrism(mMesh[2],1,1,1,100); // tbImp
 
-    gam::addSine(tbSin);
     addSphere(mMesh[3], 0.3, 16, 100); // tbSin
 
-// About: addSines (dst, amps, cycs, numh)
-// \param[out] dst		destination array
-// \param[in] amps		harmonic amplitudes of series, size must be numh - A[]
-// \param[in] cycs		harmonic numbers of series, size must be numh - C[]
-// \param[in] numh		total number of harmonics
     float scaler = 0.15;
     float hscaler = 1;
 
     { //tbPls
-      float A[] = {1, 1, 1, 1, 0.7, 0.5, 0.3, 0.1};
-      gam::addSines(tbPls, A, 8); 
       addWireBox(mMesh[4],2);    // tbPls
     }
     { // tb__1 
       float A[] = {1, 0.4, 0.65, 0.3, 0.18, 0.08, 0, 0};
       float C[] = {1, 4, 7, 11, 15, 18, 0, 0 };
-      gam::addSines(tb__1, A, C, 6);
       for (int i = 0; i < 7; i++){
         addWireBox(mMesh[5], scaler * A[i]*C[i], scaler * A[i+1]*C[i+1], 1 + 0.3*i);
 
@@ -223,7 +225,6 @@ class OscEnv : public SynthVoice {
     { // inharmonic partials
       float A[] = {0.5, 0.8, 0.7, 1, 0.3, 0.4, 0.2, 0.12};
       float C[] = {3, 4, 7, 8, 11, 12, 15, 16}; 
-      gam::addSines(tb__2, A, C, 8); // tb__2
       for (int i = 0; i < 7; i++){
         addWireBox(mMesh[6], scaler * A[i]*C[i], scaler * A[i+1]*C[i+1], 1 + 0.3*i);
       }
@@ -231,14 +232,12 @@ class OscEnv : public SynthVoice {
     { // inharmonic partials
       float A[] = {1, 0.7, 0.45, 0.3, 0.15, 0.08, 0 , 0};
       float C[] = {10, 27, 54, 81, 108, 135, 0, 0};
-      gam::addSines(tb__3, A, C, 6); // tb__3
       for (int i = 0; i < 7; i++){
         addWireBox(mMesh[7], scaler * A[i]*C[i], scaler * A[i+1]*C[i+1], 1 + 0.3*i);
       }
     }
   { // harmonics 20-27
       float A[] = {0.2, 0.4, 0.6, 1, 0.7, 0.5, 0.3, 0.1};
-      gam::addSines(tb__4, A, 8, 20); // tb__4
       for (int i = 0; i < 7; i++){
         addWireBox(mMesh[8], hscaler * A[i], hscaler * A[i+1], 1 + 0.3*i);
       }
@@ -275,8 +274,7 @@ class OscEnv : public SynthVoice {
   virtual void onProcess(AudioIOData& io) override {
     updateFromParameters();
     while (io()) {
-      float s1 =
-          0.1 * mOsc() * mAmpEnv() * getInternalParameterValue("amplitude");
+      float s1 = 0.1 * mOsc() * mAmpEnv() * mAmplitudeParam.get();
       float s2;
       mEnvFollow(s1);
       mPan(s1, s1, s2);
@@ -293,9 +291,9 @@ class OscEnv : public SynthVoice {
     a_rotate += 0.81;
     b_rotate += 0.78;
     timepose -= 0.06;
-    float frequency = getInternalParameterValue("frequency");
-    float amplitude = getInternalParameterValue("amplitude");
-    int shape = getInternalParameterValue("table");
+    float frequency = mFrequencyParam.get();
+    float amplitude = mAmplitudeParam.get();
+    int shape = mTableParam.get();
 
     // static Light light;
     g.polygonMode(wireframe ? GL_LINE : GL_FILL);
@@ -305,7 +303,7 @@ class OscEnv : public SynthVoice {
     // g.light(light);
     g.pushMatrix();
     g.depthTesting(true);
-    g.translate( timepose, getInternalParameterValue("frequency") / 200 - 3 , -15);
+    g.translate( timepose, mFrequencyParam.get() / 200 - 3 , -15);
     g.rotate(a_rotate, Vec3f(0, 1, 1));
     g.rotate(b_rotate, Vec3f(1));    
     g.scale(0.5 + mAmpEnv() * 2, 0.5 + mAmpEnv() * 2, 0.03 + 0.1*mAmpEnv() );
@@ -324,45 +322,17 @@ class OscEnv : public SynthVoice {
   virtual void onTriggerOff() override { mAmpEnv.triggerRelease(); }
 
   void updateFromParameters() {
-    mOsc.freq(getInternalParameterValue("frequency"));
-    mAmpEnv.attack(getInternalParameterValue("attackTime"));
-    mAmpEnv.decay(getInternalParameterValue("attackTime"));
-    mAmpEnv.release(getInternalParameterValue("releaseTime"));
-    mAmpEnv.sustain(getInternalParameterValue("sustain"));
-    mAmpEnv.curve(getInternalParameterValue("curve"));
-    mPan.pos(getInternalParameterValue("pan"));
+    mOsc.freq(mFrequencyParam.get());
+    mAmpEnv.attack(mAttackTimeParam.get());
+    mAmpEnv.decay(mAttackTimeParam.get());
+    mAmpEnv.release(mReleaseTimeParam.get());
+    mAmpEnv.sustain(mSustainParam.get());
+    mAmpEnv.curve(mCurveParam.get());
+    mPan.pos(mPanParam.get());
   }
   void updateWaveform(){
         // Map table number to table in memory
-    switch (int(getInternalParameterValue("table"))) {
-      case 0:
-        mOsc.source(tbSaw);
-        break;
-      case 1:
-        mOsc.source(tbSqr);
-        break;
-      case 2:
-        mOsc.source(tbImp);
-        break;
-      case 3:
-        mOsc.source(tbSin);
-        break;
-      case 4:
-        mOsc.source(tbPls);
-        break;
-      case 5:
-        mOsc.source(tb__1);
-        break;
-      case 6:
-        mOsc.source(tb__2);
-        break;
-      case 7:
-        mOsc.source(tb__3);
-        break;
-      case 8:
-        mOsc.source(tb__4);
-        break;
-    }
+    mOsc.source(WavetableBank::shared().table(int(mTableParam.get())));
   }
 
 };
@@ -389,6 +359,11 @@ class Vib : public SynthVoice {
   float vibValue;
   float outFreq;
   
+  // Handles to the parameters read below, set in init()
+  VoiceParameter mAmplitudeParam, mFrequencyParam, mAttackTimeParam,
+      mReleaseTimeParam, mSustainParam, mCurveParam, mPanParam, mTableParam,
+      mVibRate1Param, mVibRate2Param, mVibRiseParam, mVibDepthParam;
+
   // Initialize voice. This function will nly be called once per voice
   void init() override {
     // Intialize envelope
@@ -398,50 +373,42 @@ class Vib : public SynthVoice {
     mAmpEnv.sustainPoint(2);  // Make point 2 sustain until a release is issued
     mVibEnv.curve(0);
 
-    createInternalTriggerParameter("amplitude", 0.1, 0.0, 1.0);
-    createInternalTriggerParameter("frequency", 60, 20, 5000);
-    createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
-    createInternalTriggerParameter("releaseTime", 1.0, 0.1, 10.0);
-    createInternalTriggerParameter("sustain", 0.7, 0.0, 1.0);
-    createInternalTriggerParameter("curve", 4.0, -10.0, 10.0);
-    createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
-    createInternalTriggerParameter("table", 0, 0, 8);
-    createInternalTriggerParameter("vibRate1", 3.5, 0.2, 20);
-    createInternalTriggerParameter("vibRate2", 5.8, 0.2, 20);
-    createInternalTriggerParameter("vibRise", 0.5, 0.1, 2);
-    createInternalTriggerParameter("vibDepth", 0.005, 0.0, 0.3);
-
-    // Table & Visual meshes
+    mAmplitudeParam =
+        createInternalTriggerParameter("amplitude", 0.1, 0.0, 1.0);
+    mFrequencyParam = createInternalTriggerParameter("frequency", 60, 20, 5000);
+    mAttackTimeParam =
+        createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
+    mReleaseTimeParam =
+        createInternalTriggerParameter("releaseTime", 1.0, 0.1, 10.0);
+    mSustainParam = createInternalTriggerParameter("sustain", 0.7, 0.0, 1.0);
+    mCurveParam = createInternalTriggerParameter("curve", 4.0, -10.0, 10.0);
+    mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+    mTableParam = createInternalTriggerParameter("table", 0, 0, 8);
+    mVibRate1Param = createInternalTriggerParameter("vibRate1", 3.5, 0.2, 20);
+    mVibRate2Param = createInternalTriggerParameter("vibRate2", 5.8, 0.2, 20);
+    mVibRiseParam = createInternalTriggerParameter("vibRise", 0.5, 0.1, 2);
+    mVibDepthParam =
+        createInternalTriggerParameter("vibDepth", 0.005, 0.0, 0.3);
+
+    // Visual meshes
     // Now We have the mesh according to the waveform
-    gam::addSinesPow<1>(tbSaw, 9, 1);
     addCone(mMesh[0],1, Vec3f(0,0,5), 40, 1); //tbSaw
 
-    gam::addSinesPow<1>(tbSqr, 9, 2);
     addCube(mMesh[1]);  // tbSquare
 
-    gam::addSinesPow<0>(tbImp, 9, 1);
     addPrism(mMesh[2],1,1,1,100); // tbImp
 
-    gam::addSine(tbSin);
     addSphere(mMesh[3], 0.3, 16, 100); // tbSin
 
-// About: addSines (dst, amps, cycs, numh)
-// \param[out] dst		destination array
-// \param[in] amps		harmonic amplitudes of series, size must be numh - A[]
-// \param[in] cycs		harmonic numbers of series, size must be numh - C[]
-// \param[in] numh		total number of harmonics
     float scaler = 0.15;
     float hscaler = 1;
 
     { //tbPls
-      float A[] = {1, 1, 1, 1, 0.7, 0.5, 0.3, 0.1};
-      gam::addSines(tbPls, A, 8); 
       addWireBox(mMesh[4],2);    // tbPls
     }
     { // tb__1 
       float A[] = {1, 0.4, 0.65, 0.3, 0.18, 0.08, 0, 0};
       float C[] = {1, 4, 7, 11, 15, 18, 0, 0 };
-      gam::addSines(tb__1, A, C, 6);
       for (int i = 0; i < 7; i++){
         addWireBox(mMesh[5], scaler * A[i]*C[i], scaler * A[i+1]*C[i+1], 1 + 0.3*i);
 
@@ -451,7 +418,6 @@ class Vib : public SynthVoice {
     { // inharmonic partials
       float A[] = {0.5, 0.8, 0.7, 1, 0.3, 0.4, 0.2, 0.12};
       float C[] = {3, 4, 7, 8, 11, 12, 15, 16}; 
-      gam::addSines(tb__2, A, C, 8); // tb__2
       for (int i = 0; i < 7; i++){
         addWireBox(mMesh[6], scaler * A[i]*C[i], scaler * A[i+1]*C[i+1], 1 + 0.3*i);
       }
@@ -459,14 +425,12 @@ class Vib : public SynthVoice {
     { // inharmonic partials
       float A[] = {1, 0.7, 0.45, 0.3, 0.15, 0.08, 0 , 0};
       float C[] = {10, 27, 54, 81, 108, 135, 0, 0};
-      gam::addSines(tb__3, A, C, 6); // tb__3
       for (int i = 0; i < 7; i++){
         addWireBox(mMesh[7], scaler * A[i]*C[i], scaler * A[i+1]*C[i+1], 1 + 0.3*i);
       }
     }
   { // harmonics 20-27
       float A[] = {0.2, 0.4, 0.6, 1, 0.7, 0.5, 0.3, 0.1};
-      gam::addSines(tb__4, A, 8, 20); // tb__4
       for (int i = 0; i < 7; i++){
         addWireBox(mMesh[8], hscaler * A[i], hscaler * A[i+1], 1 + 0.3*i);
       }
@@ -491,15 +455,14 @@ class Vib : public SynthVoice {
   //
   virtual void onProcess(AudioIOData& io) override {
     updateFromParameters();
-    float oscFreq = getInternalParameterValue("frequency");
-    float vibDepth = getInternalParameterValue("vibDepth");
+    float oscFreq = mFrequencyParam.get();
+    float vibDepth = mVibDepthParam.get();
     outFreq = oscFreq + vibValue * vibDepth * oscFreq;
     while (io()) {
       mVib.freq(mVibEnv());
       vibValue = mVib();
        mOsc.freq(outFreq);
-      float s1 =
-          0.1 * mOsc() * mAmpEnv() * getInternalParameterValue("amplitude");
+      float s1 = 0.1 * mOsc() * mAmpEnv() * mAmplitudeParam.get();
       float s2;
       mEnvFollow(s1);
       mPan(s1, s1, s2);
@@ -516,7 +479,7 @@ class Vib : public SynthVoice {
     a_rotate += 0.81;
     b_rotate += 0.78;
     timepose -= 0.06;
-    int shape = getInternalParameterValue("table");
+    int shape = mTableParam.get();
     // static Light light;
     g.polygonMode(wireframe ? GL_LINE : GL_FILL);
     // light.pos(0, 0, 0);
@@ -548,52 +511,22 @@ class Vib : public SynthVoice {
   }
 
   void updateFromParameters() {
-    mOsc.freq(getInternalParameterValue("frequency"));
-    mAmpEnv.attack(getInternalParameterValue("attackTime"));
-    mAmpEnv.decay(getInternalParameterValue("attackTime"));
-    mAmpEnv.release(getInternalParameterValue("releaseTime"));
-    mAmpEnv.sustain(getInternalParameterValue("sustain"));
-    mAmpEnv.curve(getInternalParameterValue("curve"));
-    mPan.pos(getInternalParameterValue("pan"));
-    mVibEnv.levels(getInternalParameterValue("vibRate1"),
-                   getInternalParameterValue("vibRate2"),
-                   getInternalParameterValue("vibRate2"),
-                   getInternalParameterValue("vibRate1"));
-    mVibEnv.lengths()[0] = getInternalParameterValue("vibRise");
-    mVibEnv.lengths()[1] = getInternalParameterValue("vibRise");
-    mVibEnv.lengths()[3] = getInternalParameterValue("vibRise");
+    mOsc.freq(mFrequencyParam.get());
+    mAmpEnv.attack(mAttackTimeParam.get());
+    mAmpEnv.decay(mAttackTimeParam.get());
+    mAmpEnv.release(mReleaseTimeParam.get());
+    mAmpEnv.sustain(mSustainParam.get());
+    mAmpEnv.curve(mCurveParam.get());
+    mPan.pos(mPanParam.get());
+    mVibEnv.levels(mVibRate1Param.get(), mVibRate2Param.get(),
+                   mVibRate2Param.get(), mVibRate1Param.get());
+    mVibEnv.lengths()[0] = mVibRiseParam.get();
+    mVibEnv.lengths()[1] = mVibRiseParam.get();
+    mVibEnv.lengths()[3] = mVibRiseParam.get();
   }
   void updateWaveform(){
         // Map table number to table in memory
-    switch (int(getInternalParameterValue("table"))) {
-      case 0:
-        mOsc.source(tbSaw);
-        break;
-      case 1:
-        mOsc.source(tbSqr);
-        break;
-      case 2:
-        mOsc.source(tbImp);
-        break;
-      case 3:
-        mOsc.source(tbSin);
-        break;
-      case 4:
-        mOsc.source(tbPls);
-        break;
-      case 5:
-        mOsc.source(tb__1);
-        break;
-      case 6:
-        mOsc.source(tb__2);
-        break;
-      case 7:
-        mOsc.source(tb__3);
-        break;
-      case 8:
-        mOsc.source(tb__4);
-        break;
-    }
+    mOsc.source(WavetableBank::shared().table(int(mTableParam.get())));
   }
 
 };
@@ -620,6 +553,12 @@ public:
   float mVibDepth;
   float mVibRise;
 
+  // Handles to the parameters read below, set in init()
+  VoiceParameter mFrequencyParam, mAmplitudeParam, mAttackTimeParam,
+      mReleaseTimeParam, mSustainParam, mIdx1Param, mIdx2Param, mIdx3Param,
+      mCarMulParam, mModMulParam, mVibRate1Param, mVibRate2Param, mVibRiseParam,
+      mVibDepthParam, mPanParam;
+
   void init() override
   {
     mAmpEnv.curve(0); // linear segments
@@ -634,37 +573,40 @@ public:
     ball.generateNormals();
 
     // We have the mesh be a sphere
-    createInternalTriggerParameter("frequency", 440, 10, 4000.0);
-    createInternalTriggerParameter("amplitude", 0.05, 0.0, 1.0);
-    createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
-    createInternalTriggerParameter("releaseTime", 0.5, 0.1, 10.0);
-    createInternalTriggerParameter("sustain", 0.65, 0.1, 1.0);
+    mFrequencyParam =
+        createInternalTriggerParameter("frequency", 440, 10, 4000.0);
+    mAmplitudeParam =
+        createInternalTriggerParameter("amplitude", 0.05, 0.0, 1.0);
+    mAttackTimeParam =
+        createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
+    mReleaseTimeParam =
+        createInternalTriggerParameter("releaseTime", 0.5, 0.1, 10.0);
+    mSustainParam = createInternalTriggerParameter("sustain", 0.65, 0.1, 1.0);
 
     // FM index
-    createInternalTriggerParameter("idx1", 0.01, 0.0, 10.0);
-    createInternalTriggerParameter("idx2", 7, 0.0, 10.0);
-    createInternalTriggerParameter("idx3", 5, 0.0, 10.0);
+    mIdx1Param = createInternalTriggerParameter("idx1", 0.01, 0.0, 10.0);
+    mIdx2Param = createInternalTriggerParameter("idx2", 7, 0.0, 10.0);
+    mIdx3Param = createInternalTriggerParameter("idx3", 5, 0.0, 10.0);
 
-    createInternalTriggerParameter("carMul", 1, 0.0, 20.0);
-    createInternalTriggerParameter("modMul", 1.0007, 0.0, 20.0);
+    mCarMulParam = createInternalTriggerParameter("carMul", 1, 0.0, 20.0);
+    mModMulParam = createInternalTriggerParameter("modMul", 1.0007, 0.0, 20.0);
 
-    createInternalTriggerParameter("vibRate1", 0.01, 0.0, 10.0);
-    createInternalTriggerParameter("vibRate2", 0.5, 0.0, 10.0);
-    createInternalTriggerParameter("vibRise", 0, 0.0, 10.0);
-    createInternalTriggerParameter("vibDepth", 0, 0.0, 10.0);
+    mVibRate1Param =
+        createInternalTriggerParameter("vibRate1", 0.01, 0.0, 10.0);
+    mVibRate2Param = createInternalTriggerParameter("vibRate2", 0.5, 0.0, 10.0);
+    mVibRiseParam = createInternalTriggerParameter("vibRise", 0, 0.0, 10.0);
+    mVibDepthParam = createInternalTriggerParameter("vibDepth", 0, 0.0, 10.0);
 
-    createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+    mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
   }
 
   //
   void onProcess(AudioIOData &io) override
   {
     mVib.freq(mVibEnv());
-    float carBaseFreq =
-        getInternalParameterValue("frequency") * getInternalParameterValue("carMul");
-    float modScale =
-        getInternalParameterValue("frequency") * getInternalParameterValue("modMul");
-    float amp = getInternalParameterValue("amplitude");
+    float carBaseFreq = mFrequencyParam.get() * mCarMulParam.get();
+    float modScale = mFrequencyParam.get() * mModMulParam.get();
+    float amp = mAmplitudeParam.get();
     while (io())
     {
       mVib.freq(mVibEnv());
@@ -689,12 +631,12 @@ public:
     g.pushMatrix();
     g.depthTesting(true);
     g.lighting(true);
-    g.translate(timepose, getInternalParameterValue("frequency") / 200 - 3, -15);
+    g.translate(timepose, mFrequencyParam.get() / 200 - 3, -15);
     g.rotate(mVib() + a, Vec3f(0, 1, 0));
     g.rotate(mVibDepth + b, Vec3f(1));
-    float scaling = getInternalParameterValue("amplitude") / 10;
-    g.scale(scaling + getInternalParameterValue("modMul") / 10, scaling + getInternalParameterValue("carMul") / 30, scaling + mEnvFollow.value() * 5);
-    g.color(HSV(getInternalParameterValue("modMul") / 20, getInternalParameterValue("carMul") / 20, 0.5 + getInternalParameterValue("attackTime")));
+    float scaling = mAmplitudeParam.get() / 10;
+    g.scale(scaling + mModMulParam.get() / 10, scaling + mCarMulParam.get() / 30, scaling + mEnvFollow.value() * 5);
+    g.color(HSV(mModMulParam.get() / 20, mCarMulParam.get() / 20, 0.5 + mAttackTimeParam.get()));
     g.draw(ball);
     g.popMatrix();
   }
@@ -709,8 +651,7 @@ public:
     mod.phase(0);
     updateFromParameters();
 
-    float modFreq =
-        getInternalParameterValue("frequency") * getInternalParameterValue("modMul");
+    float modFreq = mFrequencyParam.get() * mModMulParam.get();
     mod.freq(modFreq);
   }
   void onTriggerOff() override
@@ -722,28 +663,26 @@ public:
 
   void updateFromParameters()
   {
-    mModEnv.levels()[0] = getInternalParameterValue("idx1");
-    mModEnv.levels()[1] = getInternalParameterValue("idx2");
-    mModEnv.levels()[2] = getInternalParameterValue("idx2");
-    mModEnv.levels()[3] = getInternalParameterValue("idx3");
-
-    mAmpEnv.attack(getInternalParameterValue("attackTime"));
-    mAmpEnv.release(getInternalParameterValue("releaseTime"));
-    mAmpEnv.sustain(getInternalParameterValue("sustain"));
-
-    mModEnv.lengths()[0] = getInternalParameterValue("attackTime");
-    mModEnv.lengths()[3] = getInternalParameterValue("releaseTime");
-
-    mVibEnv.levels(getInternalParameterValue("vibRate1"),
-                   getInternalParameterValue("vibRate2"),
-                   getInternalParameterValue("vibRate2"),
-                   getInternalParameterValue("vibRate1"));
-    mVibEnv.lengths()[0] = getInternalParameterValue("vibRise");
-    mVibEnv.lengths()[1] = getInternalParameterValue("vibRise");
-    mVibEnv.lengths()[3] = getInternalParameterValue("vibRise");
-    mVibDepth = getInternalParameterValue("vibDepth");
+    mModEnv.levels()[0] = mIdx1Param.get();
+    mModEnv.levels()[1] = mIdx2Param.get();
+    mModEnv.levels()[2] = mIdx2Param.get();
+    mModEnv.levels()[3] = mIdx3Param.get();
+
+    mAmpEnv.attack(mAttackTimeParam.get());
+    mAmpEnv.release(mReleaseTimeParam.get());
+    mAmpEnv.sustain(mSustainParam.get());
+
+    mModEnv.lengths()[0] = mAttackTimeParam.get();
+    mModEnv.lengths()[3] = mReleaseTimeParam.get();
+
+    mVibEnv.levels(mVibRate1Param.get(), mVibRate2Param.get(),
+                   mVibRate2Param.get(), mVibRate1Param.get());
+    mVibEnv.lengths()[0] = mVibRiseParam.get();
+    mVibEnv.lengths()[1] = mVibRiseParam.get();
+    mVibEnv.lengths()[3] = mVibRiseParam.get();
+    mVibDepth = mVibDepthParam.get();
     
-    mPan.pos(getInternalParameterValue("pan"));
+    mPan.pos(mPanParam.get());
   }
 };
 
@@ -773,6 +712,12 @@ public:
   bool wireframe = false;
   bool vertexLight = false;
 
+  // Handles to the parameters read below, set in init()
+  VoiceParameter mFrequencyParam, mAmplitudeParam, mAttackTimeParam,
+      mReleaseTimeParam, mSustainParam, mIdx1Param, mIdx2Param, mIdx3Param,
+      mCarMulParam, mModMulParam, mVibRate1Param, mVibRate2Param, mVibRiseParam,
+      mVibDepthParam, mPanParam, mTableParam;
+
   void init() override
   {
     //      mAmpEnv.curve(0); // linear segments
@@ -782,59 +727,52 @@ public:
     mAmpEnv.sustainPoint(2);
 
     // We have the mesh be a sphere
-    createInternalTriggerParameter("frequency", 440, 10, 4000.0);
-    createInternalTriggerParameter("amplitude", 0.1, 0.0, 1.0);
-    createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
-    createInternalTriggerParameter("releaseTime", 0.3, 0.1, 10.0);
-    createInternalTriggerParameter("sustain", 0.65, 0.1, 1.0);
+    mFrequencyParam =
+        createInternalTriggerParameter("frequency", 440, 10, 4000.0);
+    mAmplitudeParam =
+        createInternalTriggerParameter("amplitude", 0.1, 0.0, 1.0);
+    mAttackTimeParam =
+        createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
+    mReleaseTimeParam =
+        createInternalTriggerParameter("releaseTime", 0.3, 0.1, 10.0);
+    mSustainParam = createInternalTriggerParameter("sustain", 0.65, 0.1, 1.0);
 
     // FM index
-    createInternalTriggerParameter("idx1", 0.01, 0.0, 10.0);
-    createInternalTriggerParameter("idx2", 7, 0.0, 10.0);
-    createInternalTriggerParameter("idx3", 5, 0.0, 10.0);
+    mIdx1Param = createInternalTriggerParameter("idx1", 0.01, 0.0, 10.0);
+    mIdx2Param = createInternalTriggerParameter("idx2", 7, 0.0, 10.0);
+    mIdx3Param = createInternalTriggerParameter("idx3", 5, 0.0, 10.0);
 
-    createInternalTriggerParameter("carMul", 1, 0.0, 20.0);
-    createInternalTriggerParameter("modMul", 1.0007, 0.0, 20.0);
+    mCarMulParam = createInternalTriggerParameter("carMul", 1, 0.0, 20.0);
+    mModMulParam = createInternalTriggerParameter("modMul", 1.0007, 0.0, 20.0);
 
-    createInternalTriggerParameter("vibRate1", 0.01, 0.0, 10.0);
-    createInternalTriggerParameter("vibRate2", 0.5, 0.0, 10.0);
-    createInternalTriggerParameter("vibRise", 0, 0.0, 10.0);
-    createInternalTriggerParameter("vibDepth", 0, 0.0, 10.0);
+    mVibRate1Param =
+        createInternalTriggerParameter("vibRate1", 0.01, 0.0, 10.0);
+    mVibRate2Param = createInternalTriggerParameter("vibRate2", 0.5, 0.0, 10.0);
+    mVibRiseParam = createInternalTriggerParameter("vibRise", 0, 0.0, 10.0);
+    mVibDepthParam = createInternalTriggerParameter("vibDepth", 0, 0.0, 10.0);
 
-    createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
-    createInternalTriggerParameter("table", 0, 0, 8);
+    mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+    mTableParam = createInternalTriggerParameter("table", 0, 0, 8);
 
-    // Table & Visual meshes
+    // Visual meshes
     // Now We have the mesh according to the waveform
-    gam::addSinesPow<1>(tbSaw, 9, 1);
     addCone(mMesh[0],1, Vec3f(0,0,5), 40, 1); //tbSaw
 
-    gam::addSinesPow<1>(tbSqr, 9, 2);
     addCube(mMesh[1]);  // tbSquare
 
-    gam::addSinesPow<0>(tbImp, 9, 1);
     addPrism(mMesh[2],1,1,1,100); // tbImp
 
-    gam::addSine(tbSin);
     addSphere(mMesh[3], 0.3, 16, 100); // tbSin
 
-// About: addSines (dst, amps, cycs, numh)
-// \param[out] dst		destination array
-// \param[in] amps		harmonic amplitudes of series, size must be numh - A[]
-// \param[in] cycs		harmonic numbers of series, size must be numh - C[]
-// \param[in] numh		total number of harmonics
     float scaler = 0.15;
     float hscaler = 1;
 
     { //tbPls
-      float A[] = {1, 1, 1, 1, 0.7, 0.5, 0.3, 0.1};
-      gam::addSines(tbPls, A, 8); 
       addWireBox(mMesh[4],2);    // tbPls
     }
     { // tb__1 
       float A[] = {1, 0.4, 0.65, 0.3, 0.18, 0.08, 0, 0};
       float C[] = {1, 4, 7, 11, 15, 18, 0, 0 };
-      gam::addSines(tb__1, A, C, 6);
       for (int i = 0; i < 7; i++){
         addWireBox(mMesh[5], scaler * A[i]*C[i], scaler * A[i+1]*C[i+1], 1 + 0.3*i);
 
@@ -844,7 +782,6 @@ public:
     { // inharmonic partials
       float A[] = {0.5, 0.8, 0.7, 1, 0.3, 0.4, 0.2, 0.12};
       float C[] = {3, 4, 7, 8, 11, 12, 15, 16}; 
-      gam::addSines(tb__2, A, C, 8); // tb__2
       for (int i = 0; i < 7; i++){
         addWireBox(mMesh[6], scaler * A[i]*C[i], scaler * A[i+1]*C[i+1], 1 + 0.3*i);
       }
@@ -852,14 +789,12 @@ public:
     { // inharmonic partials
       float A[] = {1, 0.7, 0.45, 0.3, 0.15, 0.08, 0 , 0};
       float C[] = {10, 27, 54, 81, 108, 135, 0, 0};
-      gam::addSines(tb__3, A, C, 6); // tb__3
       for (int i = 0; i < 7; i++){
         addWireBox(mMesh[7], scaler * A[i]*C[i], scaler * A[i+1]*C[i+1], 1 + 0.3*i);
       }
     }
   { // harmonics 20-27
       float A[] = {0.2, 0.4, 0.6, 1, 0.7, 0.5, 0.3, 0.1};
-      gam::addSines(tb__4, A, 8, 20); // tb__4
       for (int i = 0; i < 7; i++){
         addWireBox(mMesh[8], hscaler * A[i], hscaler * A[i+1], 1 + 0.3*i);
       }
@@ -887,10 +822,9 @@ public:
   void onProcess(AudioIOData &io) override
   {
     mVib.freq(mVibEnv());
-    float carBaseFreq =
-        getInternalParameterValue("frequency") * getInternalParameterValue("carMul");
-    float modScale = getInternalParameterValue("frequency") * getInternalParameterValue("modMul");
-    float amp = getInternalParameterValue("amplitude") * 0.01;
+    float carBaseFreq = mFrequencyParam.get() * mCarMulParam.get();
+    float modScale = mFrequencyParam.get() * mModMulParam.get();
+    float amp = mAmplitudeParam.get() * 0.01;
     while (io())
     {
       mVib.freq(mVibEnv());
@@ -912,19 +846,19 @@ public:
     a += 0.29;
     b += 0.23;
     timepose -= 0.06;
-    int shape = getInternalParameterValue("table");
+    int shape = mTableParam.get();
     g.polygonMode(wireframe ? GL_LINE : GL_FILL);
     // light.pos(0, 0, 0);
     gl::depthTesting(true);
     g.pushMatrix();
     g.depthTesting(true);
     g.lighting(true);
-    g.translate(timepose, getInternalParameterValue("frequency") / 200 - 3, -15);
+    g.translate(timepose, mFrequencyParam.get() / 200 - 3, -15);
     g.rotate(mVib() + a, Vec3f(0, 1, 0));
     g.rotate(mVib() * mVibDepth + b, Vec3f(1));
-    float scaling = getInternalParameterValue("amplitude") * 10;
-    g.scale(scaling + getInternalParameterValue("modMul") / 2, scaling + getInternalParameterValue("carMul") / 20, scaling + mEnvFollow.value() * 5);
-    g.color(HSV(getInternalParameterValue("modMul") / 20, getInternalParameterValue("carMul") / 20, 0.5 + getInternalParameterValue("attackTime")));
+    float scaling = mAmplitudeParam.get() * 10;
+    g.scale(scaling + mModMulParam.get() / 2, scaling + mCarMulParam.get() / 20, scaling + mEnvFollow.value() * 5);
+    g.color(HSV(mModMulParam.get() / 20, mCarMulParam.get() / 20, 0.5 + mAttackTimeParam.get()));
     g.draw(mMesh[shape]);
     g.popMatrix();
   }
@@ -940,8 +874,7 @@ public:
     updateFromParameters();
     updateWaveform();
 
-    float modFreq =
-        getInternalParameterValue("frequency") * getInternalParameterValue("modMul");
+    float modFreq = mFrequencyParam.get() * mModMulParam.get();
     mod.freq(modFreq);
   }
   void onTriggerOff() override
@@ -953,60 +886,30 @@ public:
 
   void updateFromParameters()
   {
-    mModEnv.levels()[0] = getInternalParameterValue("idx1");
-    mModEnv.levels()[1] = getInternalParameterValue("idx2");
-    mModEnv.levels()[2] = getInternalParameterValue("idx2");
-    mModEnv.levels()[3] = getInternalParameterValue("idx3");
-
-    mAmpEnv.attack(getInternalParameterValue("attackTime"));
-    mAmpEnv.release(getInternalParameterValue("releaseTime"));
-    mAmpEnv.sustain(getInternalParameterValue("sustain"));
-
-    mModEnv.lengths()[0] = getInternalParameterValue("attackTime");
-    mModEnv.lengths()[3] = getInternalParameterValue("releaseTime");
-
-    mVibEnv.levels(getInternalParameterValue("vibRate1"),
-                   getInternalParameterValue("vibRate2"),
-                   getInternalParameterValue("vibRate2"),
-                   getInternalParameterValue("vibRate1"));
-    mVibEnv.lengths()[0] = getInternalParameterValue("vibRise");
-    mVibEnv.lengths()[1] = getInternalParameterValue("vibRise");
-    mVibEnv.lengths()[3] = getInternalParameterValue("vibRise");
-    mVibDepth = getInternalParameterValue("vibDepth");
+    mModEnv.levels()[0] = mIdx1Param.get();
+    mModEnv.levels()[1] = mIdx2Param.get();
+    mModEnv.levels()[2] = mIdx2Param.get();
+    mModEnv.levels()[3] = mIdx3Param.get();
+
+    mAmpEnv.attack(mAttackTimeParam.get());
+    mAmpEnv.release(mReleaseTimeParam.get());
+    mAmpEnv.sustain(mSustainParam.get());
+
+    mModEnv.lengths()[0] = mAttackTimeParam.get();
+    mModEnv.lengths()[3] = mReleaseTimeParam.get();
+
+    mVibEnv.levels(mVibRate1Param.get(), mVibRate2Param.get(),
+                   mVibRate2Param.get(), mVibRate1Param.get());
+    mVibEnv.lengths()[0] = mVibRiseParam.get();
+    mVibEnv.lengths()[1] = mVibRiseParam.get();
+    mVibEnv.lengths()[3] = mVibRiseParam.get();
+    mVibDepth = mVibDepthParam.get();
     
-    mPan.pos(getInternalParameterValue("pan"));
+    mPan.pos(mPanParam.get());
   }
   void updateWaveform(){
         // Map table number to table in memory
-    switch (int(getInternalParameterValue("table"))) {
-      case 0:
-        car.source(tbSaw);
-        break;
-      case 1:
-        car.source(tbSqr);
-        break;
-      case 2:
-        car.source(tbImp);
-        break;
-      case 3:
-        car.source(tbSin);
-        break;
-      case 4:
-        car.source(tbPls);
-        break;
-      case 5:
-        car.source(tb__1);
-        break;
-      case 6:
-        car.source(tb__2);
-        break;
-      case 7:
-        car.source(tb__3);
-        break;
-      case 8:
-        car.source(tb__4);
-        break;
-    }
+    car.source(WavetableBank::shared().table(int(mTableParam.get())));
   }
 
 
@@ -1033,6 +936,11 @@ public:
     double a_rotate = 0;
     double b_rotate = 0;
     double timepose = 0;
+    // Handles to the parameters read below, set in init()
+    VoiceParameter mAmplitudeParam, mFrequencyParam, mAttackTimeParam,
+        mReleaseTimeParam, mSustainParam, mCurveParam, mPanParam, mTableParam,
+        mTrm1Param, mTrm2Param, mTrmRiseParam, mTrmDepthParam;
+
     // Initialize voice. This function will nly be called once per voice
     virtual void init()
     {
@@ -1041,50 +949,44 @@ public:
         mAmpEnv.levels(0, 0.3, 0.3, 0); // These tables are not normalized, so scale to 0.3
         mTrmEnv.curve(0);
         mTrmEnv.levels(0, 1, 1, 0);
-        createInternalTriggerParameter("amplitude", 0.03, 0.0, 1.0);
-        createInternalTriggerParameter("frequency", 60, 20, 5000);
-        createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
-        createInternalTriggerParameter("releaseTime", 2.0, 0.1, 10.0);
-        createInternalTriggerParameter("sustain", 0.6, 0.0, 1.0);
-        createInternalTriggerParameter("curve", 4.0, -10.0, 10.0);
-        createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
-        createInternalTriggerParameter("table", 0, 0, 8);
-        createInternalTriggerParameter("trm1", 3.5, 0.2, 20);
-        createInternalTriggerParameter("trm2", 5.8, 0.2, 20);
-        createInternalTriggerParameter("trmRise", 0.5, 0.1, 2);
-        createInternalTriggerParameter("trmDepth", 0.1, 0.0, 1.0);
-
-        // Table & Visual meshes
+        mAmplitudeParam =
+            createInternalTriggerParameter("amplitude", 0.03, 0.0, 1.0);
+        mFrequencyParam =
+            createInternalTriggerParameter("frequency", 60, 20, 5000);
+        mAttackTimeParam =
+            createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
+        mReleaseTimeParam =
+            createInternalTriggerParameter("releaseTime", 2.0, 0.1, 10.0);
+        mSustainParam =
+            createInternalTriggerParameter("sustain", 0.6, 0.0, 1.0);
+        mCurveParam = createInternalTriggerParameter("curve", 4.0, -10.0, 10.0);
+        mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+        mTableParam = createInternalTriggerParameter("table", 0, 0, 8);
+        mTrm1Param = createInternalTriggerParameter("trm1", 3.5, 0.2, 20);
+        mTrm2Param = createInternalTriggerParameter("trm2", 5.8, 0.2, 20);
+        mTrmRiseParam = createInternalTriggerParameter("trmRise", 0.5, 0.1, 2);
+        mTrmDepthParam =
+            createInternalTriggerParameter("trmDepth", 0.1, 0.0, 1.0);
+
+        // Visual meshes
         // Now We have the mesh according to the waveform
-        gam::addSinesPow<1>(tbSaw, 9, 1);
         addCone(mMesh[0], 1, Vec3f(0, 0, 5), 40, 1); // tbSaw
 
-        gam::addSinesPow<1>(tbSqr, 9, 2);
         addCube(mMesh[1]); // tbSquare
 
-        gam::addSinesPow<0>(tbImp, 9, 1);
         addPrism(mMesh[2], 1, 1, 1, 100); // tbImp
 
-        gam::addSine(tbSin);
         addSphere(mMesh[3], 0.3, 16, 100); // tbSin
 
-        // About: addSines (dst, amps, cycs, numh)
-        // \param[out] dst		destination array
-        // \param[in] amps		harmonic amplitudes of series, size must be numh - A[]
-        // \param[in] cycs		harmonic numbers of series, size must be numh - C[]
-        // \param[in] numh		total number of harmonics
         float scaler = 0.15;
         float hscaler = 1;
 
         { // tbPls
-            float A[] = {1, 1, 1, 1, 0.7, 0.5, 0.3, 0.1};
-            gam::addSines(tbPls, A, 8);
             addWireBox(mMesh[4], 2); // tbPls
         }
         { // tb__1
             float A[] = {1, 0.4, 0.65, 0.3, 0.18, 0.08, 0, 0};
             float C[] = {1, 4, 7, 11, 15, 18, 0, 0};
-            gam::addSines(tb__1, A, C, 6);
             for (int i = 0; i < 7; i++)
             {
                 addWireBox(mMesh[5], scaler * A[i] * C[i], scaler * A[i + 1] * C[i + 1], 1 + 0.3 * i);
@@ -1095,7 +997,6 @@ public:
         { // inharmonic partials
             float A[] = {0.5, 0.8, 0.7, 1, 0.3, 0.4, 0.2, 0.12};
             float C[] = {3, 4, 7, 8, 11, 12, 15, 16};
-            gam::addSines(tb__2, A, C, 8); // tb__2
             for (int i = 0; i < 7; i++)
             {
                 addWireBox(mMesh[6], scaler * A[i] * C[i], scaler * A[i + 1] * C[i + 1], 1 + 0.3 * i);
@@ -1104,7 +1005,6 @@ public:
         { // inharmonic partials
             float A[] = {1, 0.7, 0.45, 0.3, 0.15, 0.08, 0, 0};
             float C[] = {10, 27, 54, 81, 108, 135, 0, 0};
-            gam::addSines(tb__3, A, C, 6); // tb__3
             for (int i = 0; i < 7; i++)
             {
                 addWireBox(mMesh[7], scaler * A[i] * C[i], scaler * A[i + 1] * C[i + 1], 1 + 0.3 * i);
@@ -1112,7 +1012,6 @@ public:
         }
         { // harmonics 20-27
             float A[] = {0.2, 0.4, 0.6, 1, 0.7, 0.5, 0.3, 0.1};
-            gam::addSines(tb__4, A, 8, 20); // tb__4
             for (int i = 0; i < 7; i++)
             {
                 addWireBox(mMesh[8], hscaler * A[i], hscaler * A[i + 1], 1 + 0.3 * i);
@@ -1142,9 +1041,9 @@ public:
     virtual void onProcess(AudioIOData &io) override
     {
         // updateFromParameters();
-        float oscFreq = getInternalParameterValue("frequency");
-        float amp = getInternalParameterValue("amplitude");
-        float trmDepth = getInternalParameterValue("trmDepth");
+        float oscFreq = mFrequencyParam.get();
+        float amp = mAmplitudeParam.get();
+        float trmDepth = mTrmDepthParam.get();
         while (io())
         {
 
@@ -1170,8 +1069,8 @@ public:
         a_rotate += 0.81;
         b_rotate += 0.78;
         timepose -= 0.06;
-        float frequency = getInternalParameterValue("frequency");
-        int shape = getInternalParameterValue("table");
+        float frequency = mFrequencyParam.get();
+        int shape = mTableParam.get();
 
         // static Light light;
         g.polygonMode(wireframe ? GL_LINE : GL_FILL);
@@ -1181,7 +1080,7 @@ public:
         // g.light(light);
         g.pushMatrix();
         g.depthTesting(true);
-        g.translate(timepose, getInternalParameterValue("frequency") / 200 - 3, -15);
+        g.translate(timepose, mFrequencyParam.get() / 200 - 3, -15);
         g.rotate(a_rotate, Vec3f(0, 1, 1));
         g.rotate(b_rotate, Vec3f(1));
         g.scale(0.2 + mAmpEnv() * 0.2 + 0.01 * mTrm(), 0.3 + mAmpEnv() * 0.5 + 0.01 * mTrm(), 0.1 + 0.01 * mTrm());
@@ -1210,56 +1109,25 @@ public:
 
     void updateFromParameters()
     {
-        mOsc.freq(getInternalParameterValue("frequency"));
-        mAmpEnv.attack(getInternalParameterValue("attackTime"));
-        mAmpEnv.decay(getInternalParameterValue("attackTime"));
-        mAmpEnv.release(getInternalParameterValue("releaseTime"));
-        mAmpEnv.sustain(getInternalParameterValue("sustain"));
-        mAmpEnv.curve(getInternalParameterValue("curve"));
-        mPan.pos(getInternalParameterValue("pan"));
-
-        mTrmEnv.levels(getInternalParameterValue("trm1"),
-                       getInternalParameterValue("trm2"),
-                       getInternalParameterValue("trm2"),
-                       getInternalParameterValue("trm1"));
-
-        mTrmEnv.attack(getInternalParameterValue("trmRise"));
-        mTrmEnv.decay(getInternalParameterValue("trmRise"));
-        mTrmEnv.release(getInternalParameterValue("trmRise"));
+        mOsc.freq(mFrequencyParam.get());
+        mAmpEnv.attack(mAttackTimeParam.get());
+        mAmpEnv.decay(mAttackTimeParam.get());
+        mAmpEnv.release(mReleaseTimeParam.get());
+        mAmpEnv.sustain(mSustainParam.get());
+        mAmpEnv.curve(mCurveParam.get());
+        mPan.pos(mPanParam.get());
+
+        mTrmEnv.levels(mTrm1Param.get(), mTrm2Param.get(), mTrm2Param.get(),
+                       mTrm1Param.get());
+
+        mTrmEnv.attack(mTrmRiseParam.get());
+        mTrmEnv.decay(mTrmRiseParam.get());
+        mTrmEnv.release(mTrmRiseParam.get());
     }
     void updateWaveform()
     {
         // Map table number to table in memory
-        switch (int(getInternalParameterValue("table")))
-        {
-        case 0:
-            mOsc.source(tbSaw);
-            break;
-        case 1:
-            mOsc.source(tbSqr);
-            break;
-        case 2:
-            mOsc.source(tbImp);
-            break;
-        case 3:
-            mOsc.source(tbSin);
-            break;
-        case 4:
-            mOsc.source(tbPls);
-            break;
-        case 5:
-            mOsc.source(tb__1);
-            break;
-        case 6:
-            mOsc.source(tb__2);
-            break;
-        case 7:
-            mOsc.source(tb__3);
-            break;
-        case 8:
-            mOsc.source(tb__4);
-            break;
-        }
+        mOsc.source(WavetableBank::shared().table(int(mTableParam.get())));
     }
 };
 
@@ -1282,6 +1150,11 @@ public:
   double b_rotate = 0;
   double timepose = 0;
   Vec3f spinner;
+  // Handles to the parameters read below, set in init()
+  VoiceParameter mAmplitudeParam, mFrequencyParam, mAttackTimeParam,
+      mReleaseTimeParam, mSustainParam, mPanParam, mAmFuncParam, mAm1Param,
+      mAm2Param, mAmRiseParam, mAmRatioParam;
+
   // Initialize voice. This function will nly be called once per voice
   virtual void init()
   {
@@ -1297,25 +1170,29 @@ public:
 
     // We have the mesh be a sphere
 
-    createInternalTriggerParameter("amplitude", 0.1, 0.0, 1.0);
-    createInternalTriggerParameter("frequency", 440, 10, 4000.0);
-    createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
-    createInternalTriggerParameter("releaseTime", 4, 0.1, 10.0);
-    createInternalTriggerParameter("sustain", 0.3, 0.1, 1.0);
-    createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
-    createInternalTriggerParameter("amFunc", 0.0, 0.0, 3.0);
-    createInternalTriggerParameter("am1", 0.75, 0.0, 1.0);
-    createInternalTriggerParameter("am2", 0.75, 0.0, 1.0);
-    createInternalTriggerParameter("amRise", 0.75, 0.1, 1.0);
-    createInternalTriggerParameter("amRatio", 0.75, 0.0, 2.0);
+    mAmplitudeParam =
+        createInternalTriggerParameter("amplitude", 0.1, 0.0, 1.0);
+    mFrequencyParam =
+        createInternalTriggerParameter("frequency", 440, 10, 4000.0);
+    mAttackTimeParam =
+        createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
+    mReleaseTimeParam =
+        createInternalTriggerParameter("releaseTime", 4, 0.1, 10.0);
+    mSustainParam = createInternalTriggerParameter("sustain", 0.3, 0.1, 1.0);
+    mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+    mAmFuncParam = createInternalTriggerParameter("amFunc", 0.0, 0.0, 3.0);
+    mAm1Param = createInternalTriggerParameter("am1", 0.75, 0.0, 1.0);
+    mAm2Param = createInternalTriggerParameter("am2", 0.75, 0.0, 1.0);
+    mAmRiseParam = createInternalTriggerParameter("amRise", 0.75, 0.1, 1.0);
+    mAmRatioParam = createInternalTriggerParameter("amRatio", 0.75, 0.0, 2.0);
   }
 
   virtual void onProcess(AudioIOData &io) override
   {
-    mOsc.freq(getInternalParameterValue("frequency"));
+    mOsc.freq(mFrequencyParam.get());
 
-    float amp = getInternalParameterValue("amplitude");
-    float amRatio = getInternalParameterValue("amRatio");
+    float amp = mAmplitudeParam.get();
+    float amRatio = mAmRatioParam.get();
     while (io())
     {
 
@@ -1342,9 +1219,9 @@ public:
 
   virtual void onProcess(Graphics &g)
   {
-    float frequency = getInternalParameterValue("frequency");
-    float amplitude = getInternalParameterValue("amplitude");
-    float pan = getInternalParameterValue("pan");
+    float frequency = mFrequencyParam.get();
+    float amplitude = mAmplitudeParam.get();
+    float pan = mPanParam.get();
     int shape = getInternalParameterValue("table");
     float radius = frequency / 300;
     b_rotate += 1.1;
@@ -1362,49 +1239,48 @@ public:
     g.rotate(b_rotate, spinner);
     g.scale(0.05 * mAM() + 0.3);
     // center the model
-    g.color(HSV(mOsc.freq() * getInternalParameterValue("amRatio") / 1000 + mAM() * 0.01, 0.5 + mAmpEnv() * 0.5, 0.05 + 5 * mAmpEnv()));
+    g.color(HSV(mOsc.freq() * mAmRatioParam.get() / 1000 + mAM() * 0.01, 0.5 + mAmpEnv() * 0.5, 0.05 + 5 * mAmpEnv()));
     g.draw(mMesh);
     g.popMatrix();
   }
 
   virtual void onTriggerOn() override
   {
-    mAmpEnv.attack(getInternalParameterValue("attackTime"));
+    mAmpEnv.attack(mAttackTimeParam.get());
     mAmpEnv.lengths()[1] = 0.001;
-    mAmpEnv.release(getInternalParameterValue("releaseTime"));
+    mAmpEnv.release(mReleaseTimeParam.get());
 
-    mAmpEnv.levels()[1] = getInternalParameterValue("sustain");
-    mAmpEnv.levels()[2] = getInternalParameterValue("sustain");
+    mAmpEnv.levels()[1] = mSustainParam.get();
+    mAmpEnv.levels()[2] = mSustainParam.get();
 
-    mAMEnv.levels(getInternalParameterValue("am1"),
-                  getInternalParameterValue("am2"),
-                  getInternalParameterValue("am2"),
-                  getInternalParameterValue("am1"));
+    mAMEnv.levels(mAm1Param.get(), mAm2Param.get(), mAm2Param.get(),
+                  mAm1Param.get());
 
-    mAMEnv.lengths(getInternalParameterValue("amRise"),
-                   1 - getInternalParameterValue("amRise"));
+    mAMEnv.lengths(mAmRiseParam.get(), 1 - mAmRiseParam.get());
 
-    mPan.pos(getInternalParameterValue("pan"));
+    mPan.pos(mPanParam.get());
 
     mAmpEnv.reset();
     mAMEnv.reset();
     timepose = 0; // Initiate timeline
     b_rotate = al::rnd::uniform(0, 360);
     spinner = randomVec3f(1);
-    // Map table number to table in memory
-    switch (int(getInternalParameterValue("amFunc")))
+    // Map table number to table in memory. The last is the inharmonic table
+    // 06_AM_visual calls tbDin.
+    WavetableBank &bank = WavetableBank::shared();
+    switch (int(mAmFuncParam.get()))
     {
     case 0:
-      mAM.source(tbSin);
+      mAM.source(bank.table(WavetableBank::SINE));
       break;
     case 1:
-      mAM.source(tbSqr);
+      mAM.source(bank.table(WavetableBank::SQUARE));
       break;
     case 2:
-      mAM.source(tbPls);
+      mAM.source(bank.table(WavetableBank::PULSE));
       break;
     case 3:
-      mAM.source(tbDin);
+      mAM.source(bank.table(WavetableBank::PARTIALS_3));
       break;
     }
   }
@@ -1443,6 +1319,14 @@ public:
   double timepose = 0;
   Vec3f note_position;
   Vec3f note_direction;
+  // Handles to the parameters read below, set in init()
+  VoiceParameter mAmpParam, mFrequencyParam, mAmpStriParam, mAttackStriParam,
+      mReleaseStriParam, mSustainStriParam, mAmpLowParam, mAttackLowParam,
+      mReleaseLowParam, mSustainLowParam, mAmpUpParam, mAttackUpParam,
+      mReleaseUpParam, mSustainUpParam, mFreqStri1Param, mFreqStri2Param,
+      mFreqStri3Param, mFreqLow1Param, mFreqLow2Param, mFreqUp1Param,
+      mFreqUp2Param, mFreqUp3Param, mFreqUp4Param, mPanParam;
+
   virtual void init()
   {
 
@@ -1465,51 +1349,61 @@ public:
     ball.decompress();
     ball.generateNormals();
 
-    createInternalTriggerParameter("amp", 0.01, 0.0, 0.3);
-    createInternalTriggerParameter("frequency", 60, 20, 5000);
-    createInternalTriggerParameter("ampStri", 0.5, 0.0, 1.0);
-    createInternalTriggerParameter("attackStri", 0.1, 0.01, 3.0);
-    createInternalTriggerParameter("releaseStri", 0.1, 0.1, 10.0);
-    createInternalTriggerParameter("sustainStri", 0.8, 0.0, 1.0);
-    createInternalTriggerParameter("ampLow", 0.5, 0.0, 1.0);
-    createInternalTriggerParameter("attackLow", 0.001, 0.01, 3.0);
-    createInternalTriggerParameter("releaseLow", 0.1, 0.1, 10.0);
-    createInternalTriggerParameter("sustainLow", 0.8, 0.0, 1.0);
-    createInternalTriggerParameter("ampUp", 0.6, 0.0, 1.0);
-    createInternalTriggerParameter("attackUp", 0.01, 0.01, 3.0);
-    createInternalTriggerParameter("releaseUp", 0.075, 0.1, 10.0);
-    createInternalTriggerParameter("sustainUp", 0.9, 0.0, 1.0);
-    createInternalTriggerParameter("freqStri1", 1.0, 0.1, 10);
-    createInternalTriggerParameter("freqStri2", 2.001, 0.1, 10);
-    createInternalTriggerParameter("freqStri3", 3.0, 0.1, 10);
-    createInternalTriggerParameter("freqLow1", 4.009, 0.1, 10);
-    createInternalTriggerParameter("freqLow2", 5.002, 0.1, 10);
-    createInternalTriggerParameter("freqUp1", 6.0, 0.1, 10);
-    createInternalTriggerParameter("freqUp2", 7.0, 0.1, 10);
-    createInternalTriggerParameter("freqUp3", 8.0, 0.1, 10);
-    createInternalTriggerParameter("freqUp4", 9.0, 0.1, 10);
-    createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+    mAmpParam = createInternalTriggerParameter("amp", 0.01, 0.0, 0.3);
+    mFrequencyParam = createInternalTriggerParameter("frequency", 60, 20, 5000);
+    mAmpStriParam = createInternalTriggerParameter("ampStri", 0.5, 0.0, 1.0);
+    mAttackStriParam =
+        createInternalTriggerParameter("attackStri", 0.1, 0.01, 3.0);
+    mReleaseStriParam =
+        createInternalTriggerParameter("releaseStri", 0.1, 0.1, 10.0);
+    mSustainStriParam =
+        createInternalTriggerParameter("sustainStri", 0.8, 0.0, 1.0);
+    mAmpLowParam = createInternalTriggerParameter("ampLow", 0.5, 0.0, 1.0);
+    mAttackLowParam =
+        createInternalTriggerParameter("attackLow", 0.001, 0.01, 3.0);
+    mReleaseLowParam =
+        createInternalTriggerParameter("releaseLow", 0.1, 0.1, 10.0);
+    mSustainLowParam =
+        createInternalTriggerParameter("sustainLow", 0.8, 0.0, 1.0);
+    mAmpUpParam = createInternalTriggerParameter("ampUp", 0.6, 0.0, 1.0);
+    mAttackUpParam =
+        createInternalTriggerParameter("attackUp", 0.01, 0.01, 3.0);
+    mReleaseUpParam =
+        createInternalTriggerParameter("releaseUp", 0.075, 0.1, 10.0);
+    mSustainUpParam =
+        createInternalTriggerParameter("sustainUp", 0.9, 0.0, 1.0);
+    mFreqStri1Param = createInternalTriggerParameter("freqStri1", 1.0, 0.1, 10);
+    mFreqStri2Param =
+        createInternalTriggerParameter("freqStri2", 2.001, 0.1, 10);
+    mFreqStri3Param = createInternalTriggerParameter("freqStri3", 3.0, 0.1, 10);
+    mFreqLow1Param = createInternalTriggerParameter("freqLow1", 4.009, 0.1, 10);
+    mFreqLow2Param = createInternalTriggerParameter("freqLow2", 5.002, 0.1, 10);
+    mFreqUp1Param = createInternalTriggerParameter("freqUp1", 6.0, 0.1, 10);
+    mFreqUp2Param = createInternalTriggerParameter("freqUp2", 7.0, 0.1, 10);
+    mFreqUp3Param = createInternalTriggerParameter("freqUp3", 8.0, 0.1, 10);
+    mFreqUp4Param = createInternalTriggerParameter("freqUp4", 9.0, 0.1, 10);
+    mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
   }
 
   virtual void onProcess(AudioIOData &io) override
   {
     // Parameters will update values once per audio callback
-    float freq = getInternalParameterValue("frequency");
+    float freq = mFrequencyParam.get();
     mOsc.freq(freq);
-    mOsc1.freq(getInternalParameterValue("freqStri1") * freq);
-    mOsc2.freq(getInternalParameterValue("freqStri2") * freq);
-    mOsc3.freq(getInternalParameterValue("freqStri3") * freq);
-    mOsc4.freq(getInternalParameterValue("freqLow1") * freq);
-    mOsc5.freq(getInternalParameterValue("freqLow2") * freq);
-    mOsc6.freq(getInternalParameterValue("freqUp1") * freq);
-    mOsc7.freq(getInternalParameterValue("freqUp2") * freq);
-    mOsc8.freq(getInternalParameterValue("freqUp3") * freq);
-    mOsc9.freq(getInternalParameterValue("freqUp4") * freq);
-    mPan.pos(getInternalParameterValue("pan"));
-    float ampStri = getInternalParameterValue("ampStri");
-    float ampUp = getInternalParameterValue("ampUp");
-    float ampLow = getInternalParameterValue("ampLow");
-    float amp = getInternalParameterValue("amp");
+    mOsc1.freq(mFreqStri1Param.get() * freq);
+    mOsc2.freq(mFreqStri2Param.get() * freq);
+    mOsc3.freq(mFreqStri3Param.get() * freq);
+    mOsc4.freq(mFreqLow1Param.get() * freq);
+    mOsc5.freq(mFreqLow2Param.get() * freq);
+    mOsc6.freq(mFreqUp1Param.get() * freq);
+    mOsc7.freq(mFreqUp2Param.get() * freq);
+    mOsc8.freq(mFreqUp3Param.get() * freq);
+    mOsc9.freq(mFreqUp4Param.get() * freq);
+    mPan.pos(mPanParam.get());
+    float ampStri = mAmpStriParam.get();
+    float ampUp = mAmpUpParam.get();
+    float ampLow = mAmpLowParam.get();
+    float amp = mAmpParam.get();
     while (io())
     {
       float s1 = (mOsc1() + mOsc2() + mOsc3()) * mEnvStri() * ampStri;
@@ -1534,7 +1428,7 @@ public:
     timepose += 0.02;
     // Get the paramter values on every video frame, to apply changes to the
     // current instance
-    float frequency = getInternalParameterValue("frequency");
+    float frequency = mFrequencyParam.get();
     float amplitude = getInternalParameterValue("amplitude");
     // Now draw
     g.pushMatrix();
@@ -1553,27 +1447,27 @@ public:
   virtual void onTriggerOn() override
   {
 
-    mEnvStri.attack(getInternalParameterValue("attackStri"));
-    mEnvStri.decay(getInternalParameterValue("attackStri"));
-    mEnvStri.sustain(getInternalParameterValue("sustainStri"));
-    mEnvStri.release(getInternalParameterValue("releaseStri"));
+    mEnvStri.attack(mAttackStriParam.get());
+    mEnvStri.decay(mAttackStriParam.get());
+    mEnvStri.sustain(mSustainStriParam.get());
+    mEnvStri.release(mReleaseStriParam.get());
 
-    mEnvLow.attack(getInternalParameterValue("attackLow"));
-    mEnvLow.decay(getInternalParameterValue("attackLow"));
-    mEnvLow.sustain(getInternalParameterValue("sustainLow"));
-    mEnvLow.release(getInternalParameterValue("releaseLow"));
+    mEnvLow.attack(mAttackLowParam.get());
+    mEnvLow.decay(mAttackLowParam.get());
+    mEnvLow.sustain(mSustainLowParam.get());
+    mEnvLow.release(mReleaseLowParam.get());
 
-    mEnvUp.attack(getInternalParameterValue("attackUp"));
-    mEnvUp.decay(getInternalParameterValue("attackUp"));
-    mEnvUp.sustain(getInternalParameterValue("sustainUp"));
-    mEnvUp.release(getInternalParameterValue("releaseUp"));
+    mEnvUp.attack(mAttackUpParam.get());
+    mEnvUp.decay(mAttackUpParam.get());
+    mEnvUp.sustain(mSustainUpParam.get());
+    mEnvUp.release(mReleaseUpParam.get());
 
-    mPan.pos(getInternalParameterValue("pan"));
+    mPan.pos(mPanParam.get());
 
     mEnvStri.reset();
     mEnvLow.reset();
     mEnvUp.reset();
-    float angle = getInternalParameterValue("frequency") / 200;
+    float angle = mFrequencyParam.get() / 200;
 
     a = al::rnd::uniform();
     b = al::rnd::uniform();
@@ -1611,6 +1505,12 @@ public:
     double timepose = 0;
     Vec3f note_position;
     Vec3f note_direction;
+    // Handles to the parameters read below, set in init()
+    VoiceParameter mAmplitudeParam, mFrequencyParam, mAttackTimeParam,
+        mReleaseTimeParam, mSustainParam, mCurveParam, mNoiseParam,
+        mEnvDurParam, mCf1Param, mCf2Param, mCfRiseParam, mBw1Param, mBw2Param,
+        mBwRiseParam, mHmnumParam, mHmampParam, mPanParam;
+
     // Initialize voice. This function will nly be called once per voice
     void init() override
     {
@@ -1625,23 +1525,28 @@ public:
         mMesh.decompress();
         mMesh.generateNormals();
 
-        createInternalTriggerParameter("amplitude", 0.3, 0.0, 1.0);
-        createInternalTriggerParameter("frequency", 60, 20, 5000);
-        createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
-        createInternalTriggerParameter("releaseTime", 3.0, 0.1, 10.0);
-        createInternalTriggerParameter("sustain", 0.7, 0.0, 1.0);
-        createInternalTriggerParameter("curve", 4.0, -10.0, 10.0);
-        createInternalTriggerParameter("noise", 0.0, 0.0, 1.0);
-        createInternalTriggerParameter("envDur", 1, 0.0, 5.0);
-        createInternalTriggerParameter("cf1", 400.0, 10.0, 5000);
-        createInternalTriggerParameter("cf2", 400.0, 10.0, 5000);
-        createInternalTriggerParameter("cfRise", 0.5, 0.1, 2);
-        createInternalTriggerParameter("bw1", 700.0, 10.0, 5000);
-        createInternalTriggerParameter("bw2", 900.0, 10.0, 5000);
-        createInternalTriggerParameter("bwRise", 0.5, 0.1, 2);
-        createInternalTriggerParameter("hmnum", 12.0, 5.0, 20.0);
-        createInternalTriggerParameter("hmamp", 1.0, 0.0, 1.0);
-        createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+        mAmplitudeParam =
+            createInternalTriggerParameter("amplitude", 0.3, 0.0, 1.0);
+        mFrequencyParam =
+            createInternalTriggerParameter("frequency", 60, 20, 5000);
+        mAttackTimeParam =
+            createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
+        mReleaseTimeParam =
+            createInternalTriggerParameter("releaseTime", 3.0, 0.1, 10.0);
+        mSustainParam =
+            createInternalTriggerParameter("sustain", 0.7, 0.0, 1.0);
+        mCurveParam = createInternalTriggerParameter("curve", 4.0, -10.0, 10.0);
+        mNoiseParam = createInternalTriggerParameter("noise", 0.0, 0.0, 1.0);
+        mEnvDurParam = createInternalTriggerParameter("envDur", 1, 0.0, 5.0);
+        mCf1Param = createInternalTriggerParameter("cf1", 400.0, 10.0, 5000);
+        mCf2Param = createInternalTriggerParameter("cf2", 400.0, 10.0, 5000);
+        mCfRiseParam = createInternalTriggerParameter("cfRise", 0.5, 0.1, 2);
+        mBw1Param = createInternalTriggerParameter("bw1", 700.0, 10.0, 5000);
+        mBw2Param = createInternalTriggerParameter("bw2", 900.0, 10.0, 5000);
+        mBwRiseParam = createInternalTriggerParameter("bwRise", 0.5, 0.1, 2);
+        mHmnumParam = createInternalTriggerParameter("hmnum", 12.0, 5.0, 20.0);
+        mHmampParam = createInternalTriggerParameter("hmamp", 1.0, 0.0, 1.0);
+        mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
     }
 
     //
@@ -1649,8 +1554,8 @@ public:
     virtual void onProcess(AudioIOData &io) override
     {
         updateFromParameters();
-        float amp = getInternalParameterValue("amplitude");
-        float noiseMix = getInternalParameterValue("noise");
+        float amp = mAmplitudeParam.get();
+        float noiseMix = mNoiseParam.get();
         while (io())
         {
             // mix oscillator with noise
@@ -1680,8 +1585,8 @@ public:
         timepose += 0.02;
         // Get the paramter values on every video frame, to apply changes to the
         // current instance
-        float frequency = getInternalParameterValue("frequency");
-        float amplitude = getInternalParameterValue("amplitude");
+        float frequency = mFrequencyParam.get();
+        float amplitude = mAmplitudeParam.get();
         // Now draw
         g.pushMatrix();
         g.depthTesting(true);
@@ -1705,7 +1610,7 @@ public:
         b = al::rnd::uniform();
         timepose = 0;
         note_position = {0, 0, -15};
-        float angle = getInternalParameterValue("frequency") / 200;
+        float angle = mFrequencyParam.get() / 200;
         note_direction = {sin(angle), cos(angle), 0};
     }
 
@@ -1718,31 +1623,27 @@ public:
 
     void updateFromParameters()
     {
-        mOsc.freq(getInternalParameterValue("frequency"));
-        mOsc.harmonics(getInternalParameterValue("hmnum"));
-        mOsc.ampRatio(getInternalParameterValue("hmamp"));
-        mAmpEnv.attack(getInternalParameterValue("attackTime"));
-        //    mAmpEnv.decay(getInternalParameterValue("attackTime"));
-        mAmpEnv.release(getInternalParameterValue("releaseTime"));
-        mAmpEnv.levels()[1] = getInternalParameterValue("sustain");
-        mAmpEnv.levels()[2] = getInternalParameterValue("sustain");
-
-        mAmpEnv.curve(getInternalParameterValue("curve"));
-        mPan.pos(getInternalParameterValue("pan"));
-        mCFEnv.levels(getInternalParameterValue("cf1"),
-                      getInternalParameterValue("cf2"),
-                      getInternalParameterValue("cf1"));
-
-        mCFEnv.lengths()[0] = getInternalParameterValue("cfRise");
-        mCFEnv.lengths()[1] = 1 - getInternalParameterValue("cfRise");
-        mBWEnv.levels(getInternalParameterValue("bw1"),
-                      getInternalParameterValue("bw2"),
-                      getInternalParameterValue("bw1"));
-        mBWEnv.lengths()[0] = getInternalParameterValue("bwRise");
-        mBWEnv.lengths()[1] = 1 - getInternalParameterValue("bwRise");
-
-        mCFEnv.totalLength(getInternalParameterValue("envDur"));
-        mBWEnv.totalLength(getInternalParameterValue("envDur"));
+        mOsc.freq(mFrequencyParam.get());
+        mOsc.harmonics(mHmnumParam.get());
+        mOsc.ampRatio(mHmampParam.get());
+        mAmpEnv.attack(mAttackTimeParam.get());
+        //    mAmpEnv.decay(mAttackTimeParam.get());
+        mAmpEnv.release(mReleaseTimeParam.get());
+        mAmpEnv.levels()[1] = mSustainParam.get();
+        mAmpEnv.levels()[2] = mSustainParam.get();
+
+        mAmpEnv.curve(mCurveParam.get());
+        mPan.pos(mPanParam.get());
+        mCFEnv.levels(mCf1Param.get(), mCf2Param.get(), mCf1Param.get());
+
+        mCFEnv.lengths()[0] = mCfRiseParam.get();
+        mCFEnv.lengths()[1] = 1 - mCfRiseParam.get();
+        mBWEnv.levels(mBw1Param.get(), mBw2Param.get(), mBw1Param.get());
+        mBWEnv.lengths()[0] = mBwRiseParam.get();
+        mBWEnv.lengths()[1] = 1 - mBwRiseParam.get();
+
+        mCFEnv.totalLength(mEnvDurParam.get());
+        mBWEnv.totalLength(mEnvDurParam.get());
     }
 };
 
@@ -1771,6 +1672,10 @@ public:
     // Additional members
     Mesh mMesh;
 
+    // Handles to the parameters read below, set in init()
+    VoiceParameter mAmplitudeParam, mFrequencyParam, mAttackTimeParam,
+        mReleaseTimeParam, mSustainParam, mPan1Param, mPan2Param, mPanRiseParam;
+
     virtual void init() override
     {
         // Declare the size of the spectrum
@@ -1783,14 +1688,20 @@ public:
         delay.delay(1. / 440.0);
 
         addDisc(mMesh, 1.0, 30);
-        createInternalTriggerParameter("amplitude", 0.1, 0.0, 1.0);
-        createInternalTriggerParameter("frequency", 60, 20, 5000);
-        createInternalTriggerParameter("attackTime", 0.001, 0.001, 1.0);
-        createInternalTriggerParameter("releaseTime", 3.0, 0.1, 10.0);
-        createInternalTriggerParameter("sustain", 0.7, 0.0, 1.0);
-        createInternalTriggerParameter("Pan1", 0.0, -1.0, 1.0);
-        createInternalTriggerParameter("Pan2", 0.0, -1.0, 1.0);
-        createInternalTriggerParameter("PanRise", 0.0, 0, 3.0); // range check
+        mAmplitudeParam =
+            createInternalTriggerParameter("amplitude", 0.1, 0.0, 1.0);
+        mFrequencyParam =
+            createInternalTriggerParameter("frequency", 60, 20, 5000);
+        mAttackTimeParam =
+            createInternalTriggerParameter("attackTime", 0.001, 0.001, 1.0);
+        mReleaseTimeParam =
+            createInternalTriggerParameter("releaseTime", 3.0, 0.1, 10.0);
+        mSustainParam =
+            createInternalTriggerParameter("sustain", 0.7, 0.0, 1.0);
+        mPan1Param = createInternalTriggerParameter("Pan1", 0.0, -1.0, 1.0);
+        mPan2Param = createInternalTriggerParameter("Pan2", 0.0, -1.0, 1.0);
+        // range check
+        mPanRiseParam = createInternalTriggerParameter("PanRise", 0.0, 0, 3.0);
     }
 
     //    void reset(){ env.reset(); }
@@ -1833,8 +1744,8 @@ public:
 
     virtual void onProcess(Graphics &g) override
     {
-        float frequency = getInternalParameterValue("frequency");
-        float amplitude = getInternalParameterValue("amplitude");
+        float frequency = mFrequencyParam.get();
+        float amplitude = mAmplitudeParam.get();
         a += 0.29;
         b += 0.23;
         timepose -= 0.1;
@@ -1875,16 +1786,14 @@ public:
 
     void updateFromParameters()
     {
-        mPanEnv.levels(getInternalParameterValue("Pan1"),
-                       getInternalParameterValue("Pan2"),
-                       getInternalParameterValue("Pan1"));
-        mPanRise = getInternalParameterValue("PanRise");
-        delay.freq(getInternalParameterValue("frequency"));
-        mAmp = getInternalParameterValue("amplitude");
+        mPanEnv.levels(mPan1Param.get(), mPan2Param.get(), mPan1Param.get());
+        mPanRise = mPanRiseParam.get();
+        delay.freq(mFrequencyParam.get());
+        mAmp = mAmplitudeParam.get();
         mAmpEnv.levels()[1] = 1.0;
-        mAmpEnv.levels()[2] = getInternalParameterValue("sustain");
-        mAmpEnv.lengths()[0] = getInternalParameterValue("attackTime");
-        mAmpEnv.lengths()[3] = getInternalParameterValue("releaseTime");
+        mAmpEnv.levels()[2] = mSustainParam.get();
+        mAmpEnv.lengths()[0] = mAttackTimeParam.get();
+        mAmpEnv.lengths()[3] = mReleaseTimeParam.get();
         mPanEnv.lengths()[0] = mPanRise;
         mPanEnv.lengths()[1] = mPanRise;
     }
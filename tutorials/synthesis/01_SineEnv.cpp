@@ -1,4 +1,10 @@
-﻿#include <cstdio> // for printing to stdout
+﻿#include <algorithm>
+#include <chrono>
+#include <cstdio> // for printing to stdout
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
 
 #include "Gamma/Analysis.h"
 #include "Gamma/Effects.h"
@@ -12,6 +18,8 @@
 #include "al/ui/al_ControlGUI.hpp"
 #include "al/ui/al_Parameter.hpp"
 
+#include "playground/VoiceParameter.hpp"
+
 // using namespace gam;
 using namespace al;
 
@@ -32,6 +40,10 @@ public:
   // Additional members
   Mesh mMesh;
 
+  // Handles to the parameters read below, set in init()
+  VoiceParameter mAmplitudeParam, mFrequencyParam, mAttackTimeParam,
+      mReleaseTimeParam, mPanParam;
+
   // Initialize voice. This function will only be called once per voice when
   // it is created. Voices will be reused if they are idle.
   void init() override {
@@ -48,12 +60,18 @@ public:
     // are expected to be constant within a voice instance. (You can actually
     // change them while you are prototyping, but their changes will only be
     // stored and aplied when a note is triggered.)
+    // createInternalTriggerParameter() returns the parameter, which we keep in
+    // a handle so that onProcess() can read it without searching for its name
+    // on every sample.
 
-    createInternalTriggerParameter("amplitude", 0.3, 0.0, 1.0);
-    createInternalTriggerParameter("frequency", 60, 20, 5000);
-    createInternalTriggerParameter("attackTime", 1.0, 0.01, 3.0);
-    createInternalTriggerParameter("releaseTime", 3.0, 0.1, 10.0);
-    createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+    mAmplitudeParam =
+        createInternalTriggerParameter("amplitude", 0.3, 0.0, 1.0);
+    mFrequencyParam = createInternalTriggerParameter("frequency", 60, 20, 5000);
+    mAttackTimeParam =
+        createInternalTriggerParameter("attackTime", 1.0, 0.01, 3.0);
+    mReleaseTimeParam =
+        createInternalTriggerParameter("releaseTime", 3.0, 0.1, 10.0);
+    mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
   }
 
   // The audio processing function
@@ -64,12 +82,12 @@ public:
     // voice, rather than having to trigger a new voice to hear the changes.
     // Parameters will update values once per audio callback because they
     // are outside the sample processing loop.
-    mOsc.freq(getInternalParameterValue("frequency"));
-    mAmpEnv.lengths()[0] = getInternalParameterValue("attackTime");
-    mAmpEnv.lengths()[2] = getInternalParameterValue("releaseTime");
-    mPan.pos(getInternalParameterValue("pan"));
+    mOsc.freq(mFrequencyParam.get());
+    mAmpEnv.lengths()[0] = mAttackTimeParam.get();
+    mAmpEnv.lengths()[2] = mReleaseTimeParam.get();
+    mPan.pos(mPanParam.get());
     while (io()) {
-      float s1 = mOsc() * mAmpEnv() * getInternalParameterValue("amplitude");
+      float s1 = mOsc() * mAmpEnv() * mAmplitudeParam.get();
       float s2;
       mEnvFollow(s1);
       mPan(s1, s1, s2);
@@ -87,8 +105,8 @@ public:
   void onProcess(Graphics &g) override {
     // Get the paramter values on every video frame, to apply changes to the
     // current instance
-    float frequency = getInternalParameterValue("frequency");
-    float amplitude = getInternalParameterValue("amplitude");
+    float frequency = mFrequencyParam.get();
+    float amplitude = mAmplitudeParam.get();
     // Now draw
     g.pushMatrix();
     // Move x according to frequency, y according to amplitude
@@ -110,6 +128,65 @@ public:
   void onTriggerOff() override { mAmpEnv.release(); }
 };
 
+// SineEnv as it read its parameters before VoiceParameter, by name, for the
+// benchmark below. Each getInternalParameterValue() searches the voice's
+// parameters for the name.
+class SineEnvByName : public SineEnv {
+public:
+  using SineEnv::onProcess;
+
+  void onProcess(AudioIOData &io) override {
+    mOsc.freq(getInternalParameterValue("frequency"));
+    mAmpEnv.lengths()[0] = getInternalParameterValue("attackTime");
+    mAmpEnv.lengths()[2] = getInternalParameterValue("releaseTime");
+    mPan.pos(getInternalParameterValue("pan"));
+    while (io()) {
+      float s1 = mOsc() * mAmpEnv() * getInternalParameterValue("amplitude");
+      float s2;
+      mEnvFollow(s1);
+      mPan(s1, s1, s2);
+      io.out(0) += s1;
+      io.out(1) += s2;
+    }
+    if (mAmpEnv.done() && (mEnvFollow.value() < 0.001f))
+      free();
+  }
+};
+
+// Renders blocks of 512 frames at 48 kHz from n sustained voices for about
+// two seconds, without an audio device, and returns how many voices one core
+// could keep playing in real time
+template <class Voice> double realtimeVoices(int n) {
+  AudioIOData io;
+  io.framesPerSecond(48000);
+  io.framesPerBuffer(512);
+  io.channelsOut(2);
+
+  std::vector<std::unique_ptr<Voice>> voices;
+  for (int i = 0; i < n; ++i) {
+    voices.emplace_back(new Voice);
+    voices.back()->init();
+    voices.back()->onTriggerOn();
+  }
+
+  using Clock = std::chrono::steady_clock;
+  Clock::time_point start = Clock::now();
+  double seconds = 0;
+  long long blocks = 0;
+  while (seconds < 2) {
+    for (int i = 0; i < 16; ++i, ++blocks) {
+      io.zeroOut();
+      for (auto &voice : voices) {
+        io.frame(0);
+        voice->onProcess(io);
+      }
+    }
+    seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  }
+  double voiceBlocks = double(blocks) * n / seconds;
+  return voiceBlocks * 512 / 48000;
+}
+
 // We make an app.
 class MyApp : public App {
 public:
@@ -193,7 +270,21 @@ public:
   void onExit() override { imguiShutdown(); }
 };
 
-int main() {
+int main(int argc, char *argv[]) {
+  // "01_SineEnv -bench [voices]" compares reading the voice's parameters by
+  // name and through handles, without opening a window or audio device
+  if (argc > 1 && std::strcmp(argv[1], "-bench") == 0) {
+    int voices = argc > 2 ? std::max(std::atoi(argv[2]), 1) : 64;
+    gam::sampleRate(48000);
+    double byName = realtimeVoices<SineEnvByName>(voices);
+    double handles = realtimeVoices<SineEnv>(voices);
+    printf("%d voices, 512 frame blocks at 48 kHz\n", voices);
+    printf("Voices one core plays in real time:\n");
+    printf("  by name  %8.0f\n", byName);
+    printf("  handles  %8.0f  (%.1fx)\n", handles, handles / byName);
+    return 0;
+  }
+
   // Create app instance
   MyApp app;
 
@@ -15,6 +15,8 @@
 #include "al/graphics/al_Shapes.hpp"
 #include "al/graphics/al_Font.hpp"
 
+#include "playground/VoiceParameter.hpp"
+
 // using namespace gam;
 using namespace al;
 
@@ -112,6 +114,11 @@ class SineEnv : public SynthVoice {
 
   Mesh mMesh;
 
+  // Handles to the parameters read below, set in init()
+  VoiceParameter mAmplitudeParam, mFrequencyParam, mAttackTimeParam,
+      mReleaseTimeParam, mPanParam, mPianoKeyXParam, mPianoKeyYParam,
+      mPianoKeyWidthParam, mPianoKeyHeightParam;
+
   // Initialize voice. This function will only be called once per voice when
   // it is created. Voices will be reused if they are idle.
   void init() override {
@@ -127,16 +134,19 @@ class SineEnv : public SynthVoice {
     // change them while you are prototyping, but their changes will only be
     // stored and aplied when a note is triggered.)
 
-    createInternalTriggerParameter("amplitude", 0.3, 0.0, 1.0);
-    createInternalTriggerParameter("frequency", 60, 20, 5000);
-    createInternalTriggerParameter("attackTime", 1.0, 0.01, 3.0);
-    createInternalTriggerParameter("releaseTime", 3.0, 0.1, 10.0);
-    createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+    mAmplitudeParam =
+        createInternalTriggerParameter("amplitude", 0.3, 0.0, 1.0);
+    mFrequencyParam = createInternalTriggerParameter("frequency", 60, 20, 5000);
+    mAttackTimeParam =
+        createInternalTriggerParameter("attackTime", 1.0, 0.01, 3.0);
+    mReleaseTimeParam =
+        createInternalTriggerParameter("releaseTime", 3.0, 0.1, 10.0);
+    mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
     
-    createInternalTriggerParameter("pianoKeyX");
-    createInternalTriggerParameter("pianoKeyY");
-    createInternalTriggerParameter("pianoKeyWidth");
-    createInternalTriggerParameter("pianoKeyHeight");
+    mPianoKeyXParam = createInternalTriggerParameter("pianoKeyX");
+    mPianoKeyYParam = createInternalTriggerParameter("pianoKeyY");
+    mPianoKeyWidthParam = createInternalTriggerParameter("pianoKeyWidth");
+    mPianoKeyHeightParam = createInternalTriggerParameter("pianoKeyHeight");
   }
 
   // The audio processing function
@@ -147,12 +157,12 @@ class SineEnv : public SynthVoice {
     // voice, rather than having to trigger a new voice to hear the changes.
     // Parameters will update values once per audio callback because they
     // are outside the sample processing loop.
-    mOsc.freq(getInternalParameterValue("frequency"));
-    mAmpEnv.lengths()[0] = getInternalParameterValue("attackTime");
-    mAmpEnv.lengths()[2] = getInternalParameterValue("releaseTime");
-    mPan.pos(getInternalParameterValue("pan"));
+    mOsc.freq(mFrequencyParam.get());
+    mAmpEnv.lengths()[0] = mAttackTimeParam.get();
+    mAmpEnv.lengths()[2] = mReleaseTimeParam.get();
+    mPan.pos(mPanParam.get());
     while (io()) {
-      float s1 = mOsc() * mAmpEnv() * getInternalParameterValue("amplitude");
+      float s1 = mOsc() * mAmpEnv() * mAmplitudeParam.get();
       float s2;
       mEnvFollow(s1);
       mPan(s1, s1, s2);
@@ -169,14 +179,14 @@ class SineEnv : public SynthVoice {
   void onProcess(Graphics& g) override {
     // Get the paramter values on every video frame, to apply changes to the
     // current instance
-    float frequency = getInternalParameterValue("frequency");
-    float amplitude = getInternalParameterValue("amplitude");
+    float frequency = mFrequencyParam.get();
+    float amplitude = mAmplitudeParam.get();
 
-    float x = getInternalParameterValue("pianoKeyX");
-    float y = getInternalParameterValue("pianoKeyY");
+    float x = mPianoKeyXParam.get();
+    float y = mPianoKeyYParam.get();
 
-    float w = getInternalParameterValue("pianoKeyWidth");
-    float h = getInternalParameterValue("pianoKeyHeight");
+    float w = mPianoKeyWidthParam.get();
+    float h = mPianoKeyHeightParam.get();
 
     float hue = (frequency - 200) / 1000;
     float sat = amplitude;
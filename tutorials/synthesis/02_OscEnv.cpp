@@ -11,6 +11,8 @@
 #include "al/ui/al_ControlGUI.hpp"
 #include "al/ui/al_Parameter.hpp"
 
+#include "playground/VoiceParameter.hpp"
+
 // using namespace gam;
 using namespace al;
 
@@ -32,6 +34,10 @@ class OscEnv : public SynthVoice {
   // Additional members
   Mesh mMesh;
 
+  // Handles to the parameters read below, set in init()
+  VoiceParameter mAmplitudeParam, mFrequencyParam, mAttackTimeParam,
+      mReleaseTimeParam, mSustainParam, mCurveParam, mPanParam, mTableParam;
+
   // Initialize voice. This function will nly be called once per voice
   void init() override {
     // Intialize envelope
@@ -43,22 +49,24 @@ class OscEnv : public SynthVoice {
     // We have the mesh be a sphere
     addDisc(mMesh, 1.0, 30);
 
-    createInternalTriggerParameter("amplitude", 0.1, 0.0, 1.0);
-    createInternalTriggerParameter("frequency", 60, 20, 5000);
-    createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
-    createInternalTriggerParameter("releaseTime", 3.0, 0.1, 10.0);
-    createInternalTriggerParameter("sustain", 0.7, 0.0, 1.0);
-    createInternalTriggerParameter("curve", 4.0, -10.0, 10.0);
-    createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
-    createInternalTriggerParameter("table", 0, 0, 8);
+    mAmplitudeParam =
+        createInternalTriggerParameter("amplitude", 0.1, 0.0, 1.0);
+    mFrequencyParam = createInternalTriggerParameter("frequency", 60, 20, 5000);
+    mAttackTimeParam =
+        createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
+    mReleaseTimeParam =
+        createInternalTriggerParameter("releaseTime", 3.0, 0.1, 10.0);
+    mSustainParam = createInternalTriggerParameter("sustain", 0.7, 0.0, 1.0);
+    mCurveParam = createInternalTriggerParameter("curve", 4.0, -10.0, 10.0);
+    mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+    mTableParam = createInternalTriggerParameter("table", 0, 0, 8);
   }
 
   //
   virtual void onProcess(AudioIOData& io) override {
     updateFromParameters();
     while (io()) {
-      float s1 =
-          0.1 * mOsc() * mAmpEnv() * getInternalParameterValue("amplitude");
+      float s1 = 0.1 * mOsc() * mAmpEnv() * mAmplitudeParam.get();
       float s2;
       mEnvFollow(s1);
       mPan(s1, s1, s2);
@@ -72,8 +80,8 @@ class OscEnv : public SynthVoice {
   }
 
   void onProcess(Graphics& g) override {
-    float frequency = getInternalParameterValue("frequency");
-    float amplitude = getInternalParameterValue("amplitude");
+    float frequency = mFrequencyParam.get();
+    float amplitude = mAmplitudeParam.get();
     g.pushMatrix();
     g.translate(amplitude+frequency/2000, amplitude/2+frequency/2000, -4);
     g.scale(0.1, 0.1, 0.1);
@@ -86,7 +94,7 @@ class OscEnv : public SynthVoice {
     mAmpEnv.reset();
     updateFromParameters();
     // Map table number to table in memory
-    switch (int(getInternalParameterValue("table"))) {
+    switch (int(mTableParam.get())) {
       case 0:
         mOsc.source(tbSaw);
         break;
@@ -120,13 +128,13 @@ class OscEnv : public SynthVoice {
   virtual void onTriggerOff() override { mAmpEnv.triggerRelease(); }
 
   void updateFromParameters() {
-    mOsc.freq(getInternalParameterValue("frequency"));
-    mAmpEnv.attack(getInternalParameterValue("attackTime"));
-    mAmpEnv.decay(getInternalParameterValue("attackTime"));
-    mAmpEnv.release(getInternalParameterValue("releaseTime"));
-    mAmpEnv.sustain(getInternalParameterValue("sustain"));
-    mAmpEnv.curve(getInternalParameterValue("curve"));
-    mPan.pos(getInternalParameterValue("pan"));
+    mOsc.freq(mFrequencyParam.get());
+    mAmpEnv.attack(mAttackTimeParam.get());
+    mAmpEnv.decay(mAttackTimeParam.get());
+    mAmpEnv.release(mReleaseTimeParam.get());
+    mAmpEnv.sustain(mSustainParam.get());
+    mAmpEnv.curve(mCurveParam.get());
+    mPan.pos(mPanParam.get());
   }
 };
 
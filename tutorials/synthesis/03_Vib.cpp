@@ -12,6 +12,8 @@
 #include "al/ui/al_ControlGUI.hpp"
 #include "al/ui/al_Parameter.hpp"
 
+#include "playground/VoiceParameter.hpp"
+
 // using namespace gam;
 using namespace al;
 
@@ -34,6 +36,11 @@ class Vib : public SynthVoice {
   // Additional members
   Mesh mMesh;
 
+  // Handles to the parameters read below, set in init()
+  VoiceParameter mAmplitudeParam, mFrequencyParam, mAttackTimeParam,
+      mReleaseTimeParam, mCurveParam, mPanParam, mTableParam, mVibRate1Param,
+      mVibRate2Param, mVibRiseParam, mVibDepthParam;
+
   void init() override {
     mAmpEnv.curve(0);  // linear segments
     mAmpEnv.levels(0, 1, 1, 0);
@@ -42,23 +49,27 @@ class Vib : public SynthVoice {
     // We have the mesh be a sphere
     addDisc(mMesh, 1.0, 30);
 
-    createInternalTriggerParameter("amplitude", 0.1, 0.0, 1.0);
-    createInternalTriggerParameter("frequency", 60, 20, 5000);
-    createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
-    createInternalTriggerParameter("releaseTime", 3.0, 0.1, 10.0);
-    createInternalTriggerParameter("curve", 4.0, -10.0, 10.0);
-    createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
-    createInternalTriggerParameter("table", 0, 0, 8);
-    createInternalTriggerParameter("vibRate1", 3.5, 0.2, 20);
-    createInternalTriggerParameter("vibRate2", 5.8, 0.2, 20);
-    createInternalTriggerParameter("vibRise", 0.5, 0.1, 2);
-    createInternalTriggerParameter("vibDepth", 0.005, 0.0, 0.3);
+    mAmplitudeParam =
+        createInternalTriggerParameter("amplitude", 0.1, 0.0, 1.0);
+    mFrequencyParam = createInternalTriggerParameter("frequency", 60, 20, 5000);
+    mAttackTimeParam =
+        createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
+    mReleaseTimeParam =
+        createInternalTriggerParameter("releaseTime", 3.0, 0.1, 10.0);
+    mCurveParam = createInternalTriggerParameter("curve", 4.0, -10.0, 10.0);
+    mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+    mTableParam = createInternalTriggerParameter("table", 0, 0, 8);
+    mVibRate1Param = createInternalTriggerParameter("vibRate1", 3.5, 0.2, 20);
+    mVibRate2Param = createInternalTriggerParameter("vibRate2", 5.8, 0.2, 20);
+    mVibRiseParam = createInternalTriggerParameter("vibRise", 0.5, 0.1, 2);
+    mVibDepthParam =
+        createInternalTriggerParameter("vibDepth", 0.005, 0.0, 0.3);
   }
 
   void onProcess(AudioIOData& io) override {
-    float oscFreq = getInternalParameterValue("frequency");
-    float amp = getInternalParameterValue("amplitude");
-    float vibDepth = getInternalParameterValue("vibDepth");
+    float oscFreq = mFrequencyParam.get();
+    float amp = mAmplitudeParam.get();
+    float vibDepth = mVibDepthParam.get();
     while (io()) {
       mVib.freq(mVibEnv());
       vibValue = mVib();
@@ -76,11 +87,11 @@ class Vib : public SynthVoice {
   }
 
   void onProcess(Graphics& g) override {
-    float frequency = getInternalParameterValue("frequency");
-    float amplitude = getInternalParameterValue("amplitude");
+    float frequency = mFrequencyParam.get();
+    float amplitude = mAmplitudeParam.get();
     g.pushMatrix();
     g.translate(amplitude, amplitude, -4);
-    float scaling = vibValue + getInternalParameterValue("vibDepth");
+    float scaling = vibValue + mVibDepthParam.get();
     g.scale(scaling * frequency / 200, scaling * frequency / 400, scaling * 1);
     g.color(mEnvFollow.value(), frequency / 1000, mEnvFollow.value() * 10, 0.4);
     g.draw(mMesh);
@@ -94,7 +105,7 @@ class Vib : public SynthVoice {
     mAmpEnv.reset();
     mVibEnv.reset();
     // Map table number to table in memory
-    switch (int(getInternalParameterValue("table"))) {
+    switch (int(mTableParam.get())) {
       case 0:
         mOsc.source(tbSaw);
         break;
@@ -131,19 +142,17 @@ class Vib : public SynthVoice {
   }
 
   void updateFromParameters() {
-    mOsc.freq(getInternalParameterValue("frequency"));
-    mAmpEnv.attack(getInternalParameterValue("attackTime"));
-    mAmpEnv.decay(getInternalParameterValue("attackTime"));
-    mAmpEnv.release(getInternalParameterValue("releaseTime"));
-    mAmpEnv.curve(getInternalParameterValue("curve"));
-    mPan.pos(getInternalParameterValue("pan"));
-    mVibEnv.levels(getInternalParameterValue("vibRate1"),
-                   getInternalParameterValue("vibRate2"),
-                   getInternalParameterValue("vibRate2"),
-                   getInternalParameterValue("vibRate1"));
-    mVibEnv.lengths()[0] = getInternalParameterValue("vibRise");
-    mVibEnv.lengths()[1] = getInternalParameterValue("vibRise");
-    mVibEnv.lengths()[3] = getInternalParameterValue("vibRise");
+    mOsc.freq(mFrequencyParam.get());
+    mAmpEnv.attack(mAttackTimeParam.get());
+    mAmpEnv.decay(mAttackTimeParam.get());
+    mAmpEnv.release(mReleaseTimeParam.get());
+    mAmpEnv.curve(mCurveParam.get());
+    mPan.pos(mPanParam.get());
+    mVibEnv.levels(mVibRate1Param.get(), mVibRate2Param.get(),
+                   mVibRate2Param.get(), mVibRate1Param.get());
+    mVibEnv.lengths()[0] = mVibRiseParam.get();
+    mVibEnv.lengths()[1] = mVibRiseParam.get();
+    mVibEnv.lengths()[3] = mVibRiseParam.get();
   }
 };
 
@@ -12,6 +12,8 @@
 #include "al/ui/al_ControlGUI.hpp"
 #include "al/ui/al_Parameter.hpp"
 
+#include "playground/VoiceParameter.hpp"
+
 // using namespace gam;
 using namespace al;
 using namespace std;
@@ -29,6 +31,11 @@ class FM : public SynthVoice {
   // Additional members
   Mesh mMesh;
 
+  // Handles to the parameters read below, set in init()
+  VoiceParameter mFreqParam, mAmplitudeParam, mAttackTimeParam,
+      mReleaseTimeParam, mIdx1Param, mIdx2Param, mIdx3Param, mCarMulParam,
+      mModMulParam, mPanParam;
+
   void init() override {
     //      mAmpEnv.curve(0); // linear segments
     mAmpEnv.levels(0, 1, 1, 0);
@@ -36,33 +43,33 @@ class FM : public SynthVoice {
     // We have the mesh be a sphere
     addDisc(mMesh, 1.0, 30);
 
-    createInternalTriggerParameter("freq", 440, 10, 4000.0);
-    createInternalTriggerParameter("amplitude", 0.5, 0.0, 1.0);
-    createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
-    createInternalTriggerParameter("releaseTime", 0.1, 0.1, 10.0);
+    mFreqParam = createInternalTriggerParameter("freq", 440, 10, 4000.0);
+    mAmplitudeParam =
+        createInternalTriggerParameter("amplitude", 0.5, 0.0, 1.0);
+    mAttackTimeParam =
+        createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
+    mReleaseTimeParam =
+        createInternalTriggerParameter("releaseTime", 0.1, 0.1, 10.0);
     createInternalTriggerParameter("sustain", 0.75, 0.1, 1.0);  // Unused
 
     // FM index
-    createInternalTriggerParameter("idx1", 0.01, 0.0, 10.0);
-    createInternalTriggerParameter("idx2", 7, 0.0, 10.0);
-    createInternalTriggerParameter("idx3", 5, 0.0, 10.0);
+    mIdx1Param = createInternalTriggerParameter("idx1", 0.01, 0.0, 10.0);
+    mIdx2Param = createInternalTriggerParameter("idx2", 7, 0.0, 10.0);
+    mIdx3Param = createInternalTriggerParameter("idx3", 5, 0.0, 10.0);
 
-    createInternalTriggerParameter("carMul", 1, 0.0, 20.0);
-    createInternalTriggerParameter("modMul", 1.0007, 0.0, 20.0);
+    mCarMulParam = createInternalTriggerParameter("carMul", 1, 0.0, 20.0);
+    mModMulParam = createInternalTriggerParameter("modMul", 1.0007, 0.0, 20.0);
 
-    createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+    mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
   }
 
   //
   void onProcess(AudioIOData& io) override {
-    float modFreq =
-        getInternalParameterValue("freq") * getInternalParameterValue("modMul");
+    float modFreq = mFreqParam.get() * mModMulParam.get();
     mod.freq(modFreq);
-    float carBaseFreq =
-        getInternalParameterValue("freq") * getInternalParameterValue("carMul");
-    float modScale =
-        getInternalParameterValue("freq") * getInternalParameterValue("modMul");
-    float amp = getInternalParameterValue("amplitude");
+    float carBaseFreq = mFreqParam.get() * mCarMulParam.get();
+    float modScale = mFreqParam.get() * mModMulParam.get();
+    float amp = mAmplitudeParam.get();
     while (io()) {
       car.freq(carBaseFreq + mod() * mModEnv() * modScale);
       float s1 = car() * mAmpEnv() * amp;
@@ -77,31 +84,30 @@ class FM : public SynthVoice {
 
   void onProcess(Graphics& g) override {
     g.pushMatrix();
-    g.translate(getInternalParameterValue("freq") / 300 - 2,
+    g.translate(mFreqParam.get() / 300 - 2,
                 getInternalParameterValue("modAmt") / 25 - 1, -4);
-    float scaling = getInternalParameterValue("amplitude") * 1;
+    float scaling = mAmplitudeParam.get() * 1;
     g.scale(scaling, scaling, scaling * 1);
-    g.color(HSV(getInternalParameterValue("modMul") / 20, 1,
-                mEnvFollow.value() * 10));
+    g.color(HSV(mModMulParam.get() / 20, 1, mEnvFollow.value() * 10));
     g.draw(mMesh);
     g.popMatrix();
   }
 
   void onTriggerOn() override {
-    mModEnv.levels()[0] = getInternalParameterValue("idx1");
-    mModEnv.levels()[1] = getInternalParameterValue("idx2");
-    mModEnv.levels()[2] = getInternalParameterValue("idx2");
-    mModEnv.levels()[3] = getInternalParameterValue("idx3");
+    mModEnv.levels()[0] = mIdx1Param.get();
+    mModEnv.levels()[1] = mIdx2Param.get();
+    mModEnv.levels()[2] = mIdx2Param.get();
+    mModEnv.levels()[3] = mIdx3Param.get();
 
-    mAmpEnv.lengths()[0] = getInternalParameterValue("attackTime");
-    mModEnv.lengths()[0] = getInternalParameterValue("attackTime");
+    mAmpEnv.lengths()[0] = mAttackTimeParam.get();
+    mModEnv.lengths()[0] = mAttackTimeParam.get();
 
     mAmpEnv.lengths()[1] = 0.001;
     mModEnv.lengths()[1] = 0.001;
 
-    mAmpEnv.lengths()[2] = getInternalParameterValue("releaseTime");
-    mModEnv.lengths()[2] = getInternalParameterValue("releaseTime");
-    mPan.pos(getInternalParameterValue("pan"));
+    mAmpEnv.lengths()[2] = mReleaseTimeParam.get();
+    mModEnv.lengths()[2] = mReleaseTimeParam.get();
+    mPan.pos(mPanParam.get());
 
     //        mModEnv.lengths()[1] = mAmpEnv.lengths()[1];
 
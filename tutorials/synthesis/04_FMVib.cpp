@@ -14,6 +14,8 @@
 #include "al/ui/al_ControlGUI.hpp"
 #include "al/ui/al_Parameter.hpp"
 
+#include "playground/VoiceParameter.hpp"
+
 // using namespace gam;
 using namespace al;
 using namespace std;
@@ -37,6 +39,12 @@ class FM : public SynthVoice {
   float mVibDepth;
   float mVibRise;
 
+  // Handles to the parameters read below, set in init()
+  VoiceParameter mFreqParam, mAmplitudeParam, mAttackTimeParam,
+      mReleaseTimeParam, mSustainParam, mIdx1Param, mIdx2Param, mIdx3Param,
+      mCarMulParam, mModMulParam, mVibRate1Param, mVibRate2Param, mVibRiseParam,
+      mVibDepthParam, mPanParam;
+
   void init() override {
     //      mAmpEnv.curve(0); // linear segments
 
@@ -48,37 +56,39 @@ class FM : public SynthVoice {
     // We have the mesh be a sphere
     addDisc(mMesh, 1.0, 30);
 
-    createInternalTriggerParameter("freq", 440, 10, 4000.0);
-    createInternalTriggerParameter("amplitude", 0.5, 0.0, 1.0);
-    createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
-    createInternalTriggerParameter("releaseTime", 0.1, 0.1, 10.0);
-    createInternalTriggerParameter("sustain", 0.75, 0.1, 1.0);
+    mFreqParam = createInternalTriggerParameter("freq", 440, 10, 4000.0);
+    mAmplitudeParam =
+        createInternalTriggerParameter("amplitude", 0.5, 0.0, 1.0);
+    mAttackTimeParam =
+        createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
+    mReleaseTimeParam =
+        createInternalTriggerParameter("releaseTime", 0.1, 0.1, 10.0);
+    mSustainParam = createInternalTriggerParameter("sustain", 0.75, 0.1, 1.0);
 
     // FM index
-    createInternalTriggerParameter("idx1", 0.01, 0.0, 10.0);
-    createInternalTriggerParameter("idx2", 7, 0.0, 10.0);
-    createInternalTriggerParameter("idx3", 5, 0.0, 10.0);
+    mIdx1Param = createInternalTriggerParameter("idx1", 0.01, 0.0, 10.0);
+    mIdx2Param = createInternalTriggerParameter("idx2", 7, 0.0, 10.0);
+    mIdx3Param = createInternalTriggerParameter("idx3", 5, 0.0, 10.0);
 
-    createInternalTriggerParameter("carMul", 1, 0.0, 20.0);
-    createInternalTriggerParameter("modMul", 1.0007, 0.0, 20.0);
+    mCarMulParam = createInternalTriggerParameter("carMul", 1, 0.0, 20.0);
+    mModMulParam = createInternalTriggerParameter("modMul", 1.0007, 0.0, 20.0);
 
-    createInternalTriggerParameter("vibRate1", 0.01, 0.0, 10.0);
-    createInternalTriggerParameter("vibRate2", 0.5, 0.0, 10.0);
-    createInternalTriggerParameter("vibRise", 0, 0.0, 10.0);
-    createInternalTriggerParameter("vibDepth", 0, 0.0, 10.0);
+    mVibRate1Param =
+        createInternalTriggerParameter("vibRate1", 0.01, 0.0, 10.0);
+    mVibRate2Param = createInternalTriggerParameter("vibRate2", 0.5, 0.0, 10.0);
+    mVibRiseParam = createInternalTriggerParameter("vibRise", 0, 0.0, 10.0);
+    mVibDepthParam = createInternalTriggerParameter("vibDepth", 0, 0.0, 10.0);
 
-    createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+    mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
   }
 
   //
   void onProcess(AudioIOData& io) override {
     updateFromParameters();
     mVib.freq(mVibEnv());
-    float carBaseFreq =
-        getInternalParameterValue("freq") * getInternalParameterValue("carMul");
-    float modScale =
-        getInternalParameterValue("freq") * getInternalParameterValue("modMul");
-    float amp = getInternalParameterValue("amplitude");
+    float carBaseFreq = mFreqParam.get() * mCarMulParam.get();
+    float modScale = mFreqParam.get() * mModMulParam.get();
+    float amp = mAmplitudeParam.get();
     while (io()) {
       mVib.freq(mVibEnv());
       car.freq((1 + mVib() * mVibDepth) * carBaseFreq +
@@ -95,16 +105,11 @@ class FM : public SynthVoice {
 
   void onProcess(Graphics& g) override {
     g.pushMatrix();
-    g.translate(getInternalParameterValue("freq") / 300 - 2,
-                (getInternalParameterValue("idx3") +
-                 getInternalParameterValue("idx2")) /
-                        15 -
-                    1,
-                -4);
-    float scaling = getInternalParameterValue("amplitude") / 3;
+    g.translate(mFreqParam.get() / 300 - 2,
+                (mIdx3Param.get() + mIdx2Param.get()) / 15 - 1, -4);
+    float scaling = mAmplitudeParam.get() / 3;
     g.scale(scaling, scaling, scaling * 1);
-    g.color(HSV(getInternalParameterValue("modMul") / 20, 1,
-                mEnvFollow.value() * 10));
+    g.color(HSV(mModMulParam.get() / 20, 1, mEnvFollow.value() * 10));
     g.draw(mMesh);
     g.popMatrix();
   }
@@ -112,8 +117,7 @@ class FM : public SynthVoice {
   void onTriggerOn() override {
     updateFromParameters();
 
-    float modFreq =
-        getInternalParameterValue("freq") * getInternalParameterValue("modMul");
+    float modFreq = mFreqParam.get() * mModMulParam.get();
     mod.freq(modFreq);
 
     mVibEnv.lengths()[0] = mDur * (1 - mVibRise);
@@ -129,28 +133,28 @@ class FM : public SynthVoice {
   }
 
   void updateFromParameters() {
-    mModEnv.levels()[0] = getInternalParameterValue("idx1");
-    mModEnv.levels()[1] = getInternalParameterValue("idx2");
-    mModEnv.levels()[2] = getInternalParameterValue("idx2");
-    mModEnv.levels()[3] = getInternalParameterValue("idx3");
+    mModEnv.levels()[0] = mIdx1Param.get();
+    mModEnv.levels()[1] = mIdx2Param.get();
+    mModEnv.levels()[2] = mIdx2Param.get();
+    mModEnv.levels()[3] = mIdx3Param.get();
 
     mAmpEnv.levels()[1] = 1.0;
     // mAmpEnv.levels()[2] = 1.0;
-    mAmpEnv.levels()[2] = getInternalParameterValue("sustain");
+    mAmpEnv.levels()[2] = mSustainParam.get();
 
-    mAmpEnv.lengths()[0] = getInternalParameterValue("attackTime");
-    mModEnv.lengths()[0] = getInternalParameterValue("attackTime");
+    mAmpEnv.lengths()[0] = mAttackTimeParam.get();
+    mModEnv.lengths()[0] = mAttackTimeParam.get();
 
-    mAmpEnv.lengths()[3] = getInternalParameterValue("releaseTime");
-    mModEnv.lengths()[3] = getInternalParameterValue("releaseTime");
+    mAmpEnv.lengths()[3] = mReleaseTimeParam.get();
+    mModEnv.lengths()[3] = mReleaseTimeParam.get();
 
     mAmpEnv.totalLength(getInternalParameterValue("dur"), 1);
     mModEnv.lengths()[1] = mAmpEnv.lengths()[1];
-    mVibEnv.levels()[1] = getInternalParameterValue("vibRate1");
-    mVibEnv.levels()[2] = getInternalParameterValue("vibRate2");
-    mVibDepth = getInternalParameterValue("vibDepth");
-    mVibRise = getInternalParameterValue("vibRise");
-    mPan.pos(getInternalParameterValue("pan"));
+    mVibEnv.levels()[1] = mVibRate1Param.get();
+    mVibEnv.levels()[2] = mVibRate2Param.get();
+    mVibDepth = mVibDepthParam.get();
+    mVibRise = mVibRiseParam.get();
+    mPan.pos(mPanParam.get());
 
   }
 };
@@ -14,6 +14,8 @@
 #include "al/ui/al_ControlGUI.hpp"
 #include "al/ui/al_Parameter.hpp"
 
+#include "playground/VoiceParameter.hpp"
+
 // using namespace gam;
 using namespace al;
 using namespace std;
@@ -39,6 +41,11 @@ public:
     // Additional members
     Mesh mMesh;
 
+    // Handles to the parameters read below, set in init()
+    VoiceParameter mAmplitudeParam, mFrequencyParam, mAttackTimeParam,
+        mReleaseTimeParam, mSustainParam, mCurveParam, mPanParam, mTableParam,
+        mTrm1Param, mTrm2Param, mTrmRiseParam, mTrmDepthParam;
+
     // Initialize voice. This function will nly be called once per voice
     virtual void init() {
 
@@ -54,26 +61,32 @@ public:
         // We have the mesh be a sphere
         addDisc(mMesh, 1.0, 30);
 
-        createInternalTriggerParameter("amplitude", 0.3, 0.0, 1.0);
-        createInternalTriggerParameter("frequency", 60, 20, 5000);
-        createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
-        createInternalTriggerParameter("releaseTime", 3.0, 0.1, 10.0);
-        createInternalTriggerParameter("sustain", 0.7, 0.0, 1.0);
-        createInternalTriggerParameter("curve", 4.0, -10.0, 10.0);
-        createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
-        createInternalTriggerParameter("table", 0, 0, 8);
-        createInternalTriggerParameter("trm1", 3.5, 0.2, 20);
-        createInternalTriggerParameter("trm2", 5.8, 0.2, 20);
-        createInternalTriggerParameter("trmRise", 0.5, 0.1, 2);
-        createInternalTriggerParameter("trmDepth", 0.1, 0.0, 1.0);
+        mAmplitudeParam =
+            createInternalTriggerParameter("amplitude", 0.3, 0.0, 1.0);
+        mFrequencyParam =
+            createInternalTriggerParameter("frequency", 60, 20, 5000);
+        mAttackTimeParam =
+            createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
+        mReleaseTimeParam =
+            createInternalTriggerParameter("releaseTime", 3.0, 0.1, 10.0);
+        mSustainParam =
+            createInternalTriggerParameter("sustain", 0.7, 0.0, 1.0);
+        mCurveParam = createInternalTriggerParameter("curve", 4.0, -10.0, 10.0);
+        mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+        mTableParam = createInternalTriggerParameter("table", 0, 0, 8);
+        mTrm1Param = createInternalTriggerParameter("trm1", 3.5, 0.2, 20);
+        mTrm2Param = createInternalTriggerParameter("trm2", 5.8, 0.2, 20);
+        mTrmRiseParam = createInternalTriggerParameter("trmRise", 0.5, 0.1, 2);
+        mTrmDepthParam =
+            createInternalTriggerParameter("trmDepth", 0.1, 0.0, 1.0);
     }
 
     //
     virtual void onProcess(AudioIOData& io) override {
         //updateFromParameters();
-        float oscFreq = getInternalParameterValue("frequency");
-        float amp = getInternalParameterValue("amplitude");
-        float trmDepth = getInternalParameterValue("trmDepth");
+        float oscFreq = mFrequencyParam.get();
+        float amp = mAmplitudeParam.get();
+        float trmDepth = mTrmDepthParam.get();
          while(io()){
 
             mTrm.freq(mTrmEnv());
@@ -93,12 +106,12 @@ public:
     }
 
     virtual void onProcess(Graphics &g) {
-            float frequency = getInternalParameterValue("frequency");
-            float amplitude = getInternalParameterValue("amplitude");
+            float frequency = mFrequencyParam.get();
+            float amplitude = mAmplitudeParam.get();
             g.pushMatrix();
             g.translate(amplitude,  amplitude, -4);
             //g.scale(frequency/2000, frequency/4000, 1);
-            float scaling = getInternalParameterValue("trmDepth");
+            float scaling = mTrmDepthParam.get();
             g.scale(scaling * frequency/200, scaling * frequency/400, scaling* 1);
             g.color(mEnvFollow.value(), frequency/1000, mEnvFollow.value()* 10, 0.4);
             g.draw(mMesh);
@@ -112,7 +125,7 @@ public:
         mTrmEnv.reset();
         
         // Map table number to table in memory
-        switch (int(getInternalParameterValue("table"))) {
+        switch (int(mTableParam.get())) {
         case 0: mOsc.source(tbSaw); break;
         case 1: mOsc.source(tbSqr); break;
         case 2: mOsc.source(tbImp); break;
@@ -131,22 +144,20 @@ public:
     }
 
     void updateFromParameters() {
-        mOsc.freq(getInternalParameterValue("frequency"));
-        mAmpEnv.attack(getInternalParameterValue("attackTime"));
-        mAmpEnv.decay(getInternalParameterValue("attackTime"));
-        mAmpEnv.release(getInternalParameterValue("releaseTime"));
-        mAmpEnv.sustain(getInternalParameterValue("sustain"));
-        mAmpEnv.curve(getInternalParameterValue("curve"));
-        mPan.pos(getInternalParameterValue("pan"));
-
-        mTrmEnv.levels(getInternalParameterValue("trm1"),
-                       getInternalParameterValue("trm2"),
-                       getInternalParameterValue("trm2"),
-                       getInternalParameterValue("trm1"));
-
-        mTrmEnv.attack(getInternalParameterValue("trmRise"));
-        mTrmEnv.decay(getInternalParameterValue("trmRise"));
-        mTrmEnv.release(getInternalParameterValue("trmRise"));
+        mOsc.freq(mFrequencyParam.get());
+        mAmpEnv.attack(mAttackTimeParam.get());
+        mAmpEnv.decay(mAttackTimeParam.get());
+        mAmpEnv.release(mReleaseTimeParam.get());
+        mAmpEnv.sustain(mSustainParam.get());
+        mAmpEnv.curve(mCurveParam.get());
+        mPan.pos(mPanParam.get());
+
+        mTrmEnv.levels(mTrm1Param.get(), mTrm2Param.get(), mTrm2Param.get(),
+                       mTrm1Param.get());
+
+        mTrmEnv.attack(mTrmRiseParam.get());
+        mTrmEnv.decay(mTrmRiseParam.get());
+        mTrmEnv.release(mTrmRiseParam.get());
     }
 };
 
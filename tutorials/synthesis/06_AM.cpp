@@ -13,6 +13,8 @@
 #include "al/ui/al_ControlGUI.hpp"
 #include "al/ui/al_Parameter.hpp"
 
+#include "playground/VoiceParameter.hpp"
+
 using namespace gam;
 using namespace al;
 using namespace std;
@@ -34,6 +36,11 @@ public:
 
   Mesh mMesh;
 
+  // Handles to the parameters read below, set in init()
+  VoiceParameter mAmplitudeParam, mFrequencyParam, mAttackTimeParam,
+      mReleaseTimeParam, mSustainParam, mPanParam, mAmFuncParam, mAm1Param,
+      mAm2Param, mAmRiseParam, mAmRatioParam;
+
   // Initialize voice. This function will nly be called once per voice
   virtual void init( ) {
     mAmpEnv.levels(0,1,1,0);
@@ -46,24 +53,28 @@ public:
     // We have the mesh be a sphere
     addDisc(mMesh, 1.0, 30);
 
-    createInternalTriggerParameter("amplitude", 0.5, 0.0, 1.0);
-    createInternalTriggerParameter("frequency", 440, 10, 4000.0);
-    createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
-    createInternalTriggerParameter("releaseTime", 0.1, 0.1, 10.0);
-    createInternalTriggerParameter("sustain", 0.75, 0.1, 1.0);
-    createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
-    createInternalTriggerParameter("amFunc", 0.0, 0.0, 3.0);
-    createInternalTriggerParameter("am1", 0.75, 0.1, 1.0);
-    createInternalTriggerParameter("am2", 0.75, 0.1, 1.0);
-    createInternalTriggerParameter("amRise", 0.75, 0.1, 1.0);
-    createInternalTriggerParameter("amRatio", 0.75, 0.1, 2.0);
+    mAmplitudeParam =
+        createInternalTriggerParameter("amplitude", 0.5, 0.0, 1.0);
+    mFrequencyParam =
+        createInternalTriggerParameter("frequency", 440, 10, 4000.0);
+    mAttackTimeParam =
+        createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
+    mReleaseTimeParam =
+        createInternalTriggerParameter("releaseTime", 0.1, 0.1, 10.0);
+    mSustainParam = createInternalTriggerParameter("sustain", 0.75, 0.1, 1.0);
+    mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+    mAmFuncParam = createInternalTriggerParameter("amFunc", 0.0, 0.0, 3.0);
+    mAm1Param = createInternalTriggerParameter("am1", 0.75, 0.1, 1.0);
+    mAm2Param = createInternalTriggerParameter("am2", 0.75, 0.1, 1.0);
+    mAmRiseParam = createInternalTriggerParameter("amRise", 0.75, 0.1, 1.0);
+    mAmRatioParam = createInternalTriggerParameter("amRatio", 0.75, 0.1, 2.0);
   }
 
   virtual void onProcess(AudioIOData& io) override {
-    mOsc.freq(getInternalParameterValue("frequency"));
+    mOsc.freq(mFrequencyParam.get());
 
-    float amp = getInternalParameterValue("amplitude");
-    float amRatio = getInternalParameterValue("amRatio");
+    float amp = mAmplitudeParam.get();
+    float amRatio = mAmRatioParam.get();
     while(io()){
 
       mAM.freq(mOsc.freq()*amRatio);            // set AM freq according to ratio
@@ -87,8 +98,8 @@ public:
   }
 
   virtual void onProcess(Graphics &g) {
-          float frequency = getInternalParameterValue("frequency");
-          float amplitude = getInternalParameterValue("amplitude");
+          float frequency = mFrequencyParam.get();
+          float amplitude = mAmplitudeParam.get();
           g.pushMatrix();
           g.translate(amplitude,  amplitude, -4);
           //g.scale(frequency/2000, frequency/4000, 1);
@@ -100,27 +111,24 @@ public:
   }
 
   virtual void onTriggerOn() override {
-    mAmpEnv.attack(getInternalParameterValue("attackTime"));
+    mAmpEnv.attack(mAttackTimeParam.get());
     mAmpEnv.lengths()[1] = 0.001;
-    mAmpEnv.release(getInternalParameterValue("releaseTime"));
+    mAmpEnv.release(mReleaseTimeParam.get());
 
-    mAmpEnv.levels()[1]= getInternalParameterValue("sustain");
-    mAmpEnv.levels()[2]= getInternalParameterValue("sustain");
+    mAmpEnv.levels()[1]= mSustainParam.get();
+    mAmpEnv.levels()[2]= mSustainParam.get();
 
-    mAMEnv.levels(getInternalParameterValue("am1"),
-                  getInternalParameterValue("am2"),
-                  getInternalParameterValue("am2"),
-                  getInternalParameterValue("am1"));
+    mAMEnv.levels(mAm1Param.get(), mAm2Param.get(), mAm2Param.get(),
+                  mAm1Param.get());
 
-    mAMEnv.lengths(getInternalParameterValue("amRise"),
-                   1-getInternalParameterValue("amRise"));
+    mAMEnv.lengths(mAmRiseParam.get(), 1-mAmRiseParam.get());
 
-    mPan.pos(getInternalParameterValue("pan"));
+    mPan.pos(mPanParam.get());
 
     mAmpEnv.reset();
     mAMEnv.reset();
     // Map table number to table in memory
-    switch (int(getInternalParameterValue("amFunc"))) {
+    switch (int(mAmFuncParam.get())) {
     case 0: mAM.source(tbSin); break;
     case 1: mAM.source(tbSqr); break;
     case 2: mAM.source(tbPls); break;
@@ -13,6 +13,8 @@
 #include "al/ui/al_ControlGUI.hpp"
 #include "al/ui/al_Parameter.hpp"
 
+#include "playground/VoiceParameter.hpp"
+
 using namespace gam;
 using namespace al;
 using namespace std;
@@ -32,6 +34,12 @@ public:
     // Additional members
     Mesh mMesh;
 
+    // Handles to the parameters read below, set in init()
+    VoiceParameter mAmplitudeParam, mFrequencyParam, mAttackTimeParam,
+        mReleaseTimeParam, mSustainParam, mCurveParam, mNoiseParam,
+        mEnvDurParam, mCf1Param, mCf2Param, mCfRiseParam, mBw1Param, mBw2Param,
+        mBwRiseParam, mHmnumParam, mHmampParam, mPanParam;
+
     // Initialize voice. This function will nly be called once per voice
     void init() override {
         mAmpEnv.curve(0); // linear segments
@@ -43,23 +51,28 @@ public:
         // We have the mesh be a sphere
         addDisc(mMesh, 1.0, 30);
 
-        createInternalTriggerParameter("amplitude", 0.3, 0.0, 1.0);
-        createInternalTriggerParameter("frequency", 60, 20, 5000);
-        createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
-        createInternalTriggerParameter("releaseTime", 3.0, 0.1, 10.0);
-        createInternalTriggerParameter("sustain", 0.7, 0.0, 1.0);
-        createInternalTriggerParameter("curve", 4.0, -10.0, 10.0);
-        createInternalTriggerParameter("noise", 0.0, 0.0, 1.0);
-        createInternalTriggerParameter("envDur",1, 0.0, 5.0);
-        createInternalTriggerParameter("cf1", 400.0, 10.0, 5000);
-        createInternalTriggerParameter("cf2", 400.0, 10.0, 5000);
-        createInternalTriggerParameter("cfRise", 0.5, 0.1, 2);
-        createInternalTriggerParameter("bw1", 700.0, 10.0, 5000);
-        createInternalTriggerParameter("bw2", 900.0, 10.0, 5000);
-        createInternalTriggerParameter("bwRise", 0.5, 0.1, 2);
-        createInternalTriggerParameter("hmnum", 12.0, 5.0, 20.0);
-        createInternalTriggerParameter("hmamp", 1.0, 0.0, 1.0);
-        createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+        mAmplitudeParam =
+            createInternalTriggerParameter("amplitude", 0.3, 0.0, 1.0);
+        mFrequencyParam =
+            createInternalTriggerParameter("frequency", 60, 20, 5000);
+        mAttackTimeParam =
+            createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
+        mReleaseTimeParam =
+            createInternalTriggerParameter("releaseTime", 3.0, 0.1, 10.0);
+        mSustainParam =
+            createInternalTriggerParameter("sustain", 0.7, 0.0, 1.0);
+        mCurveParam = createInternalTriggerParameter("curve", 4.0, -10.0, 10.0);
+        mNoiseParam = createInternalTriggerParameter("noise", 0.0, 0.0, 1.0);
+        mEnvDurParam = createInternalTriggerParameter("envDur",1, 0.0, 5.0);
+        mCf1Param = createInternalTriggerParameter("cf1", 400.0, 10.0, 5000);
+        mCf2Param = createInternalTriggerParameter("cf2", 400.0, 10.0, 5000);
+        mCfRiseParam = createInternalTriggerParameter("cfRise", 0.5, 0.1, 2);
+        mBw1Param = createInternalTriggerParameter("bw1", 700.0, 10.0, 5000);
+        mBw2Param = createInternalTriggerParameter("bw2", 900.0, 10.0, 5000);
+        mBwRiseParam = createInternalTriggerParameter("bwRise", 0.5, 0.1, 2);
+        mHmnumParam = createInternalTriggerParameter("hmnum", 12.0, 5.0, 20.0);
+        mHmampParam = createInternalTriggerParameter("hmamp", 1.0, 0.0, 1.0);
+        mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
 
     }
 
@@ -67,8 +80,8 @@ public:
     
     virtual void onProcess(AudioIOData& io) override {
         updateFromParameters();
-        float amp = getInternalParameterValue("amplitude");
-        float noiseMix = getInternalParameterValue("noise");
+        float amp = mAmplitudeParam.get();
+        float noiseMix = mNoiseParam.get();
         while(io()){
             // mix oscillator with noise
             float s1 = mOsc()*(1-noiseMix) + mNoise()*noiseMix;
@@ -91,8 +104,8 @@ public:
     }
 
    virtual void onProcess(Graphics &g) {
-          float frequency = getInternalParameterValue("frequency");
-          float amplitude = getInternalParameterValue("amplitude");
+          float frequency = mFrequencyParam.get();
+          float amplitude = mAmplitudeParam.get();
           g.pushMatrix();
           g.translate(amplitude,  amplitude, -4);
           //g.scale(frequency/2000, frequency/4000, 1);
@@ -117,32 +130,28 @@ public:
     }
 
     void updateFromParameters() {
-        mOsc.freq(getInternalParameterValue("frequency"));
-        mOsc.harmonics(getInternalParameterValue("hmnum"));
-        mOsc.ampRatio(getInternalParameterValue("hmamp"));
-        mAmpEnv.attack(getInternalParameterValue("attackTime"));
-    //    mAmpEnv.decay(getInternalParameterValue("attackTime"));
-        mAmpEnv.release(getInternalParameterValue("releaseTime"));
-        mAmpEnv.levels()[1]=getInternalParameterValue("sustain");
-        mAmpEnv.levels()[2]=getInternalParameterValue("sustain");
-
-        mAmpEnv.curve(getInternalParameterValue("curve"));
-        mPan.pos(getInternalParameterValue("pan"));
-        mCFEnv.levels(getInternalParameterValue("cf1"),
-                      getInternalParameterValue("cf2"),
-                      getInternalParameterValue("cf1"));
-
-
-        mCFEnv.lengths()[0] = getInternalParameterValue("cfRise");
-        mCFEnv.lengths()[1] = 1 - getInternalParameterValue("cfRise");
-        mBWEnv.levels(getInternalParameterValue("bw1"),
-                      getInternalParameterValue("bw2"),
-                      getInternalParameterValue("bw1"));
-        mBWEnv.lengths()[0] = getInternalParameterValue("bwRise");
-        mBWEnv.lengths()[1] = 1- getInternalParameterValue("bwRise");
-
-        mCFEnv.totalLength(getInternalParameterValue("envDur"));
-        mBWEnv.totalLength(getInternalParameterValue("envDur"));
+        mOsc.freq(mFrequencyParam.get());
+        mOsc.harmonics(mHmnumParam.get());
+        mOsc.ampRatio(mHmampParam.get());
+        mAmpEnv.attack(mAttackTimeParam.get());
+    //    mAmpEnv.decay(mAttackTimeParam.get());
+        mAmpEnv.release(mReleaseTimeParam.get());
+        mAmpEnv.levels()[1]=mSustainParam.get();
+        mAmpEnv.levels()[2]=mSustainParam.get();
+
+        mAmpEnv.curve(mCurveParam.get());
+        mPan.pos(mPanParam.get());
+        mCFEnv.levels(mCf1Param.get(), mCf2Param.get(), mCf1Param.get());
+
+
+        mCFEnv.lengths()[0] = mCfRiseParam.get();
+        mCFEnv.lengths()[1] = 1 - mCfRiseParam.get();
+        mBWEnv.levels(mBw1Param.get(), mBw2Param.get(), mBw1Param.get());
+        mBWEnv.lengths()[0] = mBwRiseParam.get();
+        mBWEnv.lengths()[1] = 1- mBwRiseParam.get();
+
+        mCFEnv.totalLength(mEnvDurParam.get());
+        mBWEnv.totalLength(mEnvDurParam.get());
     }
 };
 
@@ -1,3 +1,11 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
 
 #include "Gamma/Analysis.h"
 #include "Gamma/Effects.h"
@@ -12,24 +20,40 @@
 #include "al/ui/al_ControlGUI.hpp"
 #include "al/ui/al_Parameter.hpp"
 
+#include "MipOsc.hpp"
+#include "playground/VoiceParameter.hpp"
+
 // using namespace gam;
 using namespace al;
 using namespace std;
-// tables for oscillator
-gam::ArrayPow2<float> tbSaw(2048), tbSqr(2048), tbImp(2048), tbSin(2048),
-    tbPls(2048), tbDin(2048), tb__1(2048), tb__2(2048), tb__3(2048),
-    tb__4(2048);
+
+// Renders up to MipOsc::BLOCK of the samples osc plays over the rest of io's
+// buffer into block, for voices whose oscillator frequency holds for the
+// whole callback. Returns how many it rendered, 0 at the end of the buffer.
+inline int renderBlock(MipOsc &osc, AudioIOData &io, float *block) {
+  int n = int(io.framesPerBuffer()) - (io.frame() + 1);
+  if (n > MipOsc::BLOCK)
+    n = MipOsc::BLOCK;
+  osc.process(block, n);
+  return n;
+}
+
 class OscEnv : public SynthVoice {
 public:
   // Unit generators
   gam::Pan<> mPan;
-  gam::Osc<> mOsc;
+  MipOsc mOsc;
   gam::ADSR<> mAmpEnv;
   gam::EnvFollow<>
       mEnvFollow; // envelope follower to connect audio output to graphics
 
   // Additional members
   Mesh mMesh;
+  float mOscBlock[MipOsc::BLOCK]; // mOsc's next samples
+
+  // Handles to the parameters read below, set in init()
+  VoiceParameter mAmplitudeParam, mFrequencyParam, mAttackTimeParam,
+      mReleaseTimeParam, mSustainParam, mCurveParam, mPanParam, mTableParam;
 
   // Initialize voice. This function will nly be called once per voice
   void init() override {
@@ -42,27 +66,31 @@ public:
     // We have the mesh be a sphere
     addDisc(mMesh, 1.0, 30);
 
-    createInternalTriggerParameter("amplitude", 0.1, 0.0, 1.0);
-    createInternalTriggerParameter("frequency", 60, 20, 5000);
-    createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
-    createInternalTriggerParameter("releaseTime", 3.0, 0.1, 10.0);
-    createInternalTriggerParameter("sustain", 0.7, 0.0, 1.0);
-    createInternalTriggerParameter("curve", 4.0, -10.0, 10.0);
-    createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
-    createInternalTriggerParameter("table", 0, 0, 8);
+    mAmplitudeParam =
+        createInternalTriggerParameter("amplitude", 0.1, 0.0, 1.0);
+    mFrequencyParam = createInternalTriggerParameter("frequency", 60, 20, 5000);
+    mAttackTimeParam =
+        createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
+    mReleaseTimeParam =
+        createInternalTriggerParameter("releaseTime", 3.0, 0.1, 10.0);
+    mSustainParam = createInternalTriggerParameter("sustain", 0.7, 0.0, 1.0);
+    mCurveParam = createInternalTriggerParameter("curve", 4.0, -10.0, 10.0);
+    mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+    mTableParam = createInternalTriggerParameter("table", 0, 0, 8);
   }
 
   //
   virtual void onProcess(AudioIOData &io) override {
     updateFromParameters();
-    while (io()) {
-      float s1 =
-          0.1 * mOsc() * mAmpEnv() * getInternalParameterValue("amplitude");
-      float s2;
-      mEnvFollow(s1);
-      mPan(s1, s1, s2);
-      io.out(0) += s1;
-      io.out(1) += s2;
+    for (int n; (n = renderBlock(mOsc, io, mOscBlock)) > 0;) {
+      for (int i = 0; i < n && io(); ++i) {
+        float s1 = 0.1 * mOscBlock[i] * mAmpEnv() * mAmplitudeParam.get();
+        float s2;
+        mEnvFollow(s1);
+        mPan(s1, s1, s2);
+        io.out(0) += s1;
+        io.out(1) += s2;
+      }
     }
     // We need to let the synth know that this voice is done
     // by calling the free(). This takes the voice out of the
@@ -72,8 +100,8 @@ public:
   }
 
   void onProcess(Graphics &g) override {
-    float frequency = getInternalParameterValue("frequency");
-    float amplitude = getInternalParameterValue("amplitude");
+    float frequency = mFrequencyParam.get();
+    float amplitude = mAmplitudeParam.get();
     g.pushMatrix();
     g.translate(amplitude + frequency / 2000, amplitude / 2 + frequency / 2000,
                 -4);
@@ -87,47 +115,19 @@ public:
     mAmpEnv.reset();
     updateFromParameters();
     // Map table number to table in memory
-    switch (int(getInternalParameterValue("table"))) {
-    case 0:
-      mOsc.source(tbSaw);
-      break;
-    case 1:
-      mOsc.source(tbSqr);
-      break;
-    case 2:
-      mOsc.source(tbImp);
-      break;
-    case 3:
-      mOsc.source(tbSin);
-      break;
-    case 4:
-      mOsc.source(tbPls);
-      break;
-    case 5:
-      mOsc.source(tb__1);
-      break;
-    case 6:
-      mOsc.source(tb__2);
-      break;
-    case 7:
-      mOsc.source(tb__3);
-      break;
-    case 8:
-      mOsc.source(tb__4);
-      break;
-    }
+    mOsc.source(int(mTableParam.get()));
   }
 
   virtual void onTriggerOff() override { mAmpEnv.triggerRelease(); }
 
   void updateFromParameters() {
-    mOsc.freq(getInternalParameterValue("frequency"));
-    mAmpEnv.attack(getInternalParameterValue("attackTime"));
-    mAmpEnv.decay(getInternalParameterValue("attackTime"));
-    mAmpEnv.release(getInternalParameterValue("releaseTime"));
-    mAmpEnv.sustain(getInternalParameterValue("sustain"));
-    mAmpEnv.curve(getInternalParameterValue("curve"));
-    mPan.pos(getInternalParameterValue("pan"));
+    mOsc.freq(mFrequencyParam.get());
+    mAmpEnv.attack(mAttackTimeParam.get());
+    mAmpEnv.decay(mAttackTimeParam.get());
+    mAmpEnv.release(mReleaseTimeParam.get());
+    mAmpEnv.sustain(mSustainParam.get());
+    mAmpEnv.curve(mCurveParam.get());
+    mPan.pos(mPanParam.get());
   }
 };
 
@@ -146,6 +146,11 @@ public:
   // Additional members
   Mesh mMesh;
 
+  // Handles to the parameters read below, set in init()
+  VoiceParameter mAmplitudeParam, mFrequencyParam, mAttackTimeParam,
+      mReleaseTimeParam, mCurveParam, mPanParam, mTableParam, mVibRate1Param,
+      mVibRate2Param, mVibRiseParam, mVibDepthParam;
+
   void init() override {
     mAmpEnv.curve(0); // linear segments
     mAmpEnv.levels(0, 1, 1, 0);
@@ -154,23 +159,27 @@ public:
     // We have the mesh be a sphere
     addDisc(mMesh, 1.0, 30);
 
-    createInternalTriggerParameter("amplitude", 0.1, 0.0, 1.0);
-    createInternalTriggerParameter("frequency", 60, 20, 5000);
-    createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
-    createInternalTriggerParameter("releaseTime", 3.0, 0.1, 10.0);
-    createInternalTriggerParameter("curve", 4.0, -10.0, 10.0);
-    createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
-    createInternalTriggerParameter("table", 0, 0, 8);
-    createInternalTriggerParameter("vibRate1", 3.5, 0.2, 20);
-    createInternalTriggerParameter("vibRate2", 5.8, 0.2, 20);
-    createInternalTriggerParameter("vibRise", 0.5, 0.1, 2);
-    createInternalTriggerParameter("vibDepth", 0.005, 0.0, 0.3);
+    mAmplitudeParam =
+        createInternalTriggerParameter("amplitude", 0.1, 0.0, 1.0);
+    mFrequencyParam = createInternalTriggerParameter("frequency", 60, 20, 5000);
+    mAttackTimeParam =
+        createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
+    mReleaseTimeParam =
+        createInternalTriggerParameter("releaseTime", 3.0, 0.1, 10.0);
+    mCurveParam = createInternalTriggerParameter("curve", 4.0, -10.0, 10.0);
+    mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+    mTableParam = createInternalTriggerParameter("table", 0, 0, 8);
+    mVibRate1Param = createInternalTriggerParameter("vibRate1", 3.5, 0.2, 20);
+    mVibRate2Param = createInternalTriggerParameter("vibRate2", 5.8, 0.2, 20);
+    mVibRiseParam = createInternalTriggerParameter("vibRise", 0.5, 0.1, 2);
+    mVibDepthParam =
+        createInternalTriggerParameter("vibDepth", 0.005, 0.0, 0.3);
   }
 
   void onProcess(AudioIOData &io) override {
-    float oscFreq = getInternalParameterValue("frequency");
-    float amp = getInternalParameterValue("amplitude");
-    float vibDepth = getInternalParameterValue("vibDepth");
+    float oscFreq = mFrequencyParam.get();
+    float amp = mAmplitudeParam.get();
+    float vibDepth = mVibDepthParam.get();
     while (io()) {
       mVib.freq(mVibEnv());
       vibValue = mVib();
@@ -189,11 +198,11 @@ public:
   }
 
   void onProcess(Graphics &g) override {
-    float frequency = getInternalParameterValue("frequency");
-    float amplitude = getInternalParameterValue("amplitude");
+    float frequency = mFrequencyParam.get();
+    float amplitude = mAmplitudeParam.get();
     g.pushMatrix();
     g.translate(amplitude, amplitude, -4);
-    float scaling = vibValue + getInternalParameterValue("vibDepth");
+    float scaling = vibValue + mVibDepthParam.get();
     g.scale(scaling * frequency / 200, scaling * frequency / 400, scaling * 1);
     g.color(mEnvFollow.value(), frequency / 1000, mEnvFollow.value() * 10, 0.4);
     g.draw(mMesh);
@@ -207,35 +216,7 @@ public:
     mAmpEnv.reset();
     mVibEnv.reset();
     // Map table number to table in memory
-    switch (int(getInternalParameterValue("table"))) {
-    case 0:
-      mOsc.source(tbSaw);
-      break;
-    case 1:
-      mOsc.source(tbSqr);
-      break;
-    case 2:
-      mOsc.source(tbImp);
-      break;
-    case 3:
-      mOsc.source(tbSin);
-      break;
-    case 4:
-      mOsc.source(tbPls);
-      break;
-    case 5:
-      mOsc.source(tb__1);
-      break;
-    case 6:
-      mOsc.source(tb__2);
-      break;
-    case 7:
-      mOsc.source(tb__3);
-      break;
-    case 8:
-      mOsc.source(tb__4);
-      break;
-    }
+    mOsc.source(WavetableBank::shared().table(int(mTableParam.get())));
   }
 
   void onTriggerOff() override {
@@ -244,19 +225,17 @@ public:
   }
 
   void updateFromParameters() {
-    mOsc.freq(getInternalParameterValue("frequency"));
-    mAmpEnv.attack(getInternalParameterValue("attackTime"));
-    mAmpEnv.decay(getInternalParameterValue("attackTime"));
-    mAmpEnv.release(getInternalParameterValue("releaseTime"));
-    mAmpEnv.curve(getInternalParameterValue("curve"));
-    mPan.pos(getInternalParameterValue("pan"));
-    mVibEnv.levels(getInternalParameterValue("vibRate1"),
-                   getInternalParameterValue("vibRate2"),
-                   getInternalParameterValue("vibRate2"),
-                   getInternalParameterValue("vibRate1"));
-    mVibEnv.lengths()[0] = getInternalParameterValue("vibRise");
-    mVibEnv.lengths()[1] = getInternalParameterValue("vibRise");
-    mVibEnv.lengths()[3] = getInternalParameterValue("vibRise");
+    mOsc.freq(mFrequencyParam.get());
+    mAmpEnv.attack(mAttackTimeParam.get());
+    mAmpEnv.decay(mAttackTimeParam.get());
+    mAmpEnv.release(mReleaseTimeParam.get());
+    mAmpEnv.curve(mCurveParam.get());
+    mPan.pos(mPanParam.get());
+    mVibEnv.levels(mVibRate1Param.get(), mVibRate2Param.get(),
+                   mVibRate2Param.get(), mVibRate1Param.get());
+    mVibEnv.lengths()[0] = mVibRiseParam.get();
+    mVibEnv.lengths()[1] = mVibRiseParam.get();
+    mVibEnv.lengths()[3] = mVibRiseParam.get();
   }
 };
 
@@ -279,6 +258,12 @@ public:
   float mVibDepth;
   float mVibRise;
 
+  // Handles to the parameters read below, set in init()
+  VoiceParameter mFrequencyParam, mAmplitudeParam, mAttackTimeParam,
+      mReleaseTimeParam, mSustainParam, mIdx1Param, mIdx2Param, mIdx3Param,
+      mCarMulParam, mModMulParam, mVibRate1Param, mVibRate2Param, mVibRiseParam,
+      mVibDepthParam, mPanParam;
+
   void init() override {
     //      mAmpEnv.curve(0); // linear segments
 
@@ -290,37 +275,40 @@ public:
     // We have the mesh be a sphere
     addDisc(mMesh, 1.0, 30);
 
-    createInternalTriggerParameter("frequency", 440, 10, 4000.0);
-    createInternalTriggerParameter("amplitude", 0.5, 0.0, 1.0);
-    createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
-    createInternalTriggerParameter("releaseTime", 0.1, 0.1, 10.0);
-    createInternalTriggerParameter("sustain", 0.75, 0.1, 1.0);
+    mFrequencyParam =
+        createInternalTriggerParameter("frequency", 440, 10, 4000.0);
+    mAmplitudeParam =
+        createInternalTriggerParameter("amplitude", 0.5, 0.0, 1.0);
+    mAttackTimeParam =
+        createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
+    mReleaseTimeParam =
+        createInternalTriggerParameter("releaseTime", 0.1, 0.1, 10.0);
+    mSustainParam = createInternalTriggerParameter("sustain", 0.75, 0.1, 1.0);
 
     // FM index
-    createInternalTriggerParameter("idx1", 0.01, 0.0, 10.0);
-    createInternalTriggerParameter("idx2", 7, 0.0, 10.0);
-    createInternalTriggerParameter("idx3", 5, 0.0, 10.0);
+    mIdx1Param = createInternalTriggerParameter("idx1", 0.01, 0.0, 10.0);
+    mIdx2Param = createInternalTriggerParameter("idx2", 7, 0.0, 10.0);
+    mIdx3Param = createInternalTriggerParameter("idx3", 5, 0.0, 10.0);
 
-    createInternalTriggerParameter("carMul", 1, 0.0, 20.0);
-    createInternalTriggerParameter("modMul", 1.0007, 0.0, 20.0);
+    mCarMulParam = createInternalTriggerParameter("carMul", 1, 0.0, 20.0);
+    mModMulParam = createInternalTriggerParameter("modMul", 1.0007, 0.0, 20.0);
 
-    createInternalTriggerParameter("vibRate1", 0.01, 0.0, 10.0);
-    createInternalTriggerParameter("vibRate2", 0.5, 0.0, 10.0);
-    createInternalTriggerParameter("vibRise", 0, 0.0, 10.0);
-    createInternalTriggerParameter("vibDepth", 0, 0.0, 10.0);
+    mVibRate1Param =
+        createInternalTriggerParameter("vibRate1", 0.01, 0.0, 10.0);
+    mVibRate2Param = createInternalTriggerParameter("vibRate2", 0.5, 0.0, 10.0);
+    mVibRiseParam = createInternalTriggerParameter("vibRise", 0, 0.0, 10.0);
+    mVibDepthParam = createInternalTriggerParameter("vibDepth", 0, 0.0, 10.0);
 
-    createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+    mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
   }
 
   //
   void onProcess(AudioIOData &io) override {
     updateFromParameters();
     mVib.freq(mVibEnv());
-    float carBaseFreq = getInternalParameterValue("frequency") *
-                        getInternalParameterValue("carMul");
-    float modScale = getInternalParameterValue("frequency") *
-                     getInternalParameterValue("modMul");
-    float amp = getInternalParameterValue("amplitude");
+    float carBaseFreq = mFrequencyParam.get() * mCarMulParam.get();
+    float modScale = mFrequencyParam.get() * mModMulParam.get();
+    float amp = mAmplitudeParam.get();
     while (io()) {
       mVib.freq(mVibEnv());
       car.freq((1 + mVib() * mVibDepth) * carBaseFreq +
@@ -338,16 +326,11 @@ public:
 
   void onProcess(Graphics &g) override {
     g.pushMatrix();
-    g.translate(getInternalParameterValue("frequency") / 300 - 2,
-                (getInternalParameterValue("idx3") +
-                 getInternalParameterValue("idx2")) /
-                        15 -
-                    1,
-                -4);
-    float scaling = getInternalParameterValue("amplitude") / 3;
+    g.translate(mFrequencyParam.get() / 300 - 2,
+                (mIdx3Param.get() + mIdx2Param.get()) / 15 - 1, -4);
+    float scaling = mAmplitudeParam.get() / 3;
     g.scale(scaling, scaling, scaling * 1);
-    g.color(HSV(getInternalParameterValue("modMul") / 20, 1,
-                mEnvFollow.value() * 10));
+    g.color(HSV(mModMulParam.get() / 20, 1, mEnvFollow.value() * 10));
     g.draw(mMesh);
     g.popMatrix();
   }
@@ -355,8 +338,7 @@ public:
   void onTriggerOn() override {
     updateFromParameters();
 
-    float modFreq = getInternalParameterValue("frequency") *
-                    getInternalParameterValue("modMul");
+    float modFreq = mFrequencyParam.get() * mModMulParam.get();
     mod.freq(modFreq);
 
     mVibEnv.lengths()[0] = mDur * (1 - mVibRise);
@@ -372,28 +354,28 @@ public:
   }
 
   void updateFromParameters() {
-    mModEnv.levels()[0] = getInternalParameterValue("idx1");
-    mModEnv.levels()[1] = getInternalParameterValue("idx2");
-    mModEnv.levels()[2] = getInternalParameterValue("idx2");
-    mModEnv.levels()[3] = getInternalParameterValue("idx3");
+    mModEnv.levels()[0] = mIdx1Param.get();
+    mModEnv.levels()[1] = mIdx2Param.get();
+    mModEnv.levels()[2] = mIdx2Param.get();
+    mModEnv.levels()[3] = mIdx3Param.get();
 
     mAmpEnv.levels()[1] = 1.0;
     // mAmpEnv.levels()[2] = 1.0;
-    mAmpEnv.levels()[2] = getInternalParameterValue("sustain");
+    mAmpEnv.levels()[2] = mSustainParam.get();
 
-    mAmpEnv.lengths()[0] = getInternalParameterValue("attackTime");
-    mModEnv.lengths()[0] = getInternalParameterValue("attackTime");
+    mAmpEnv.lengths()[0] = mAttackTimeParam.get();
+    mModEnv.lengths()[0] = mAttackTimeParam.get();
 
-    mAmpEnv.lengths()[3] = getInternalParameterValue("releaseTime");
-    mModEnv.lengths()[3] = getInternalParameterValue("releaseTime");
+    mAmpEnv.lengths()[3] = mReleaseTimeParam.get();
+    mModEnv.lengths()[3] = mReleaseTimeParam.get();
 
     mAmpEnv.totalLength(getInternalParameterValue("dur"), 1);
     mModEnv.lengths()[1] = mAmpEnv.lengths()[1];
-    mVibEnv.levels()[1] = getInternalParameterValue("vibRate1");
-    mVibEnv.levels()[2] = getInternalParameterValue("vibRate2");
-    mVibDepth = getInternalParameterValue("vibDepth");
-    mVibRise = getInternalParameterValue("vibRise");
-    mPan.pos(getInternalParameterValue("pan"));
+    mVibEnv.levels()[1] = mVibRate1Param.get();
+    mVibEnv.levels()[2] = mVibRate2Param.get();
+    mVibDepth = mVibDepthParam.get();
+    mVibRise = mVibRiseParam.get();
+    mPan.pos(mPanParam.get());
   }
 };
 
@@ -402,7 +384,7 @@ public:
   // Unit generators
   gam::Pan<> mPan;
   gam::Sine<> mTrm;
-  gam::Osc<> mOsc;
+  MipOsc mOsc;
   gam::ADSR<> mTrmEnv;
   // gam::Env<2> mTrmEnv;
   gam::ADSR<> mAmpEnv;
@@ -411,6 +393,12 @@ public:
 
   // Additional members
   Mesh mMesh;
+  float mOscBlock[MipOsc::BLOCK]; // mOsc's next samples
+
+  // Handles to the parameters read below, set in init()
+  VoiceParameter mAmplitudeParam, mFrequencyParam, mAttackTimeParam,
+      mReleaseTimeParam, mSustainParam, mCurveParam, mPanParam, mTableParam,
+      mTrm1Param, mTrm2Param, mTrmRiseParam, mTrmDepthParam;
 
   // Initialize voice. This function will nly be called once per voice
   virtual void init() {
@@ -430,37 +418,42 @@ public:
     // We have the mesh be a sphere
     addDisc(mMesh, 1.0, 30);
 
-    createInternalTriggerParameter("amplitude", 0.3, 0.0, 1.0);
-    createInternalTriggerParameter("frequency", 60, 20, 5000);
-    createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
-    createInternalTriggerParameter("releaseTime", 3.0, 0.1, 10.0);
-    createInternalTriggerParameter("sustain", 0.7, 0.0, 1.0);
-    createInternalTriggerParameter("curve", 4.0, -10.0, 10.0);
-    createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
-    createInternalTriggerParameter("table", 0, 0, 8);
-    createInternalTriggerParameter("trm1", 3.5, 0.2, 20);
-    createInternalTriggerParameter("trm2", 5.8, 0.2, 20);
-    createInternalTriggerParameter("trmRise", 0.5, 0.1, 2);
-    createInternalTriggerParameter("trmDepth", 0.1, 0.0, 1.0);
+    mAmplitudeParam =
+        createInternalTriggerParameter("amplitude", 0.3, 0.0, 1.0);
+    mFrequencyParam = createInternalTriggerParameter("frequency", 60, 20, 5000);
+    mAttackTimeParam =
+        createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
+    mReleaseTimeParam =
+        createInternalTriggerParameter("releaseTime", 3.0, 0.1, 10.0);
+    mSustainParam = createInternalTriggerParameter("sustain", 0.7, 0.0, 1.0);
+    mCurveParam = createInternalTriggerParameter("curve", 4.0, -10.0, 10.0);
+    mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+    mTableParam = createInternalTriggerParameter("table", 0, 0, 8);
+    mTrm1Param = createInternalTriggerParameter("trm1", 3.5, 0.2, 20);
+    mTrm2Param = createInternalTriggerParameter("trm2", 5.8, 0.2, 20);
+    mTrmRiseParam = createInternalTriggerParameter("trmRise", 0.5, 0.1, 2);
+    mTrmDepthParam = createInternalTriggerParameter("trmDepth", 0.1, 0.0, 1.0);
   }
 
   //
   virtual void onProcess(AudioIOData &io) override {
     // updateFromParameters();
-    float amp = getInternalParameterValue("amplitude");
-    float trmDepth = getInternalParameterValue("trmDepth");
-    while (io()) {
-
-      mTrm.freq(mTrmEnv());
-      // float trmAmp = mAmp - mTrm()*mTrmDepth; // Replaced with line below
-      float trmAmp =
-          (mTrm() * 0.5 + 0.5) * trmDepth + (1 - trmDepth); // Corrected
-      float s1 = mOsc() * mAmpEnv() * trmAmp * amp;
-      float s2;
-      mEnvFollow(s1);
-      mPan(s1, s1, s2);
-      io.out(0) += s1;
-      io.out(1) += s2;
+    float amp = mAmplitudeParam.get();
+    float trmDepth = mTrmDepthParam.get();
+    for (int n; (n = renderBlock(mOsc, io, mOscBlock)) > 0;) {
+      for (int i = 0; i < n && io(); ++i) {
+
+        mTrm.freq(mTrmEnv());
+        // float trmAmp = mAmp - mTrm()*mTrmDepth; // Replaced with line below
+        float trmAmp =
+            (mTrm() * 0.5 + 0.5) * trmDepth + (1 - trmDepth); // Corrected
+        float s1 = mOscBlock[i] * mAmpEnv() * trmAmp * amp;
+        float s2;
+        mEnvFollow(s1);
+        mPan(s1, s1, s2);
+        io.out(0) += s1;
+        io.out(1) += s2;
+      }
     }
     // We need to let the synth know that this voice is done
     // by calling the free(). This takes the voice out of the
@@ -470,12 +463,12 @@ public:
   }
 
   virtual void onProcess(Graphics &g) {
-    float frequency = getInternalParameterValue("frequency");
-    float amplitude = getInternalParameterValue("amplitude");
+    float frequency = mFrequencyParam.get();
+    float amplitude = mAmplitudeParam.get();
     g.pushMatrix();
     g.translate(amplitude, amplitude, -4);
     // g.scale(frequency/2000, frequency/4000, 1);
-    float scaling = getInternalParameterValue("trmDepth");
+    float scaling = mTrmDepthParam.get();
     g.scale(scaling * frequency / 200, scaling * frequency / 400, scaling * 1);
     g.color(mEnvFollow.value(), frequency / 1000, mEnvFollow.value() * 10, 0.4);
     g.draw(mMesh);
@@ -489,35 +482,7 @@ public:
     mTrmEnv.reset();
 
     // Map table number to table in memory
-    switch (int(getInternalParameterValue("table"))) {
-    case 0:
-      mOsc.source(tbSaw);
-      break;
-    case 1:
-      mOsc.source(tbSqr);
-      break;
-    case 2:
-      mOsc.source(tbImp);
-      break;
-    case 3:
-      mOsc.source(tbSin);
-      break;
-    case 4:
-      mOsc.source(tbPls);
-      break;
-    case 5:
-      mOsc.source(tb__1);
-      break;
-    case 6:
-      mOsc.source(tb__2);
-      break;
-    case 7:
-      mOsc.source(tb__3);
-      break;
-    case 8:
-      mOsc.source(tb__4);
-      break;
-    }
+    mOsc.source(int(mTableParam.get()));
   }
 
   virtual void onTriggerOff() override {
@@ -526,27 +491,26 @@ public:
   }
 
   void updateFromParameters() {
-    mOsc.freq(getInternalParameterValue("frequency"));
-    mAmpEnv.attack(getInternalParameterValue("attackTime"));
-    mAmpEnv.decay(getInternalParameterValue("attackTime"));
-    mAmpEnv.release(getInternalParameterValue("releaseTime"));
-    mAmpEnv.sustain(getInternalParameterValue("sustain"));
-    mAmpEnv.curve(getInternalParameterValue("curve"));
-    mPan.pos(getInternalParameterValue("pan"));
-
-    mTrmEnv.levels(
-        getInternalParameterValue("trm1"), getInternalParameterValue("trm2"),
-        getInternalParameterValue("trm2"), getInternalParameterValue("trm1"));
-
-    mTrmEnv.attack(getInternalParameterValue("trmRise"));
-    mTrmEnv.decay(getInternalParameterValue("trmRise"));
-    mTrmEnv.release(getInternalParameterValue("trmRise"));
+    mOsc.freq(mFrequencyParam.get());
+    mAmpEnv.attack(mAttackTimeParam.get());
+    mAmpEnv.decay(mAttackTimeParam.get());
+    mAmpEnv.release(mReleaseTimeParam.get());
+    mAmpEnv.sustain(mSustainParam.get());
+    mAmpEnv.curve(mCurveParam.get());
+    mPan.pos(mPanParam.get());
+
+    mTrmEnv.levels(mTrm1Param.get(), mTrm2Param.get(), mTrm2Param.get(),
+                   mTrm1Param.get());
+
+    mTrmEnv.attack(mTrmRiseParam.get());
+    mTrmEnv.decay(mTrmRiseParam.get());
+    mTrmEnv.release(mTrmRiseParam.get());
   }
 };
 
 class OscAM : public SynthVoice {
 public:
-  gam::Osc<> mAM;
+  MipOsc mAM;
   gam::ADSR<> mAMEnv;
   gam::Sine<> mOsc;
   gam::ADSR<> mAmpEnv;
@@ -554,6 +518,12 @@ public:
   gam::Pan<> mPan;
 
   Mesh mMesh;
+  float mAMBlock[MipOsc::BLOCK]; // mAM's next samples
+
+  // Handles to the parameters read below, set in init()
+  VoiceParameter mAmplitudeParam, mFrequencyParam, mAttackTimeParam,
+      mReleaseTimeParam, mSustainParam, mPanParam, mAmFuncParam, mAm1Param,
+      mAm2Param, mAmRiseParam, mAmRatioParam;
 
   // Initialize voice. This function will nly be called once per voice
   virtual void init() {
@@ -567,40 +537,46 @@ public:
     // We have the mesh be a sphere
     addDisc(mMesh, 1.0, 30);
 
-    createInternalTriggerParameter("amplitude", 0.5, 0.0, 1.0);
-    createInternalTriggerParameter("frequency", 440, 10, 4000.0);
-    createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
-    createInternalTriggerParameter("releaseTime", 0.1, 0.1, 10.0);
-    createInternalTriggerParameter("sustain", 0.75, 0.1, 1.0);
-    createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
-    createInternalTriggerParameter("amFunc", 0.0, 0.0, 3.0);
-    createInternalTriggerParameter("am1", 0.75, 0.1, 1.0);
-    createInternalTriggerParameter("am2", 0.75, 0.1, 1.0);
-    createInternalTriggerParameter("amRise", 0.75, 0.1, 1.0);
-    createInternalTriggerParameter("amRatio", 0.75, 0.1, 2.0);
+    mAmplitudeParam =
+        createInternalTriggerParameter("amplitude", 0.5, 0.0, 1.0);
+    mFrequencyParam =
+        createInternalTriggerParameter("frequency", 440, 10, 4000.0);
+    mAttackTimeParam =
+        createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
+    mReleaseTimeParam =
+        createInternalTriggerParameter("releaseTime", 0.1, 0.1, 10.0);
+    mSustainParam = createInternalTriggerParameter("sustain", 0.75, 0.1, 1.0);
+    mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+    mAmFuncParam = createInternalTriggerParameter("amFunc", 0.0, 0.0, 3.0);
+    mAm1Param = createInternalTriggerParameter("am1", 0.75, 0.1, 1.0);
+    mAm2Param = createInternalTriggerParameter("am2", 0.75, 0.1, 1.0);
+    mAmRiseParam = createInternalTriggerParameter("amRise", 0.75, 0.1, 1.0);
+    mAmRatioParam = createInternalTriggerParameter("amRatio", 0.75, 0.1, 2.0);
   }
 
   virtual void onProcess(AudioIOData &io) override {
-    mOsc.freq(getInternalParameterValue("frequency"));
+    mOsc.freq(mFrequencyParam.get());
 
-    float amp = getInternalParameterValue("amplitude");
-    float amRatio = getInternalParameterValue("amRatio");
-    while (io()) {
+    float amp = mAmplitudeParam.get();
+    float amRatio = mAmRatioParam.get();
+    mAM.freq(mOsc.freq() * amRatio); // set AM freq according to ratio
+    for (int n; (n = renderBlock(mAM, io, mAMBlock)) > 0;) {
+      for (int i = 0; i < n && io(); ++i) {
 
-      mAM.freq(mOsc.freq() * amRatio); // set AM freq according to ratio
-      float amAmt = mAMEnv();          // AM amount envelope
+        float amAmt = mAMEnv(); // AM amount envelope
 
-      float s1 = mOsc(); // non-modulated signal
-      s1 = s1 * (1 - amAmt) +
-           (s1 * mAM()) * amAmt; // mix modulated and non-modulated
+        float s1 = mOsc(); // non-modulated signal
+        s1 = s1 * (1 - amAmt) +
+             (s1 * mAMBlock[i]) * amAmt; // mix modulated and non-modulated
 
-      s1 *= mAmpEnv() * amp;
+        s1 *= mAmpEnv() * amp;
 
-      float s2;
-      mEnvFollow(s1);
-      mPan(s1, s1, s2);
-      io.out(0) += s1;
-      io.out(1) += s2;
+        float s2;
+        mEnvFollow(s1);
+        mPan(s1, s1, s2);
+        io.out(0) += s1;
+        io.out(1) += s2;
+      }
     }
     // We need to let the synth know that this voice is done
     // by calling the free(). This takes the voice out of the
@@ -610,8 +586,8 @@ public:
   }
 
   virtual void onProcess(Graphics &g) {
-    float frequency = getInternalParameterValue("frequency");
-    float amplitude = getInternalParameterValue("amplitude");
+    float frequency = mFrequencyParam.get();
+    float amplitude = mAmplitudeParam.get();
     g.pushMatrix();
     g.translate(amplitude, amplitude, -4);
     // g.scale(frequency/2000, frequency/4000, 1);
@@ -623,37 +599,35 @@ public:
   }
 
   virtual void onTriggerOn() override {
-    mAmpEnv.attack(getInternalParameterValue("attackTime"));
+    mAmpEnv.attack(mAttackTimeParam.get());
     mAmpEnv.lengths()[1] = 0.001;
-    mAmpEnv.release(getInternalParameterValue("releaseTime"));
+    mAmpEnv.release(mReleaseTimeParam.get());
 
-    mAmpEnv.levels()[1] = getInternalParameterValue("sustain");
-    mAmpEnv.levels()[2] = getInternalParameterValue("sustain");
+    mAmpEnv.levels()[1] = mSustainParam.get();
+    mAmpEnv.levels()[2] = mSustainParam.get();
 
-    mAMEnv.levels(
-        getInternalParameterValue("am1"), getInternalParameterValue("am2"),
-        getInternalParameterValue("am2"), getInternalParameterValue("am1"));
+    mAMEnv.levels(mAm1Param.get(), mAm2Param.get(), mAm2Param.get(),
+                  mAm1Param.get());
 
-    mAMEnv.lengths(getInternalParameterValue("amRise"),
-                   1 - getInternalParameterValue("amRise"));
+    mAMEnv.lengths(mAmRiseParam.get(), 1 - mAmRiseParam.get());
 
-    mPan.pos(getInternalParameterValue("pan"));
+    mPan.pos(mPanParam.get());
 
     mAmpEnv.reset();
     mAMEnv.reset();
     // Map table number to table in memory
-    switch (int(getInternalParameterValue("amFunc"))) {
+    switch (int(mAmFuncParam.get())) {
     case 0:
-      mAM.source(tbSin);
+      mAM.source(WavetableBank::SINE);
       break;
     case 1:
-      mAM.source(tbSqr);
+      mAM.source(WavetableBank::SQUARE);
       break;
     case 2:
-      mAM.source(tbPls);
+      mAM.source(WavetableBank::PULSE);
       break;
     case 3:
-      mAM.source(tbDin);
+      mAM.source(WavetableBank::PARTIALS_3);
       break;
     }
   }
@@ -685,6 +659,14 @@ public:
   // Additional members
   Mesh mMesh;
 
+  // Handles to the parameters read below, set in init()
+  VoiceParameter mAmpParam, mFrequencyParam, mAmpStriParam, mAttackStriParam,
+      mReleaseStriParam, mSustainStriParam, mAmpLowParam, mAttackLowParam,
+      mReleaseLowParam, mSustainLowParam, mAmpUpParam, mAttackUpParam,
+      mReleaseUpParam, mSustainUpParam, mFreqStri1Param, mFreqStri2Param,
+      mFreqStri3Param, mFreqLow1Param, mFreqLow2Param, mFreqUp1Param,
+      mFreqUp2Param, mFreqUp3Param, mFreqUp4Param, mPanParam;
+
   virtual void init() {
 
     // Intialize envelopes
@@ -704,50 +686,60 @@ public:
     // We have the mesh be a sphere
     addDisc(mMesh, 1.0, 30);
 
-    createInternalTriggerParameter("amp", 0.01, 0.0, 0.3);
-    createInternalTriggerParameter("frequency", 60, 20, 5000);
-    createInternalTriggerParameter("ampStri", 0.5, 0.0, 1.0);
-    createInternalTriggerParameter("attackStri", 0.1, 0.01, 3.0);
-    createInternalTriggerParameter("releaseStri", 0.1, 0.1, 10.0);
-    createInternalTriggerParameter("sustainStri", 0.8, 0.0, 1.0);
-    createInternalTriggerParameter("ampLow", 0.5, 0.0, 1.0);
-    createInternalTriggerParameter("attackLow", 0.001, 0.01, 3.0);
-    createInternalTriggerParameter("releaseLow", 0.1, 0.1, 10.0);
-    createInternalTriggerParameter("sustainLow", 0.8, 0.0, 1.0);
-    createInternalTriggerParameter("ampUp", 0.6, 0.0, 1.0);
-    createInternalTriggerParameter("attackUp", 0.01, 0.01, 3.0);
-    createInternalTriggerParameter("releaseUp", 0.075, 0.1, 10.0);
-    createInternalTriggerParameter("sustainUp", 0.9, 0.0, 1.0);
-    createInternalTriggerParameter("freqStri1", 1.0, 0.1, 10);
-    createInternalTriggerParameter("freqStri2", 2.001, 0.1, 10);
-    createInternalTriggerParameter("freqStri3", 3.0, 0.1, 10);
-    createInternalTriggerParameter("freqLow1", 4.009, 0.1, 10);
-    createInternalTriggerParameter("freqLow2", 5.002, 0.1, 10);
-    createInternalTriggerParameter("freqUp1", 6.0, 0.1, 10);
-    createInternalTriggerParameter("freqUp2", 7.0, 0.1, 10);
-    createInternalTriggerParameter("freqUp3", 8.0, 0.1, 10);
-    createInternalTriggerParameter("freqUp4", 9.0, 0.1, 10);
-    createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+    mAmpParam = createInternalTriggerParameter("amp", 0.01, 0.0, 0.3);
+    mFrequencyParam = createInternalTriggerParameter("frequency", 60, 20, 5000);
+    mAmpStriParam = createInternalTriggerParameter("ampStri", 0.5, 0.0, 1.0);
+    mAttackStriParam =
+        createInternalTriggerParameter("attackStri", 0.1, 0.01, 3.0);
+    mReleaseStriParam =
+        createInternalTriggerParameter("releaseStri", 0.1, 0.1, 10.0);
+    mSustainStriParam =
+        createInternalTriggerParameter("sustainStri", 0.8, 0.0, 1.0);
+    mAmpLowParam = createInternalTriggerParameter("ampLow", 0.5, 0.0, 1.0);
+    mAttackLowParam =
+        createInternalTriggerParameter("attackLow", 0.001, 0.01, 3.0);
+    mReleaseLowParam =
+        createInternalTriggerParameter("releaseLow", 0.1, 0.1, 10.0);
+    mSustainLowParam =
+        createInternalTriggerParameter("sustainLow", 0.8, 0.0, 1.0);
+    mAmpUpParam = createInternalTriggerParameter("ampUp", 0.6, 0.0, 1.0);
+    mAttackUpParam =
+        createInternalTriggerParameter("attackUp", 0.01, 0.01, 3.0);
+    mReleaseUpParam =
+        createInternalTriggerParameter("releaseUp", 0.075, 0.1, 10.0);
+    mSustainUpParam =
+        createInternalTriggerParameter("sustainUp", 0.9, 0.0, 1.0);
+    mFreqStri1Param = createInternalTriggerParameter("freqStri1", 1.0, 0.1, 10);
+    mFreqStri2Param =
+        createInternalTriggerParameter("freqStri2", 2.001, 0.1, 10);
+    mFreqStri3Param = createInternalTriggerParameter("freqStri3", 3.0, 0.1, 10);
+    mFreqLow1Param = createInternalTriggerParameter("freqLow1", 4.009, 0.1, 10);
+    mFreqLow2Param = createInternalTriggerParameter("freqLow2", 5.002, 0.1, 10);
+    mFreqUp1Param = createInternalTriggerParameter("freqUp1", 6.0, 0.1, 10);
+    mFreqUp2Param = createInternalTriggerParameter("freqUp2", 7.0, 0.1, 10);
+    mFreqUp3Param = createInternalTriggerParameter("freqUp3", 8.0, 0.1, 10);
+    mFreqUp4Param = createInternalTriggerParameter("freqUp4", 9.0, 0.1, 10);
+    mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
   }
 
   virtual void onProcess(AudioIOData &io) override {
     // Parameters will update values once per audio callback
-    float freq = getInternalParameterValue("frequency");
+    float freq = mFrequencyParam.get();
     mOsc.freq(freq);
-    mOsc1.freq(getInternalParameterValue("freqStri1") * freq);
-    mOsc2.freq(getInternalParameterValue("freqStri2") * freq);
-    mOsc3.freq(getInternalParameterValue("freqStri3") * freq);
-    mOsc4.freq(getInternalParameterValue("freqLow1") * freq);
-    mOsc5.freq(getInternalParameterValue("freqLow2") * freq);
-    mOsc6.freq(getInternalParameterValue("freqUp1") * freq);
-    mOsc7.freq(getInternalParameterValue("freqUp2") * freq);
-    mOsc8.freq(getInternalParameterValue("freqUp3") * freq);
-    mOsc9.freq(getInternalParameterValue("freqUp4") * freq);
-    mPan.pos(getInternalParameterValue("pan"));
-    float ampStri = getInternalParameterValue("ampStri");
-    float ampUp = getInternalParameterValue("ampUp");
-    float ampLow = getInternalParameterValue("ampLow");
-    float amp = getInternalParameterValue("amp");
+    mOsc1.freq(mFreqStri1Param.get() * freq);
+    mOsc2.freq(mFreqStri2Param.get() * freq);
+    mOsc3.freq(mFreqStri3Param.get() * freq);
+    mOsc4.freq(mFreqLow1Param.get() * freq);
+    mOsc5.freq(mFreqLow2Param.get() * freq);
+    mOsc6.freq(mFreqUp1Param.get() * freq);
+    mOsc7.freq(mFreqUp2Param.get() * freq);
+    mOsc8.freq(mFreqUp3Param.get() * freq);
+    mOsc9.freq(mFreqUp4Param.get() * freq);
+    mPan.pos(mPanParam.get());
+    float ampStri = mAmpStriParam.get();
+    float ampUp = mAmpUpParam.get();
+    float ampLow = mAmpLowParam.get();
+    float amp = mAmpParam.get();
     while (io()) {
       float s1 = (mOsc1() + mOsc2() + mOsc3()) * mEnvStri() * ampStri;
       s1 += (mOsc4() + mOsc5()) * mEnvLow() * ampLow;
@@ -766,7 +758,7 @@ public:
   }
 
   virtual void onProcess(Graphics &g) {
-    float frequency = getInternalParameterValue("frequency");
+    float frequency = mFrequencyParam.get();
     float amplitude = getInternalParameterValue("amplitude");
     g.pushMatrix();
     g.translate(amplitude, amplitude, -4);
@@ -780,22 +772,22 @@ public:
 
   virtual void onTriggerOn() override {
 
-    mEnvStri.attack(getInternalParameterValue("attackStri"));
-    mEnvStri.decay(getInternalParameterValue("attackStri"));
-    mEnvStri.sustain(getInternalParameterValue("sustainStri"));
-    mEnvStri.release(getInternalParameterValue("releaseStri"));
+    mEnvStri.attack(mAttackStriParam.get());
+    mEnvStri.decay(mAttackStriParam.get());
+    mEnvStri.sustain(mSustainStriParam.get());
+    mEnvStri.release(mReleaseStriParam.get());
 
-    mEnvLow.attack(getInternalParameterValue("attackLow"));
-    mEnvLow.decay(getInternalParameterValue("attackLow"));
-    mEnvLow.sustain(getInternalParameterValue("sustainLow"));
-    mEnvLow.release(getInternalParameterValue("releaseLow"));
+    mEnvLow.attack(mAttackLowParam.get());
+    mEnvLow.decay(mAttackLowParam.get());
+    mEnvLow.sustain(mSustainLowParam.get());
+    mEnvLow.release(mReleaseLowParam.get());
 
-    mEnvUp.attack(getInternalParameterValue("attackUp"));
-    mEnvUp.decay(getInternalParameterValue("attackUp"));
-    mEnvUp.sustain(getInternalParameterValue("sustainUp"));
-    mEnvUp.release(getInternalParameterValue("releaseUp"));
+    mEnvUp.attack(mAttackUpParam.get());
+    mEnvUp.decay(mAttackUpParam.get());
+    mEnvUp.sustain(mSustainUpParam.get());
+    mEnvUp.release(mReleaseUpParam.get());
 
-    mPan.pos(getInternalParameterValue("pan"));
+    mPan.pos(mPanParam.get());
 
     mEnvStri.reset();
     mEnvLow.reset();
@@ -826,6 +818,12 @@ public:
   // Additional members
   Mesh mMesh;
 
+  // Handles to the parameters read below, set in init()
+  VoiceParameter mAmplitudeParam, mFrequencyParam, mAttackTimeParam,
+      mReleaseTimeParam, mSustainParam, mCurveParam, mNoiseParam, mEnvDurParam,
+      mCf1Param, mCf2Param, mCfRiseParam, mBw1Param, mBw2Param, mBwRiseParam,
+      mHmnumParam, mHmampParam, mPanParam;
+
   // Initialize voice. This function will nly be called once per voice
   void init() override {
     mAmpEnv.curve(0); // linear segments
@@ -838,31 +836,34 @@ public:
     // We have the mesh be a sphere
     addDisc(mMesh, 1.0, 30);
 
-    createInternalTriggerParameter("amplitude", 0.3, 0.0, 1.0);
-    createInternalTriggerParameter("frequency", 60, 20, 5000);
-    createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
-    createInternalTriggerParameter("releaseTime", 3.0, 0.1, 10.0);
-    createInternalTriggerParameter("sustain", 0.7, 0.0, 1.0);
-    createInternalTriggerParameter("curve", 4.0, -10.0, 10.0);
-    createInternalTriggerParameter("noise", 0.0, 0.0, 1.0);
-    createInternalTriggerParameter("envDur", 1, 0.0, 5.0);
-    createInternalTriggerParameter("cf1", 400.0, 10.0, 5000);
-    createInternalTriggerParameter("cf2", 400.0, 10.0, 5000);
-    createInternalTriggerParameter("cfRise", 0.5, 0.1, 2);
-    createInternalTriggerParameter("bw1", 700.0, 10.0, 5000);
-    createInternalTriggerParameter("bw2", 900.0, 10.0, 5000);
-    createInternalTriggerParameter("bwRise", 0.5, 0.1, 2);
-    createInternalTriggerParameter("hmnum", 12.0, 5.0, 20.0);
-    createInternalTriggerParameter("hmamp", 1.0, 0.0, 1.0);
-    createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
+    mAmplitudeParam =
+        createInternalTriggerParameter("amplitude", 0.3, 0.0, 1.0);
+    mFrequencyParam = createInternalTriggerParameter("frequency", 60, 20, 5000);
+    mAttackTimeParam =
+        createInternalTriggerParameter("attackTime", 0.1, 0.01, 3.0);
+    mReleaseTimeParam =
+        createInternalTriggerParameter("releaseTime", 3.0, 0.1, 10.0);
+    mSustainParam = createInternalTriggerParameter("sustain", 0.7, 0.0, 1.0);
+    mCurveParam = createInternalTriggerParameter("curve", 4.0, -10.0, 10.0);
+    mNoiseParam = createInternalTriggerParameter("noise", 0.0, 0.0, 1.0);
+    mEnvDurParam = createInternalTriggerParameter("envDur", 1, 0.0, 5.0);
+    mCf1Param = createInternalTriggerParameter("cf1", 400.0, 10.0, 5000);
+    mCf2Param = createInternalTriggerParameter("cf2", 400.0, 10.0, 5000);
+    mCfRiseParam = createInternalTriggerParameter("cfRise", 0.5, 0.1, 2);
+    mBw1Param = createInternalTriggerParameter("bw1", 700.0, 10.0, 5000);
+    mBw2Param = createInternalTriggerParameter("bw2", 900.0, 10.0, 5000);
+    mBwRiseParam = createInternalTriggerParameter("bwRise", 0.5, 0.1, 2);
+    mHmnumParam = createInternalTriggerParameter("hmnum", 12.0, 5.0, 20.0);
+    mHmampParam = createInternalTriggerParameter("hmamp", 1.0, 0.0, 1.0);
+    mPanParam = createInternalTriggerParameter("pan", 0.0, -1.0, 1.0);
   }
 
   //
 
   virtual void onProcess(AudioIOData &io) override {
     updateFromParameters();
-    float amp = getInternalParameterValue("amplitude");
-    float noiseMix = getInternalParameterValue("noise");
+    float amp = mAmplitudeParam.get();
+    float noiseMix = mNoiseParam.get();
     while (io()) {
       // mix oscillator with noise
       float s1 = mOsc() * (1 - noiseMix) + mNoise() * noiseMix;
@@ -885,8 +886,8 @@ public:
   }
 
   virtual void onProcess(Graphics &g) {
-    float frequency = getInternalParameterValue("frequency");
-    float amplitude = getInternalParameterValue("amplitude");
+    float frequency = mFrequencyParam.get();
+    float amplitude = mAmplitudeParam.get();
     g.pushMatrix();
     g.translate(amplitude, amplitude, -4);
     // g.scale(frequency/2000, frequency/4000, 1);
@@ -910,31 +911,27 @@ public:
   }
 
   void updateFromParameters() {
-    mOsc.freq(getInternalParameterValue("frequency"));
-    mOsc.harmonics(getInternalParameterValue("hmnum"));
-    mOsc.ampRatio(getInternalParameterValue("hmamp"));
-    mAmpEnv.attack(getInternalParameterValue("attackTime"));
-    //    mAmpEnv.decay(getInternalParameterValue("attackTime"));
-    mAmpEnv.release(getInternalParameterValue("releaseTime"));
-    mAmpEnv.levels()[1] = getInternalParameterValue("sustain");
-    mAmpEnv.levels()[2] = getInternalParameterValue("sustain");
-
-    mAmpEnv.curve(getInternalParameterValue("curve"));
-    mPan.pos(getInternalParameterValue("pan"));
-    mCFEnv.levels(getInternalParameterValue("cf1"),
-                  getInternalParameterValue("cf2"),
-                  getInternalParameterValue("cf1"));
-
-    mCFEnv.lengths()[0] = getInternalParameterValue("cfRise");
-    mCFEnv.lengths()[1] = 1 - getInternalParameterValue("cfRise");
-    mBWEnv.levels(getInternalParameterValue("bw1"),
-                  getInternalParameterValue("bw2"),
-                  getInternalParameterValue("bw1"));
-    mBWEnv.lengths()[0] = getInternalParameterValue("bwRise");
-    mBWEnv.lengths()[1] = 1 - getInternalParameterValue("bwRise");
-
-    mCFEnv.totalLength(getInternalParameterValue("envDur"));
-    mBWEnv.totalLength(getInternalParameterValue("envDur"));
+    mOsc.freq(mFrequencyParam.get());
+    mOsc.harmonics(mHmnumParam.get());
+    mOsc.ampRatio(mHmampParam.get());
+    mAmpEnv.attack(mAttackTimeParam.get());
+    //    mAmpEnv.decay(mAttackTimeParam.get());
+    mAmpEnv.release(mReleaseTimeParam.get());
+    mAmpEnv.levels()[1] = mSustainParam.get();
+    mAmpEnv.levels()[2] = mSustainParam.get();
+
+    mAmpEnv.curve(mCurveParam.get());
+    mPan.pos(mPanParam.get());
+    mCFEnv.levels(mCf1Param.get(), mCf2Param.get(), mCf1Param.get());
+
+    mCFEnv.lengths()[0] = mCfRiseParam.get();
+    mCFEnv.lengths()[1] = 1 - mCfRiseParam.get();
+    mBWEnv.levels(mBw1Param.get(), mBw2Param.get(), mBw1Param.get());
+    mBWEnv.lengths()[0] = mBwRiseParam.get();
+    mBWEnv.lengths()[1] = 1 - mBwRiseParam.get();
+
+    mCFEnv.totalLength(mEnvDurParam.get());
+    mBWEnv.totalLength(mEnvDurParam.get());
   }
 };
 
@@ -955,6 +952,10 @@ public:
   // Additional members
   Mesh mMesh;
 
+  // Handles to the parameters read below, set in init()
+  VoiceParameter mAmplitudeParam, mFrequencyParam, mAttackTimeParam,
+      mReleaseTimeParam, mSustainParam, mPan1Param, mPan2Param, mPanRiseParam;
+
   virtual void init() {
     mAmp = 1;
     mDur = 2;
@@ -966,14 +967,18 @@ public:
     delay.delay(1. / 440.0);
 
     addDisc(mMesh, 1.0, 30);
-    createInternalTriggerParameter("amplitude", 0.1, 0.0, 1.0);
-    createInternalTriggerParameter("frequency", 60, 20, 5000);
-    createInternalTriggerParameter("attackTime", 0.001, 0.001, 1.0);
-    createInternalTriggerParameter("releaseTime", 3.0, 0.1, 10.0);
-    createInternalTriggerParameter("sustain", 0.7, 0.0, 1.0);
-    createInternalTriggerParameter("Pan1", 0.0, -1.0, 1.0);
-    createInternalTriggerParameter("Pan2", 0.0, -1.0, 1.0);
-    createInternalTriggerParameter("PanRise", 0.0, -1.0, 1.0); // range check
+    mAmplitudeParam =
+        createInternalTriggerParameter("amplitude", 0.1, 0.0, 1.0);
+    mFrequencyParam = createInternalTriggerParameter("frequency", 60, 20, 5000);
+    mAttackTimeParam =
+        createInternalTriggerParameter("attackTime", 0.001, 0.001, 1.0);
+    mReleaseTimeParam =
+        createInternalTriggerParameter("releaseTime", 3.0, 0.1, 10.0);
+    mSustainParam = createInternalTriggerParameter("sustain", 0.7, 0.0, 1.0);
+    mPan1Param = createInternalTriggerParameter("Pan1", 0.0, -1.0, 1.0);
+    mPan2Param = createInternalTriggerParameter("Pan2", 0.0, -1.0, 1.0);
+    // range check
+    mPanRiseParam = createInternalTriggerParameter("PanRise", 0.0, -1.0, 1.0);
   }
 
   //    void reset(){ env.reset(); }
@@ -997,8 +1002,8 @@ public:
   }
 
   virtual void onProcess(Graphics &g) {
-    float frequency = getInternalParameterValue("frequency");
-    float amplitude = getInternalParameterValue("amplitude");
+    float frequency = mFrequencyParam.get();
+    float amplitude = mAmplitudeParam.get();
     g.pushMatrix();
     g.translate(amplitude, amplitude, -4);
     // g.scale(frequency/2000, frequency/4000, 1);
@@ -1019,16 +1024,14 @@ public:
   virtual void onTriggerOff() override { mAmpEnv.triggerRelease(); }
 
   void updateFromParameters() {
-    mPanEnv.levels(getInternalParameterValue("Pan1"),
-                   getInternalParameterValue("Pan2"),
-                   getInternalParameterValue("Pan1"));
-    mPanRise = getInternalParameterValue("PanRise");
-    delay.freq(getInternalParameterValue("frequency"));
-    mAmp = getInternalParameterValue("amplitude");
+    mPanEnv.levels(mPan1Param.get(), mPan2Param.get(), mPan1Param.get());
+    mPanRise = mPanRiseParam.get();
+    delay.freq(mFrequencyParam.get());
+    mAmp = mAmplitudeParam.get();
     mAmpEnv.levels()[1] = 1.0;
-    mAmpEnv.levels()[2] = getInternalParameterValue("sustain");
-    mAmpEnv.lengths()[0] = getInternalParameterValue("attackTime");
-    mAmpEnv.lengths()[3] = getInternalParameterValue("releaseTime");
+    mAmpEnv.levels()[2] = mSustainParam.get();
+    mAmpEnv.lengths()[0] = mAttackTimeParam.get();
+    mAmpEnv.lengths()[3] = mReleaseTimeParam.get();
 
     mPanEnv.lengths()[0] = mDur * (1 - mPanRise);
     mPanEnv.lengths()[1] = mDur * mPanRise;
@@ -1054,48 +1057,9 @@ public:
     // Additive Synth Related
     initScaleToHarmonicSeries();
     initScaleTo12TET(110);
-    // Tremolo
-    gam::addSinesPow<1>(tbSaw, 9, 1);
-    gam::addSinesPow<1>(tbSqr, 9, 2);
-    gam::addSinesPow<0>(tbImp, 9, 1);
-    gam::addSine(tbSin);
-
-    {
-      float A[] = {1, 1, 1, 1, 0.7, 0.5, 0.3, 0.1};
-      gam::addSines(tbPls, A, 8);
-    }
-
-    {
-      float A[] = {1, 0.4, 0.65, 0.3, 0.18, 0.08};
-      float C[] = {1, 4, 7, 11, 15, 18};
-      gam::addSines(tb__1, A, C, 6);
-    }
-
-    // inharmonic partials
-    {
-      float A[] = {0.5, 0.8, 0.7, 1, 0.3, 0.4, 0.2, 0.12};
-      float C[] = {3, 4, 7, 8, 11, 12, 15, 16};
-      gam::addSines(tb__2, A, C, 8);
-    }
-
-    // inharmonic partials
-    {
-      float A[] = {1, 0.7, 0.45, 0.3, 0.15, 0.08};
-      float C[] = {10, 27, 54, 81, 108, 135};
-      gam::addSines(tb__3, A, C, 6);
-    }
-
-    // harmonics 20-27
-    {
-      float A[] = {0.2, 0.4, 0.6, 1, 0.7, 0.5, 0.3, 0.1};
-      gam::addSines(tb__4, A, 8, 20);
-    }
-
-    {
-      float A[] = {1, 0.7, 0.45, 0.3, 0.15, 0.08};
-      float C[] = {10, 27, 54, 81, 108, 135};
-      addSines(tbDin, A, C, 6);
-    }
+    // Tables come from the cache the first run writes, else are built
+    if (!WavetableBank::shared().load("wavetables.bin"))
+      WavetableBank::shared().save("wavetables.bin");
   }
   void onCreate() override {
     // Play example sequence. Comment this line to start from scratch
@@ -1233,7 +1197,172 @@ public:
   }
 };
 
-int main() {
+// Power of the n samples of s, a tone of frequency f at rate, that lies
+// outside the tone's harmonics below Nyquist, relative to the total, in dB.
+// n must be a power of 2. Returns 1 for silence.
+double aliasLevel(const float *s, int n, float f, float rate) {
+  // Radix 2 FFT, with a Blackman-Harris window, whose sidelobes are below
+  // -92 dB, so that leakage from the harmonics doesn't pass for aliasing
+  std::vector<std::complex<double>> x(n);
+  for (int i = 0; i < n; ++i) {
+    double t = 2 * M_PI * i / n;
+    x[i] = s[i] * (0.35875 - 0.48829 * std::cos(t) + 0.14128 * std::cos(2 * t) -
+                   0.01168 * std::cos(3 * t));
+  }
+  for (int i = 1, j = 0; i < n; ++i) {
+    int bit = n >> 1;
+    for (; j & bit; bit >>= 1)
+      j ^= bit;
+    j ^= bit;
+    if (i < j)
+      std::swap(x[i], x[j]);
+  }
+  for (int len = 2; len <= n; len <<= 1) {
+    std::complex<double> w = std::polar(1.0, -2 * M_PI / len);
+    for (int i = 0; i < n; i += len) {
+      std::complex<double> wk = 1;
+      for (int k = 0; k < len / 2; ++k, wk *= w) {
+        std::complex<double> a = x[i + k], b = x[i + k + len / 2] * wk;
+        x[i + k] = a + b;
+        x[i + k + len / 2] = a - b;
+      }
+    }
+  }
+
+  // Bins within the window's main lobe of a harmonic count as the tone
+  double binsPerHarmonic = f * n / rate, tone = 0, alias = 0;
+  for (int bin = 1; bin <= n / 2; ++bin) {
+    double harmonic = std::round(bin / binsPerHarmonic);
+    double power = std::norm(x[bin]);
+    if (harmonic >= 1 && std::fabs(bin - harmonic * binsPerHarmonic) <= 5)
+      tone += power;
+    else
+      alias += power;
+  }
+  if (tone + alias < 1e-20)
+    return 1;
+  return 10 * std::log10(alias / (tone + alias) + 1e-30);
+}
+
+// Compares the aliasing of gam::Osc reading one table with MipOsc's
+int spectralCheck() {
+  const float rate = 48000;
+  const int n = 1 << 16;
+  gam::sampleRate(rate);
+  std::vector<float> s(n);
+  bool pass = true;
+  printf("Alias power relative to the tone, %g Hz:\n", rate);
+  printf("  %-11s %7s  %9s  %9s\n", "table", "Hz", "gam::Osc", "MipOsc");
+  const char *names[] = {"saw", "square", "partials_3"};
+  int waves[] = {WavetableBank::SAW, WavetableBank::SQUARE,
+                 WavetableBank::PARTIALS_3};
+  for (int w = 0; w < 3; ++w)
+    for (float f : {110.f, 440.f, 1245.f, 2637.f, 4186.f, 4999.f}) {
+      gam::Osc<> single;
+      single.source(WavetableBank::shared().table(waves[w]));
+      single.freq(f);
+      for (float &v : s)
+        v = single();
+      double before = aliasLevel(s.data(), n, f, rate);
+
+      MipOsc mip;
+      mip.source(waves[w]);
+      mip.freq(f);
+      mip.process(s.data(), n);
+      double after = aliasLevel(s.data(), n, f, rate);
+
+      // Interpolating the table linearly leaves images of its partials, near
+      // -90 dB for the saw and -60 dB for the 135th harmonic of partials_3.
+      // Every partial of a high enough note is above Nyquist, and MipOsc is
+      // silent.
+      bool ok = after < -60 || after == 1;
+      pass = pass && ok;
+      printf("  %-11s %7.0f  %6.1f dB  ", names[w], f, before);
+      if (after == 1)
+        printf("  silent%s\n", ok ? "" : "  FAIL");
+      else
+        printf("%6.1f dB%s\n", after, ok ? "" : "  FAIL");
+    }
+  printf(pass ? "Passed\n" : "FAILED\n");
+  return pass ? 0 : 1;
+}
+
+// Times n voices of each oscillator at frequencies from 50 to 5000 Hz, in
+// 512 sample blocks, and prints the cost per sample
+int oscillatorBenchmark(int voices) {
+  const float rate = 48000;
+  const int frames = 512;
+  gam::sampleRate(rate);
+  std::vector<float> out(frames);
+
+  // Seconds for one block of every voice
+  auto time = [&](auto render) {
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point start = Clock::now();
+    double seconds = 0;
+    long long blocks = 0;
+    while (seconds < 1) {
+      for (int i = 0; i < 16; ++i, ++blocks)
+        render();
+      seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    }
+    return seconds / blocks;
+  };
+  auto report = [&](const char *name, double seconds, double reference) {
+    double ns = seconds / (double(voices) * frames) * 1e9;
+    printf("  %-22s %6.2f ns  %8.0f voices  (%.1fx)\n", name, ns,
+           frames / rate / seconds * voices, reference / seconds);
+  };
+  auto frequency = [&](int v) {
+    return 50 * std::pow(100.f, float(v) / std::max(voices - 1, 1));
+  };
+
+  std::vector<gam::Osc<>> single(voices);
+  std::vector<MipOsc> mip(voices);
+  for (int v = 0; v < voices; ++v) {
+    single[v].source(WavetableBank::shared().table(WavetableBank::SAW));
+    single[v].freq(frequency(v));
+    mip[v].source(WavetableBank::SAW);
+    mip[v].freq(frequency(v));
+  }
+
+  double osc = time([&] {
+    for (auto &o : single)
+      for (int i = 0; i < frames; ++i)
+        out[i] += o();
+  });
+  double perSample = time([&] {
+    for (auto &o : mip)
+      for (int i = 0; i < frames; ++i)
+        out[i] += o();
+  });
+  std::vector<float> block(frames);
+  double blocks = time([&] {
+    for (auto &o : mip) {
+      o.process(block.data(), frames);
+      for (int i = 0; i < frames; ++i)
+        out[i] += block[i];
+    }
+  });
+
+  printf("%d saw voices, 50-5000 Hz, 512 sample blocks at %g Hz\n", voices,
+         rate);
+  printf("Cost a sample, voices one core plays in real time:\n");
+  report("gam::Osc, one table", osc, osc);
+  report("MipOsc, operator()", perSample, osc);
+  report("MipOsc, process()", blocks, osc);
+  return out[0] == 12345 ? 1 : 0; // Keeps the rendering from being dropped
+}
+
+int main(int argc, char *argv[]) {
+  // "10_Integrated -check" measures aliasing and "10_Integrated -bench
+  // [voices]" the oscillators' cost, without a window or audio device
+  if (argc > 1 && std::strcmp(argv[1], "-check") == 0)
+    return spectralCheck();
+  if (argc > 1 && std::strcmp(argv[1], "-bench") == 0)
+    return oscillatorBenchmark(argc > 2 ? std::max(std::atoi(argv[2]), 1)
+                                        : 64);
+
   MyApp app;
 
   // Set up audio
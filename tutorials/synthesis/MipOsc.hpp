@@ -0,0 +1,170 @@
+#pragma once
+#ifndef MipOsc_H
+#define MipOsc_H
+
+// A wavetable oscillator that doesn't alias.
+//
+// gam::Osc reads one table at every frequency, so the partials of a high
+// note that lie above Nyquist fold back as inharmonic tones. MipOsc reads a
+// WavetableBank wave through its band-limited levels, choosing the level
+// for the frequency, so that no partial it plays is above Nyquist. Between
+// levels it crossfades over the octave, so partials fade out as a note
+// rises rather than dropping out an octave at a time.
+//
+// It replaces a gam::Osc reading one of the bank's tables:
+//
+//   gam::Osc<> mOsc;                        MipOsc mOsc;
+//   mOsc.source(tbSaw);                     mOsc.source(WavetableBank::SAW);
+//   mOsc.freq(440);                         mOsc.freq(440);
+//   float s = mOsc();                       float s = mOsc();
+//
+// Samples are computed BLOCK at a time by process(), a loop without
+// branches that turns into SIMD instructions in release builds, and
+// operator() hands them out one by one. So a new frequency takes effect
+// within BLOCK samples; source() takes effect at once. Handing samples out
+// costs about half as much again as computing them, so voices whose
+// frequency holds over a callback call process() for the whole buffer
+// instead, and keep operator() for frequencies that change every sample.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "Gamma/Domain.h"
+
+#include "playground/WavetableBank.hpp"
+
+class MipOsc {
+public:
+  static constexpr int BLOCK = 64;
+
+  MipOsc(float frequency = 440) {
+    source(WavetableBank::SINE);
+    freq(frequency);
+  }
+
+  // Plays wave from the shared bank
+  void source(int wave) {
+    WavetableBank &bank = WavetableBank::shared();
+    for (int k = 0; k < WavetableBank::LEVELS; ++k)
+      mTables[k] = bank.table(wave, k).elems();
+    restart();
+  }
+
+  // Plays a table of WavetableBank::SIZE samples at every frequency, as
+  // gam::Osc would
+  void source(gam::ArrayPow2<float> &table) {
+    for (const float *&t : mTables)
+      t = table.elems();
+    restart();
+  }
+
+  void freq(float f) {
+    float rate = float(gam::sampleRate());
+    if (f == mFreq && rate == mRate)
+      return;
+    mFreq = f;
+    mRate = rate;
+    // Cycles a sample in 32 bit fixed point, wrapping for negative f
+    mIncrement = uint32_t(int64_t(double(f) / rate * 4294967296.0));
+    choose();
+  }
+  float freq() const { return mFreq; }
+
+  float operator()() {
+    if (mNext == BLOCK) {
+      process(mBlock, BLOCK);
+      mBlockIncrement = mIncrement;
+      mNext = 0;
+    }
+    return mBlock[mNext++];
+  }
+
+  // Writes the next n samples to out
+  void process(float *out, int n) {
+    for (int i = 0; i < n; i += BLOCK) {
+      // Rendered to a local array, which the compiler knows isn't one of the
+      // tables, so that it can vectorize the loop
+      float block[BLOCK];
+      int m = n - i < BLOCK ? n - i : BLOCK;
+      render(block, m);
+      std::copy(block, block + m, out + i);
+    }
+  }
+
+  // Level read at the current frequency, crossfading toward level() + 1 by
+  // levelMix()
+  int level() const { return mLevel; }
+  float levelMix() const { return mLo == mHi ? 0 : mMix; }
+
+private:
+  // The phase's top 11 bits index the table, the rest interpolate
+  static constexpr int FRACTION_BITS = 21;
+  static constexpr uint32_t FRACTION_MASK = (1u << FRACTION_BITS) - 1;
+
+  void render(float *out, int n) {
+    const float *lo = mLo, *hi = mHi;
+    uint32_t phase = mPhase, increment = mIncrement;
+    const int mask = WavetableBank::SIZE - 1;
+    const float scale = 1.f / (1 << FRACTION_BITS);
+    // Signed indices and fractions: SSE has no unsigned conversions
+    if (lo == hi) {
+      for (int i = 0; i < n; ++i) {
+        uint32_t p = phase + uint32_t(i) * increment;
+        int j = int(p >> FRACTION_BITS), j1 = (j + 1) & mask;
+        float frac = float(int(p & FRACTION_MASK)) * scale;
+        out[i] = lo[j] + (lo[j1] - lo[j]) * frac;
+      }
+    } else {
+      float mix = mMix;
+      for (int i = 0; i < n; ++i) {
+        uint32_t p = phase + uint32_t(i) * increment;
+        int j = int(p >> FRACTION_BITS), j1 = (j + 1) & mask;
+        float frac = float(int(p & FRACTION_MASK)) * scale;
+        float a = lo[j] + (lo[j1] - lo[j]) * frac;
+        float b = hi[j] + (hi[j1] - hi[j]) * frac;
+        out[i] = a + (b - a) * mix;
+      }
+    }
+    mPhase = phase + uint32_t(n) * increment;
+  }
+
+  // Level k has no partial above Nyquist up to log2(SIZE f / rate) = k. Over
+  // the octave below that, fade from level k to k + 1, so that by the time
+  // k + 1 is needed it is all that plays.
+  void choose() {
+    const int top = WavetableBank::LEVELS - 1;
+    float x = std::log2(std::fabs(mFreq) * WavetableBank::SIZE / mRate);
+    x = x > -1 ? x : -1; // Also for a frequency of 0
+    float octave = std::floor(x);
+    int k = int(octave) + 1;
+    mMix = x - octave;
+    if (k >= top) {
+      k = top;
+      mMix = 0;
+    }
+    mLevel = k;
+    mLo = mTables[k];
+    mHi = mTables[k < top ? k + 1 : top];
+  }
+
+  // Drops the samples not yet handed out, moving the phase back to the first
+  // of them so that the wave continues where it was heard
+  void restart() {
+    mPhase -= uint32_t(BLOCK - mNext) * mBlockIncrement;
+    mNext = BLOCK;
+    if (mRate > 0)
+      choose();
+  }
+
+  const float *mTables[WavetableBank::LEVELS] = {};
+  const float *mLo = nullptr, *mHi = nullptr;
+  float mMix = 0;
+  int mLevel = 0;
+  float mFreq = 0, mRate = 0;
+  uint32_t mPhase = 0, mIncrement = 0, mBlockIncrement = 0;
+  float mBlock[BLOCK];
+  int mNext = BLOCK;
+};
+
+#endif
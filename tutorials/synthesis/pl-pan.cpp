@@ -13,6 +13,8 @@
 #include "al/ui/al_ControlGUI.hpp"
 #include "al/ui/al_Parameter.hpp"
 
+#include "playground/VoiceParameter.hpp"
+
 using namespace gam;
 using namespace al;
 using namespace std;
@@ -34,6 +36,10 @@ public:
     // Additional members
     Mesh mMesh;
 
+    // Handles to the parameters read below, set in init()
+    VoiceParameter mAmplitudeParam, mFrequencyParam, mAttackTimeParam,
+        mReleaseTimeParam, mSustainParam, mPan1Param, mPan2Param, mPanRiseParam;
+
     virtual void init(){
         mAmp  = 1;
         mDur = 2;
@@ -45,14 +51,20 @@ public:
 
 
         addDisc(mMesh, 1.0, 30);
-        createInternalTriggerParameter("amplitude", 0.1, 0.0, 1.0);
-        createInternalTriggerParameter("frequency", 60, 20, 5000);
-        createInternalTriggerParameter("attackTime", 0.001, 0.001, 1.0);
-        createInternalTriggerParameter("releaseTime", 3.0, 0.1, 10.0);
-        createInternalTriggerParameter("sustain", 0.7, 0.0, 1.0);
-        createInternalTriggerParameter("Pan1", 0.0, -1.0, 1.0);
-        createInternalTriggerParameter("Pan2", 0.0, -1.0, 1.0);
-        createInternalTriggerParameter("PanRise", 0.0, -1.0, 1.0); // range check
+        mAmplitudeParam =
+            createInternalTriggerParameter("amplitude", 0.1, 0.0, 1.0);
+        mFrequencyParam =
+            createInternalTriggerParameter("frequency", 60, 20, 5000);
+        mAttackTimeParam =
+            createInternalTriggerParameter("attackTime", 0.001, 0.001, 1.0);
+        mReleaseTimeParam =
+            createInternalTriggerParameter("releaseTime", 3.0, 0.1, 10.0);
+        mSustainParam =
+            createInternalTriggerParameter("sustain", 0.7, 0.0, 1.0);
+        mPan1Param = createInternalTriggerParameter("Pan1", 0.0, -1.0, 1.0);
+        mPan2Param = createInternalTriggerParameter("Pan2", 0.0, -1.0, 1.0);
+        // range check
+        mPanRiseParam = createInternalTriggerParameter("PanRise", 0.0, -1.0, 1.0);
     }
     
 //    void reset(){ env.reset(); }
@@ -82,8 +94,8 @@ public:
     }
 
     virtual void onProcess(Graphics &g) {
-          float frequency = getInternalParameterValue("frequency");
-          float amplitude = getInternalParameterValue("amplitude");
+          float frequency = mFrequencyParam.get();
+          float amplitude = mAmplitudeParam.get();
           g.pushMatrix();
           g.translate(amplitude,  amplitude, -4);
           //g.scale(frequency/2000, frequency/4000, 1);
@@ -106,16 +118,14 @@ public:
     }
 
     void updateFromParameters() {
-        mPanEnv.levels(getInternalParameterValue("Pan1"),
-                       getInternalParameterValue("Pan2"),
-                       getInternalParameterValue("Pan1"));
-        mPanRise = getInternalParameterValue("PanRise");
-        delay.freq(getInternalParameterValue("frequency"));
-        mAmp = getInternalParameterValue("amplitude");
+        mPanEnv.levels(mPan1Param.get(), mPan2Param.get(), mPan1Param.get());
+        mPanRise = mPanRiseParam.get();
+        delay.freq(mFrequencyParam.get());
+        mAmp = mAmplitudeParam.get();
         mAmpEnv.levels()[1] = 1.0;
-        mAmpEnv.levels()[2] = getInternalParameterValue("sustain");
-        mAmpEnv.lengths()[0] = getInternalParameterValue("attackTime");
-        mAmpEnv.lengths()[3] = getInternalParameterValue("releaseTime");
+        mAmpEnv.levels()[2] = mSustainParam.get();
+        mAmpEnv.lengths()[0] = mAttackTimeParam.get();
+        mAmpEnv.lengths()[3] = mReleaseTimeParam.get();
 
         mPanEnv.lengths()[0] = mDur * (1-mPanRise);
         mPanEnv.lengths()[1] = mDur * mPanRise;
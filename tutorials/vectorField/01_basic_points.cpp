@@ -7,12 +7,21 @@ Various methods to handle computation and sophisticated rendering techniques.
 
 Basic example of vector field and rending with point meshes
 
+The points stay where they are, so the mesh is built once and only its colors
+are evaluated each frame, by FieldEngine on all threads (see FieldEngine.hpp).
+
+Usage: ./01_basic_points [resolution] [threads]
+
 Author:
 Kon Hyong Kim - Jan 2021
 */
 
 #include "al/app/al_App.hpp"
+#include <string>
 #include <vector>
+
+#include "FieldEngine.hpp"
+
 using namespace al;
 
 class FieldApp : public App {
@@ -30,10 +39,13 @@ public:
   // phase of the sine waves in the algorithm used in the example
   float theta;
 
-  FieldApp() {
+  // evaluates the colors on all threads
+  FieldEngine engine;
+
+  FieldApp(int resolution = 512, int threads = 0) : engine(threads) {
     // initialize variables
-    xRes = 512;
-    yRes = 512;
+    xRes = resolution;
+    yRes = resolution;
     theta = 0.f;
     scale = 2.f;
   }
@@ -43,38 +55,34 @@ public:
     // rendered at the origin.
     // Some elements like nav need to be modified after being created
     nav().pos(0, 0, 4);
-  }
 
-  void onAnimate(double dt) {
-    // reset the mesh
-    mesh.reset();
     // configure the mesh to render using individual points
     mesh.primitive(Mesh::POINTS);
 
+    // place a point in the middle of each pixel, scaled to the field size
+    engine.resize(xRes, yRes);
     for (int j = 0; j < yRes; ++j) {
       for (int i = 0; i < xRes; ++i) {
-        // get the middle of the pixel in a vector field -0.5~0.5 x -0.5~0.5
-        Vec3f p((i + 0.5f) / (float)xRes - 0.5f,
-                (j + 0.5f) / (float)yRes - 0.5f, 0.f);
-
-        // scale the vector field size
-        p *= scale;
-
-        // ** place to apply algorithms based on the vector field
-        // here we're coloring the vector field based on the radius
-        // and a sine wave as an example
-        float radius = p.mag();
-        // RGB that fluctuates from 0-1 based on radius and theta
-        // with different periods
-        Color color = Color(0.5f * sin(8.f * radius + theta) + 0.5f,
-                            0.5f * sin(7.f * radius + theta) + 0.5f,
-                            0.5f * sin(5.f * radius + theta) + 0.5f);
-
-        // here we're rendering a point based on the vector field
-        mesh.vertex(p);
-        mesh.color(color);
+        mesh.vertex(Vec3f(engine.x(i), engine.y(j), 0.f) * scale);
+        mesh.color(Color());
       }
     }
+  }
+
+  void onAnimate(double dt) {
+    // ** place to apply algorithms based on the vector field
+    // here we're coloring the vector field based on the radius
+    // and a sine wave as an example
+    engine.evaluate(mesh.colors().data(), [this](float x, float y) {
+      // get the point's position in the vector field
+      Vec3f p = Vec3f(x, y, 0.f) * scale;
+      float radius = p.mag();
+      // RGB that fluctuates from 0-1 based on radius and theta
+      // with different periods
+      return Color(0.5f * sin(8.f * radius + theta) + 0.5f,
+                   0.5f * sin(7.f * radius + theta) + 0.5f,
+                   0.5f * sin(5.f * radius + theta) + 0.5f);
+    });
 
     // increment the phase based on the time elapsed from last frame
     // this allows animation to look smooth regardless of fps
@@ -91,7 +99,8 @@ public:
   }
 };
 
-int main() {
-  FieldApp app;
+int main(int argc, char *argv[]) {
+  FieldApp app(argc > 1 ? std::stoi(argv[1]) : 512,
+               argc > 2 ? std::stoi(argv[2]) : 0);
   app.start();
 }
@@ -7,14 +7,58 @@ Various methods to handle computation and sophisticated rendering techniques.
 
 Example of rendering vector field to a texture
 
+The field is evaluated by FieldEngine, which splits it into tiles and shares
+them between threads. Here it evaluates eight pixels at a time with
+evaluateLanes(), so the loops over pixels can use SIMD instructions.
+
+The texture can hold the field in a smaller format than RGBA32F, to upload
+fewer bytes: rgba16f, srgb8 or r16f. The field is packed on the CPU first,
+which often costs more than the upload saves (see FieldFormat.hpp). -formats
+reports how fast the field packs into each.
+
+Usage: ./02_texture [resolution] [threads] [format]
+       ./02_texture -bench [resolution] [threads]
+       ./02_texture -formats [resolution] [threads]
+
 Author:
 Kon Hyong Kim - Jan 2021
 */
 
 #include "al/app/al_App.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
 #include <vector>
+
+#include "FieldEngine.hpp"
+#include "FieldFormat.hpp"
+
 using namespace al;
 
+// RGB that fluctuates from 0-1 based on radius and theta with different
+// periods
+inline Color ripple(float x, float y, float scale, float theta) {
+  float radius = (Vec3f(x, y, 0.f) * scale).mag();
+  return Color(0.5f * sin(8.f * radius + theta) + 0.5f,
+               0.5f * sin(7.f * radius + theta) + 0.5f,
+               0.5f * sin(5.f * radius + theta) + 0.5f);
+}
+
+// The same for eight pixels at a time
+void rippleLanes(FieldLanes &l, float scale, float theta) {
+  for (int k = 0; k < kFieldLanes; ++k) {
+    float x = l.x[k] * scale, y = l.y[k] * scale;
+    float radius = fieldSqrt(x * x + y * y);
+    l.r[k] = 0.5f * fieldSin(8.f * radius + theta) + 0.5f;
+    l.g[k] = 0.5f * fieldSin(7.f * radius + theta) + 0.5f;
+    l.b[k] = 0.5f * fieldSin(5.f * radius + theta) + 0.5f;
+  }
+}
+
 class FieldApp : public App {
 public:
   // resolution of the vector field
@@ -27,8 +71,12 @@ public:
   // std::vector to store the color of the vector field
   std::vector<Color> field;
 
-  // Texture to store the image
-  Texture tex;
+  // evaluates the field on all threads
+  FieldEngine engine;
+
+  // Texture to store the image, in the format chosen
+  FieldTexture tex;
+  FieldFormat format;
 
   // Rectangle mesh to apply the texture
   VAOMesh quad;
@@ -36,10 +84,12 @@ public:
   // phase of the sine waves in the algorithm used in the example
   float theta;
 
-  FieldApp() {
+  FieldApp(int resolution = 512, int threads = 0,
+           FieldFormat format = FieldFormat::RGBA32F)
+      : engine(threads), format(format) {
     // initialize variables
-    xRes = 512;
-    yRes = 512;
+    xRes = resolution;
+    yRes = resolution;
     theta = 0.f;
     scale = 2.f;
   }
@@ -52,13 +102,10 @@ public:
 
     // resize the field container
     field.resize(xRes * yRes);
+    engine.resize(xRes, yRes);
 
-    // set the filters for the texture. Default: NEAREST
-    tex.filterMag(Texture::LINEAR);
-    tex.filterMin(Texture::LINEAR);
-
-    // create a texture unit on the GPU
-    tex.create2D(xRes, yRes, Texture::RGBA32F, Texture::RGBA, Texture::FLOAT);
+    // create a texture unit on the GPU, with LINEAR filters
+    tex.create(format, xRes, yRes);
 
     // create the quad mesh to apply texture on
     quad.primitive(Mesh::TRIANGLE_STRIP);
@@ -76,32 +123,16 @@ public:
   }
 
   void onAnimate(double dt) {
-    for (int j = 0; j < yRes; ++j) {
-      for (int i = 0; i < xRes; ++i) {
-        // get the middle of the pixel in a vector field -0.5~0.5 x -0.5~0.5
-        Vec3f p((i + 0.5f) / (float)xRes - 0.5f,
-                (j + 0.5f) / (float)yRes - 0.5f, 0.f);
-
-        // scale the vector field size
-        p *= scale;
-
-        // ** place to apply algorithms based on the vector field
-        // here we're coloring the vector field based on the radius
-        // and a sine wave as an example
-        float radius = p.mag();
-        // RGB that fluctuates from 0-1 based on radius and theta
-        // with different periods
-        Color color = Color(0.5f * sin(8.f * radius + theta) + 0.5f,
-                            0.5f * sin(7.f * radius + theta) + 0.5f,
-                            0.5f * sin(5.f * radius + theta) + 0.5f);
-
-        // store the color in the container
-        field[xRes * j + i] = color;
-      }
-    }
+    // ** place to apply algorithms based on the vector field
+    // here we're coloring the vector field based on the radius
+    // and a sine wave as an example
+    engine.evaluateLanes(field.data(), [this](FieldLanes &lanes) {
+      rippleLanes(lanes, scale, theta);
+    });
 
-    // update the texture with the modified vector field
-    tex.submit(field.data());
+    // update the texture with the modified vector field, packed to the
+    // texture's format
+    tex.submit(engine, field.data());
 
     // increment the phase based on the time elapsed from last frame
     // this allows animation to look smooth regardless of fps
@@ -112,18 +143,177 @@ public:
 
   void onDraw(Graphics &g) {
     g.clear();
-    // use textures to color meshes
-    g.texture();
-    // bind the texture we want to use
-    tex.bind();
-    // render the quad to apply texture
-    g.draw(quad);
-    // unbind the texture after use
-    tex.unbind();
+    // render the quad with the texture bound
+    tex.draw(g, quad);
   }
 };
 
-int main() {
-  FieldApp app;
+// The loop this example used before FieldEngine, for comparison
+void rippleReference(std::vector<Color> &field, int xRes, int yRes,
+                     float scale, float theta) {
+  for (int j = 0; j < yRes; ++j) {
+    for (int i = 0; i < xRes; ++i) {
+      Vec3f p((i + 0.5f) / (float)xRes - 0.5f,
+              (j + 0.5f) / (float)yRes - 0.5f, 0.f);
+      p *= scale;
+      float radius = p.mag();
+      field[xRes * j + i] = Color(0.5f * sin(8.f * radius + theta) + 0.5f,
+                                  0.5f * sin(7.f * radius + theta) + 0.5f,
+                                  0.5f * sin(5.f * radius + theta) + 0.5f);
+    }
+  }
+}
+
+// Reports frames/s evaluating the field with the original loop, with
+// evaluate() and with evaluateLanes(), and how far the results differ
+int benchmark(int resolution, int threads) {
+  typedef std::chrono::steady_clock Clock;
+  FieldEngine engine(threads);
+  engine.resize(resolution, resolution);
+  std::vector<Color> reference(engine.size()), field(engine.size());
+  const float scale = 2.f;
+
+  auto framesPerSecond = [&](const std::function<void(float)> &frame) {
+    int frames = 0;
+    auto start = Clock::now();
+    double seconds = 0;
+    while (seconds < 1 || frames < 3) {
+      frame(0.1f * frames);
+      ++frames;
+      seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    }
+    return frames / seconds;
+  };
+  auto maxDifference = [&]() {
+    float d = 0;
+    for (int i = 0; i < engine.size(); ++i) {
+      d = std::max(d, std::fabs(field[i].r - reference[i].r));
+      d = std::max(d, std::fabs(field[i].g - reference[i].g));
+      d = std::max(d, std::fabs(field[i].b - reference[i].b));
+    }
+    return d;
+  };
+
+  printf("%d x %d field, %d threads, %d pixel tiles\n", resolution,
+         resolution, engine.threads(), engine.tileSize);
+  double loop = framesPerSecond([&](float theta) {
+    rippleReference(reference, resolution, resolution, scale, theta);
+  });
+  printf("original loop   %8.1f frames/s\n", loop);
+
+  double tiles = framesPerSecond([&](float theta) {
+    engine.evaluate(field.data(), [&](float x, float y) {
+      return ripple(x, y, scale, theta);
+    });
+  });
+  rippleReference(reference, resolution, resolution, scale, 1.f);
+  engine.evaluate(field.data(),
+                  [&](float x, float y) { return ripple(x, y, scale, 1.f); });
+  float tilesDifference = maxDifference();
+  printf("evaluate        %8.1f frames/s, differs by %.1e\n", tiles,
+         tilesDifference);
+
+  double lanes = framesPerSecond([&](float theta) {
+    engine.evaluateLanes(field.data(), [&](FieldLanes &l) {
+      rippleLanes(l, scale, theta);
+    });
+  });
+  engine.evaluateLanes(field.data(),
+                       [&](FieldLanes &l) { rippleLanes(l, scale, 1.f); });
+  float lanesDifference = maxDifference();
+  printf("evaluateLanes   %8.1f frames/s, differs by %.1e\n", lanes,
+         lanesDifference);
+
+  bool ok = tilesDifference == 0 && lanesDifference < 1e-5f;
+  printf("%s\n", ok ? "results match" : "results DIFFER");
+  return ok ? 0 : 1;
+}
+
+// Reports how fast the field packs into each format and how many bytes a
+// frame uploads, after checking the conversions: every half must come back
+// from its own value and round ties to even, and sRGB must match the
+// standard curve
+int formatBenchmark(int resolution, int threads) {
+  int failures = 0;
+
+  int halfErrors = 0;
+  for (int h = 0; h < 0x7c00; ++h) {
+    for (int sign : {0, 0x8000}) {
+      float v = fieldHalfToFloat(uint16_t(h | sign));
+      halfErrors += fieldHalf(v) != (h | sign);
+      // Halfway to the next half rounds to whichever is even
+      float next = h + 1 < 0x7c00 ? fieldHalfToFloat(uint16_t((h + 1) | sign))
+                                  : (sign ? -65536.f : 65536.f);
+      int even = (h & 1) ? h + 1 : h;
+      halfErrors += fieldHalf(0.5f * (v + next)) != (even | sign);
+    }
+  }
+  printf("half floats: %d errors in %d values\n", halfErrors, 4 * 0x7c00);
+  failures += halfErrors > 0;
+
+  const int steps = 1 << 20;
+  int srgbDiffer = 0, srgbWorst = 0;
+  for (int i = 0; i <= steps; ++i) {
+    float x = float(i) / steps;
+    float s = x < 0.0031308f ? 12.92f * x
+                             : 1.055f * std::pow(x, 1.f / 2.4f) - 0.055f;
+    int d = std::abs(int(s * 255.f + 0.5f) - int(fieldSrgb(x) * 255.f + 0.5f));
+    srgbDiffer += d > 0;
+    srgbWorst = std::max(srgbWorst, d);
+  }
+  printf("sRGB: %d of %d values differ from pow(), by at most %d\n",
+         srgbDiffer, steps + 1, srgbWorst);
+  failures += srgbWorst > 1;
+
+  FieldEngine engine(threads);
+  engine.resize(resolution, resolution);
+  std::vector<Color> field(engine.size());
+  std::vector<unsigned char> packed(field.size() * sizeof(Color));
+  engine.evaluateLanes(field.data(),
+                       [](FieldLanes &l) { rippleLanes(l, 2.f, 1.f); });
+
+  printf("%d x %d field, %d threads\n", resolution, resolution,
+         engine.threads());
+  for (FieldFormat f : {FieldFormat::RGBA32F, FieldFormat::RGBA16F,
+                        FieldFormat::SRGB8, FieldFormat::R16F}) {
+    int frames = 0;
+    auto start = std::chrono::steady_clock::now();
+    double seconds = 0;
+    while (seconds < 1 || frames < 3) {
+      packField(engine, f, field.data(), packed.data());
+      ++frames;
+      seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                              start)
+                    .count();
+    }
+    double pixels = double(engine.size()) * frames / seconds;
+    printf("%-8s %2d bytes/pixel, %6.1f MB/frame, packs at %7.1f Mpixels/s "
+           "(%5.2f ms/frame)\n",
+           fieldFormatName(f), fieldPixelBytes(f),
+           engine.size() * fieldPixelBytes(f) / 1e6, pixels / 1e6,
+           1000 * seconds / frames);
+  }
+
+  printf("%s\n", failures ? "conversions FAILED" : "conversions match");
+  return failures ? 1 : 0;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc > 1 && std::string(argv[1]) == "-bench") {
+    return benchmark(argc > 2 ? std::stoi(argv[2]) : 2048,
+                     argc > 3 ? std::stoi(argv[3]) : 0);
+  }
+  if (argc > 1 && std::string(argv[1]) == "-formats") {
+    return formatBenchmark(argc > 2 ? std::stoi(argv[2]) : 2048,
+                           argc > 3 ? std::stoi(argv[3]) : 0);
+  }
+  FieldFormat format = FieldFormat::RGBA32F;
+  if (argc > 3 && !parseFieldFormat(argv[3], format)) {
+    printf("unknown format %s: use rgba32f, rgba16f, srgb8 or r16f\n",
+           argv[3]);
+    return 1;
+  }
+  FieldApp app(argc > 1 ? std::stoi(argv[1]) : 512,
+               argc > 2 ? std::stoi(argv[2]) : 0, format);
   app.start();
 }
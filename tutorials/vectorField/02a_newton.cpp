@@ -8,14 +8,144 @@ Various methods to handle computation and sophisticated rendering techniques.
 Example of using newton's method on the vector field
 and rendering using a texture
 
+Pixels need from a few to a hundred iterations, so FieldEngine hands out
+small tiles of the field to threads as they finish the last one (see
+FieldEngine.hpp). newtonLanes() iterates eight pixels at once, computing f
+and f' once per iteration; pixels that have converged stop moving while the
+others go on, until all of them have. Press 'l' to switch between it and the
+one pixel at a time version, newtonPixel().
+
+The texture can hold the field as rgba32f (default), rgba16f, srgb8 or r16f
+to upload fewer bytes a frame (see FieldFormat.hpp).
+
+Usage: ./02a_newton [resolution] [threads] [format]
+       ./02a_newton -bench [resolution] [threads]
+       ./02a_newton -check
+
 Author:
 Kon Hyong Kim - Jan 2021
 */
 
 #include "al/app/al_App.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <string>
 #include <vector>
+
+#include "FieldEngine.hpp"
+#include "FieldFormat.hpp"
+
 using namespace al;
 
+// square of complex number
+inline Vec2f p2(Vec2f p) {
+  return Vec2f(p[0] * p[0] - p[1] * p[1], 2.f * p[0] * p[1]);
+}
+
+// cube of complex number
+inline Vec2f p3(Vec2f p) {
+  return Vec2f(p[0] * p[0] * p[0] - 3.f * p[0] * p[1] * p[1],
+               3.f * p[0] * p[0] * p[1] - p[1] * p[1] * p[1]);
+}
+
+// function to apply newton's method
+// here we use p_next = p^9 + coef * p - i
+// with coef as the artistic manipulation
+inline Vec2f myF(Vec2f p, float coef) {
+  return p3(p3(p)) + coef * p - Vec2f(0.f, 1.f);
+}
+
+// derivative of the function above
+inline Vec2f myFPrime(Vec2f p, float coef) {
+  return 9.f * p2(p2(p2(p))) + Vec2f(coef, 0.f);
+}
+
+// apply newton's method to find the root of the function
+// on each iteration add a bit of the base color
+inline Color newtonPixel(Vec2f p, float coef, const Color &baseColor) {
+  Color color;
+  color.set(0);
+  int t = 0;
+  while (myF(p, coef).mag() > 1E-3 && t < 100) {
+    Vec2f f = myF(p, coef);
+    Vec2f fP = myFPrime(p, coef);
+
+    p = p - Vec2f((f[0] * fP[0] + f[1] * fP[1]) /
+                      (fP[0] * fP[0] + fP[1] * fP[1]),
+                  (f[1] * fP[0] - f[0] * fP[1]) /
+                      (fP[0] * fP[0] + fP[1] * fP[1]));
+
+    color += 0.02f * baseColor;
+
+    ++t;
+  }
+  return color;
+}
+
+// The same for the eight pixels in lanes, scaled by scale. Each iteration
+// computes f and f' for every lane, and lanes where f is small enough keep
+// their position and color while the rest move on. The operations are those
+// of newtonPixel() in the same order, except that |f| is compared squared.
+// Returns the number of iterations, for measuring how busy the lanes were.
+inline int newtonLanes(FieldLanes &lanes, float scale, float coef,
+                       const Color &baseColor) {
+  const int L = kFieldLanes;
+  float px[L], py[L];
+  for (int k = 0; k < L; ++k) {
+    px[k] = lanes.x[k] * scale;
+    py[k] = lanes.y[k] * scale;
+    lanes.r[k] = lanes.g[k] = lanes.b[k] = lanes.a[k] = 0.f;
+  }
+  Color step = 0.02f * baseColor;
+  const float threshold = 1E-6f;
+  const int32_t kInfinityBits = 0x7f800000;
+  int32_t thresholdBits;
+  std::memcpy(&thresholdBits, &threshold, 4);
+  int t = 0;
+  while (t < 100) {
+    int running = 0;
+    for (int k = 0; k < L; ++k) {
+      float x = px[k], y = py[k];
+      // p^3 and p^9 = (p^3)^3
+      float cx = x * x * x - 3.f * x * y * y;
+      float cy = 3.f * x * x * y - y * y * y;
+      float nx = cx * cx * cx - 3.f * cx * cy * cy;
+      float ny = 3.f * cx * cx * cy - cy * cy * cy;
+      float fx = nx + coef * x, fy = (ny + coef * y) - 1.f;
+
+      // p^8 = ((p^2)^2)^2
+      float sx = x * x - y * y, sy = 2.f * x * y;
+      float qx = sx * sx - sy * sy, qy = 2.f * sx * sy;
+      float ex = qx * qx - qy * qy, ey = 2.f * qx * qy;
+      float dx = 9.f * ex + coef, dy = 9.f * ey;
+
+      float d = dx * dx + dy * dy;
+      float ux = (fx * dx + fy * dy) / d, uy = (fy * dx - fx * dy) / d;
+      // |f|^2 is compared as bits, which order like non-negative floats:
+      // NaN stops, as in newtonPixel(), and infinity goes on
+      float mag2 = fx * fx + fy * fy;
+      int32_t bits;
+      std::memcpy(&bits, &mag2, 4);
+      int32_t on = -int32_t(bits > thresholdBits && bits <= kInfinityBits);
+      px[k] = x - fieldMask(ux, on);
+      py[k] = y - fieldMask(uy, on);
+      lanes.r[k] += fieldMask(step.r, on);
+      lanes.g[k] += fieldMask(step.g, on);
+      lanes.b[k] += fieldMask(step.b, on);
+      lanes.a[k] += fieldMask(step.a, on);
+      running -= on;
+    }
+    if (running == 0)
+      break;
+    ++t;
+  }
+  return t;
+}
+
 class FieldApp : public App {
 public:
   // resolution of the vector field
@@ -28,21 +158,30 @@ public:
   // std::vector to store the color of the vector field
   std::vector<Color> field;
 
-  // Texture to store the image
-  Texture tex;
+  // Texture to store the image, in the format chosen
+  FieldTexture tex;
+  FieldFormat format;
 
   // Rectangle mesh to apply the texture
   VAOMesh quad;
 
+  // evaluates the field on all threads
+  FieldEngine engine;
+
   // variables for the algorithm's artistic manipulation
   float coef;
   bool goUp;
   Color baseColor;
 
-  FieldApp() {
+  // iterate eight pixels at a time
+  bool useLanes = true;
+
+  FieldApp(int resolution = 512, int threads = 0,
+           FieldFormat format = FieldFormat::RGBA32F)
+      : format(format), engine(threads) {
     // initialize variables
-    xRes = 512;
-    yRes = 512;
+    xRes = resolution;
+    yRes = resolution;
     scale = 2.f;
 
     coef = -0.2f;
@@ -59,13 +198,10 @@ public:
 
     // resize the field container
     field.resize(xRes * yRes);
+    engine.resize(xRes, yRes);
 
-    // set the filters for the texture. Default: NEAREST
-    tex.filterMag(Texture::LINEAR);
-    tex.filterMin(Texture::LINEAR);
-
-    // create a texture unit on the GPU
-    tex.create2D(xRes, yRes, Texture::RGBA32F, Texture::RGBA, Texture::FLOAT);
+    // create a texture unit on the GPU, with LINEAR filters
+    tex.create(format, xRes, yRes);
 
     // create the quad mesh to apply texture on
     quad.primitive(Mesh::TRIANGLE_STRIP);
@@ -82,58 +218,16 @@ public:
     quad.update();
   }
 
-  // square of complex number
-  Vec2f p2(Vec2f p) {
-    return Vec2f(p[0] * p[0] - p[1] * p[1], 2.f * p[0] * p[1]);
-  }
-
-  // cube of complex number
-  Vec2f p3(Vec2f p) {
-    return Vec2f(p[0] * p[0] * p[0] - 3.f * p[0] * p[1] * p[1],
-                 3.f * p[0] * p[0] * p[1] - p[1] * p[1] * p[1]);
-  }
-
-  // function to apply newton's method
-  // here we use p_next = p^9 + coef * p - i
-  // with coef as the artistic manipulation
-  Vec2f myF(Vec2f p) { return p3(p3(p)) + coef * p - Vec2f(0.f, 1.f); }
-
-  // derivative of the function above
-  Vec2f myFPrime(Vec2f p) { return 9.f * p2(p2(p2(p))) + Vec2f(coef, 0.f); }
-
   void onAnimate(double dt) {
-    // reset the field
-    for (auto &f : field) {
-      f.set(0);
-    }
-
-    for (int j = 0; j < yRes; ++j) {
-      for (int i = 0; i < xRes; ++i) {
-        // get the middle of the pixel in a vector field -0.5~0.5 x -0.5~0.5
-        Vec2f p((i + 0.5f) / (float)xRes - 0.5f,
-                (j + 0.5f) / (float)yRes - 0.5f);
-
-        // scale the vector field size
-        p *= scale;
-
-        // apply newton's method to find the root of the function
-        // on each iteration add a bit of the base color
-        // to the corresponding vector field
-        int t = 0;
-        while (myF(p).mag() > 1E-3 && t < 100) {
-          Vec2f f = myF(p);
-          Vec2f fP = myFPrime(p);
-
-          p = p - Vec2f((f[0] * fP[0] + f[1] * fP[1]) /
-                            (fP[0] * fP[0] + fP[1] * fP[1]),
-                        (f[1] * fP[0] - f[0] * fP[1]) /
-                            (fP[0] * fP[0] + fP[1] * fP[1]));
-
-          field[i + j * xRes] += 0.02f * baseColor;
-
-          ++t;
-        }
-      }
+    if (useLanes) {
+      engine.evaluateLanes(field.data(), [this](FieldLanes &lanes) {
+        newtonLanes(lanes, scale, coef, baseColor);
+      });
+    } else {
+      engine.evaluate(field.data(), [this](float x, float y) {
+        // get the middle of the pixel in a vector field, scaled to its size
+        return newtonPixel(Vec2f(x, y) * scale, coef, baseColor);
+      });
     }
 
     // increment the parameters based on the time elapsed from last frame
@@ -148,24 +242,150 @@ public:
         goUp = true;
     }
 
-    // update the texture with the modified vector field
-    tex.submit(field.data());
+    // update the texture with the modified vector field, packed to the
+    // texture's format
+    tex.submit(engine, field.data());
   }
 
   void onDraw(Graphics &g) {
     g.clear();
-    // use textures to color meshes
-    g.texture();
-    // bind the texture we want to use
-    tex.bind();
-    // render the quad to apply texture
-    g.draw(quad);
-    // unbind the texture after use
-    tex.unbind();
+    // render the quad with the texture bound
+    tex.draw(g, quad);
   }
+
+  bool onKeyDown(const Keyboard &k) {
+    if (k.key() == 'l') {
+      useLanes = !useLanes;
+      printf("%s\n",
+             useLanes ? "eight pixels at a time" : "one pixel at a time");
+    }
+    return true;
+  }
+};
+
+// Differences between the fields of newtonPixel() and newtonLanes()
+struct FieldDiff {
+  float largest = 0; // Largest difference in a color component
+  int pixels = 0;    // Pixels differing by more than one iteration's color
 };
 
-int main() {
-  FieldApp app;
+FieldDiff compare(const std::vector<Color> &a, const std::vector<Color> &b,
+                  const Color &baseColor) {
+  FieldDiff diff;
+  float step =
+      0.02f * std::max(baseColor.r, std::max(baseColor.g, baseColor.b));
+  for (size_t i = 0; i < a.size(); ++i) {
+    float d = std::max(std::max(std::fabs(a[i].r - b[i].r),
+                                std::fabs(a[i].g - b[i].g)),
+                       std::max(std::fabs(a[i].b - b[i].b),
+                                std::fabs(a[i].a - b[i].a)));
+    diff.largest = std::max(diff.largest, d);
+    diff.pixels += d > step * 1.5f;
+  }
+  return diff;
+}
+
+// Renders the field one pixel and eight pixels at a time at a few values of
+// coef, and fails if more than 0.1% of the pixels differ by more than one
+// iteration. Pixels whose |f| lands within rounding of 1e-3 may take one
+// iteration more or less with the squared comparison.
+int check(int resolution) {
+  FieldEngine engine;
+  engine.resize(resolution, resolution);
+  std::vector<Color> scalar(engine.size()), lanes(engine.size());
+  const float scale = 2.f;
+  const Color baseColor(0.4f, 0.5f, 0.3f, 1.f);
+  bool ok = true;
+  for (float coef : {-0.2f, -0.25f, -0.3f}) {
+    engine.evaluate(scalar.data(), [&](float x, float y) {
+      return newtonPixel(Vec2f(x, y) * scale, coef, baseColor);
+    });
+    engine.evaluateLanes(lanes.data(), [&](FieldLanes &l) {
+      newtonLanes(l, scale, coef, baseColor);
+    });
+    FieldDiff diff = compare(scalar, lanes, baseColor);
+    bool match = diff.pixels * 1000 <= engine.size();
+    printf("coef %5.2f: %d of %d pixels differ, largest difference %.3f, "
+           "%s\n",
+           coef, diff.pixels, engine.size(), diff.largest,
+           match ? "ok" : "FAILED");
+    ok = ok && match;
+  }
+  return ok ? 0 : 1;
+}
+
+// Reports ms per frame one pixel and eight pixels at a time, and how many of
+// the lanes' iterations were on pixels that had not converged yet
+void benchmark(int resolution, int threads) {
+  typedef std::chrono::steady_clock Clock;
+  FieldEngine engine(threads);
+  engine.resize(resolution, resolution);
+  std::vector<Color> field(engine.size());
+  const float scale = 2.f, coef = -0.25f;
+  const Color baseColor(0.4f, 0.5f, 0.3f, 1.f);
+
+  auto msPerFrame = [&](const std::function<void()> &frame) {
+    int frames = 0;
+    auto start = Clock::now();
+    double seconds = 0;
+    while (seconds < 1 || frames < 3) {
+      frame();
+      ++frames;
+      seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    }
+    return seconds / frames * 1e3;
+  };
+
+  printf("%d x %d field, %d threads\n", resolution, resolution,
+         engine.threads());
+  double scalar = msPerFrame([&]() {
+    engine.evaluate(field.data(), [&](float x, float y) {
+      return newtonPixel(Vec2f(x, y) * scale, coef, baseColor);
+    });
+  });
+  printf("one pixel at a time     %8.2f ms/frame\n", scalar);
+  double lanes = msPerFrame([&]() {
+    engine.evaluateLanes(field.data(), [&](FieldLanes &l) {
+      newtonLanes(l, scale, coef, baseColor);
+    });
+  });
+  printf("eight pixels at a time  %8.2f ms/frame, %.1fx\n", lanes,
+         scalar / lanes);
+
+  // Iterations each pixel needed against those its group of lanes ran
+  double pixelIterations = 0, laneIterations = 0;
+  for (int j = 0; j < resolution; ++j) {
+    for (int i = 0; i < resolution; i += kFieldLanes) {
+      FieldLanes l;
+      for (int k = 0; k < kFieldLanes; ++k) {
+        l.x[k] = engine.x(std::min(i + k, resolution - 1));
+        l.y[k] = engine.y(j);
+      }
+      laneIterations += newtonLanes(l, scale, coef, baseColor) * kFieldLanes;
+      for (int k = 0; k < kFieldLanes; ++k)
+        pixelIterations += std::lround(l.a[k] / 0.02f);
+    }
+  }
+  printf("%.1f iterations per pixel, lanes busy %.0f%% of the time\n",
+         pixelIterations / engine.size(),
+         100 * pixelIterations / laneIterations);
+}
+
+int main(int argc, char *argv[]) {
+  if (argc > 1 && std::string(argv[1]) == "-check")
+    return check(512);
+  if (argc > 1 && std::string(argv[1]) == "-bench") {
+    benchmark(argc > 2 ? std::stoi(argv[2]) : 512,
+              argc > 3 ? std::stoi(argv[3]) : 0);
+    return 0;
+  }
+  FieldFormat format = FieldFormat::RGBA32F;
+  if (argc > 3 && !parseFieldFormat(argv[3], format)) {
+    printf("unknown format %s: use rgba32f, rgba16f, srgb8 or r16f\n",
+           argv[3]);
+    return 1;
+  }
+  FieldApp app(argc > 1 ? std::stoi(argv[1]) : 512,
+               argc > 2 ? std::stoi(argv[2]) : 0, format);
   app.start();
 }
@@ -10,14 +10,80 @@ Example of uploading the vector field to a Pixel buffer object(PBO)
 More in-depth explanation of PBO can be found here
 http://www.songho.ca/opengl/gl_pbo.html
 
+The field is evaluated by FieldEngine on all threads (see FieldEngine.hpp).
+It is computed on a producer thread of its own, straight into a ring of
+persistently mapped PBOs (see FieldPipeline.hpp). The render thread only
+checks fences, uploads the newest field with glTexSubImage2D and fences the
+upload, so computing the next field overlaps drawing this one. Without
+persistent mapping (OpenGL before 4.4, such as on macOS) the ring holds client
+memory, uploaded directly. Counts of dropped fields, stalls and how long
+buffers take to come back are printed on exit.
+
+The field can be uploaded as rgba32f (default), rgba16f, srgb8 or r16f (see
+FieldFormat.hpp). The producer then packs it into the buffers after
+computing it.
+
+Usage: ./03_pbo [resolution] [threads] [buffers] [format]
+       ./03_pbo -check
+       ./03_pbo -bench [resolution] [threads]
+
 Author:
 Kon Hyong Kim - Jan 2021
 */
 
 #include "al/app/al_App.hpp"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <thread>
 #include <vector>
+
+#include "FieldEngine.hpp"
+#include "FieldFormat.hpp"
+#include "FieldPipeline.hpp"
+
 using namespace al;
 
+typedef std::chrono::steady_clock Clock;
+
+inline double secondsSince(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Evaluates the field at phase theta into out
+inline void rippleField(FieldEngine &engine, Color *out, float scale,
+                        float theta) {
+  engine.evaluate(out, [=](float x, float y) {
+    // get the middle of the pixel in a vector field, scaled to its size
+    Vec3f p = Vec3f(x, y, 0.f) * scale;
+
+    // ** place to apply algorithms based on the vector field
+    // here we're coloring the vector field based on the radius
+    // and a sine wave as an example
+    float radius = p.mag();
+    // RGB that fluctuates from 0-1 based on radius and theta
+    // with different periods
+    return Color(0.5f * sin(8.f * radius + theta) + 0.5f,
+                 0.5f * sin(7.f * radius + theta) + 0.5f,
+                 0.5f * sin(5.f * radius + theta) + 0.5f);
+  });
+}
+
+void printStats(const FieldPipeline::Stats &s, double seconds) {
+  printf("%lld fields computed, %lld uploaded (%.1f/s), %lld dropped\n",
+         s.produced, s.uploaded, s.uploaded / seconds, s.dropped);
+  printf("%lld frames without a new field, %lld producer stalls (%.1f ms)\n",
+         s.consumerStalls, s.producerStalls, 1000 * s.stallTime);
+  printf("buffers back %.2f ms after upload on average, %.2f ms at most\n",
+         1000 * s.meanReuse(), 1000 * s.reuseMax);
+  printf("fields uploaded %.2f ms after they were computed\n",
+         1000 * s.meanAge());
+}
+
 class FieldApp : public App {
 public:
   // resolution of the vector field
@@ -27,35 +93,46 @@ public:
   // scale of the vector field
   float scale;
 
-  // parameters of the data type in the vector field
-  int channels;
-  int dataBytes;
+  // format the field is uploaded in, and its size in bytes
+  FieldFormat format;
   int dataSize;
 
-  // std::vector to store the color of the vector field
+  // the field as computed, when packed to another format
   std::vector<Color> field;
 
-  // PBO objects to upload the vector field
-  BufferObject buffer[2];
+  // evaluates the field on all threads
+  FieldEngine engine;
+
+  // hands fields from the producer thread to onDraw through the buffers
+  FieldPipeline pipeline;
+
+  // PBOs the fields are written to, which stay mapped while the app runs
+  std::vector<GLuint> buffer;
+  bool persistent;
+
+  // client memory the fields are written to instead, without PBOs
+  std::vector<std::vector<unsigned char>> memory;
+
+  // fence after the upload from each buffer in flight
+  std::vector<GLsync> fence;
 
   // Texture to store the image
-  Texture tex;
+  FieldTexture tex;
 
   // Rectangle mesh to apply the texture
   VAOMesh quad;
 
-  // phase of the sine waves in the algorithm used in the example
-  float theta;
+  Clock::time_point startTime;
 
-  FieldApp() {
+  FieldApp(int resolution = 512, int threads = 0, int buffers = 3,
+           FieldFormat format = FieldFormat::RGBA32F)
+      : format(format), engine(threads), pipeline(buffers) {
     // initialize variables
-    xRes = 512;
-    yRes = 512;
-    theta = 0.f;
+    xRes = resolution;
+    yRes = resolution;
     scale = 2.f;
-    channels = 4;  // RGBA
-    dataBytes = 4; // Floats are 32 bit = 4 bytes
-    dataSize = xRes * yRes * channels * dataBytes;
+    dataSize = xRes * yRes * fieldPixelBytes(format);
+    persistent = false;
   }
 
   void onCreate() {
@@ -64,32 +141,13 @@ public:
     // Some elements like nav need to be modified after being created
     nav().pos(0, 0, 4);
 
-    // resize the field container
-    field.resize(xRes * yRes);
-
-    // set the buffer object as a PBO and configure
-    // GL_PIXEL_UNPACK_BUFFER: uploading pixel data to OpenGL
-    // GL_STREAM_DRAW: streaming texture upload
-    buffer[0].bufferType(GL_PIXEL_UNPACK_BUFFER);
-    buffer[0].usage(GL_STREAM_DRAW);
-    buffer[0].create();
-    buffer[0].bind();
-    buffer[0].data(dataSize, nullptr); // reserve memory space
-    buffer[0].unbind();
-
-    buffer[1].bufferType(GL_PIXEL_UNPACK_BUFFER);
-    buffer[1].usage(GL_STREAM_DRAW);
-    buffer[1].create();
-    buffer[1].bind();
-    buffer[1].data(dataSize, nullptr);
-    buffer[1].unbind();
-
-    // set the filters for the texture. Default: NEAREST
-    tex.filterMag(Texture::LINEAR);
-    tex.filterMin(Texture::LINEAR);
-
-    // create a texture unit on the GPU
-    tex.create2D(xRes, yRes, Texture::RGBA32F, Texture::RGBA, Texture::FLOAT);
+    engine.resize(xRes, yRes);
+    if (format != FieldFormat::RGBA32F)
+      field.resize(xRes * yRes);
+    createBuffers();
+
+    // create a texture unit on the GPU, with LINEAR filters
+    tex.create(format, xRes, yRes);
 
     // create the quad mesh to apply texture on
     quad.primitive(Mesh::TRIANGLE_STRIP);
@@ -104,87 +162,341 @@ public:
     quad.texCoord(1, 0);
 
     quad.update();
+
+    // compute fields on the producer thread from now on. The phase of the
+    // sine waves follows the clock, so the animation looks smooth
+    // regardless of fps
+    startTime = Clock::now();
+    pipeline.start([this](void *data) {
+      double theta = std::fmod(1.5 * secondsSince(startTime), 2 * M_PI);
+      if (format == FieldFormat::RGBA32F) {
+        rippleField(engine, static_cast<Color *>(data), scale, float(theta));
+      } else {
+        rippleField(engine, field.data(), scale, float(theta));
+        packField(engine, format, field.data(), data);
+      }
+    });
   }
 
-  void onAnimate(double dt) {
-    for (int j = 0; j < yRes; ++j) {
-      for (int i = 0; i < xRes; ++i) {
-        // get the middle of the pixel in a vector field -0.5~0.5 x -0.5~0.5
-        Vec3f p((i + 0.5f) / (float)xRes - 0.5f,
-                (j + 0.5f) / (float)yRes - 0.5f, 0.f);
-
-        // scale the vector field size
-        p *= scale;
-
-        // ** place to apply algorithms based on the vector field
-        // here we're coloring the vector field based on the radius
-        // and a sine wave as an example
-        float radius = p.mag();
-        // RGB that fluctuates from 0-1 based on radius and theta
-        // with different periods
-        Color color = Color(0.5f * sin(8.f * radius + theta) + 0.5f,
-                            0.5f * sin(7.f * radius + theta) + 0.5f,
-                            0.5f * sin(5.f * radius + theta) + 0.5f);
-
-        // store the color in the container
-        field[xRes * j + i] = color;
+  // Gives each slot of the pipeline a buffer to write to
+  void createBuffers() {
+    int n = pipeline.size();
+    fence.assign(n, nullptr);
+
+#ifdef GL_MAP_PERSISTENT_BIT
+    // buffers that stay mapped while GL reads from them need OpenGL 4.4
+    GLint major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    persistent = major > 4 || (major == 4 && minor >= 4);
+    if (persistent) {
+      // COHERENT makes the producer's writes visible to GL without
+      // flushing them
+      GLbitfield flags =
+          GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+      buffer.assign(n, 0);
+      glGenBuffers(n, buffer.data());
+      for (int i = 0; i < n; ++i) {
+        // GL_PIXEL_UNPACK_BUFFER: uploading pixel data to OpenGL
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer[i]);
+        glBufferStorage(GL_PIXEL_UNPACK_BUFFER, dataSize, nullptr, flags);
+        void *ptr =
+            glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, dataSize, flags);
+        persistent = persistent && ptr;
+        pipeline.data(i, ptr);
       }
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+      if (!persistent)
+        deleteBuffers();
     }
+#endif
 
-    // increment the phase based on the time elapsed from last frame
-    // this allows animation to look smooth regardless of fps
-    theta += 1.5f * dt;
-    if (theta > 2 * M_PI)
-      theta -= 2 * M_PI;
+    if (!persistent) {
+      memory.assign(n, std::vector<unsigned char>(dataSize));
+      for (int i = 0; i < n; ++i)
+        pipeline.data(i, memory[i].data());
+    }
+    printf("%d %s buffers of %s\n", n,
+           persistent ? "persistently mapped" : "client memory",
+           fieldFormatName(format));
+  }
+
+  void deleteBuffers() {
+    for (GLuint b : buffer) {
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, b);
+      glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    if (!buffer.empty())
+      glDeleteBuffers(int(buffer.size()), buffer.data());
+    buffer.clear();
   }
 
   void onDraw(Graphics &g) {
     g.clear();
-    // use textures to color meshes
-    g.texture();
 
-    // static index to switch between 0 and 1 every frame
-    static int index = 0;
-    int nextIndex = index;   // index for the next frame
-    index = (index + 1) % 2; // switch between 0 and 1
+    // give back the buffers GL has finished uploading from. Uploads from
+    // client memory copy it before returning, so those are done already.
+    pipeline.retire([this](int s) {
+      if (!persistent)
+        return true;
+      // a timeout of 0 only checks the fence
+      if (glClientWaitSync(fence[s], 0, 0) == GL_TIMEOUT_EXPIRED)
+        return false;
+      glDeleteSync(fence[s]);
+      fence[s] = nullptr;
+      return true;
+    });
+
+    // upload the newest field, if one was computed since the last frame
+    int s = pipeline.take();
+    if (s >= 0) {
+      // bind the texture we want to upload to
+      tex.texture().bind();
+      if (persistent) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer[s]);
+        // Transfer pixel data from the bound PBO to the texture
+        // 0 at the end acts as the offset instead of a pointer if there's
+        // a PBO is bound
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, xRes, yRes,
+                        tex.uploadFormat(), tex.uploadType(), 0);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        // signaled once GL has read the buffer, so it can be written again
+        fence[s] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+      } else {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, xRes, yRes,
+                        tex.uploadFormat(), tex.uploadType(),
+                        pipeline.data(s));
+      }
+      tex.texture().unbind();
+    }
 
-    // bind the texture we want to use
-    tex.bind();
-    buffer[index].bind(); // bind the PBO to use
+    // render the quad with the texture bound
+    tex.draw(g, quad);
+  }
 
-    // Transfer pixel data from the bound PBO to the texture
-    // 0 at the end acts as the offset instead of a pointer if there's
-    // a PBO is bound
-    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, xRes, yRes, GL_RGBA, GL_FLOAT, 0);
+  void onExit() {
+    pipeline.stop();
+    printStats(pipeline.stats(), secondsSince(startTime));
+    for (GLsync f : fence)
+      if (f)
+        glDeleteSync(f);
+    deleteBuffers();
+  }
+};
 
-    // bind the next PBO to use in the next frame
-    buffer[nextIndex].bind();
+// Checks the pipeline's handoff and counters, without OpenGL
+int check() {
+  int failures = 0;
+  auto expect = [&](bool ok, const char *what) {
+    printf("%s: %s\n", ok ? "ok    " : "FAILED", what);
+    failures += !ok;
+  };
+  auto never = [](int) { return false; };
+  auto always = [](int) { return true; };
+
+  {
+    FieldPipeline p(3);
+    expect(p.take() == -1, "nothing to take before a field is published");
+    int a = p.acquire();
+    expect(p.state(a) == FieldPipeline::WRITING, "acquired slot is writing");
+    p.publish(a);
+    expect(p.take() == a && p.state(a) == FieldPipeline::IN_FLIGHT,
+           "take() returns the published slot, in flight");
+    expect(p.take() == -1, "a field is taken only once");
+    expect(p.retire(never) == 0 && p.state(a) == FieldPipeline::IN_FLIGHT,
+           "slot stays in flight until its upload is done");
+    expect(p.retire(always) == 1 && p.state(a) == FieldPipeline::FREE,
+           "retire() frees the slot");
+    FieldPipeline::Stats s = p.stats();
+    expect(s.produced == 1 && s.uploaded == 1 && s.dropped == 0 &&
+               s.consumerStalls == 2 && s.producerStalls == 0,
+           "counters after one field");
+  }
 
-    // discard previous data and create a new data store
-    buffer[nextIndex].data(dataSize, nullptr);
+  {
+    FieldPipeline p(3);
+    int a = p.acquire();
+    p.publish(a);
+    int b = p.acquire();
+    p.publish(b);
+    expect(a != b && p.take() == b, "take() returns the newest field");
+    expect(p.state(a) == FieldPipeline::FREE && p.stats().dropped == 1,
+           "older ready fields are dropped");
+  }
 
-    // map the buffer's memory to a client's memory space
-    void *ptr = glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
+  {
+    FieldPipeline p(3);
+    int a = p.acquire();
+    p.publish(a);
+    int b = p.acquire();
+    p.publish(b);
+    int c = p.acquire();
+    p.publish(c);
+    expect(p.tryAcquire() == a && p.stats().dropped == 1,
+           "without a free slot the oldest ready one is rewritten");
+    expect(p.tryAcquire() == b, "then the next oldest");
+  }
 
-    if (ptr) {
-      // copy the vector field to the mapped memory space
-      std::memcpy(ptr, field.data(), dataSize);
+  {
+    FieldPipeline p(2);
+    int a = p.acquire();
+    p.publish(a);
+    p.take();
+    int b = p.acquire();
+    p.publish(b);
+    p.take();
+    expect(p.tryAcquire() == -1, "no slot while all are in flight");
+
+    std::atomic<int> got{-2};
+    std::thread producer([&] { got = p.acquire(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    expect(got == -2, "acquire() waits while all are in flight");
+    p.retire([&](int s) { return s == a; });
+    producer.join();
+    expect(got == a && p.stats().producerStalls == 1,
+           "acquire() returns the retired slot, counting a stall");
+
+    std::thread waiting([&] { got = p.acquire(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    p.stop();
+    waiting.join();
+    expect(got == -1, "stop() wakes a waiting acquire()");
+  }
 
-      // release the mapping
-      glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+  {
+    // A producer thread fills each buffer with its field's number, while
+    // this thread takes fields and frees them two frames later, as a fence
+    // would
+    const int n = 3, words = 1 << 14;
+    FieldPipeline p(n);
+    std::vector<std::vector<int>> buffers(n, std::vector<int>(words));
+    for (int i = 0; i < n; ++i)
+      p.data(i, buffers[i].data());
+    int next = 0;
+    p.start([&](void *data) {
+      int *w = static_cast<int *>(data);
+      ++next;
+      for (int i = 0; i < words; ++i)
+        w[i] = next;
+    });
+
+    std::vector<int> takenAt(n, 0);
+    int last = 0;
+    bool whole = true, ordered = true;
+    auto start = Clock::now();
+    for (int frame = 0; p.stats().uploaded < 2000 && secondsSince(start) < 10;
+         ++frame) {
+      p.retire([&](int s) { return takenAt[s] <= frame - 2; });
+      int s = p.take();
+      if (s >= 0) {
+        const int *w = static_cast<const int *>(p.data(s));
+        for (int i = 1; i < words; ++i)
+          whole = whole && w[i] == w[0];
+        ordered = ordered && w[0] > last;
+        last = w[0];
+        takenAt[s] = frame;
+      }
+      std::this_thread::yield();
     }
+    p.stop();
+
+    int ready = 0;
+    for (int i = 0; i < n; ++i)
+      ready += p.state(i) == FieldPipeline::READY;
+    FieldPipeline::Stats s = p.stats();
+    printf("        %lld fields, %lld uploaded, %lld dropped, %lld stalls\n",
+           s.produced, s.uploaded, s.dropped, s.producerStalls);
+    expect(s.uploaded >= 2000, "threads hand over 2000 fields");
+    expect(whole, "no field is written while it is uploaded");
+    expect(ordered, "fields are uploaded in order");
+    expect(s.produced == s.uploaded + s.dropped + ready,
+           "every field is uploaded, dropped or still ready");
+  }
 
-    // unbind the PBO
-    buffer[nextIndex].unbind();
+  printf("%s\n", failures ? "check FAILED" : "check passed");
+  return failures ? 1 : 0;
+}
 
-    // render the quad to apply texture
-    g.draw(quad);
-    // unbind the texture after use
-    tex.unbind();
-  }
-};
+// Reports the render thread's time per frame at 60 frames/s when it
+// computes the field itself and when it takes fields from the pipeline. A
+// copy stands in for the upload, and the frame two frames later for its
+// fence.
+int benchmark(int resolution, int threads) {
+  const double frameTime = 1. / 60, seconds = 3;
+  FieldEngine engine(threads);
+  engine.resize(resolution, resolution);
+  size_t bytes = engine.size() * sizeof(Color);
+  std::vector<Color> field(engine.size()), texture(engine.size());
+  std::vector<std::vector<Color>> staging(3, field);
+  printf("%d x %d field, %d threads\n", resolution, resolution,
+         engine.threads());
+
+  // runs frame(n) for a while, returning the ms it takes per frame
+  auto run = [&](const std::function<void(int)> &frame, int &frames) {
+    auto start = Clock::now();
+    double busy = 0;
+    for (frames = 0; secondsSince(start) < seconds; ++frames) {
+      auto t = Clock::now();
+      frame(frames);
+      busy += secondsSince(t);
+      std::this_thread::sleep_until(
+          start + std::chrono::duration_cast<Clock::duration>(
+                      std::chrono::duration<double>((frames + 1) * frameTime)));
+    }
+    return 1000 * busy / frames;
+  };
+
+  int frames;
+  double serial = run(
+      [&](int n) {
+        rippleField(engine, field.data(), 2.f, 0.1f * n);
+        std::memcpy(staging[n % 2].data(), field.data(), bytes); // mapped
+        std::memcpy(texture.data(), staging[n % 2].data(), bytes); // upload
+      },
+      frames);
+  printf("serial     %7.2f ms/frame on the render thread, %.1f fields/s\n",
+         serial, frames / seconds);
+
+  FieldPipeline pipeline(3);
+  for (int i = 0; i < 3; ++i)
+    pipeline.data(i, staging[i].data());
+  int fields = 0;
+  pipeline.start([&](void *data) {
+    rippleField(engine, static_cast<Color *>(data), 2.f, 0.1f * fields++);
+  });
+  std::vector<int> takenAt(3, 0);
+  double pipelined = run(
+      [&](int n) {
+        pipeline.retire([&](int s) { return takenAt[s] <= n - 2; });
+        int s = pipeline.take();
+        if (s >= 0) {
+          std::memcpy(texture.data(), pipeline.data(s), bytes);
+          takenAt[s] = n;
+        }
+      },
+      frames);
+  pipeline.stop();
+  printf("pipelined  %7.2f ms/frame on the render thread\n", pipelined);
+  printStats(pipeline.stats(), seconds);
+  return 0;
+}
 
-int main() {
-  FieldApp app;
+int main(int argc, char *argv[]) {
+  if (argc > 1 && std::string(argv[1]) == "-check")
+    return check();
+  if (argc > 1 && std::string(argv[1]) == "-bench") {
+    return benchmark(argc > 2 ? std::stoi(argv[2]) : 1024,
+                     argc > 3 ? std::stoi(argv[3]) : 0);
+  }
+  FieldFormat format = FieldFormat::RGBA32F;
+  if (argc > 4 && !parseFieldFormat(argv[4], format)) {
+    printf("unknown format %s: use rgba32f, rgba16f, srgb8 or r16f\n",
+           argv[4]);
+    return 1;
+  }
+  FieldApp app(argc > 1 ? std::stoi(argv[1]) : 512,
+               argc > 2 ? std::stoi(argv[2]) : 0,
+               argc > 3 ? std::stoi(argv[3]) : 3, format);
   app.start();
 }
@@ -0,0 +1,160 @@
+#pragma once
+#ifndef FieldEngine_H
+#define FieldEngine_H
+
+// Evaluates a field of colors over a grid of pixels on a thread pool.
+//
+// The image is split into square tiles of tileSize pixels, small enough that
+// a tile's colors stay in cache while they are written. Threads take tiles in
+// turn from a shared counter, so a field that costs more in some places than
+// others (like Newton's method) still keeps every thread busy. Each pixel is
+// written by one call only, so the result doesn't depend on the number of
+// threads.
+//
+// evaluate() calls f(x, y) for each pixel, with (x, y) the pixel's center in
+// [-0.5, 0.5] x [-0.5, 0.5], and stores the Color it returns:
+//
+//   engine.evaluate(field.data(), [&](float x, float y) {
+//     return Color(x + 0.5f, y + 0.5f, 0.f);
+//   });
+//
+// evaluateLanes() calls f(FieldLanes &) for kFieldLanes pixels of a row at a
+// time. f reads the x and y arrays and writes r, g, b and a, in loops over
+// the lanes that the compiler can turn into SIMD instructions. Lanes past the
+// end of a row repeat its last pixel and are not stored.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+#include "al/types/al_Color.hpp"
+
+#include "playground/ThreadPool.hpp"
+
+const int kFieldLanes = 8;
+
+struct FieldLanes {
+  float x[kFieldLanes], y[kFieldLanes];
+  float r[kFieldLanes], g[kFieldLanes], b[kFieldLanes], a[kFieldLanes];
+};
+
+// sin(x) to about 1e-6 for |x| < 1e5, without branches or calls so that loops
+// over lanes using it vectorize
+inline float fieldSin(float x) {
+  // Nearest multiple of 2 pi, rounded by the float addition
+  const float kRound = 12582912.f; // 1.5 * 2^23
+  float k = (x * 0.159154943f + kRound) - kRound;
+  float r = (x - k * 6.28125f) - k * 1.93530717e-3f; // 2 pi in two parts
+  float r2 = r * r;
+  float s = -7.64716373e-13f;
+  s = s * r2 + 1.60590438e-10f;
+  s = s * r2 - 2.50521084e-8f;
+  s = s * r2 + 2.75573192e-6f;
+  s = s * r2 - 1.98412698e-4f;
+  s = s * r2 + 8.33333333e-3f;
+  s = s * r2 - 1.66666667e-1f;
+  return r + r * r2 * s;
+}
+
+// sqrt(x) to about 1e-7 relative for x >= 0, for the same reason: std::sqrt
+// may set errno, which keeps loops calling it from vectorizing
+inline float fieldSqrt(float x) {
+  int32_t bits;
+  std::memcpy(&bits, &x, 4);
+  bits = 0x5f375a86 - (bits >> 1);
+  float y;
+  std::memcpy(&y, &bits, 4);
+  y = y * (1.5f - 0.5f * x * y * y);
+  y = y * (1.5f - 0.5f * x * y * y);
+  y = y * (1.5f - 0.5f * x * y * y);
+  return x * y;
+}
+
+// v where mask is all ones, and 0 where it is zero. Choosing with ?: between
+// floats computed in a loop keeps it from vectorizing under the default
+// trapping math, where the compiler won't compute the side not chosen.
+inline float fieldMask(float v, int32_t mask) {
+  int32_t bits;
+  std::memcpy(&bits, &v, 4);
+  bits &= mask;
+  std::memcpy(&v, &bits, 4);
+  return v;
+}
+
+class FieldEngine {
+public:
+  int tileSize = 64; // Pixels along each side of a tile
+
+  // numThreads of zero or less uses every hardware thread
+  explicit FieldEngine(int numThreads = 0) : mPool(numThreads) {}
+
+  void resize(int xRes, int yRes) {
+    mXRes = std::max(xRes, 1);
+    mYRes = std::max(yRes, 1);
+  }
+
+  int xRes() const { return mXRes; }
+  int yRes() const { return mYRes; }
+  int size() const { return mXRes * mYRes; }
+  int threads() const { return mPool.size(); }
+
+  // Center of pixel (i, j) in [-0.5, 0.5]
+  float x(int i) const { return (i + 0.5f) / (float)mXRes - 0.5f; }
+  float y(int j) const { return (j + 0.5f) / (float)mYRes - 0.5f; }
+
+  // Stores f(x, y) for each pixel (i, j) at out[i + j * xRes()]
+  template <class F> void evaluate(al::Color *out, F f) {
+    forEachTile([&](int i0, int i1, int j0, int j1) {
+      for (int j = j0; j < j1; ++j) {
+        float y = this->y(j);
+        al::Color *row = out + j * mXRes;
+        for (int i = i0; i < i1; ++i)
+          row[i] = f(x(i), y);
+      }
+    });
+  }
+
+  // Stores the colors f(lanes) writes for each run of kFieldLanes pixels
+  template <class F> void evaluateLanes(al::Color *out, F f) {
+    forEachTile([&](int i0, int i1, int j0, int j1) {
+      FieldLanes lanes;
+      for (int j = j0; j < j1; ++j) {
+        float y = this->y(j);
+        al::Color *row = out + j * mXRes;
+        for (int i = i0; i < i1; i += kFieldLanes) {
+          for (int k = 0; k < kFieldLanes; ++k) {
+            lanes.x[k] = x(std::min(i + k, i1 - 1));
+            lanes.y[k] = y;
+            lanes.a[k] = 1.f;
+          }
+          f(lanes);
+          int n = std::min(i1 - i, kFieldLanes);
+          for (int k = 0; k < n; ++k)
+            row[i + k].set(lanes.r[k], lanes.g[k], lanes.b[k], lanes.a[k]);
+        }
+      }
+    });
+  }
+
+  // Calls tile(i0, i1, j0, j1) for each tile, on every thread, with the
+  // tile's pixels being [i0, i1) x [j0, j1)
+  template <class Tile> void forEachTile(Tile tile) {
+    int size = std::max(tileSize, 1);
+    int columns = (mXRes + size - 1) / size;
+    int numTiles = columns * ((mYRes + size - 1) / size);
+    std::atomic<int> next{0};
+    mPool.parallelFor(0, mPool.size(), [&](int, int, int) {
+      for (int t; (t = next.fetch_add(1)) < numTiles;) {
+        int i0 = (t % columns) * size, j0 = (t / columns) * size;
+        tile(i0, std::min(i0 + size, mXRes), j0, std::min(j0 + size, mYRes));
+      }
+    });
+  }
+
+private:
+  int mXRes = 1, mYRes = 1;
+  ThreadPool mPool;
+};
+
+#endif
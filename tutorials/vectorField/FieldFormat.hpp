@@ -0,0 +1,345 @@
+#pragma once
+#ifndef FieldFormat_H
+#define FieldFormat_H
+
+// Smaller texture formats for uploading fields.
+//
+// The tutorials compute colors as RGBA floats, 16 bytes a pixel, although
+// the colors shown are between 0 and 1. Packing them before the upload cuts
+// the bytes sent to the GPU:
+//
+//   RGBA32F  16 bytes  the field as computed
+//   RGBA16F   8 bytes  half floats, about 3 decimal digits
+//   SRGB8     4 bytes  8 bits a channel, spaced evenly in sRGB so that steps
+//                      in dark colors are as small as in bright ones
+//   R16F      2 bytes  the field's luminance only, drawn through a colormap
+//
+// The GPU decodes sRGB to the same linear colors when sampling, so every
+// format but R16F looks like the field as computed.
+//
+// Packing is not free. packField() converts a run of colors without
+// branches or calls, but its loops only turn into SIMD instructions at -O3,
+// and even then it takes longer on one core than a desktop GPU's bus takes
+// to move the RGBA32F field. Per 1024 x 1024 frame on one core
+// (02_texture -formats):
+//
+//            -O2      -O3
+//   RGBA16F  21 ms    11 ms
+//   SRGB8   107 ms    21 ms
+//   R16F     7.5 ms   4.2 ms
+//
+// against about 1.5 ms to send 16.8 MB over PCIe 3 x16. So RGBA32F stays
+// the default; the packed formats pay off when the link to the GPU is slow
+// or its memory is short, and when there are spare cores to pack on.
+//
+// FieldTexture packs a field on a FieldEngine's threads, a row of a tile at
+// a time, and uploads and draws it:
+//
+//   FieldTexture tex;
+//   tex.create(FieldFormat::RGBA16F, xRes, yRes);     // onCreate
+//   tex.submit(engine, field.data());                 // onAnimate
+//   tex.draw(g, quad);                                // onDraw
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "al/graphics/al_Graphics.hpp"
+#include "al/graphics/al_Shader.hpp"
+#include "al/graphics/al_Texture.hpp"
+
+#include "FieldEngine.hpp"
+
+enum class FieldFormat { RGBA32F, RGBA16F, SRGB8, R16F };
+
+inline const char *fieldFormatName(FieldFormat f) {
+  switch (f) {
+  case FieldFormat::RGBA16F:
+    return "rgba16f";
+  case FieldFormat::SRGB8:
+    return "srgb8";
+  case FieldFormat::R16F:
+    return "r16f";
+  default:
+    return "rgba32f";
+  }
+}
+
+// Sets f from its name, returning false if there is no such format
+inline bool parseFieldFormat(const std::string &name, FieldFormat &f) {
+  for (FieldFormat g : {FieldFormat::RGBA32F, FieldFormat::RGBA16F,
+                        FieldFormat::SRGB8, FieldFormat::R16F}) {
+    if (name == fieldFormatName(g)) {
+      f = g;
+      return true;
+    }
+  }
+  return false;
+}
+
+inline int fieldPixelBytes(FieldFormat f) {
+  switch (f) {
+  case FieldFormat::RGBA16F:
+    return 8;
+  case FieldFormat::SRGB8:
+    return 4;
+  case FieldFormat::R16F:
+    return 2;
+  default:
+    return 16;
+  }
+}
+
+// Half float nearest to v, rounding ties to even. Overflow gives infinity
+// and NaN stays NaN.
+inline uint16_t fieldHalf(float v) {
+  uint32_t f;
+  std::memcpy(&f, &v, 4);
+  uint32_t sign = f & 0x80000000u;
+  f ^= sign;
+
+  // Normal halves: move the exponent from a bias of 127 to 15, and round
+  // the 13 mantissa bits dropped, up on ties if the kept ones are odd
+  uint32_t normal = (f + 0xc8000fffu + ((f >> 13) & 1)) >> 13;
+
+  // Subnormal halves: adding 0.5 lines the mantissa up with the half's and
+  // the float addition rounds it
+  float d;
+  std::memcpy(&d, &f, 4);
+  d += 0.5f;
+  uint32_t subnormal;
+  std::memcpy(&subnormal, &d, 4);
+  subnormal -= 0x3f000000u;
+
+  // Choose with masks rather than ?:, which keeps loops from vectorizing
+  uint32_t small = 0u - uint32_t(f < 0x38800000u);
+  uint32_t large = 0u - uint32_t(f >= 0x47800000u);
+  uint32_t nan = 0u - uint32_t(f > 0x7f800000u);
+  uint32_t special = 0x7c00u | (nan & 0x200u);
+  uint32_t h = (subnormal & small) | (special & large) |
+               (normal & ~(small | large));
+  return uint16_t(h | (sign >> 16));
+}
+
+// The float a half stands for, exactly
+inline float fieldHalfToFloat(uint16_t h) {
+  uint32_t sign = uint32_t(h & 0x8000u) << 16;
+  uint32_t exponent = (h >> 10) & 0x1f, mantissa = h & 0x3ffu;
+  float v;
+  if (exponent == 0) {
+    v = mantissa * (1.f / (1 << 24));
+  } else if (exponent == 31) {
+    uint32_t bits = 0x7f800000u | (mantissa << 13);
+    std::memcpy(&v, &bits, 4);
+  } else {
+    uint32_t bits = ((exponent + 112) << 23) | (mantissa << 13);
+    std::memcpy(&v, &bits, 4);
+  }
+  uint32_t bits;
+  std::memcpy(&bits, &v, 4);
+  bits |= sign;
+  std::memcpy(&v, &bits, 4);
+  return v;
+}
+
+// The sRGB encoding of linear x in [0, 1], to within 1/28000. The curve
+// 1.055 x^(1/2.4) - 0.055 is fit with square roots instead of pow, which
+// has no SIMD form.
+inline float fieldSrgb(float x) {
+  float s1 = fieldSqrt(x), s2 = fieldSqrt(s1); // x^(1/2), x^(1/4)
+  float curve = (1.12228498f - 0.335045169f * s2) * s1 + 0.196274339f * s2 +
+                0.0811486147f * x - 0.0646277203f;
+  int32_t bits;
+  std::memcpy(&bits, &x, 4);
+  int32_t linear = -int32_t(bits < 0x3b4d2e1c); // x < 0.0031308
+  return fieldMask(12.92f * x, linear) + fieldMask(curve, ~linear);
+}
+
+// v clamped to [0, 1], with masks for the same reason
+inline float fieldUnit(float v) {
+  int32_t bits;
+  std::memcpy(&bits, &v, 4);
+  v = fieldMask(v, ~(bits >> 31)); // Negative to 0
+  int32_t over = -int32_t(bits > 0x3f800000);
+  return fieldMask(v, ~over) + fieldMask(1.f, over);
+}
+
+// Converts n colors to format f at out, which holds n * fieldPixelBytes(f)
+// bytes
+inline void packField(FieldFormat f, const al::Color *in, void *out, int n) {
+  static_assert(sizeof(al::Color) == 4 * sizeof(float),
+                "Colors must be four packed floats");
+  const float *c = reinterpret_cast<const float *>(in);
+  switch (f) {
+  case FieldFormat::RGBA16F: {
+    uint16_t *h = static_cast<uint16_t *>(out);
+    for (int i = 0; i < 4 * n; ++i)
+      h[i] = fieldHalf(c[i]);
+    break;
+  }
+  case FieldFormat::SRGB8: {
+    uint8_t *b = static_cast<uint8_t *>(out);
+    for (int i = 0; i < 4 * n; ++i) {
+      // Alpha, every fourth value, stays linear
+      float v = fieldUnit(c[i]);
+      int32_t alpha = -int32_t((i & 3) == 3);
+      v = fieldMask(v, alpha) + fieldMask(fieldSrgb(v), ~alpha);
+      b[i] = uint8_t(int32_t(v * 255.f + 0.5f));
+    }
+    break;
+  }
+  case FieldFormat::R16F: {
+    uint16_t *h = static_cast<uint16_t *>(out);
+    for (int i = 0; i < n; ++i)
+      h[i] = fieldHalf(0.2126f * c[4 * i] + 0.7152f * c[4 * i + 1] +
+                       0.0722f * c[4 * i + 2]);
+    break;
+  }
+  default:
+    std::memcpy(out, in, size_t(n) * sizeof(al::Color));
+  }
+}
+
+// Packs a whole field of engine's size, on engine's threads
+inline void packField(FieldEngine &engine, FieldFormat f, const al::Color *in,
+                      void *out) {
+  int bytes = fieldPixelBytes(f), xRes = engine.xRes();
+  engine.forEachTile([&](int i0, int i1, int j0, int j1) {
+    for (int j = j0; j < j1; ++j) {
+      int first = j * xRes + i0;
+      packField(f, in + first, static_cast<char *>(out) + first * bytes,
+                i1 - i0);
+    }
+  });
+}
+
+// Draws the texture's red channel through a colormap, for R16F
+const std::string fieldColormapVert = R"(
+#version 330
+uniform mat4 al_ModelViewMatrix;
+uniform mat4 al_ProjectionMatrix;
+
+layout (location = 0) in vec3 position;
+layout (location = 2) in vec2 texcoord;
+
+out vec2 T;
+
+void main(void) {
+  T = texcoord;
+  gl_Position = al_ProjectionMatrix * al_ModelViewMatrix * vec4(position, 1.0);
+}
+)";
+
+const std::string fieldColormapFrag = R"(
+#version 330
+in vec2 T;
+layout (location = 0) out vec4 fragColor;
+
+uniform sampler2D field;
+
+// A polynomial fit of the viridis colormap, from dark blue at 0 through
+// green to yellow at 1
+vec3 viridis(float t) {
+  const vec3 c0 = vec3(0.2777273, 0.005407345, 0.3340998);
+  const vec3 c1 = vec3(0.105093, 1.404614, 1.38459);
+  const vec3 c2 = vec3(-0.3308618, 0.2148476, 0.09509516);
+  const vec3 c3 = vec3(-4.63423, -5.799101, -19.33244);
+  const vec3 c4 = vec3(6.22827, 14.17993, 56.69055);
+  const vec3 c5 = vec3(4.776385, -13.74515, -65.35303);
+  const vec3 c6 = vec3(-5.435456, 4.645853, 26.31244);
+  return c0 + t * (c1 + t * (c2 + t * (c3 + t * (c4 + t * (c5 + t * c6)))));
+}
+
+void main(){
+  float value = clamp(texture(field, T).r, 0., 1.);
+  fragColor = vec4(viridis(value), 1);
+}
+)";
+
+// A texture holding a field in one of the formats above
+class FieldTexture {
+public:
+  void create(FieldFormat format, int xRes, int yRes) {
+    mFormat = format;
+    mXRes = xRes;
+    mYRes = yRes;
+    mPacked.resize(size_t(xRes) * yRes * pixelBytes());
+
+    mTexture.filterMag(al::Texture::LINEAR);
+    mTexture.filterMin(al::Texture::LINEAR);
+    mTexture.create2D(xRes, yRes, internalFormat(), uploadFormat(),
+                      uploadType());
+    if (format == FieldFormat::R16F) {
+      mColormap.compile(fieldColormapVert, fieldColormapFrag);
+      // Rows of R16F pixels needn't fill whole words
+      glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    }
+  }
+
+  FieldFormat format() const { return mFormat; }
+  int pixelBytes() const { return fieldPixelBytes(mFormat); }
+  int dataSize() const { return mXRes * mYRes * pixelBytes(); }
+
+  // Format and type to pass to glTexSubImage2D
+  unsigned uploadFormat() const {
+    return mFormat == FieldFormat::R16F ? GL_RED : GL_RGBA;
+  }
+  unsigned uploadType() const {
+    switch (mFormat) {
+    case FieldFormat::RGBA32F:
+      return GL_FLOAT;
+    case FieldFormat::SRGB8:
+      return GL_UNSIGNED_BYTE;
+    default:
+      return GL_HALF_FLOAT;
+    }
+  }
+
+  // Packs field, of engine's size, and uploads it
+  void submit(FieldEngine &engine, const al::Color *field) {
+    if (mFormat == FieldFormat::RGBA32F) {
+      mTexture.submit(field);
+      return;
+    }
+    packField(engine, mFormat, field, mPacked.data());
+    mTexture.submit(mPacked.data());
+  }
+
+  // Draws mesh with the texture, through the colormap for R16F
+  template <class Mesh> void draw(al::Graphics &g, Mesh &mesh) {
+    if (mFormat == FieldFormat::R16F) {
+      g.shader(mColormap);
+      g.shader().uniform("field", 0);
+    } else {
+      g.texture();
+    }
+    mTexture.bind(0);
+    g.draw(mesh);
+    mTexture.unbind(0);
+  }
+
+  al::Texture &texture() { return mTexture; }
+
+private:
+  int internalFormat() const {
+    switch (mFormat) {
+    case FieldFormat::RGBA16F:
+      return GL_RGBA16F;
+    case FieldFormat::SRGB8:
+      return GL_SRGB8_ALPHA8;
+    case FieldFormat::R16F:
+      return GL_R16F;
+    default:
+      return GL_RGBA32F;
+    }
+  }
+
+  FieldFormat mFormat = FieldFormat::RGBA32F;
+  int mXRes = 0, mYRes = 0;
+  std::vector<unsigned char> mPacked;
+  al::Texture mTexture;
+  al::ShaderProgram mColormap;
+};
+
+#endif
@@ -0,0 +1,234 @@
+#pragma once
+#ifndef FieldPipeline_H
+#define FieldPipeline_H
+
+// Hands fields from a producer thread to the render thread through a ring of
+// staging buffers, so that computing the next field overlaps drawing and
+// uploading the last one.
+//
+// Each slot of the ring points to a buffer of the owner's, typically a
+// persistently mapped PBO, and moves through four states:
+//
+//   free -> writing -> ready -> in flight -> free
+//
+// The producer takes a free slot with acquire(), writes its field straight
+// into the slot's buffer and publish()es it. If no slot is free, it takes the
+// oldest ready one instead, which drops that field unseen; only when every
+// other slot is in flight does it wait.
+//
+// Once a frame, the render thread calls take(), which returns the newest
+// ready slot (dropping any older ones) and marks it in flight, then uploads
+// from it and fences the upload. retire(done) frees the in-flight slots for
+// which done(slot) is true, e.g. whose fence has signaled:
+//
+//   pipeline.retire([&](int s) { return signaled(fence[s]); });
+//   int s = pipeline.take();
+//   if (s >= 0) { upload(s); fence[s] = glFenceSync(...); }
+//
+// Nothing here calls OpenGL, so the ring can be driven and checked without a
+// context.
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class FieldPipeline {
+public:
+  struct Stats {
+    long long produced = 0; // Fields published
+    long long uploaded = 0; // Fields taken by the render thread
+    long long dropped = 0;  // Fields replaced by newer ones before upload
+    long long producerStalls = 0; // Waits for a slot to leave flight
+    long long consumerStalls = 0; // Frames with no new field to upload
+    double stallTime = 0;         // Seconds the producer waited
+    double reuseTotal = 0, reuseMax = 0; // Seconds from take() to retire()
+    double ageTotal = 0; // Seconds from publish() to take()
+
+    double meanReuse() const { return uploaded ? reuseTotal / uploaded : 0; }
+    double meanAge() const { return uploaded ? ageTotal / uploaded : 0; }
+  };
+
+  enum State { FREE, WRITING, READY, IN_FLIGHT };
+
+  explicit FieldPipeline(int slots = 3) : mSlots(std::max(slots, 2)) {}
+  ~FieldPipeline() { stop(); }
+
+  int size() const { return int(mSlots.size()); }
+
+  // Buffer written for slot, of the owner's
+  void data(int slot, void *buffer) { mSlots[slot].data = buffer; }
+  void *data(int slot) const { return mSlots[slot].data; }
+
+  State state(int slot) const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mSlots[slot].state;
+  }
+
+  // Producer: a slot to write, waiting while every other one is in flight.
+  // Returns -1 once stop() is called.
+  int acquire() {
+    std::unique_lock<std::mutex> lock(mMutex);
+    int slot = writable();
+    if (slot < 0 && !mStopped) {
+      ++mStats.producerStalls;
+      double start = now();
+      mChanged.wait(lock, [&] { return mStopped || (slot = writable()) >= 0; });
+      mStats.stallTime += now() - start;
+    }
+    if (mStopped)
+      return -1;
+    return begin(slot);
+  }
+
+  // Producer: a slot to write, or -1 without waiting
+  int tryAcquire() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    int slot = writable();
+    return slot < 0 || mStopped ? -1 : begin(slot);
+  }
+
+  // Producer: slot's field is written
+  void publish(int slot) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    Slot &s = mSlots[slot];
+    s.state = READY;
+    s.sequence = ++mSequence;
+    s.time = now();
+    ++mStats.produced;
+  }
+
+  // Render thread: the newest ready slot, now in flight, or -1 if no field
+  // was published since the last call
+  int take() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    int newest = -1;
+    for (int i = 0; i < size(); ++i)
+      if (mSlots[i].state == READY &&
+          (newest < 0 || mSlots[i].sequence > mSlots[newest].sequence))
+        newest = i;
+    if (newest < 0) {
+      ++mStats.consumerStalls;
+      return -1;
+    }
+    for (Slot &s : mSlots)
+      if (s.state == READY && &s != &mSlots[newest]) {
+        s.state = FREE;
+        ++mStats.dropped;
+      }
+    Slot &s = mSlots[newest];
+    double t = now();
+    mStats.ageTotal += t - s.time;
+    s.state = IN_FLIGHT;
+    s.time = t;
+    ++mStats.uploaded;
+    mChanged.notify_all();
+    return newest;
+  }
+
+  // Render thread: frees each slot in flight for which done(slot) is true.
+  // Returns the number freed.
+  template <class Done> int retire(Done done) {
+    std::vector<int> flying;
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      for (int i = 0; i < size(); ++i)
+        if (mSlots[i].state == IN_FLIGHT)
+          flying.push_back(i);
+    }
+    // done() may call OpenGL, so it runs outside the lock
+    flying.erase(std::remove_if(flying.begin(), flying.end(),
+                                [&](int i) { return !done(i); }),
+                 flying.end());
+    if (flying.empty())
+      return 0;
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    double t = now();
+    for (int i : flying) {
+      double reuse = t - mSlots[i].time;
+      mStats.reuseTotal += reuse;
+      mStats.reuseMax = std::max(mStats.reuseMax, reuse);
+      mSlots[i].state = FREE;
+    }
+    mChanged.notify_all();
+    return int(flying.size());
+  }
+
+  // Runs produce(data) for each field on a thread of its own until stop()
+  void start(std::function<void(void *)> produce) {
+    stop();
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mStopped = false;
+    }
+    mProducer = std::thread([this, produce] {
+      for (int slot; (slot = acquire()) >= 0;) {
+        produce(data(slot));
+        publish(slot);
+      }
+    });
+  }
+
+  // Wakes a waiting acquire() and joins the producer thread, if started
+  void stop() {
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mStopped = true;
+    }
+    mChanged.notify_all();
+    if (mProducer.joinable())
+      mProducer.join();
+  }
+
+  Stats stats() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mStats;
+  }
+
+private:
+  struct Slot {
+    void *data = nullptr;
+    State state = FREE;
+    long long sequence = 0;
+    double time = 0; // Of publish() while ready, of take() in flight
+  };
+
+  // A free slot, else the oldest ready one, else -1
+  int writable() const {
+    int oldest = -1;
+    for (int i = 0; i < size(); ++i) {
+      if (mSlots[i].state == FREE)
+        return i;
+      if (mSlots[i].state == READY &&
+          (oldest < 0 || mSlots[i].sequence < mSlots[oldest].sequence))
+        oldest = i;
+    }
+    return oldest;
+  }
+
+  int begin(int slot) {
+    if (mSlots[slot].state == READY)
+      ++mStats.dropped;
+    mSlots[slot].state = WRITING;
+    return slot;
+  }
+
+  static double now() {
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+  }
+
+  std::vector<Slot> mSlots;
+  long long mSequence = 0;
+  bool mStopped = false;
+  Stats mStats;
+  mutable std::mutex mMutex;
+  std::condition_variable mChanged;
+  std::thread mProducer;
+};
+
+#endif
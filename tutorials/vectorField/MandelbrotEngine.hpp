@@ -0,0 +1,532 @@
+#pragma once
+#ifndef MandelbrotEngine_H
+#define MandelbrotEngine_H
+
+// Escape counts of the Mandelbrot set on the CPU, down to deep zooms.
+//
+// Once a view is smaller than about 1e-13, doubles can no longer tell its
+// pixels apart. So the orbit of the view's center, the reference, is
+// computed once with as many bits as the zoom needs (BigFixed), and each
+// pixel follows only its difference dz from the reference, in doubles:
+//
+//   dz' = (2 Z + dz) dz + dc
+//
+// where Z is the reference and dc the pixel's offset from the center. When a
+// pixel's orbit passes closer to zero than dz is large, or the reference
+// ends, the orbit is rebased onto the start of the reference: dz becomes z
+// and the reference starts over. This avoids the glitches of plain
+// perturbation without a second reference.
+//
+// For the first iterations dz is close to a polynomial in dc, the series
+//
+//   dz = A dc + B dc^2 + C dc^3
+//
+// whose coefficients are computed along the reference. Pixels start from
+// the series as many iterations in as it stays accurate, checked against a
+// few probe pixels at the edges of the view iterated in full.
+//
+// Pixels are computed by tiles on a FieldEngine thread pool, in passes of
+// finer and finer spacing: every 8th pixel first, filling its 8 x 8 block,
+// then every 4th and so on. Calling refine() once a frame shows a coarse
+// image at once and the full one a few frames later. At deep zooms a pass
+// can take seconds, so an app can instead call refine() on a thread of its
+// own and cancel() it from another when the view changes.
+//
+// Counts follow the tutorial's shader: the number of iterations of
+// z -> z^2 + c from 0 until |z| >= bailout, or 0 if that doesn't happen
+// within iterations, for pixels taken to be inside the set. Offsets are
+// doubles, so views must be wider than about 1e-290.
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "FieldEngine.hpp"
+
+// Signed fixed point numbers with 32 integer bits and 32 * fracLimbs bits of
+// fraction. Numbers combined must have the same number of limbs.
+class BigFixed {
+public:
+  explicit BigFixed(int fracLimbs = 2) : mLimbs(std::max(fracLimbs, 1) + 1) {}
+
+  // Fraction limbs to resolve offsets of size delta with 64 bits to spare
+  static int limbsFor(double delta) {
+    int bits = delta > 0 ? int(std::ceil(-std::log2(delta))) : 1024;
+    return std::max(2, (std::max(bits, 0) + 64 + 31) / 32);
+  }
+
+  static BigFixed fromDouble(double v, int fracLimbs) {
+    BigFixed r(fracLimbs);
+    r.mNegative = v < 0;
+    v = std::fabs(v);
+    double whole = std::floor(v);
+    int n = r.fracLimbs();
+    r.mLimbs[n] = uint32_t(whole);
+    double frac = v - whole;
+    for (int k = n - 1; k >= 0 && frac > 0; --k) {
+      frac *= 4294967296.0;
+      double limb = std::floor(frac);
+      r.mLimbs[k] = uint32_t(limb);
+      frac -= limb;
+    }
+    r.normalize();
+    return r;
+  }
+
+  // Parses a decimal number such as "-0.7436438870371587". Numbers with an
+  // exponent are read as doubles.
+  static BigFixed fromString(const std::string &s, int fracLimbs) {
+    if (s.find_first_of("eE") != std::string::npos)
+      return fromDouble(std::stod(s), fracLimbs);
+    BigFixed r(fracLimbs);
+    int n = r.fracLimbs();
+    size_t pos = 0;
+    bool negative = false;
+    if (pos < s.size() && (s[pos] == '-' || s[pos] == '+'))
+      negative = s[pos++] == '-';
+    uint32_t whole = 0;
+    for (; pos < s.size() && isDigit(s[pos]); ++pos)
+      whole = whole * 10 + (s[pos] - '0');
+    if (pos < s.size() && s[pos] == '.') {
+      size_t last = ++pos;
+      while (last < s.size() && isDigit(s[last]))
+        ++last;
+      // From the last digit to the first: f = (digit + f) / 10
+      for (size_t d = last; d-- > pos;) {
+        r.mLimbs[n] = s[d] - '0';
+        uint64_t rest = 0;
+        for (int k = n; k >= 0; --k) {
+          uint64_t v = (rest << 32) | r.mLimbs[k];
+          r.mLimbs[k] = uint32_t(v / 10);
+          rest = v % 10;
+        }
+      }
+    }
+    r.mLimbs[n] = whole;
+    r.mNegative = negative;
+    r.normalize();
+    return r;
+  }
+
+  int fracLimbs() const { return int(mLimbs.size()) - 1; }
+
+  // The same number with more or fewer fraction limbs
+  BigFixed withPrecision(int fracLimbs) const {
+    BigFixed r(fracLimbs);
+    int from = this->fracLimbs(), to = r.fracLimbs();
+    for (int k = 0; k <= to; ++k) {
+      int source = k - to + from;
+      if (source >= 0 && source <= from)
+        r.mLimbs[k] = mLimbs[source];
+    }
+    r.mNegative = mNegative;
+    r.normalize();
+    return r;
+  }
+
+  double toDouble() const {
+    int n = fracLimbs();
+    double r = 0;
+    for (int k = 0; k <= n; ++k)
+      r += std::ldexp(double(mLimbs[k]), 32 * (k - n));
+    return mNegative ? -r : r;
+  }
+
+  std::string toString(int digits) const {
+    int n = fracLimbs();
+    std::string s = (mNegative ? "-" : "") + std::to_string(mLimbs[n]) + ".";
+    std::vector<uint32_t> frac(mLimbs.begin(), mLimbs.begin() + n);
+    for (int d = 0; d < digits; ++d) {
+      uint64_t carry = 0;
+      for (int k = 0; k < n; ++k) {
+        uint64_t v = uint64_t(frac[k]) * 10 + carry;
+        frac[k] = uint32_t(v);
+        carry = v >> 32;
+      }
+      s += char('0' + carry);
+    }
+    return s;
+  }
+
+  BigFixed operator-() const {
+    BigFixed r = *this;
+    r.mNegative = !mNegative;
+    r.normalize();
+    return r;
+  }
+
+  friend BigFixed operator+(const BigFixed &a, const BigFixed &b) {
+    BigFixed r(a.fracLimbs());
+    if (a.mNegative == b.mNegative) {
+      addMagnitudes(a.mLimbs, b.mLimbs, r.mLimbs);
+      r.mNegative = a.mNegative;
+    } else if (compareMagnitudes(a.mLimbs, b.mLimbs) >= 0) {
+      subtractMagnitudes(a.mLimbs, b.mLimbs, r.mLimbs);
+      r.mNegative = a.mNegative;
+    } else {
+      subtractMagnitudes(b.mLimbs, a.mLimbs, r.mLimbs);
+      r.mNegative = b.mNegative;
+    }
+    r.normalize();
+    return r;
+  }
+
+  friend BigFixed operator-(const BigFixed &a, const BigFixed &b) {
+    return a + (-b);
+  }
+
+  // Truncates the bits below the last limb; the integer part must fit
+  friend BigFixed operator*(const BigFixed &a, const BigFixed &b) {
+    int m = int(a.mLimbs.size()), n = m - 1;
+    std::vector<uint32_t> product(2 * m, 0);
+    for (int i = 0; i < m; ++i) {
+      uint64_t carry = 0;
+      for (int j = 0; j < m; ++j) {
+        uint64_t t = uint64_t(a.mLimbs[i]) * b.mLimbs[j] + product[i + j] +
+                     carry;
+        product[i + j] = uint32_t(t);
+        carry = t >> 32;
+      }
+      product[i + m] = uint32_t(carry);
+    }
+    BigFixed r(n);
+    std::copy(product.begin() + n, product.begin() + 2 * n + 1,
+              r.mLimbs.begin());
+    r.mNegative = a.mNegative != b.mNegative;
+    r.normalize();
+    return r;
+  }
+
+private:
+  static bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+  // Zero is never negative
+  void normalize() {
+    if (std::all_of(mLimbs.begin(), mLimbs.end(),
+                    [](uint32_t l) { return l == 0; }))
+      mNegative = false;
+  }
+
+  static int compareMagnitudes(const std::vector<uint32_t> &a,
+                               const std::vector<uint32_t> &b) {
+    for (int k = int(a.size()) - 1; k >= 0; --k)
+      if (a[k] != b[k])
+        return a[k] < b[k] ? -1 : 1;
+    return 0;
+  }
+
+  static void addMagnitudes(const std::vector<uint32_t> &a,
+                            const std::vector<uint32_t> &b,
+                            std::vector<uint32_t> &r) {
+    uint64_t carry = 0;
+    for (size_t k = 0; k < a.size(); ++k) {
+      uint64_t t = uint64_t(a[k]) + b[k] + carry;
+      r[k] = uint32_t(t);
+      carry = t >> 32;
+    }
+  }
+
+  // a - b, for |a| >= |b|
+  static void subtractMagnitudes(const std::vector<uint32_t> &a,
+                                 const std::vector<uint32_t> &b,
+                                 std::vector<uint32_t> &r) {
+    int64_t borrow = 0;
+    for (size_t k = 0; k < a.size(); ++k) {
+      int64_t t = int64_t(a[k]) - b[k] - borrow;
+      borrow = t < 0;
+      r[k] = uint32_t(t + (borrow << 32));
+    }
+  }
+
+  std::vector<uint32_t> mLimbs; // Least significant first; the last is the
+                                // integer part
+  bool mNegative = false;
+};
+
+class MandelbrotEngine {
+public:
+  double bailout = 200;  // |z| at which a pixel has escaped, as the shader
+  bool useSeries = true; // Start pixels from the series approximation
+
+  struct Stats {
+    int referenceLength = 0; // Iterations of the reference orbit
+    int skipped = 0;         // Iterations each pixel starts from the series
+    int precisionBits = 0;   // Fraction bits of the reference
+    long long iterations = 0, rebases = 0; // Summed over the pixels so far
+  };
+
+  explicit MandelbrotEngine(int numThreads = 0) : mTiles(numThreads) {
+    mTiles.tileSize = 8 * kFirstStep;
+  }
+
+  void resize(int xRes, int yRes) {
+    mTiles.resize(xRes, yRes);
+    mCounts.assign(mTiles.size(), 0);
+    restart();
+  }
+
+  // Centers the view on re + i im, radius being half its width. Starts the
+  // image over.
+  void setView(const BigFixed &re, const BigFixed &im, double radius,
+               int iterations) {
+    mRe = re;
+    mIm = im;
+    mRadius = radius;
+    mIterations = std::max(iterations, 1);
+    restart();
+  }
+
+  int xRes() const { return mTiles.xRes(); }
+  int yRes() const { return mTiles.yRes(); }
+  const BigFixed &re() const { return mRe; }
+  const BigFixed &im() const { return mIm; }
+  double radius() const { return mRadius; }
+  int iterations() const { return mIterations; }
+
+  // Escape counts of the pixels, row by row from the bottom, 0 inside
+  const std::vector<int> &counts() const { return mCounts; }
+
+  // Spacing of the pixels the next refine() computes, or 0 when done
+  int step() const { return mStep; }
+  bool done() const { return mStep == 0; }
+
+  // Computes the next pass. Returns false if the image was already done, or
+  // if the pass was cancelled.
+  bool refine() {
+    if (mStep == 0 || mCancelled)
+      return false;
+    if (!mPrepared)
+      prepare();
+    if (mCancelled)
+      return false;
+    int s = mStep, xRes = this->xRes();
+    bool first = s == kFirstStep;
+    mTiles.forEachTile([&](int i0, int i1, int j0, int j1) {
+      long long iterations = 0, rebases = 0;
+      for (int j = j0; j < j1 && !mCancelled; j += s) {
+        for (int i = i0; i < i1; i += s) {
+          if (!first && i % (2 * s) == 0 && j % (2 * s) == 0)
+            continue; // Computed in an earlier pass
+          int count = pixel(offsetX(i), offsetY(j), iterations, rebases);
+          for (int y = j; y < std::min(j + s, j1); ++y)
+            std::fill(&mCounts[y * xRes + i],
+                      &mCounts[y * xRes + std::min(i + s, i1)], count);
+        }
+      }
+      mIterationsDone += iterations;
+      mRebases += rebases;
+    });
+    if (mCancelled)
+      return false;
+    mStep /= 2;
+    return true;
+  }
+
+  // Makes a refine() running on another thread return false soon, leaving
+  // its pass unfinished. Later calls to refine() do nothing until the next
+  // setView() or resize().
+  void cancel() { mCancelled = true; }
+
+  // Computes all the passes left
+  void render() {
+    while (refine()) {
+    }
+  }
+
+  Stats stats() const {
+    Stats s = mStats;
+    s.iterations = mIterationsDone;
+    s.rebases = mRebases;
+    return s;
+  }
+
+  // Offset of pixel (i, j) from the center of the view
+  double offsetX(int i) const {
+    return ((i + 0.5) / xRes() * 2 - 1) * mRadius;
+  }
+  double offsetY(int j) const {
+    return ((j + 0.5) / yRes() * 2 - 1) * mRadius * yRes() / xRes();
+  }
+
+private:
+  static const int kFirstStep = 8;
+
+  struct Complex {
+    double re, im;
+  };
+
+  void restart() {
+    mStep = kFirstStep;
+    mPrepared = false;
+    mCancelled = false;
+    mIterationsDone = 0;
+    mRebases = 0;
+  }
+
+  // Computes the reference orbit and how far the series can go
+  void prepare() {
+    double pixelSize = 2 * mRadius / xRes();
+    int limbs = std::max(BigFixed::limbsFor(pixelSize),
+                         std::max(mRe.fracLimbs(), mIm.fracLimbs()));
+    BigFixed cr = mRe.withPrecision(limbs), ci = mIm.withPrecision(limbs);
+    BigFixed zr(limbs), zi(limbs);
+    mReference.assign(1, Complex{0, 0});
+    double bailout2 = bailout * bailout;
+    for (int k = 1; k <= mIterations && !mCancelled; ++k) {
+      BigFixed zri = zr * zi;
+      zr = zr * zr - zi * zi + cr;
+      zi = zri + zri + ci;
+      Complex z{zr.toDouble(), zi.toDouble()};
+      mReference.push_back(z);
+      if (z.re * z.re + z.im * z.im >= bailout2)
+        break;
+    }
+    mStats = Stats();
+    mStats.referenceLength = int(mReference.size()) - 1;
+    mStats.precisionBits = 32 * limbs;
+    mSkip = useSeries ? seriesSkip() : 0;
+    mStats.skipped = mSkip;
+    mPrepared = true;
+  }
+
+  // Computes the series coefficients along the reference, scaled by powers
+  // of the largest offset so they stay in range, and returns the number of
+  // iterations it can skip
+  int seriesSkip() {
+    int length = int(mReference.size());
+    mSeriesScale = mRadius * std::sqrt(1 + double(yRes()) * yRes() /
+                                               (double(xRes()) * xRes()));
+    mSeries.assign(1, Series{{0, 0}, {0, 0}, {0, 0}});
+    // Stop where the cubic term is no longer small against the linear one,
+    const double tolerance = 1e-8;
+    for (int n = 0; n + 2 < length; ++n) {
+      const Series &s = mSeries.back();
+      Complex z2{2 * mReference[n].re, 2 * mReference[n].im};
+      Series next;
+      next.a = add(mul(z2, s.a), Complex{mSeriesScale, 0});
+      next.b = add(mul(z2, s.b), mul(s.a, s.a));
+      Complex ab = mul(s.a, s.b);
+      next.c = add(mul(z2, s.c), Complex{2 * ab.re, 2 * ab.im});
+      if (!(norm(next.c) <= tolerance * tolerance * norm(next.a)))
+        break;
+      // and where dz could come near Z in size, as z = Z + dz then loses the
+      // accuracy the series has relative to dz
+      double dzMax = std::sqrt(norm(next.a)) + std::sqrt(norm(next.b)) +
+                     std::sqrt(norm(next.c));
+      if (!(dzMax * dzMax <= 1e-6 * norm(mReference[n + 1])))
+        break;
+      mSeries.push_back(next);
+    }
+
+    // Shorten the skip until probe pixels at the edges agree with it
+    int skip = int(mSeries.size()) - 1;
+    while (skip > 0 && !mCancelled && !seriesMatchesProbes(skip))
+      skip /= 2;
+    return skip;
+  }
+
+  bool seriesMatchesProbes(int skip) const {
+    int xs[3] = {0, xRes() / 2, xRes() - 1};
+    int ys[3] = {0, yRes() / 2, yRes() - 1};
+    double bailout2 = bailout * bailout;
+    for (int a = 0; a < 3; ++a) {
+      for (int b = 0; b < 3; ++b) {
+        if (a == 1 && b == 1)
+          continue;
+        Complex dc{offsetX(xs[a]), offsetY(ys[b])}, dz{0, 0};
+        for (int n = 0; n < skip; ++n) {
+          dz = step(mReference[n], dz, dc);
+          Complex z = add(mReference[n + 1], dz);
+          if (norm(z) >= bailout2 || norm(z) < norm(dz))
+            return false; // Escapes or needs rebasing before the skip
+        }
+        Complex e = seriesAt(skip, dc);
+        Complex d{e.re - dz.re, e.im - dz.im};
+        if (!(norm(d) <= 1e-20 * norm(dz)))
+          return false;
+      }
+    }
+    return true;
+  }
+
+  // dz after iteration n of the series
+  Complex seriesAt(int n, Complex dc) const {
+    Complex u{dc.re / mSeriesScale, dc.im / mSeriesScale};
+    const Series &s = mSeries[n];
+    // ((c u + b) u + a) u
+    return mul(add(mul(add(mul(s.c, u), s.b), u), s.a), u);
+  }
+
+  // Escape count of the pixel at offset dc from the center
+  int pixel(double dcRe, double dcIm, long long &iterations,
+            long long &rebases) const {
+    Complex dc{dcRe, dcIm}, dz{0, 0};
+    int n = 0, count = 0;
+    if (mSkip > 0) {
+      dz = seriesAt(mSkip, dc);
+      n = count = mSkip;
+    }
+    int last = int(mReference.size()) - 1;
+    double bailout2 = bailout * bailout;
+    int start = count;
+    bool escaped = false;
+    while (count < mIterations) {
+      dz = step(mReference[n], dz, dc);
+      ++n;
+      ++count;
+      Complex z = add(mReference[n], dz);
+      double z2 = norm(z);
+      if (z2 >= bailout2) {
+        escaped = true;
+        break;
+      }
+      if ((z2 < norm(dz) || n == last) && count < mIterations) {
+        dz = z;
+        n = 0;
+        ++rebases;
+      }
+    }
+    iterations += count - start;
+    return escaped ? count : 0;
+  }
+
+  // dz' = (2 Z + dz) dz + dc
+  static Complex step(Complex Z, Complex dz, Complex dc) {
+    double tr = 2 * Z.re + dz.re, ti = 2 * Z.im + dz.im;
+    return Complex{tr * dz.re - ti * dz.im + dc.re,
+                   tr * dz.im + ti * dz.re + dc.im};
+  }
+
+  static Complex add(Complex a, Complex b) {
+    return Complex{a.re + b.re, a.im + b.im};
+  }
+  static Complex mul(Complex a, Complex b) {
+    return Complex{a.re * b.re - a.im * b.im, a.re * b.im + a.im * b.re};
+  }
+  static double norm(Complex a) { return a.re * a.re + a.im * a.im; }
+
+  struct Series {
+    Complex a, b, c;
+  };
+
+  FieldEngine mTiles;
+  std::vector<int> mCounts;
+  BigFixed mRe, mIm;
+  double mRadius = 1;
+  int mIterations = 100;
+
+  int mStep = kFirstStep;
+  bool mPrepared = false;
+  std::vector<Complex> mReference;
+  std::vector<Series> mSeries;
+  double mSeriesScale = 1;
+  int mSkip = 0;
+  Stats mStats;
+  std::atomic<long long> mIterationsDone{0}, mRebases{0};
+  std::atomic<bool> mCancelled{false};
+};
+
+#endif